@@ -1,23 +1,61 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <algorithm>
 #include "AST.hpp"
 std::string unary_operator_to_string(UnaryOperator op){
     switch(op) {
         case UnaryOperator::Negation: return "-";
         case UnaryOperator::Complement: return "~";
+        case UnaryOperator::Increment: return "++";
+        case UnaryOperator::Decrement: return "--";
+        case UnaryOperator::LogicalNot: return "!";
         case UnaryOperator::Error: return "Error";
     }
     return ""; // optional default, to silence compiler warnings
 }
+std::string binary_operator_to_string(BinaryOperator op){
+    switch(op) {
+        case BinaryOperator::Add: return "+";
+        case BinaryOperator::Subtract: return "-";
+        case BinaryOperator::Multiply: return "*";
+        case BinaryOperator::Divide: return "/";
+        case BinaryOperator::Remainder: return "%";
+        case BinaryOperator::BitwiseAnd: return "&";
+        case BinaryOperator::BitwiseOr: return "|";
+        case BinaryOperator::BitwiseXor: return "^";
+        case BinaryOperator::LeftShift: return "<<";
+        case BinaryOperator::RightShift: return ">>";
+        case BinaryOperator::LogicalRightShift: return ">>>";
+        case BinaryOperator::LessThan: return "<";
+        case BinaryOperator::LessOrEqual: return "<=";
+        case BinaryOperator::GreaterThan: return ">";
+        case BinaryOperator::GreaterOrEqual: return ">=";
+        case BinaryOperator::Equal: return "==";
+        case BinaryOperator::NotEqual: return "!=";
+        case BinaryOperator::LogicalAnd: return "&&";
+        case BinaryOperator::LogicalOr: return "||";
+        case BinaryOperator::Comma: return ",";
+    }
+    return "";
+}
 // ======================================================
 //                     ExpressionNode
 // ======================================================
 //Abstract Base class for all expression(Statements that evaluate to a value);
-ExpressionNode::ExpressionNode(ExpressionType t): type(t){}
+ExpressionNode::ExpressionNode(ExpressionType t): type(t), registerNeed(0), nesting(0){}
 ExpressionType ExpressionNode::getType() const {
     return(this->type);
 }
+int ExpressionNode::getRegisterNeed() const {
+    return(this->registerNeed);
+}
+void ExpressionNode::setRegisterNeed(int need){
+    this->registerNeed = need;
+}
+int ExpressionNode::getNesting() const {
+    return(this->nesting);
+}
 
 
 // ======================================================
@@ -34,7 +72,9 @@ const std::string ConstantNode::getValue(){
 // ======================================================
 //                     UnaryNode::ExperssionNode
 // ======================================================
-UnaryNode::UnaryNode(UnaryOperator unary_operator, ExpressionNode* exp):ExpressionNode{ExpressionType::UNARY},unary_operator(unary_operator),exp(exp){}
+UnaryNode::UnaryNode(UnaryOperator unary_operator, ExpressionNode* exp):ExpressionNode{ExpressionType::UNARY},unary_operator(unary_operator),exp(exp){
+    this->nesting = exp->getNesting() + 1;
+}
 
 UnaryOperator UnaryNode::get_unary_operator(){
     return(this->unary_operator);
@@ -60,6 +100,124 @@ UnaryNode::~UnaryNode(){}
 // }
 
 
+// ======================================================
+//                     BinaryNode::ExpressionNode
+// ======================================================
+BinaryNode::BinaryNode(BinaryOperator binary_operator, ExpressionNode* left, ExpressionNode* right)
+    :ExpressionNode(ExpressionType::BINARY), binary_operator(binary_operator), left(left), right(right){
+    this->nesting = std::max(left->getNesting(), right->getNesting() + 1);
+}
+void BinaryNode::print(){
+    std::cout<<"\t\tBinary("<<this->getValue()<<")";
+}
+const std::string BinaryNode::getValue(){
+    // the left operands of a chain are printed in a loop, (((a + b) + c) + d) is built left to right in one string
+    std::vector<BinaryNode*> chain;
+    ExpressionNode* leaf = this;
+    while(BinaryNode* binary = dynamic_cast<BinaryNode*>(leaf)){
+        chain.push_back(binary);
+        leaf = binary->left;
+    }
+    std::string value(chain.size(), '(');
+    value += leaf->getValue();
+    for(size_t i = chain.size(); i-- > 0;){
+        value += " " + binary_operator_to_string(chain[i]->binary_operator) + " " + chain[i]->right->getValue() + ")";
+    }
+    return(value);
+}
+BinaryOperator BinaryNode::getBinaryOperator() const{
+    return(this->binary_operator);
+}
+ExpressionNode* BinaryNode::getLeft() const{
+    return(this->left);
+}
+ExpressionNode* BinaryNode::getRight() const{
+    return(this->right);
+}
+
+// ======================================================
+//                     VariableNode::ExpressionNode
+// ======================================================
+VariableNode::VariableNode(std::string identifier):ExpressionNode(ExpressionType::VARIABLE), identifier(identifier){}
+void VariableNode::print(){
+    std::cout<<"\t\t\tVar ("<<identifier<<")";
+}
+const std::string VariableNode::getValue(){
+    return(this->identifier);
+}
+std::string VariableNode::getIdentifier() const{
+    return(this->identifier);
+}
+
+// ======================================================
+//                     AssignmentNode::ExpressionNode
+// ======================================================
+AssignmentNode::AssignmentNode(VariableNode* variable, ExpressionNode* exp)
+    :ExpressionNode(ExpressionType::ASSIGNMENT), variable(variable), exp(exp){
+    this->nesting = exp->getNesting() + 1;
+}
+void AssignmentNode::print(){
+    std::cout<<"\t\tAssign("<<this->variable->getIdentifier()<<" = "<<this->exp->getValue()<<")";
+}
+const std::string AssignmentNode::getValue(){
+    return(this->variable->getIdentifier() + " = " + this->exp->getValue());
+}
+VariableNode* AssignmentNode::getVariable() const{
+    return(this->variable);
+}
+ExpressionNode* AssignmentNode::getExpression() const{
+    return(this->exp);
+}
+
+// ======================================================
+//                     ConditionalNode::ExpressionNode
+// ======================================================
+ConditionalNode::ConditionalNode(ExpressionNode* condition, ExpressionNode* thenExpression, ExpressionNode* elseExpression)
+    :ExpressionNode(ExpressionType::CONDITIONAL), condition(condition), thenExpression(thenExpression), elseExpression(elseExpression){
+    this->nesting = std::max(condition->getNesting(), std::max(thenExpression->getNesting(), elseExpression->getNesting())) + 1;
+}
+void ConditionalNode::print(){
+    std::cout<<"\t\tConditional("<<this->getValue()<<")";
+}
+const std::string ConditionalNode::getValue(){
+    return("(" + this->condition->getValue() + " ? " + this->thenExpression->getValue() + " : " + this->elseExpression->getValue() + ")");
+}
+ExpressionNode* ConditionalNode::getCondition() const{
+    return(this->condition);
+}
+ExpressionNode* ConditionalNode::getThen() const{
+    return(this->thenExpression);
+}
+ExpressionNode* ConditionalNode::getElse() const{
+    return(this->elseExpression);
+}
+
+// ======================================================
+//                     FunctionCallNode::ExpressionNode
+// ======================================================
+FunctionCallNode::FunctionCallNode(std::string identifier, std::vector<ExpressionNode*> arguments)
+    :ExpressionNode(ExpressionType::FUNCTION_CALL), identifier(identifier), arguments(arguments){
+    for(ExpressionNode* argument: arguments){
+        this->nesting = std::max(this->nesting, argument->getNesting() + 1);
+    }
+}
+void FunctionCallNode::print(){
+    std::cout<<"\t\tCall("<<this->getValue()<<")";
+}
+const std::string FunctionCallNode::getValue(){
+    std::string value = this->identifier + "(";
+    for(size_t i = 0; i < this->arguments.size(); i++){
+        value += (i ? ", " : "") + this->arguments[i]->getValue();
+    }
+    return(value + ")");
+}
+std::string FunctionCallNode::getIdentifier() const{
+    return(this->identifier);
+}
+const std::vector<ExpressionNode*>& FunctionCallNode::getArguments() const{
+    return(this->arguments);
+}
+
 // ======================================================
 //                     StatementNode
 // ======================================================
@@ -85,26 +243,207 @@ ExpressionNode* ReturnNode::getExpression(void)const{
     return(this->exp);
 }
 
+// ======================================================
+//                     ExpressionStatementNode::StatementNode
+// ======================================================
+ExpressionStatementNode::ExpressionStatementNode(ExpressionNode* exp):StatementNode(StatementType::EXPRESSION), exp(exp){}
+void ExpressionStatementNode::print(){
+    std::cout<<"Expression(\n";
+    this->exp->print();
+    std::cout<<"\n\t\t)";
+}
+
+ExpressionNode* ExpressionStatementNode::getExpression(void)const{
+    return(this->exp);
+}
+
+// ======================================================
+//                     IfNode::StatementNode
+// ======================================================
+IfNode::IfNode(ExpressionNode* condition, StatementNode* thenStatement, StatementNode* elseStatement)
+    :StatementNode(StatementType::IF), condition(condition), thenStatement(thenStatement), elseStatement(elseStatement){}
+void IfNode::print(){
+    std::cout<<"If(\n";
+    this->condition->print();
+    std::cout<<"\n\t\tthen=";
+    this->thenStatement->print();
+    if(this->elseStatement != nullptr){
+        std::cout<<"\n\t\telse=";
+        this->elseStatement->print();
+    }
+    std::cout<<"\n\t\t)";
+}
+
+ExpressionNode* IfNode::getCondition(void)const{
+    return(this->condition);
+}
+
+StatementNode* IfNode::getThen(void)const{
+    return(this->thenStatement);
+}
+
+StatementNode* IfNode::getElse(void)const{
+    return(this->elseStatement);
+}
+
+// ======================================================
+//                     CompoundNode::StatementNode
+// ======================================================
+CompoundNode::CompoundNode(std::vector<StatementNode*> statements):StatementNode(StatementType::COMPOUND), statements(statements){}
+void CompoundNode::print(){
+    std::cout<<"Block(\n";
+    for(StatementNode* statement: this->statements){
+        std::cout<<"\t\t";
+        statement->print();
+        std::cout<<"\n";
+    }
+    std::cout<<"\t\t)";
+}
+
+const std::vector<StatementNode*>& CompoundNode::getStatements(void)const{
+    return(this->statements);
+}
+
+// ======================================================
+//                     NullNode::StatementNode
+// ======================================================
+NullNode::NullNode():StatementNode(StatementType::NULL_STATEMENT){}
+void NullNode::print(){
+    std::cout<<"Null";
+}
+
+// ======================================================
+//                     DeclarationNode::StatementNode
+// ======================================================
+DeclarationNode::DeclarationNode(std::string identifier, ExpressionNode* init)
+    :StatementNode(StatementType::DECLARATION), identifier(identifier), init(init){}
+void DeclarationNode::print(){
+    std::cout<<"Declaration("<<this->identifier;
+    if(this->init != nullptr){
+        std::cout<<" =\n";
+        this->init->print();
+    }
+    std::cout<<"\n\t\t)";
+}
+
+std::string DeclarationNode::getIdentifier(void)const{
+    return(this->identifier);
+}
+
+ExpressionNode* DeclarationNode::getInit(void)const{
+    return(this->init);
+}
+
+// ======================================================
+//                     CaseNode::StatementNode
+// ======================================================
+CaseNode::CaseNode(int32_t value, StatementNode* statement)
+    :StatementNode(StatementType::CASE), value(value), statement(statement){}
+void CaseNode::print(){
+    std::cout<<"Case("<<this->value<<",\n\t\t";
+    this->statement->print();
+    std::cout<<"\n\t\t)";
+}
+
+int32_t CaseNode::getValue(void)const{
+    return(this->value);
+}
+
+StatementNode* CaseNode::getStatement(void)const{
+    return(this->statement);
+}
+
+// ======================================================
+//                     DefaultNode::StatementNode
+// ======================================================
+DefaultNode::DefaultNode(StatementNode* statement):StatementNode(StatementType::DEFAULT), statement(statement){}
+void DefaultNode::print(){
+    std::cout<<"Default(\n\t\t";
+    this->statement->print();
+    std::cout<<"\n\t\t)";
+}
+
+StatementNode* DefaultNode::getStatement(void)const{
+    return(this->statement);
+}
+
+// ======================================================
+//                     SwitchNode::StatementNode
+// ======================================================
+SwitchNode::SwitchNode(ExpressionNode* exp, StatementNode* body, std::vector<CaseNode*> cases, DefaultNode* defaultCase)
+    :StatementNode(StatementType::SWITCH), exp(exp), body(body), cases(cases), defaultCase(defaultCase){}
+void SwitchNode::print(){
+    std::cout<<"Switch(\n";
+    this->exp->print();
+    std::cout<<"\n\t\tbody=";
+    this->body->print();
+    std::cout<<"\n\t\t)";
+}
+
+ExpressionNode* SwitchNode::getExpression(void)const{
+    return(this->exp);
+}
+
+StatementNode* SwitchNode::getBody(void)const{
+    return(this->body);
+}
+
+const std::vector<CaseNode*>& SwitchNode::getCases(void)const{
+    return(this->cases);
+}
+
+DefaultNode* SwitchNode::getDefault(void)const{
+    return(this->defaultCase);
+}
+
+// ======================================================
+//                     BreakNode::StatementNode
+// ======================================================
+BreakNode::BreakNode():StatementNode(StatementType::BREAK){}
+void BreakNode::print(){
+    std::cout<<"Break";
+}
+
 // ======================================================
 //                     FunctionNode
 // ======================================================
 //FunctionNode
-FunctionNode::FunctionNode(std::string identifier, StatementNode* statement){
+FunctionNode::FunctionNode(std::string identifier, std::vector<std::string> parameters, std::vector<StatementNode*> body, bool internal){
     this->identifier =  identifier;
-    this->statement =  statement;
+    this->parameters =  parameters;
+    this->body =  body;
+    this->internal = internal;
 }
 void FunctionNode::print(){
     // std::cout<<this->statement<<'\n';
     std::cout<<"\tFunction(\n";
-    std::cout<<"\t\tname=\""<<this->identifier<<"\",\n\t\tbody=";
-    this->statement->print();
-    std::cout<<"\n\t)\n";
+    std::cout<<"\t\tname=\""<<this->identifier<<"\",\n";
+    if(this->internal){
+        std::cout<<"\t\tstatic,\n";
+    }
+    std::cout<<"\t\tparameters=[";
+    for(size_t i = 0; i < this->parameters.size(); i++){
+        std::cout<<(i ? ", " : "")<<this->parameters[i];
+    }
+    std::cout<<"],\n\t\tbody=[\n";
+    for(StatementNode* statement: this->body){
+        std::cout<<"\t\t";
+        statement->print();
+        std::cout<<"\n";
+    }
+    std::cout<<"\t\t]\n\t)\n";
 }
 std::string FunctionNode::getIdentifer(){
     return(this->identifier);
 }
-StatementNode* FunctionNode::getStatement(){
-    return(this->statement);
+const std::vector<std::string>& FunctionNode::getParameters(){
+    return(this->parameters);
+}
+const std::vector<StatementNode*>& FunctionNode::getBody(){
+    return(this->body);
+}
+bool FunctionNode::isInternal(){
+    return(this->internal);
 }
 
 // ======================================================
@@ -1,6 +1,7 @@
 #ifndef AST_H
 #define AST_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -10,10 +11,16 @@
 //                     Enums
 // ======================================================
 
-enum class ExpressionType { CONSTANT,UNARY };
-enum class StatementType  { RETURN };
-enum class UnaryOperator{Complement, Negation,Error};
+enum class ExpressionType { CONSTANT,UNARY,VARIABLE,ASSIGNMENT,BINARY,CONDITIONAL,FUNCTION_CALL };
+enum class StatementType  { RETURN, EXPRESSION, IF, COMPOUND, NULL_STATEMENT, DECLARATION, SWITCH, CASE, DEFAULT, BREAK };
+enum class UnaryOperator{Complement, Negation,Increment,Decrement,LogicalNot,Error};
+// LogicalRightShift only comes out of the instruction selector, C has no >>> (>> on an int is arithmetic).
+// The comparisons give 0 or 1, && and || are lowered to jumps (or selects) and never reach an instruction.
+enum class BinaryOperator{Add, Subtract, Multiply, Divide, Remainder, BitwiseAnd, BitwiseOr, BitwiseXor, LeftShift,
+    RightShift, LogicalRightShift, LessThan, LessOrEqual, GreaterThan, GreaterOrEqual, Equal, NotEqual, LogicalAnd,
+    LogicalOr, Comma};
 std::string unary_operator_to_string(UnaryOperator op);
+std::string binary_operator_to_string(BinaryOperator op);
 // ======================================================
 //                     ExpressionNode
 // ======================================================
@@ -21,12 +28,29 @@ class ExpressionNode {
     public:
         virtual void print() = 0;
         ExpressionType getType() const;
+        /**
+         * @brief The Sethi-Ullman label of the expression: how many temporaries must be live at once to
+         * evaluate it. Set by TackyGenerator::labelExpression.
+         *
+         * @return int
+         */
+        int getRegisterNeed() const;
+        void setRegisterNeed(int need);
+        /**
+         * @brief How many levels the recursive walks over the AST go below this node. The left operands of a chain
+         * of binary operators are walked in a loop, every other operand is one level down. Set by the constructors.
+         *
+         * @return int
+         */
+        int getNesting() const;
 
         virtual const std::string getValue() = 0;
     protected:
         ExpressionNode(ExpressionType t);
 
         ExpressionType type;
+        int registerNeed;
+        int nesting;
 };
 
 
@@ -116,6 +140,105 @@ class UnaryNode: public ExpressionNode{
          */
         const std::string getValue() override;
 };
+// ======================================================
+//                     BinaryNode:ExpressionNode
+// ======================================================
+// left op right, both operands are always evaluated
+class BinaryNode : public ExpressionNode {
+    private:
+        BinaryOperator binary_operator;
+        ExpressionNode* left;
+        ExpressionNode* right;
+
+    public:
+        BinaryNode(BinaryOperator binary_operator, ExpressionNode* left, ExpressionNode* right);
+
+        void print() override;
+        const std::string getValue() override;
+        BinaryOperator getBinaryOperator() const;
+        ExpressionNode* getLeft() const;
+        ExpressionNode* getRight() const;
+};
+// ======================================================
+//                     VariableNode:ExpressionNode
+// ======================================================
+// A read of a local variable
+class VariableNode : public ExpressionNode {
+    private:
+        /**
+         * @brief The name given by the Parser, unique within the function (i.e "var.x.0", see Parser::declareVariable)
+         *
+         */
+        std::string identifier;
+
+    public:
+        VariableNode(std::string identifier);
+
+        void print() override;
+        const std::string getValue() override;
+        std::string getIdentifier() const;
+};
+
+// ======================================================
+//                     AssignmentNode:ExpressionNode
+// ======================================================
+// variable = expression, its value is the value assigned
+class AssignmentNode : public ExpressionNode {
+    private:
+        VariableNode* variable;
+        ExpressionNode* exp;
+
+    public:
+        AssignmentNode(VariableNode* variable, ExpressionNode* exp);
+
+        void print() override;
+        const std::string getValue() override;
+        VariableNode* getVariable() const;
+        ExpressionNode* getExpression() const;
+};
+
+// ======================================================
+//                     ConditionalNode:ExpressionNode
+// ======================================================
+// condition ? then : otherwise, only one of the two branches is evaluated
+class ConditionalNode : public ExpressionNode {
+    private:
+        ExpressionNode* condition;
+        ExpressionNode* thenExpression;
+        ExpressionNode* elseExpression;
+
+    public:
+        ConditionalNode(ExpressionNode* condition, ExpressionNode* thenExpression, ExpressionNode* elseExpression);
+
+        void print() override;
+        const std::string getValue() override;
+        ExpressionNode* getCondition() const;
+        ExpressionNode* getThen() const;
+        ExpressionNode* getElse() const;
+};
+
+// ======================================================
+//                     FunctionCallNode:ExpressionNode
+// ======================================================
+// name(arguments...), the arguments are evaluated left to right before the call
+class FunctionCallNode : public ExpressionNode {
+    private:
+        /**
+         * @brief Name of the function called, as written in the source (functions aren't renamed)
+         *
+         */
+        std::string identifier;
+        std::vector<ExpressionNode*> arguments;
+
+    public:
+        FunctionCallNode(std::string identifier, std::vector<ExpressionNode*> arguments);
+
+        void print() override;
+        const std::string getValue() override;
+        std::string getIdentifier() const;
+        const std::vector<ExpressionNode*>& getArguments() const;
+};
+
 // ======================================================
 //                     StatementNode
 // ======================================================
@@ -132,7 +255,6 @@ public:
      * @return StatementType 
      */
     StatementType getType();
-    virtual const ExpressionNode* getExpression() const = 0;
 
 protected:
     StatementNode(StatementType t);
@@ -170,7 +292,176 @@ class ReturnNode : public StatementNode {
          * 
          * @return ExpressionNode* 
          */
-        ExpressionNode* getExpression() const override;
+        ExpressionNode* getExpression() const;
+};
+
+// ======================================================
+//                     ExpressionStatementNode:StatementNode
+// ======================================================
+// An expression evaluated for its side effects, its value is thrown away (i.e -5;)
+class ExpressionStatementNode : public StatementNode {
+    private:
+        ExpressionNode* exp;
+
+    public:
+        ExpressionStatementNode(ExpressionNode* exp);
+
+        void print() override;
+        ExpressionNode* getExpression() const;
+};
+
+// ======================================================
+//                     IfNode:StatementNode
+// ======================================================
+class IfNode : public StatementNode {
+    private:
+        /**
+         * @brief The then branch runs when the condition is not 0
+         *
+         */
+        ExpressionNode* condition;
+        StatementNode* thenStatement;
+        /**
+         * @brief nullptr when the if has no else
+         *
+         */
+        StatementNode* elseStatement;
+
+    public:
+        IfNode(ExpressionNode* condition, StatementNode* thenStatement, StatementNode* elseStatement);
+
+        void print() override;
+        ExpressionNode* getCondition() const;
+        StatementNode* getThen() const;
+        StatementNode* getElse() const;
+};
+
+// ======================================================
+//                     CompoundNode:StatementNode
+// ======================================================
+// A block of statements between braces
+class CompoundNode : public StatementNode {
+    private:
+        std::vector<StatementNode*> statements;
+
+    public:
+        CompoundNode(std::vector<StatementNode*> statements);
+
+        void print() override;
+        const std::vector<StatementNode*>& getStatements() const;
+};
+
+// ======================================================
+//                     NullNode:StatementNode
+// ======================================================
+// The empty statement (a lone ;)
+class NullNode : public StatementNode {
+    public:
+        NullNode();
+
+        void print() override;
+};
+
+// ======================================================
+//                     DeclarationNode:StatementNode
+// ======================================================
+// int x; or int x = expression; inside a block
+class DeclarationNode : public StatementNode {
+    private:
+        /**
+         * @brief The unique name of the variable, as in VariableNode
+         *
+         */
+        std::string identifier;
+        /**
+         * @brief nullptr when the variable is not initialized
+         *
+         */
+        ExpressionNode* init;
+
+    public:
+        DeclarationNode(std::string identifier, ExpressionNode* init);
+
+        void print() override;
+        std::string getIdentifier() const;
+        ExpressionNode* getInit() const;
+};
+
+
+// ======================================================
+//                     CaseNode:StatementNode
+// ======================================================
+// case value: statement, a label of the closest enclosing switch
+class CaseNode : public StatementNode {
+    private:
+        /**
+         * @brief The value of the constant expression of the label, already folded by the Parser
+         *
+         */
+        int32_t value;
+        StatementNode* statement;
+
+    public:
+        CaseNode(int32_t value, StatementNode* statement);
+
+        void print() override;
+        int32_t getValue() const;
+        StatementNode* getStatement() const;
+};
+
+// ======================================================
+//                     DefaultNode:StatementNode
+// ======================================================
+// default: statement, where the closest enclosing switch goes when no case matches
+class DefaultNode : public StatementNode {
+    private:
+        StatementNode* statement;
+
+    public:
+        explicit DefaultNode(StatementNode* statement);
+
+        void print() override;
+        StatementNode* getStatement() const;
+};
+
+// ======================================================
+//                     SwitchNode:StatementNode
+// ======================================================
+class SwitchNode : public StatementNode {
+    private:
+        ExpressionNode* exp;
+        StatementNode* body;
+        /**
+         * @brief The case labels of this switch wherever they are in the body (not those of a nested switch), in
+         * source order. The Parser checks that their values are unique.
+         *
+         */
+        std::vector<CaseNode*> cases;
+        /**
+         * @brief nullptr when the switch has no default, a value matching no case then skips the body
+         *
+         */
+        DefaultNode* defaultCase;
+
+    public:
+        SwitchNode(ExpressionNode* exp, StatementNode* body, std::vector<CaseNode*> cases, DefaultNode* defaultCase);
+
+        void print() override;
+        ExpressionNode* getExpression() const;
+        StatementNode* getBody() const;
+        const std::vector<CaseNode*>& getCases() const;
+        DefaultNode* getDefault() const;
+};
+
+// ======================================================
+//                     BreakNode:StatementNode
+// ======================================================
+// break; leaves the closest enclosing switch
+class BreakNode : public StatementNode {
+    public:
+        BreakNode();
+
+        void print() override;
 };
 
 
@@ -185,19 +476,31 @@ private:
      */
     std::string identifier;
     /**
-     * @brief The statement of the function. So far only supports one statement
+     * @brief The unique names of the parameters, in order (i.e "var.a.0", see Parser::declareVariable)
+     *
+     */
+    std::vector<std::string> parameters;
+    /**
+     * @brief The statements of the function body, in source order.
      * A statement is an operation that does something.
      */
-    StatementNode* statement;
+    std::vector<StatementNode*> body;
+    /**
+     * @brief Declared static, the function can't be called from other files and isn't emitted as a global symbol
+     *
+     */
+    bool internal;
 
 public:
     /**
      * @brief Construct a new Function Node object
      * 
      * @param identifier 
-     * @param statement 
+     * @param parameters 
+     * @param body 
+     * @param internal 
      */
-    FunctionNode(std::string identifier, StatementNode* statement);
+    FunctionNode(std::string identifier, std::vector<std::string> parameters, std::vector<StatementNode*> body, bool internal);
 
     void print();
     /**
@@ -207,11 +510,18 @@ public:
      */
     std::string getIdentifer();
     /**
-     * @brief Get the Statement object
+     * @brief Get the Parameters object
+     * 
+     * @return const std::vector<std::string>& 
+     */
+    const std::vector<std::string>& getParameters();
+    /**
+     * @brief Get the Body object
      * 
-     * @return StatementNode* 
+     * @return const std::vector<StatementNode*>& 
      */
-    StatementNode* getStatement();
+    const std::vector<StatementNode*>& getBody();
+    bool isInternal();
 };
 
 
@@ -1,5 +1,9 @@
 #include "Assembly.hpp"
+#include "Optimizer.hpp"
+#include "InstructionSelector.hpp"
+#include "Profile.hpp"
 #include <iostream>
+#include <sstream>
 #include<limits.h>
 
 // ======================================================
@@ -30,8 +34,7 @@ void ImmediateNode::print() {
     std::cout << value;
 }
 
-void ImmediateNode::filePrint(std::ofstream& assemblyFile) {
-    std::cout << "$" << value;
+void ImmediateNode::filePrint(std::ostream& assemblyFile) {
     assemblyFile << "$" << value;
 }
 
@@ -52,11 +55,46 @@ RegisterName RegisterNode::getRegEnum(void) const {
 std::string RegisterNode::getRegStr(void) const{
     switch (this->reg){
         case RegisterName::AX: return "eax";
+        case RegisterName::CX: return "ecx";
+        case RegisterName::DX: return "edx";
+        case RegisterName::SI: return "esi";
+        case RegisterName::DI: return "edi";
+        case RegisterName::R8: return "r8d";
+        case RegisterName::R9: return "r9d";
         case RegisterName::R10: return "r10d";
+        case RegisterName::R11: return "r11d";
         default: return "UNKOWN";
     }
 
 }
+std::string RegisterNode::getRegStr64(void) const{
+    switch (this->reg){
+        case RegisterName::AX: return "rax";
+        case RegisterName::CX: return "rcx";
+        case RegisterName::DX: return "rdx";
+        case RegisterName::SI: return "rsi";
+        case RegisterName::DI: return "rdi";
+        case RegisterName::R8: return "r8";
+        case RegisterName::R9: return "r9";
+        case RegisterName::R10: return "r10";
+        case RegisterName::R11: return "r11";
+        default: return "UNKOWN";
+    }
+}
+std::string RegisterNode::getRegStr8(void) const{
+    switch (this->reg){
+        case RegisterName::AX: return "al";
+        case RegisterName::CX: return "cl";
+        case RegisterName::DX: return "dl";
+        case RegisterName::SI: return "sil";
+        case RegisterName::DI: return "dil";
+        case RegisterName::R8: return "r8b";
+        case RegisterName::R9: return "r9b";
+        case RegisterName::R10: return "r10b";
+        case RegisterName::R11: return "r11b";
+        default: return "UNKOWN";
+    }
+}
 OperandType RegisterNode::getType(void) {
     return this->type;
 }
@@ -65,8 +103,7 @@ void RegisterNode::print() {
     std::cout << getRegStr();
 }
 
-void RegisterNode::filePrint(std::ofstream& assemblyFile) {
-    std::cout << "%" << getRegStr();
+void RegisterNode::filePrint(std::ostream& assemblyFile) {
     assemblyFile<<"%"<<getRegStr();
 
 }
@@ -90,8 +127,8 @@ void Pseudo::print(){
     std::cout<<identifier;
 }
 
-void Pseudo::filePrint(std::ofstream& assemblyFile){
-    std::cout<<identifier;
+void Pseudo::filePrint(std::ostream& assemblyFile){
+    assemblyFile<<identifier;
 }
 void Pseudo::prettyPrint(int indentLevel) const {
     indent(indentLevel);
@@ -102,23 +139,34 @@ void Pseudo::prettyPrint(int indentLevel) const {
 //                     Stack:OperandNode
 // ======================================================
 
-Stack::Stack(int amount):OperandNode(STACK), amount(amount){}
+Stack::Stack(int amount, FrameBase base):OperandNode(STACK), amount(amount), base(base){}
 
 int Stack::getAmount(){
     return this->amount;
 }
 
+FrameBase Stack::getBase(){
+    return this->base;
+}
+
+void Stack::setAmount(int newAmount){
+    this->amount = newAmount;
+}
+
+void Stack::setBase(FrameBase newBase){
+    this->base = newBase;
+}
+
 OperandType Stack::getType(void){
     return this->type;
 }
 
 void Stack::print(){
-    std::cout << amount << "(%rbp)";
+    std::cout << amount << (base == FrameBase::RBP ? "(%rbp)" : "(%rsp)");
 }
 
-void Stack::filePrint(std::ofstream& assemblyFile){
-    std::cout << amount << "(%rbp)";
-    assemblyFile << amount << "(%rbp)";
+void Stack::filePrint(std::ostream& assemblyFile){
+    assemblyFile << amount << (base == FrameBase::RBP ? "(%rbp)" : "(%rsp)");
 }
 
 void Stack::prettyPrint(int indentLevel) const {
@@ -159,20 +207,17 @@ void MoveInstruction::print() {
     std::cout << ")\n";
 }
 
-void MoveInstruction::filePrint(std::ofstream& assemblyFile) {
+void MoveInstruction::filePrint(std::ostream& assemblyFile) {
 
     
-    std::cout << "movl ";
     assemblyFile << "movl ";
 
 
 
 
     src->filePrint(assemblyFile);
-    std::cout << ", ";
     assemblyFile << ", ";
     dst->filePrint(assemblyFile);
-    std::cout << '\n';
     assemblyFile << '\n';
 }
 
@@ -200,7 +245,15 @@ void MoveInstruction::prettyPrint(int indentLevel) const {
 // ======================================================
 
 IRReturnNode::IRReturnNode()
-    : InstructionNode(RET){}
+    : InstructionNode(RET), restoresFrame(true){}
+
+bool IRReturnNode::getRestoresFrame(){
+    return(this->restoresFrame);
+}
+
+void IRReturnNode::setRestoresFrame(bool restores){
+    this->restoresFrame = restores;
+}
 
 // std::string IRReturnNode::getReg(void) {
 //     return this->reg;
@@ -210,13 +263,14 @@ void IRReturnNode::print() {
     std::cout << "\t\t\tret\n";
 }
 
-void IRReturnNode::filePrint(std::ofstream& assemblyFile) {
-    std::cout << "movq %rbp, %rsp\n";
-    std::cout << "\tpopq %rbp\n";
-    std::cout << "\tret\n";
-    assemblyFile << "movq %rbp, %rsp\n";
-    assemblyFile << "\tpopq %rbp\n";
-    assemblyFile << "\tret\n";
+void IRReturnNode::filePrint(std::ostream& assemblyFile) {
+    if(restoresFrame){
+        assemblyFile << "movq %rbp, %rsp\n";
+        assemblyFile << "\tpopq %rbp\n";
+        assemblyFile << "\t.cfi_def_cfa %rsp, 8\n";
+        assemblyFile << "\t";
+    }
+    assemblyFile << "ret\n";
 }
 
 
@@ -250,6 +304,12 @@ void UnaryInstruction::print(){
         case UnaryOperator::Negation:
             opStr = "negl";
             break;
+        case UnaryOperator::Increment:
+            opStr = "incl";
+            break;
+        case UnaryOperator::Decrement:
+            opStr = "decl";
+            break;
         default:
             opStr = "unknown_unary";
     }
@@ -259,7 +319,7 @@ void UnaryInstruction::print(){
     std::cout << "\n";
 
 }
-void UnaryInstruction::filePrint(std::ofstream& assemblyFile) {
+void UnaryInstruction::filePrint(std::ostream& assemblyFile) {
     std::string opStr;
     switch (unary_operator) {
         case UnaryOperator::Complement:
@@ -268,16 +328,20 @@ void UnaryInstruction::filePrint(std::ofstream& assemblyFile) {
         case UnaryOperator::Negation:
             opStr = "negl";
             break;
+        case UnaryOperator::Increment:
+            opStr = "incl";
+            break;
+        case UnaryOperator::Decrement:
+            opStr = "decl";
+            break;
         default:
             opStr = "unknown_unary";
     }
 
-    std::cout << opStr << " ";
     assemblyFile << opStr << " ";
 
     operand->filePrint(assemblyFile);
 
-    std::cout << "\n";
     assemblyFile << "\n";
 }
 
@@ -287,11 +351,576 @@ void UnaryInstruction::prettyPrint(int indentLevel) const {
     switch (unary_operator) {
         case UnaryOperator::Negation: std::cout << "Neg"; break;
         case UnaryOperator::Complement: std::cout << "Not"; break;
+        case UnaryOperator::Increment: std::cout << "Inc"; break;
+        case UnaryOperator::Decrement: std::cout << "Dec"; break;
         default: std::cout << "Unknown"; break;
     }
     std::cout << ")\n";
     operand->prettyPrint(indentLevel + 1);
 }
+// ======================================================
+//                     BinaryInstruction:InstructionNode
+// ======================================================
+
+BinaryInstruction::BinaryInstruction(BinaryOperator binary_operator, OperandNode* src, OperandNode* dst)
+    : InstructionNode(BINARY), binary_operator(binary_operator), src(src), dst(dst) {}
+
+BinaryOperator BinaryInstruction::getBinaryOperator(){
+    return(this->binary_operator);
+}
+
+OperandNode* BinaryInstruction::getSrc(void){
+    return(this->src);
+}
+
+OperandNode* BinaryInstruction::getDst(void){
+    return(this->dst);
+}
+
+void BinaryInstruction::setSrc(OperandNode* newSrc){
+    this->src = newSrc;
+}
+
+void BinaryInstruction::setDst(OperandNode* newDst){
+    this->dst = newDst;
+}
+
+static std::string binaryMnemonic(BinaryOperator op){
+    switch (op) {
+        case BinaryOperator::Add: return "addl";
+        case BinaryOperator::Subtract: return "subl";
+        case BinaryOperator::Multiply: return "imull";
+        case BinaryOperator::BitwiseAnd: return "andl";
+        case BinaryOperator::BitwiseOr: return "orl";
+        case BinaryOperator::BitwiseXor: return "xorl";
+        case BinaryOperator::LeftShift: return "sall";
+        case BinaryOperator::RightShift: return "sarl";
+        case BinaryOperator::LogicalRightShift: return "shrl";
+        default:
+            // idivl is an instruction of its own (see IdivInstruction), the rest never reach the assembly
+            break;
+    }
+    return "unknown_binary";
+}
+
+static bool is_shift(BinaryOperator op){
+    return(op == BinaryOperator::LeftShift || op == BinaryOperator::RightShift || op == BinaryOperator::LogicalRightShift);
+}
+
+void BinaryInstruction::print(){
+    std::cout << binaryMnemonic(binary_operator) << " ";
+    if(is_shift(binary_operator) && src->getType() == REG){
+        std::cout << static_cast<RegisterNode*>(src)->getRegStr8();
+    }else{
+        src->print();
+    }
+    std::cout << ", ";
+    dst->print();
+    std::cout << "\n";
+}
+
+void BinaryInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << binaryMnemonic(binary_operator) << " ";
+    if(is_shift(binary_operator) && src->getType() == REG){
+        // a shift count in a register is always %cl
+        assemblyFile << "%" << static_cast<RegisterNode*>(src)->getRegStr8();
+    }else{
+        src->filePrint(assemblyFile);
+    }
+    assemblyFile << ", ";
+    dst->filePrint(assemblyFile);
+    assemblyFile << "\n";
+}
+
+void BinaryInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "BinaryInstruction(op=" << binary_operator_to_string(binary_operator) << ")\n";
+    src->prettyPrint(indentLevel + 1);
+    dst->prettyPrint(indentLevel + 1);
+}
+
+// ======================================================
+//                     LeaInstruction:InstructionNode
+// ======================================================
+
+LeaInstruction::LeaInstruction(RegisterNode* base, int displacement, RegisterNode* dst)
+    : InstructionNode(LEA), base(base), index(nullptr), scale(1), displacement(displacement), dst(dst) {}
+
+LeaInstruction::LeaInstruction(RegisterNode* base, RegisterNode* index, int scale, int displacement, RegisterNode* dst)
+    : InstructionNode(LEA), base(base), index(index), scale(scale), displacement(displacement), dst(dst) {}
+
+RegisterNode* LeaInstruction::getBase(void){
+    return(this->base);
+}
+
+RegisterNode* LeaInstruction::getIndex(void){
+    return(this->index);
+}
+
+int LeaInstruction::getScale(void){
+    return(this->scale);
+}
+
+int LeaInstruction::getDisplacement(void){
+    return(this->displacement);
+}
+
+RegisterNode* LeaInstruction::getDst(void){
+    return(this->dst);
+}
+
+void LeaInstruction::print(){
+    std::cout << "leal " << displacement << "(" << base->getRegStr64();
+    if(index != nullptr){
+        std::cout << ", " << index->getRegStr64() << ", " << scale;
+    }
+    std::cout << "), " << dst->getRegStr() << "\n";
+}
+
+void LeaInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "leal " << displacement << "(%" << base->getRegStr64();
+    if(index != nullptr){
+        assemblyFile << ", %" << index->getRegStr64() << ", " << scale;
+    }
+    assemblyFile << "), %" << dst->getRegStr() << "\n";
+}
+
+void LeaInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "LeaInstruction(disp=" << displacement << ", scale=" << scale << ")\n";
+    base->prettyPrint(indentLevel + 1);
+    if(index != nullptr){
+        index->prettyPrint(indentLevel + 1);
+    }
+    dst->prettyPrint(indentLevel + 1);
+}
+// ======================================================
+//                     CdqInstruction:InstructionNode
+// ======================================================
+
+CdqInstruction::CdqInstruction() : InstructionNode(CDQ) {}
+
+void CdqInstruction::print(){
+    std::cout << "cltd\n";
+}
+
+void CdqInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "cltd\n";
+}
+
+void CdqInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "CdqInstruction()\n";
+}
+
+// ======================================================
+//                     IdivInstruction:InstructionNode
+// ======================================================
+
+IdivInstruction::IdivInstruction(OperandNode* operand) : InstructionNode(IDIV), operand(operand) {}
+
+OperandNode* IdivInstruction::getOperand(void){
+    return(this->operand);
+}
+
+void IdivInstruction::setOperand(OperandNode* newOp){
+    this->operand = newOp;
+}
+
+void IdivInstruction::print(){
+    std::cout << "idivl ";
+    operand->print();
+    std::cout << "\n";
+}
+
+void IdivInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "idivl ";
+    operand->filePrint(assemblyFile);
+    assemblyFile << "\n";
+}
+
+void IdivInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "IdivInstruction()\n";
+    operand->prettyPrint(indentLevel + 1);
+}
+
+// ======================================================
+//                     MultiplyHighInstruction:InstructionNode
+// ======================================================
+
+MultiplyHighInstruction::MultiplyHighInstruction(int32_t magic, int shift, RegisterNode* src, RegisterNode* dst)
+    : InstructionNode(MULHI), magic(magic), shift(shift), src(src), dst(dst) {}
+
+int32_t MultiplyHighInstruction::getMagic(void){
+    return(this->magic);
+}
+
+int MultiplyHighInstruction::getShift(void){
+    return(this->shift);
+}
+
+RegisterNode* MultiplyHighInstruction::getSrc(void){
+    return(this->src);
+}
+
+RegisterNode* MultiplyHighInstruction::getDst(void){
+    return(this->dst);
+}
+
+void MultiplyHighInstruction::print(){
+    std::cout << "movslq " << src->getRegStr() << ", " << dst->getRegStr64() << "\n";
+    std::cout << "imulq $" << magic << ", " << dst->getRegStr64() << ", " << dst->getRegStr64() << "\n";
+    std::cout << "sarq $" << 32 + shift << ", " << dst->getRegStr64() << "\n";
+}
+
+void MultiplyHighInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "movslq %" << src->getRegStr() << ", %" << dst->getRegStr64() << "\n";
+    assemblyFile << "\timulq $" << magic << ", %" << dst->getRegStr64() << ", %" << dst->getRegStr64() << "\n";
+    assemblyFile << "\tsarq $" << 32 + shift << ", %" << dst->getRegStr64() << "\n";
+}
+
+void MultiplyHighInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "MultiplyHighInstruction(magic=" << magic << ", shift=" << shift << ")\n";
+    src->prettyPrint(indentLevel + 1);
+    dst->prettyPrint(indentLevel + 1);
+}
+
+// ======================================================
+//                     CompareInstruction:InstructionNode
+// ======================================================
+
+CompareInstruction::CompareInstruction(OperandNode* src, OperandNode* dst)
+    : InstructionNode(CMP), src(src), dst(dst) {}
+
+OperandNode* CompareInstruction::getSrc(void){
+    return(this->src);
+}
+
+OperandNode* CompareInstruction::getDst(void){
+    return(this->dst);
+}
+
+void CompareInstruction::setSrc(OperandNode* newSrc){
+    this->src = newSrc;
+}
+
+void CompareInstruction::setDst(OperandNode* newDst){
+    this->dst = newDst;
+}
+
+void CompareInstruction::print(){
+    std::cout << "cmpl ";
+    src->print();
+    std::cout << ", ";
+    dst->print();
+    std::cout << "\n";
+}
+
+void CompareInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "cmpl ";
+    src->filePrint(assemblyFile);
+    assemblyFile << ", ";
+    dst->filePrint(assemblyFile);
+    assemblyFile << "\n";
+}
+
+void CompareInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "CompareInstruction()\n";
+    src->prettyPrint(indentLevel + 1);
+    dst->prettyPrint(indentLevel + 1);
+}
+
+// ======================================================
+//                     JumpInstruction:InstructionNode
+// ======================================================
+
+JumpInstruction::JumpInstruction(std::string target):InstructionNode(JMP), target(target){}
+
+std::string JumpInstruction::getTarget(void){
+    return(this->target);
+}
+
+void JumpInstruction::print(){
+    std::cout << "jmp " << target << "\n";
+}
+
+void JumpInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "jmp " << target << "\n";
+}
+
+void JumpInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "JumpInstruction(" << target << ")\n";
+}
+
+// ======================================================
+//                     ConditionalJumpInstruction:InstructionNode
+// ======================================================
+
+ConditionalJumpInstruction::ConditionalJumpInstruction(ConditionCode condition, std::string target)
+    : InstructionNode(JMPCC), condition(condition), target(target){}
+
+ConditionCode ConditionalJumpInstruction::getCondition(void){
+    return(this->condition);
+}
+
+std::string ConditionalJumpInstruction::getTarget(void){
+    return(this->target);
+}
+
+// Helper giving the suffix of the jcc, setcc and cmovcc mnemonics
+static std::string conditionSuffix(ConditionCode condition){
+    switch(condition){
+        case ConditionCode::E: return "e";
+        case ConditionCode::NE: return "ne";
+        case ConditionCode::L: return "l";
+        case ConditionCode::LE: return "le";
+        case ConditionCode::G: return "g";
+        case ConditionCode::GE: return "ge";
+        case ConditionCode::B: return "b";
+        case ConditionCode::BE: return "be";
+        case ConditionCode::A: return "a";
+        case ConditionCode::AE: return "ae";
+    }
+    return "unknown_cc";
+}
+
+ConditionCode negate_condition(ConditionCode condition){
+    switch(condition){
+        case ConditionCode::E: return ConditionCode::NE;
+        case ConditionCode::NE: return ConditionCode::E;
+        case ConditionCode::L: return ConditionCode::GE;
+        case ConditionCode::LE: return ConditionCode::G;
+        case ConditionCode::G: return ConditionCode::LE;
+        case ConditionCode::GE: return ConditionCode::L;
+        case ConditionCode::B: return ConditionCode::AE;
+        case ConditionCode::BE: return ConditionCode::A;
+        case ConditionCode::A: return ConditionCode::BE;
+        case ConditionCode::AE: return ConditionCode::B;
+    }
+    return condition;
+}
+
+ConditionCode swap_condition(ConditionCode condition){
+    switch(condition){
+        case ConditionCode::L: return ConditionCode::G;
+        case ConditionCode::LE: return ConditionCode::GE;
+        case ConditionCode::G: return ConditionCode::L;
+        case ConditionCode::GE: return ConditionCode::LE;
+        case ConditionCode::B: return ConditionCode::A;
+        case ConditionCode::BE: return ConditionCode::AE;
+        case ConditionCode::A: return ConditionCode::B;
+        case ConditionCode::AE: return ConditionCode::BE;
+        default: return condition;
+    }
+}
+
+void ConditionalJumpInstruction::print(){
+    std::cout << "j" << conditionSuffix(condition) << " " << target << "\n";
+}
+
+void ConditionalJumpInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "j" << conditionSuffix(condition) << " " << target << "\n";
+}
+
+void ConditionalJumpInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "ConditionalJumpInstruction(j" << conditionSuffix(condition) << ", " << target << ")\n";
+}
+
+// ======================================================
+//                     JumpTableInstruction:InstructionNode
+// ======================================================
+
+JumpTableInstruction::JumpTableInstruction(RegisterNode* index, RegisterNode* scratch, std::string table, std::vector<std::string> targets, std::string base)
+    : InstructionNode(JMPTABLE), index(index), scratch(scratch), table(table), targets(targets), base(base){}
+
+RegisterNode* JumpTableInstruction::getIndex(void){
+    return(this->index);
+}
+
+RegisterNode* JumpTableInstruction::getScratch(void){
+    return(this->scratch);
+}
+
+std::string JumpTableInstruction::getTable(void){
+    return(this->table);
+}
+
+const std::vector<std::string>& JumpTableInstruction::getTargets(void){
+    return(this->targets);
+}
+
+std::string JumpTableInstruction::getBase(void){
+    return(this->base);
+}
+
+void JumpTableInstruction::print(){
+    this->filePrint(std::cout);
+}
+
+void JumpTableInstruction::filePrint(std::ostream& assemblyFile){
+    std::string index64 = "%" + this->index->getRegStr64();
+    std::string scratch64 = "%" + this->scratch->getRegStr64();
+    assemblyFile << "leaq " << table << "(%rip), " << scratch64 << "\n";
+    assemblyFile << "\tmovslq (" << scratch64 << "," << index64 << ",4), " << index64 << "\n";
+    assemblyFile << "\tleaq " << base << "(%rip), " << scratch64 << "\n";
+    assemblyFile << "\taddq " << scratch64 << ", " << index64 << "\n";
+    assemblyFile << "\tjmp *" << index64 << "\n";
+    // the entries are differences of labels of the same section, the assembler resolves them
+    assemblyFile << "\t.pushsection .rodata\n";
+    assemblyFile << "\t.p2align 2\n";
+    assemblyFile << table << ":\n";
+    for(const std::string& target: targets){
+        assemblyFile << "\t.long " << target << "-" << base << "\n";
+    }
+    assemblyFile << "\t.popsection\n";
+}
+
+void JumpTableInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "JumpTableInstruction(" << table << ", base=" << base << ", targets=[";
+    for(size_t i = 0; i < targets.size(); i++){
+        std::cout << (i == 0 ? "" : ", ") << targets[i];
+    }
+    std::cout << "])\n";
+}
+
+// ======================================================
+//                     SetConditionInstruction:InstructionNode
+// ======================================================
+
+SetConditionInstruction::SetConditionInstruction(ConditionCode condition, RegisterNode* dst)
+    : InstructionNode(SETCC), condition(condition), dst(dst){}
+
+ConditionCode SetConditionInstruction::getCondition(void){
+    return(this->condition);
+}
+
+RegisterNode* SetConditionInstruction::getDst(void){
+    return(this->dst);
+}
+
+void SetConditionInstruction::print(){
+    std::cout << "set" << conditionSuffix(condition) << " " << dst->getRegStr8() << "\n";
+}
+
+void SetConditionInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "set" << conditionSuffix(condition) << " %" << dst->getRegStr8() << "\n";
+}
+
+void SetConditionInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "SetConditionInstruction(set" << conditionSuffix(condition) << ")\n";
+    dst->prettyPrint(indentLevel + 1);
+}
+
+// ======================================================
+//                     MoveZeroExtendInstruction:InstructionNode
+// ======================================================
+
+MoveZeroExtendInstruction::MoveZeroExtendInstruction(RegisterNode* src, RegisterNode* dst)
+    : InstructionNode(MOVZX), src(src), dst(dst){}
+
+RegisterNode* MoveZeroExtendInstruction::getSrc(void){
+    return(this->src);
+}
+
+RegisterNode* MoveZeroExtendInstruction::getDst(void){
+    return(this->dst);
+}
+
+void MoveZeroExtendInstruction::print(){
+    std::cout << "movzbl " << src->getRegStr8() << ", ";
+    dst->print();
+    std::cout << "\n";
+}
+
+void MoveZeroExtendInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "movzbl %" << src->getRegStr8() << ", ";
+    dst->filePrint(assemblyFile);
+    assemblyFile << "\n";
+}
+
+void MoveZeroExtendInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "MoveZeroExtendInstruction()\n";
+    src->prettyPrint(indentLevel + 1);
+    dst->prettyPrint(indentLevel + 1);
+}
+
+// ======================================================
+//                     ConditionalMoveInstruction:InstructionNode
+// ======================================================
+
+ConditionalMoveInstruction::ConditionalMoveInstruction(ConditionCode condition, OperandNode* src, RegisterNode* dst)
+    : InstructionNode(CMOV), condition(condition), src(src), dst(dst){}
+
+ConditionCode ConditionalMoveInstruction::getCondition(void){
+    return(this->condition);
+}
+
+OperandNode* ConditionalMoveInstruction::getSrc(void){
+    return(this->src);
+}
+
+RegisterNode* ConditionalMoveInstruction::getDst(void){
+    return(this->dst);
+}
+
+void ConditionalMoveInstruction::setSrc(OperandNode* newSrc){
+    this->src = newSrc;
+}
+
+void ConditionalMoveInstruction::print(){
+    std::cout << "cmov" << conditionSuffix(condition) << "l ";
+    src->print();
+    std::cout << ", ";
+    dst->print();
+    std::cout << "\n";
+}
+
+void ConditionalMoveInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "cmov" << conditionSuffix(condition) << "l ";
+    src->filePrint(assemblyFile);
+    assemblyFile << ", ";
+    dst->filePrint(assemblyFile);
+    assemblyFile << "\n";
+}
+
+void ConditionalMoveInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "ConditionalMoveInstruction(cmov" << conditionSuffix(condition) << ")\n";
+    src->prettyPrint(indentLevel + 1);
+    dst->prettyPrint(indentLevel + 1);
+}
+
+// ======================================================
+//                     LabelInstruction:InstructionNode
+// ======================================================
+
+LabelInstruction::LabelInstruction(std::string name):InstructionNode(LABEL), name(name){}
+
+std::string LabelInstruction::getName(void){
+    return(this->name);
+}
+
+void LabelInstruction::print(){
+    std::cout << name << ":\n";
+}
+
+void LabelInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << name << ":\n";
+}
+
+void LabelInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "Label(" << name << ")\n";
+}
+
 // ======================================================
 //                     AllocateStack:InstructionNode
 // ======================================================
@@ -314,17 +943,130 @@ void AllocateStack::print(){
     std::cout<<"AllocateStack(bytes=" << amount << ")\n";
 }
 
-void AllocateStack::filePrint(std::ofstream& assemblyFile){
-    std::cout<<"subq $"<<this->amount<<", %rsp\n";
+void AllocateStack::filePrint(std::ostream& assemblyFile){
     assemblyFile<<"subq $"<<this->amount<<", %rsp\n";
 }
 
+// ======================================================
+//                     PushInstruction:InstructionNode
+// ======================================================
+
+PushInstruction::PushInstruction(OperandNode* operand):InstructionNode(PUSH), operand(operand){}
+
+OperandNode* PushInstruction::getOperand(void){
+    return(this->operand);
+}
+
+void PushInstruction::print(){
+    std::cout << "pushq ";
+    this->operand->print();
+    std::cout << "\n";
+}
+
+void PushInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "pushq ";
+    if(RegisterNode* reg = dynamic_cast<RegisterNode*>(this->operand)){
+        assemblyFile << "%" << reg->getRegStr64();
+    }else{
+        this->operand->filePrint(assemblyFile);
+    }
+    assemblyFile << "\n";
+}
+
+void PushInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "PushInstruction(\n";
+    this->operand->prettyPrint(indentLevel + 1);
+    indent(indentLevel);
+    std::cout << ")\n";
+}
+
+// ======================================================
+//                     CallInstruction:InstructionNode
+// ======================================================
+
+CallInstruction::CallInstruction(std::string name, int registerArguments)
+    : InstructionNode(CALL), name(name), registerArguments(registerArguments){}
+
+std::string CallInstruction::getName(void){
+    return(this->name);
+}
+
+int CallInstruction::getRegisterArguments(void){
+    return(this->registerArguments);
+}
+
+const std::vector<RegisterName>& CallInstruction::argumentRegisters(){
+    static const std::vector<RegisterName> registers = {
+        RegisterName::DI, RegisterName::SI, RegisterName::DX, RegisterName::CX, RegisterName::R8, RegisterName::R9
+    };
+    return(registers);
+}
+
+void CallInstruction::print(){
+    std::cout << "call " << this->name << "\n";
+}
+
+void CallInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "call " << this->name << "\n";
+}
+
+void CallInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "CallInstruction(" << this->name << ", registers=" << this->registerArguments << ")\n";
+}
+
+// ======================================================
+//                     DeallocateStack:InstructionNode
+// ======================================================
+
+DeallocateStack::DeallocateStack(int amount):InstructionNode(DEALLOCATE), amount(amount){}
+
+int DeallocateStack::getAmount(void){
+    return(this->amount);
+}
+
+void DeallocateStack::print(){
+    std::cout << "DeallocateStack(bytes=" << this->amount << ")\n";
+}
+
+void DeallocateStack::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "addq $" << this->amount << ", %rsp\n";
+}
+
+void DeallocateStack::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "DeallocateStack(bytes=" << this->amount << ")\n";
+}
+
+// ======================================================
+//                     ProfileCounterInstruction
+// ======================================================
+ProfileCounterInstruction::ProfileCounterInstruction(size_t index):InstructionNode(PROFILE), index(index){}
+
+size_t ProfileCounterInstruction::getIndex(void){
+    return(this->index);
+}
+
+void ProfileCounterInstruction::print(){
+    std::cout << "incq counter " << this->index << "\n";
+}
+
+void ProfileCounterInstruction::filePrint(std::ostream& assemblyFile){
+    assemblyFile << "incq " << Profile::COUNTERS_LABEL << "+" << 8 * this->index << "(%rip)\n";
+}
+
+void ProfileCounterInstruction::prettyPrint(int indentLevel) const {
+    indent(indentLevel);
+    std::cout << "ProfileCounterInstruction(index=" << index << ")\n";
+}
+
 // ======================================================
 //                     IRFunctionNode
 // ======================================================
 
 IRFunctionNode::IRFunctionNode(std::string identifier, std::vector<InstructionNode*> instr)
-    : identifier(identifier), instructions(instr) {}
+    : identifier(identifier), instructions(instr), framePointer(true), global(true) {}
 
 const std::string IRFunctionNode::getIdentifier(void) {
     return this->identifier;
@@ -334,6 +1076,26 @@ std::vector<InstructionNode*> IRFunctionNode::getInstructions(void) {
     return this->instructions;
 }
 
+void IRFunctionNode::setInstructions(std::vector<InstructionNode*> instr) {
+    this->instructions = instr;
+}
+
+bool IRFunctionNode::hasFramePointer(void) {
+    return this->framePointer;
+}
+
+void IRFunctionNode::setFramePointer(bool framePointer) {
+    this->framePointer = framePointer;
+}
+
+bool IRFunctionNode::isGlobal(void) {
+    return this->global;
+}
+
+void IRFunctionNode::setGlobal(bool global) {
+    this->global = global;
+}
+
 void IRFunctionNode::print() {
     std::cout << "\tFunction(\n";
     std::cout << "\t\tname=" << this->identifier << '\n';
@@ -345,18 +1107,41 @@ void IRFunctionNode::print() {
     std::cout << "\t)\n";
 }
 
-void IRFunctionNode::filePrint(std::ofstream& assemblyFile) {
-    std::cout << "\t.global " << identifier << "\n";
-    assemblyFile << "\t.global " << identifier << "\n";
-    std::cout << identifier << ":\n";
+void IRFunctionNode::filePrint(std::ostream& assemblyFile) {
+    assemblyFile << "\t.p2align 4\n";
+    if(global){
+        assemblyFile << "\t.global " << identifier << "\n";
+    }
+    assemblyFile << "\t.type " << identifier << ", @function\n";
     assemblyFile<< identifier << ":\n";
+    assemblyFile << "\t.cfi_startproc\n";
+    if(framePointer){
+        assemblyFile << "\tpushq %rbp\n";
+        assemblyFile << "\t.cfi_def_cfa_offset 16\n";
+        assemblyFile << "\t.cfi_offset %rbp, -16\n";
+        assemblyFile << "\tmovq %rsp, %rbp\n";
+        assemblyFile << "\t.cfi_def_cfa_register %rbp\n";
+    }
 
-    for (InstructionNode* i : instructions) {
-        assemblyFile << "\t";
-        std::cout << "\t";
+    for (size_t index = 0; index < instructions.size(); index++) {
+        InstructionNode* i = instructions[index];
+        // the code after a return that tears down the frame still runs with the %rbp frame
+        IRReturnNode* ret = dynamic_cast<IRReturnNode*>(i);
+        bool reentered = ret != nullptr && ret->getRestoresFrame() && index + 1 < instructions.size();
+        if(reentered){
+            assemblyFile << "\t.cfi_remember_state\n";
+        }
+        if(i->getType() != LABEL){
+            assemblyFile << "\t";
+        }
 
         i->filePrint(assemblyFile);
+        if(reentered){
+            assemblyFile << "\t.cfi_restore_state\n";
+        }
     }
+    assemblyFile << "\t.cfi_endproc\n";
+    assemblyFile << "\t.size " << identifier << ", .-" << identifier << "\n";
 }
 
 void IRFunctionNode::prettyPrint(int indentLevel) const {
@@ -385,14 +1170,16 @@ void IRProgramNode::print() {
     std::cout << ")\n";
 }
 
-void IRProgramNode::filePrint(std::ofstream& assemblyFile) {
+void IRProgramNode::filePrint(std::ostream& assemblyFile) {
     // std::cout<<"HERE\n";
     for (IRFunctionNode* f : functions) {
         f->filePrint(assemblyFile);
-        std::cout << '\n';
         assemblyFile<<'\n';
     }
-    std::cout << ".section .note.GNU-stack,\"\",@progbits\n";
+    filePrintEpilogue(assemblyFile);
+}
+
+void IRProgramNode::filePrintEpilogue(std::ostream& assemblyFile) {
     assemblyFile<< ".section .note.GNU-stack,\"\",@progbits\n";
 }
 
@@ -415,84 +1202,39 @@ IRTree::IRTree(AST ast)
 IRTree::IRTree(){}
 
 
-std::vector<InstructionNode*> IRTree::traverseTackyInstructions(std::vector<TackyInstruction*> instructions){
+std::vector<InstructionNode*> IRTree::traverseTackyInstructions(std::vector<TackyInstruction*> instructions, const std::string& function,
+    const std::vector<std::string>& params){
     std::vector<InstructionNode*>  intermediateInstructions;
     intermediateInstructions.push_back(new AllocateStack{-1});
-    for(TackyInstruction* instr: instructions){
-        if(TackyReturn* tackyReturn = dynamic_cast<TackyReturn*>(instr)){
-            if(TackyConstant* tackyConstant =  dynamic_cast<TackyConstant*>(tackyReturn->getVar())){
-                ImmediateNode* imm = new ImmediateNode{tackyConstant->getValue()};
-                RegisterNode* reg = new RegisterNode{RegisterName::AX};
-                MoveInstruction* mov = new MoveInstruction{imm,reg};
-                intermediateInstructions.push_back(mov);
-                IRReturnNode* ret =  new IRReturnNode{};
-                intermediateInstructions.push_back(ret);
-            }else if(TackyVariable* tackyVar = dynamic_cast<TackyVariable*>(tackyReturn->getVar())){
-                Pseudo* psuedo = new Pseudo{tackyVar->getVariableIdentifier()};
-                RegisterNode* reg = new RegisterNode{RegisterName::AX};
-                MoveInstruction* mov = new MoveInstruction{psuedo,reg};
-                intermediateInstructions.push_back(mov);
-                IRReturnNode* ret =  new IRReturnNode{};
-                intermediateInstructions.push_back(ret);
-            }
-
-        }else if(TackyUnary* tackyUnary = dynamic_cast<TackyUnary*>(instr)){
-            UnaryOperator unaryOperator = tackyUnary->getUnaryOperator();
-            TackyVal* src = tackyUnary->getSrc();
-            TackyVal* dst = tackyUnary->getDst();
-
-            OperandNode* srcOp = nullptr;
-            OperandNode* dstOp = nullptr;
-            
-            if(TackyConstant* tackyConst =  dynamic_cast<TackyConstant*>(src)){
-                srcOp = new ImmediateNode{tackyConst->getValue()};
-            }else if(TackyVariable* tackyVar = dynamic_cast<TackyVariable*>(src)){
-                srcOp = new Pseudo{tackyVar->getVariableIdentifier()};
-            }
-
-
-
-            if(TackyVariable* tackyVar = dynamic_cast<TackyVariable*>(dst)){
-                dstOp = new Pseudo{tackyVar->getVariableIdentifier()};
-            }else if(TackyConstant* tackyConst = dynamic_cast<TackyConstant*>(dst)){
-                dstOp = new ImmediateNode{tackyConst->getValue()};
-            }else{
-                throw std::runtime_error("TESTING ERROR: dst is neither TackyVariable nor TackyConstant");
-            }
-
-            if(Pseudo* s1 = dynamic_cast<Pseudo*>(srcOp) ){
-                if( Pseudo* d = dynamic_cast<Pseudo*>(dstOp)){
-                        RegisterNode* movTmp = new RegisterNode{RegisterName::R10};
-                        intermediateInstructions.push_back(new MoveInstruction(srcOp, movTmp));
-                        intermediateInstructions.push_back(new MoveInstruction(movTmp, dstOp));
-                        // MoveInstruction* mov = new MoveInstruction(srcOp, movTmp);
-
-                }
-
-            }else{
-
-                MoveInstruction* mov = new MoveInstruction(srcOp, dstOp);
-                intermediateInstructions.push_back(mov);
-            }
-
-
-            UnaryInstruction* unaryInstr = new UnaryInstruction{unaryOperator,dstOp};
-            intermediateInstructions.push_back(unaryInstr);
+    // the instructions are picked by tiling the expression trees of the body, see InstructionSelector
+    InstructionSelector selector;
+    std::vector<InstructionNode*> selected = selector.select(instructions, function, params);
+    intermediateInstructions.insert(intermediateInstructions.end(), selected.begin(), selected.end());
+    return(intermediateInstructions);
+}
 
-        }   
+OperandNode* IRTree::traverseTackyValue(TackyVal* val){
+    if(TackyConstant* tackyConst = dynamic_cast<TackyConstant*>(val)){
+        return(new ImmediateNode{tackyConst->getValue()});
+    }else if(TackyVariable* tackyVar = dynamic_cast<TackyVariable*>(val)){
+        return(new Pseudo{tackyVar->getVariableIdentifier()});
     }
-    return(intermediateInstructions);
+    throw std::runtime_error("TAC value is neither TackyVariable nor TackyConstant");
 }
 
 std::vector<IRFunctionNode*> IRTree::traverseTackyFunction(std::vector<TackyFunction*> functions){
     std::vector<IRFunctionNode*> programFunctions;
     for(TackyFunction* f: functions){
-        std::string identifer =  f->getIdentifier();
-        std::vector<InstructionNode*> instructions = traverseTackyInstructions(f->getBody());
-        programFunctions.push_back(new IRFunctionNode{identifer,instructions});
+        programFunctions.push_back(lowerFunction(f));
     }
     return(programFunctions);
 }
+
+IRFunctionNode* IRTree::lowerFunction(TackyFunction* function){
+    std::string identifer =  function->getIdentifier();
+    std::vector<InstructionNode*> instructions = traverseTackyInstructions(function->getBody(), identifer, function->getParams());
+    return(new IRFunctionNode{identifer,instructions});
+}
 IRProgramNode* IRTree::traverseTackyProgram( TackyProgram* program){
     return(new IRProgramNode{traverseTackyFunction(program->getFunctions())});
 }
@@ -514,10 +1256,16 @@ void IRTree::prettyPrint() {
 }
 
 void IRTree::filePrint(std::string assemblyFileName) {
-    // assemblyFile.open("assemblyFileName + "".s");
-    assemblyFile.open("../Assembly.s");
+    std::ostringstream assembly;
+    root->filePrint(assembly);
+    writeAssemblyFile(assemblyFileName, assembly.str());
+}
 
-    root->filePrint(assemblyFile);
+void IRTree::writeAssemblyFile(std::string assemblyFileName, const std::string& assembly) {
+    // assemblyFile.open("assemblyFileName + "".s");
+    std::ofstream assemblyFile{"../Assembly.s"};
+    std::cout << assembly;
+    assemblyFile << assembly;
     assemblyFile.close();
 }
 
@@ -531,51 +1279,75 @@ std::unordered_map<std::string, int>& IRTree::getPseudoOffsets(){
 }
 
 void IRTree::replacePseudoOperands(){
-    PseudoReplacer replacer{pseudoOffsets,currentOffset};
-    std::unordered_set<Pseudo*> pseudoNodes;
     // std::cout<<"THERE are "<<root->getFunctions().size()<<" function(s)\n";
-    int counter = 0;
     for(IRFunctionNode* f: root->getFunctions()){
-        // std::cout<<f->getIdentifier()<<" has "<<f->getInstructions().size()<<" assembly instructions\n";
-        for(InstructionNode* instr:f->getInstructions()){
-            // std::cout<<"INSTRUCTION: "<<counter<<'\n';
-            // std::cout<<"HERE\n";
-            if(UnaryInstruction* unaryInstr =  dynamic_cast<UnaryInstruction*>(instr)){
-                OperandNode* oldOperand =  unaryInstr->getOperand();
-                // std::cout<<"UNARY"<<'\n';
-                OperandNode* newOperand = replacer.replace(unaryInstr->getOperand(),pseudoNodes);
-                // if(oldOperand == nullptr){
-                //     std::cout<<"NULLPTR\n";
-                // }
-                if(oldOperand != newOperand){
-                    unaryInstr->setOperand(newOperand);
-                    // delete oldOperand;
-                }
-            }else if(MoveInstruction* movInstr =  dynamic_cast<MoveInstruction*>(instr)){
-                // std::cout<<"MOVE"<<'\n';
-                OperandNode* oldSrc =  movInstr->getSrc();
-                OperandNode* oldDst = movInstr->getDst();
-
-                OperandNode* newSrc  =  replacer.replace(movInstr->getSrc(),pseudoNodes);
-                OperandNode* newDst = replacer.replace(movInstr->getDst(),pseudoNodes);
-
-                if(oldSrc != newSrc){
-                    movInstr->setSrc(newSrc);
-                    // delete oldSrc;
-                }
-                if(oldDst != newDst){
-                    movInstr->setDst(newDst);
-                    // delete oldDst;
-                }
-                counter++;
+        replacePseudoOperands(f, pseudoOffsets, currentOffset);
+    }
+}
+
+void IRTree::replacePseudoOperands(IRFunctionNode* f, std::unordered_map<std::string, int>& offsets, int& currentOffset){
+    PseudoReplacer replacer{offsets,currentOffset};
+    std::unordered_set<Pseudo*> pseudoNodes;
+    int counter = 0;
+    // std::cout<<f->getIdentifier()<<" has "<<f->getInstructions().size()<<" assembly instructions\n";
+    for(InstructionNode* instr:f->getInstructions()){
+        // std::cout<<"INSTRUCTION: "<<counter<<'\n';
+        // std::cout<<"HERE\n";
+        if(UnaryInstruction* unaryInstr =  dynamic_cast<UnaryInstruction*>(instr)){
+            OperandNode* oldOperand =  unaryInstr->getOperand();
+            // std::cout<<"UNARY"<<'\n';
+            OperandNode* newOperand = replacer.replace(unaryInstr->getOperand(),pseudoNodes);
+            // if(oldOperand == nullptr){
+            //     std::cout<<"NULLPTR\n";
+            // }
+            if(oldOperand != newOperand){
+                unaryInstr->setOperand(newOperand);
+                // delete oldOperand;
             }
-        }
-        if(AllocateStack* allocate =  dynamic_cast<AllocateStack*>(f->getInstructions()[0])){
-            allocate->setStackDecrementAmount(currentOffset+4);
-        }
+        }else if(MoveInstruction* movInstr =  dynamic_cast<MoveInstruction*>(instr)){
+            // std::cout<<"MOVE"<<'\n';
+            OperandNode* oldSrc =  movInstr->getSrc();
+            OperandNode* oldDst = movInstr->getDst();
 
-        replacer.resetOffsets();
+            OperandNode* newSrc  =  replacer.replace(movInstr->getSrc(),pseudoNodes);
+            OperandNode* newDst = replacer.replace(movInstr->getDst(),pseudoNodes);
+
+            if(oldSrc != newSrc){
+                movInstr->setSrc(newSrc);
+                // delete oldSrc;
+            }
+            if(oldDst != newDst){
+                movInstr->setDst(newDst);
+                // delete oldDst;
+            }
+            counter++;
+        }else if(BinaryInstruction* binaryInstr = dynamic_cast<BinaryInstruction*>(instr)){
+            OperandNode* oldSrc = binaryInstr->getSrc();
+            OperandNode* oldDst = binaryInstr->getDst();
+            OperandNode* newSrc = replacer.replace(oldSrc,pseudoNodes);
+            OperandNode* newDst = replacer.replace(oldDst,pseudoNodes);
+            if(oldSrc != newSrc){
+                binaryInstr->setSrc(newSrc);
+            }
+            if(oldDst != newDst){
+                binaryInstr->setDst(newDst);
+            }
+        }else if(CompareInstruction* compareInstr = dynamic_cast<CompareInstruction*>(instr)){
+            compareInstr->setSrc(replacer.replace(compareInstr->getSrc(),pseudoNodes));
+            compareInstr->setDst(replacer.replace(compareInstr->getDst(),pseudoNodes));
+        }else if(IdivInstruction* idivInstr = dynamic_cast<IdivInstruction*>(instr)){
+            idivInstr->setOperand(replacer.replace(idivInstr->getOperand(),pseudoNodes));
+        }else if(ConditionalMoveInstruction* cmovInstr = dynamic_cast<ConditionalMoveInstruction*>(instr)){
+            cmovInstr->setSrc(replacer.replace(cmovInstr->getSrc(),pseudoNodes));
+        }
     }
+    if(AllocateStack* allocate =  dynamic_cast<AllocateStack*>(f->getInstructions()[0])){
+        // %rsp is 16 byte aligned right after pushq %rbp, keep it that way for calls
+        int bytes = -(currentOffset+4);
+        allocate->setStackDecrementAmount((bytes + 15) / 16 * 16);
+    }
+
+    replacer.resetOffsets();
     for(Pseudo* p: pseudoNodes){
         delete p;
     }
@@ -586,6 +1358,175 @@ IRProgramNode* IRTree::transformFromTacky(TackyProgram* tackyProgram){
     return(this->root);
 }
 
+// ======================================================
+//                     Operand helpers
+// ======================================================
+void instruction_operands(InstructionNode* instr, std::vector<OperandNode*>& reads, std::vector<OperandNode*>& writes){
+    static RegisterNode returnRegister{RegisterName::AX};
+    // cltd and idivl also use %edx without naming it
+    static RegisterNode remainderRegister{RegisterName::DX};
+    // dispatch on the type tag, this runs for every instruction in most passes
+    switch(instr->getType()){
+        case MOV: {
+            MoveInstruction* mov = static_cast<MoveInstruction*>(instr);
+            reads.push_back(mov->getSrc());
+            writes.push_back(mov->getDst());
+            break;
+        }
+        case UNARY: {
+            UnaryInstruction* unary = static_cast<UnaryInstruction*>(instr);
+            reads.push_back(unary->getOperand());
+            writes.push_back(unary->getOperand());
+            break;
+        }
+        case BINARY: {
+            BinaryInstruction* binary = static_cast<BinaryInstruction*>(instr);
+            reads.push_back(binary->getSrc());
+            reads.push_back(binary->getDst());
+            writes.push_back(binary->getDst());
+            break;
+        }
+        case LEA: {
+            LeaInstruction* lea = static_cast<LeaInstruction*>(instr);
+            reads.push_back(lea->getBase());
+            if(lea->getIndex() != nullptr){
+                reads.push_back(lea->getIndex());
+            }
+            writes.push_back(lea->getDst());
+            break;
+        }
+        case CDQ:
+            reads.push_back(&returnRegister);
+            writes.push_back(&remainderRegister);
+            break;
+        case IDIV:
+            reads.push_back(static_cast<IdivInstruction*>(instr)->getOperand());
+            reads.push_back(&returnRegister);
+            reads.push_back(&remainderRegister);
+            writes.push_back(&returnRegister);
+            writes.push_back(&remainderRegister);
+            break;
+        case MULHI: {
+            MultiplyHighInstruction* multiply = static_cast<MultiplyHighInstruction*>(instr);
+            reads.push_back(multiply->getSrc());
+            writes.push_back(multiply->getDst());
+            break;
+        }
+        case CMP: {
+            CompareInstruction* compare = static_cast<CompareInstruction*>(instr);
+            reads.push_back(compare->getSrc());
+            reads.push_back(compare->getDst());
+            break;
+        }
+        case SETCC: {
+            // only the low byte is written, the rest of the register is kept
+            RegisterNode* dst = static_cast<SetConditionInstruction*>(instr)->getDst();
+            reads.push_back(dst);
+            writes.push_back(dst);
+            break;
+        }
+        case MOVZX: {
+            MoveZeroExtendInstruction* extend = static_cast<MoveZeroExtendInstruction*>(instr);
+            reads.push_back(extend->getSrc());
+            writes.push_back(extend->getDst());
+            break;
+        }
+        case CMOV: {
+            // dst keeps its value when the condition doesn't hold
+            ConditionalMoveInstruction* cmov = static_cast<ConditionalMoveInstruction*>(instr);
+            reads.push_back(cmov->getSrc());
+            reads.push_back(cmov->getDst());
+            writes.push_back(cmov->getDst());
+            break;
+        }
+        case RET:
+            reads.push_back(&returnRegister);
+            break;
+        case PUSH:
+            reads.push_back(static_cast<PushInstruction*>(instr)->getOperand());
+            break;
+        case CALL: {
+            // the argument registers are read, every caller saved register may be overwritten
+            static std::vector<RegisterNode> argumentRegisters(CallInstruction::argumentRegisters().begin(),
+                CallInstruction::argumentRegisters().end());
+            static RegisterNode clobbered[] = {
+                RegisterNode{RegisterName::AX}, RegisterNode{RegisterName::CX}, RegisterNode{RegisterName::DX},
+                RegisterNode{RegisterName::SI}, RegisterNode{RegisterName::DI}, RegisterNode{RegisterName::R8},
+                RegisterNode{RegisterName::R9}, RegisterNode{RegisterName::R10}, RegisterNode{RegisterName::R11}
+            };
+            int count = static_cast<CallInstruction*>(instr)->getRegisterArguments();
+            for(int k = 0; k < count; k++){
+                reads.push_back(&argumentRegisters[k]);
+            }
+            for(RegisterNode& reg: clobbered){
+                writes.push_back(&reg);
+            }
+            break;
+        }
+        case ALLOCATE:
+        case DEALLOCATE:
+        case PROFILE:
+            // the counter is memory no pass allocates or reads
+            break;
+        case JMPTABLE: {
+            // the table entry is loaded over the index
+            JumpTableInstruction* dispatch = static_cast<JumpTableInstruction*>(instr);
+            reads.push_back(dispatch->getIndex());
+            writes.push_back(dispatch->getIndex());
+            writes.push_back(dispatch->getScratch());
+            break;
+        }
+        case JMP:
+        case JMPCC:
+        case LABEL:
+            break;
+    }
+}
+
+void replace_operand(InstructionNode* instr, OperandNode* oldOp, OperandNode* newOp){
+    if(MoveInstruction* mov = dynamic_cast<MoveInstruction*>(instr)){
+        if(mov->getSrc() == oldOp) mov->setSrc(newOp);
+        if(mov->getDst() == oldOp) mov->setDst(newOp);
+    }else if(UnaryInstruction* unary = dynamic_cast<UnaryInstruction*>(instr)){
+        if(unary->getOperand() == oldOp) unary->setOperand(newOp);
+    }else if(BinaryInstruction* binary = dynamic_cast<BinaryInstruction*>(instr)){
+        if(binary->getSrc() == oldOp) binary->setSrc(newOp);
+        if(binary->getDst() == oldOp) binary->setDst(newOp);
+    }else if(CompareInstruction* compare = dynamic_cast<CompareInstruction*>(instr)){
+        if(compare->getSrc() == oldOp) compare->setSrc(newOp);
+        if(compare->getDst() == oldOp) compare->setDst(newOp);
+    }else if(IdivInstruction* idiv = dynamic_cast<IdivInstruction*>(instr)){
+        if(idiv->getOperand() == oldOp) idiv->setOperand(newOp);
+    }else if(ConditionalMoveInstruction* cmov = dynamic_cast<ConditionalMoveInstruction*>(instr)){
+        if(cmov->getSrc() == oldOp) cmov->setSrc(newOp);
+    }
+}
+
+bool operands_equal(OperandNode* a, OperandNode* b){
+    if(a == b){
+        return(true);
+    }
+    if(a == nullptr || b == nullptr || a->getType() != b->getType()){
+        return(false);
+    }
+    switch(a->getType()){
+        case IMM: return(static_cast<ImmediateNode*>(a)->getImm() == static_cast<ImmediateNode*>(b)->getImm());
+        case REG: return(static_cast<RegisterNode*>(a)->getRegEnum() == static_cast<RegisterNode*>(b)->getRegEnum());
+        case PSEUDO: return(static_cast<Pseudo*>(a)->getIdentifier() == static_cast<Pseudo*>(b)->getIdentifier());
+        case STACK: return(static_cast<Stack*>(a)->getAmount() == static_cast<Stack*>(b)->getAmount()
+            && static_cast<Stack*>(a)->getBase() == static_cast<Stack*>(b)->getBase());
+    }
+    return(false);
+}
+
+std::string local_label(const std::string& function, const std::string& label){
+    return(".L" + function + "." + label);
+}
+
+bool is_memory_operand(OperandNode* op){
+    return(op->getType() == PSEUDO || op->getType() == STACK);
+}
+
 PseudoReplacer::PseudoReplacer(std::unordered_map<std::string,int>& offsets, int& currentFreeOffset)
     : offsets(offsets), currentFreeOffset(currentFreeOffset) {}
 
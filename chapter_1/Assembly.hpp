@@ -16,7 +16,12 @@ static inline void indent(int n) {
 // ======================================================
 enum OperandType { IMM, REG ,PSEUDO,STACK};
 
-enum class RegisterName{AX,R10};
+enum class RegisterName{AX,CX,DX,SI,DI,R8,R9,R10,R11};
+/**
+ * @brief The register a stack slot is addressed from. Functions without a frame address their slots
+ * in the red zone below %rsp.
+ */
+enum class FrameBase{RBP, RSP};
 
 // ======================================================
 //                     OperandNode(Base)
@@ -28,7 +33,7 @@ class OperandNode {
 
         virtual OperandType getType(void) = 0;
         virtual void print() = 0;
-        virtual void filePrint(std::ofstream& assemblyFile) = 0;
+        virtual void filePrint(std::ostream& assemblyFile) = 0;
         virtual void prettyPrint(int indent = 0) const = 0; // <-- NEW
 
     protected:
@@ -48,7 +53,7 @@ class ImmediateNode : public OperandNode {
         std::string getImm(void);
         OperandType getType(void) override;
         void print() override;
-        void filePrint(std::ofstream& assemblyFile) override;
+        void filePrint(std::ostream& assemblyFile) override;
         void prettyPrint(int indent = 0) const override; // <-- NEW
 
     private:
@@ -65,9 +70,21 @@ class RegisterNode : public OperandNode {
 
         RegisterName getRegEnum(void) const;
         std::string getRegStr(void) const;
+        /**
+         * @brief Get the name of the full 64 bit register (i.e rax for eax). Used for addressing.
+         * 
+         * @return std::string 
+         */
+        std::string getRegStr64(void) const;
+        /**
+         * @brief Get the name of the low byte of the register (i.e cl for ecx). Used for shift counts.
+         *
+         * @return std::string
+         */
+        std::string getRegStr8(void) const;
         OperandType getType(void) override;
         void print() override;
-        void filePrint(std::ofstream& assemblyFile) override;
+        void filePrint(std::ostream& assemblyFile) override;
         void prettyPrint(int indent = 0) const override; // <-- NEW
 
     private:
@@ -83,7 +100,7 @@ class Pseudo : public OperandNode {
         std::string getIdentifier();
         OperandType getType() override;
         void print() override;
-        void filePrint(std::ofstream& assemblyFile) override;
+        void filePrint(std::ostream& assemblyFile) override;
         void prettyPrint(int indent = 0) const override; // <-- NEW
 
     private:
@@ -95,21 +112,45 @@ class Pseudo : public OperandNode {
 // ======================================================
 class Stack : public OperandNode {
     public:
-        Stack(int amount);
+        Stack(int amount, FrameBase base = FrameBase::RBP);
         int getAmount();
+        void setAmount(int newAmount);
+        FrameBase getBase();
+        void setBase(FrameBase newBase);
         OperandType getType(void) override;
         void print() override;
-        void filePrint(std::ofstream& assemblyFile) override;
+        void filePrint(std::ostream& assemblyFile) override;
         void prettyPrint(int indent = 0) const override; // <-- NEW
 
     private:
         int amount;
+        FrameBase base;
 };
 
 // ======================================================
 //                     Instruction Types
 // ======================================================
-enum InstructionType { MOV, RET,UNARY,ALLOCATE };
+enum InstructionType { MOV, RET,UNARY,ALLOCATE,BINARY,LEA,CDQ,IDIV,MULHI,PROFILE,CMP,JMP,JMPCC,LABEL,SETCC,MOVZX,CMOV,JMPTABLE,PUSH,CALL,DEALLOCATE };
+/**
+ * @brief The condition a JMPCC, SETCC or CMOV tests, on the flags set by the CMP before it. L to GE are the signed
+ * orderings (l is dst < src for cmpl src, dst), B to AE the unsigned ones (b is dst < src as unsigned), which is
+ * how a single ja checks that 0 <= x - low <= high - low.
+ */
+enum class ConditionCode{E, NE, L, LE, G, GE, B, BE, A, AE};
+/**
+ * @brief The condition holding exactly when the given one doesn't (l => ge)
+ *
+ * @param condition
+ * @return ConditionCode
+ */
+ConditionCode negate_condition(ConditionCode condition);
+/**
+ * @brief The condition to test once the operands of the cmpl are swapped (l => g)
+ *
+ * @param condition
+ * @return ConditionCode
+ */
+ConditionCode swap_condition(ConditionCode condition);
 
 
 // ======================================================
@@ -119,7 +160,7 @@ enum InstructionType { MOV, RET,UNARY,ALLOCATE };
 class InstructionNode {
     public:
         virtual void print() = 0;
-        virtual void filePrint(std::ofstream& assemblyFile) = 0;
+        virtual void filePrint(std::ostream& assemblyFile) = 0;
         virtual void prettyPrint(int indent = 0) const = 0; // <-- NEW
         InstructionType getType();
     protected:
@@ -141,7 +182,7 @@ class MoveInstruction : public InstructionNode {
         void setSrc(OperandNode* newSrc);
         void setDst(OperandNode* newDst);
 
-        void filePrint(std::ofstream& assemblyFile) override;
+        void filePrint(std::ostream& assemblyFile) override;
         void print() override;
         void prettyPrint(int indent = 0) const override; // <-- NEW
 
@@ -158,10 +199,18 @@ class MoveInstruction : public InstructionNode {
 class IRReturnNode : public InstructionNode {
     public:
         IRReturnNode();
+        /**
+         * @brief Whether the return tears down the %rbp frame before ret. False in functions without a frame.
+         *
+         */
+        bool getRestoresFrame();
+        void setRestoresFrame(bool restores);
 
         void print() override;
-        void filePrint(std::ofstream& assemblyFile) override;
+        void filePrint(std::ostream& assemblyFile) override;
         void prettyPrint(int indent = 0) const override; // <-- NEW
+    private:
+        bool restoresFrame;
 };
 
 // ======================================================
@@ -175,7 +224,7 @@ class UnaryInstruction : public InstructionNode {
         OperandNode* getOperand();
         void setOperand(OperandNode* newOp);
         void print() override;
-        void filePrint(std::ofstream& assemblyFile) override;
+        void filePrint(std::ostream& assemblyFile) override;
         void prettyPrint(int indent = 0) const override; // <-- NEW
         
         private:
@@ -183,6 +232,310 @@ class UnaryInstruction : public InstructionNode {
         OperandNode* operand;
     };
     
+// ======================================================
+//                     BinaryInstruction:InstructionNode
+// ======================================================
+// dst = dst op src (addl, subl, imull, andl, orl, xorl, sall, sarl, shrl). The shifts take an immediate count or
+// %ecx, printed %cl.
+class BinaryInstruction : public InstructionNode {
+    public:
+        BinaryInstruction(BinaryOperator binary_operator, OperandNode* src, OperandNode* dst);
+
+        BinaryOperator getBinaryOperator();
+        OperandNode* getSrc(void);
+        OperandNode* getDst(void);
+        void setSrc(OperandNode* newSrc);
+        void setDst(OperandNode* newDst);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        BinaryOperator binary_operator;
+        OperandNode* src;
+        OperandNode* dst;
+};
+
+// ======================================================
+//                     LeaInstruction:InstructionNode
+// ======================================================
+// dst = base + displacement, computed by the address unit (leal disp(%base), %dst).
+// Unlike addl it doesn't need dst to hold the base and doesn't modify the flags.
+class LeaInstruction : public InstructionNode {
+    public:
+        LeaInstruction(RegisterNode* base, int displacement, RegisterNode* dst);
+        /**
+         * @brief leal displacement(%base,%index,scale), %dst
+         *
+         * @param scale 1, 2, 4 or 8
+         */
+        LeaInstruction(RegisterNode* base, RegisterNode* index, int scale, int displacement, RegisterNode* dst);
+
+        RegisterNode* getBase(void);
+        /**
+         * @brief The index register, nullptr for a plain displacement(%base)
+         *
+         * @return RegisterNode*
+         */
+        RegisterNode* getIndex(void);
+        int getScale(void);
+        int getDisplacement(void);
+        RegisterNode* getDst(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        RegisterNode* base;
+        RegisterNode* index;
+        int scale;
+        int displacement;
+        RegisterNode* dst;
+};
+
+// ======================================================
+//                     CdqInstruction:InstructionNode
+// ======================================================
+// Sign extends %eax into %edx:%eax, the dividend of idivl (cltd)
+class CdqInstruction : public InstructionNode {
+    public:
+        CdqInstruction();
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+};
+
+// ======================================================
+//                     IdivInstruction:InstructionNode
+// ======================================================
+// Divides %edx:%eax by the operand, the quotient goes in %eax and the remainder in %edx (idivl operand).
+// The operand is a register or a memory operand, never an immediate.
+class IdivInstruction : public InstructionNode {
+    public:
+        explicit IdivInstruction(OperandNode* operand);
+
+        OperandNode* getOperand(void);
+        void setOperand(OperandNode* newOp);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        OperandNode* operand;
+};
+
+// ======================================================
+//                     MultiplyHighInstruction:InstructionNode
+// ======================================================
+/**
+ * @brief dst = (src * magic) >> (32 + shift), the high half of the signed 64 bit product shifted right, the core
+ * of a division by a constant. Emitted as movslq %src, %dst; imulq $magic, %dst, %dst; sarq $(32 + shift), %dst.
+ */
+class MultiplyHighInstruction : public InstructionNode {
+    public:
+        MultiplyHighInstruction(int32_t magic, int shift, RegisterNode* src, RegisterNode* dst);
+
+        int32_t getMagic(void);
+        int getShift(void);
+        RegisterNode* getSrc(void);
+        RegisterNode* getDst(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        int32_t magic;
+        int shift;
+        RegisterNode* src;
+        RegisterNode* dst;
+};
+
+// ======================================================
+//                     CompareInstruction:InstructionNode
+// ======================================================
+// Sets the flags from dst - src, without writing dst (cmpl src, dst)
+class CompareInstruction : public InstructionNode {
+    public:
+        CompareInstruction(OperandNode* src, OperandNode* dst);
+
+        OperandNode* getSrc(void);
+        OperandNode* getDst(void);
+        void setSrc(OperandNode* newSrc);
+        void setDst(OperandNode* newDst);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        OperandNode* src;
+        OperandNode* dst;
+};
+
+// ======================================================
+//                     JumpInstruction:InstructionNode
+// ======================================================
+/**
+ * @brief jmp to a label of the same function. Labels are the assembler local symbols made by local_label, so
+ * they never end up in the symbol table and two functions can't clash.
+ */
+class JumpInstruction : public InstructionNode {
+    public:
+        explicit JumpInstruction(std::string target);
+
+        std::string getTarget(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        std::string target;
+};
+
+// ======================================================
+//                     ConditionalJumpInstruction:InstructionNode
+// ======================================================
+// j<cc> target, falls through when the condition doesn't hold
+class ConditionalJumpInstruction : public InstructionNode {
+    public:
+        ConditionalJumpInstruction(ConditionCode condition, std::string target);
+
+        ConditionCode getCondition(void);
+        std::string getTarget(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        ConditionCode condition;
+        std::string target;
+};
+
+// ======================================================
+//                     JumpTableInstruction:InstructionNode
+// ======================================================
+/**
+ * @brief jmp through a table of targets, the case of a switch at index i of the table goes to the i-th target.
+ * index must already be within the table (a cmpl and ja before it check that). The table goes to .rodata, each
+ * entry a .long of the distance from base to its target, so it needs no relocation and the function can be
+ * loaded anywhere:
+ *      leaq table(%rip), %scratch
+ *      movslq (%scratch,%index,4), %index
+ *      leaq base(%rip), %scratch
+ *      addq %scratch, %index
+ *      jmp *%index
+ * index and scratch are both overwritten, the upper half of index has to be 0 (a 32 bit write leaves it so).
+ */
+class JumpTableInstruction : public InstructionNode {
+    public:
+        JumpTableInstruction(RegisterNode* index, RegisterNode* scratch, std::string table, std::vector<std::string> targets, std::string base);
+
+        RegisterNode* getIndex(void);
+        RegisterNode* getScratch(void);
+        /**
+         * @brief Label of the table in .rodata, local to the function like the targets
+         *
+         */
+        std::string getTable(void);
+        const std::vector<std::string>& getTargets(void);
+        /**
+         * @brief Label the entries are relative to, one of the targets (the default of the switch)
+         *
+         */
+        std::string getBase(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        RegisterNode* index;
+        RegisterNode* scratch;
+        std::string table;
+        std::vector<std::string> targets;
+        std::string base;
+};
+
+// ======================================================
+//                     SetConditionInstruction:InstructionNode
+// ======================================================
+/**
+ * @brief set<cc> of the low byte of a register (setl %al), 1 if the condition holds and 0 otherwise. The upper
+ * bits are left alone, a MOVZX clears them.
+ */
+class SetConditionInstruction : public InstructionNode {
+    public:
+        SetConditionInstruction(ConditionCode condition, RegisterNode* dst);
+
+        ConditionCode getCondition(void);
+        RegisterNode* getDst(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        ConditionCode condition;
+        RegisterNode* dst;
+};
+
+// ======================================================
+//                     MoveZeroExtendInstruction:InstructionNode
+// ======================================================
+// movzbl: dst = the low byte of src, zero extended
+class MoveZeroExtendInstruction : public InstructionNode {
+    public:
+        MoveZeroExtendInstruction(RegisterNode* src, RegisterNode* dst);
+
+        RegisterNode* getSrc(void);
+        RegisterNode* getDst(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        RegisterNode* src;
+        RegisterNode* dst;
+};
+
+// ======================================================
+//                     ConditionalMoveInstruction:InstructionNode
+// ======================================================
+/**
+ * @brief cmov<cc> src, dst: dst = src if the condition holds. src is a register or a variable, never an immediate
+ * (cmov has no immediate form), dst a register.
+ */
+class ConditionalMoveInstruction : public InstructionNode {
+    public:
+        ConditionalMoveInstruction(ConditionCode condition, OperandNode* src, RegisterNode* dst);
+
+        ConditionCode getCondition(void);
+        OperandNode* getSrc(void);
+        RegisterNode* getDst(void);
+        void setSrc(OperandNode* newSrc);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        ConditionCode condition;
+        OperandNode* src;
+        RegisterNode* dst;
+};
+
+// ======================================================
+//                     LabelInstruction:InstructionNode
+// ======================================================
+class LabelInstruction : public InstructionNode {
+    public:
+        explicit LabelInstruction(std::string name);
+
+        std::string getName(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        std::string name;
+};
+
     // ======================================================
     //                     AllocateStack:InstructionNode
     // ======================================================
@@ -194,9 +547,92 @@ class UnaryInstruction : public InstructionNode {
         int getStackDecrementAmount();
         void setStackDecrementAmount(int amount);
         void print() override;
-        void filePrint(std::ofstream& assemblyFile) override;
+        void filePrint(std::ostream& assemblyFile) override;
         void prettyPrint(int indent = 0) const override; // <-- NEW
 };
+
+// ======================================================
+//                     PushInstruction:InstructionNode
+// ======================================================
+// pushq of a stack argument, the operand is an immediate or a register (pushed whole, pushq %rax)
+class PushInstruction : public InstructionNode {
+    public:
+        explicit PushInstruction(OperandNode* operand);
+
+        OperandNode* getOperand(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        OperandNode* operand;
+};
+
+// ======================================================
+//                     CallInstruction:InstructionNode
+// ======================================================
+/**
+ * @brief call of a function by name, which may be defined in another file. The first registerArguments of %edi,
+ * %esi, %edx, %ecx, %r8d and %r9d hold its arguments (System V), the result comes back in %eax and every other
+ * caller saved register is clobbered.
+ */
+class CallInstruction : public InstructionNode {
+    public:
+        CallInstruction(std::string name, int registerArguments);
+
+        std::string getName(void);
+        int getRegisterArguments(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+        /**
+         * @brief The registers holding the arguments, in order
+         *
+         */
+        static const std::vector<RegisterName>& argumentRegisters();
+
+    private:
+        std::string name;
+        int registerArguments;
+};
+
+// ======================================================
+//                     DeallocateStack:InstructionNode
+// ======================================================
+// addq $amount, %rsp, pops the stack arguments (and their padding) after a call
+class DeallocateStack : public InstructionNode {
+    public:
+        explicit DeallocateStack(int amount);
+
+        int getAmount(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+
+    private:
+        int amount;
+};
+
+// ======================================================
+//                     ProfileCounter:InstructionNode
+// ======================================================
+/**
+ * @brief incq of the execution counter of a function (-fprofile-generate), see Profile.hpp. The counters of a
+ * file are a table in their own .bss like section, the instruction addresses its slot %rip relative.
+ */
+class ProfileCounterInstruction : public InstructionNode {
+    public:
+        /**
+         * @param index slot of the function in the counter table of the file
+         */
+        explicit ProfileCounterInstruction(size_t index);
+        size_t getIndex(void);
+        void print() override;
+        void filePrint(std::ostream& assemblyFile) override;
+        void prettyPrint(int indent = 0) const override;
+    private:
+        size_t index;
+};
 // ======================================================
 //                     IRFunctionNode
 // ======================================================
@@ -207,14 +643,34 @@ class IRFunctionNode {
 
         const std::string getIdentifier(void);
         std::vector<InstructionNode*> getInstructions(void);
+        void setInstructions(std::vector<InstructionNode*> instr);
+        /**
+         * @brief Whether the function sets up %rbp as a frame pointer (pushq %rbp; movq %rsp, %rbp)
+         *
+         */
+        bool hasFramePointer(void);
+        void setFramePointer(bool framePointer);
+        /**
+         * @brief Whether the symbol of the function is global (.global), false for a static function
+         *
+         */
+        bool isGlobal(void);
+        void setGlobal(bool global);
 
         void print();
-        void filePrint(std::ofstream& assemblyFile);
+        /**
+         * @brief Writes the function aligned to 16 bytes, with its .type and .size and the .cfi directives
+         * describing the frame, so debuggers and perf can unwind through it and attribute samples to it
+         *
+         */
+        void filePrint(std::ostream& assemblyFile);
         void prettyPrint(int indent = 0) const; // <-- NEW
 
     private:
         std::string identifier;
         std::vector<InstructionNode*> instructions;
+        bool framePointer;
+        bool global;
 };
 
 
@@ -227,7 +683,13 @@ class IRProgramNode {
         IRProgramNode(std::vector<IRFunctionNode*> fs);
 
         void print();
-        void filePrint(std::ofstream& assemblyFile);
+        void filePrint(std::ostream& assemblyFile);
+        /**
+         * @brief Prints the directives that follow the last function of the file
+         * 
+         * @param assemblyFile 
+         */
+        static void filePrintEpilogue(std::ostream& assemblyFile);
         void prettyPrint(int indent = 0) const; // <-- NEW
         std::vector<IRFunctionNode*> getFunctions();
 
@@ -253,7 +715,20 @@ class IRTree {
         
         
         std::string traverseTackyExpression(TackyVal* expression);
-        std::vector<InstructionNode*> traverseTackyInstructions(std::vector<TackyInstruction*> instructions);
+        /**
+         * @brief Converts a TAC value into the operand it lives in. Constants become ImmediateNodes, variables Pseudos.
+         * 
+         * @param val 
+         * @return OperandNode* 
+         */
+        OperandNode* traverseTackyValue(TackyVal* val);
+        /**
+         * @brief Lowers the body of a function, labels are qualified with its name and the parameters are loaded
+         * from where the caller passed them
+         * 
+         */
+        std::vector<InstructionNode*> traverseTackyInstructions(std::vector<TackyInstruction*> instructions, const std::string& function,
+            const std::vector<std::string>& params);
         std::vector<IRFunctionNode*> traverseTackyFunction( std::vector<TackyFunction*> functions);
         IRProgramNode* traverseTackyProgram( TackyProgram* program);
 
@@ -271,7 +746,74 @@ class IRTree {
         void filePrint(std::string assemblyFileName);
         IRProgramNode* transformFromTacky(TackyProgram*);
         void replacePseudoOperands();
+        /**
+         * @brief Lowers a single function. Doesn't touch any state of the IRTree, so functions can be lowered concurrently.
+         * 
+         * @param function 
+         * @return IRFunctionNode* 
+         */
+        IRFunctionNode* lowerFunction(TackyFunction* function);
+        /**
+         * @brief Assigns a stack slot to every Pseudo of the function using the given offsets.
+         * 
+         * @param function 
+         * @param offsets 
+         * @param offset the next free offset, reset to -4 when done
+         */
+        static void replacePseudoOperands(IRFunctionNode* function, std::unordered_map<std::string, int>& offsets, int& offset);
+        /**
+         * @brief Writes the assembly to the output file and echoes it to the console
+         * 
+         * @param assemblyFileName 
+         * @param assembly 
+         */
+        static void writeAssemblyFile(std::string assemblyFileName, const std::string& assembly);
 };
+// ======================================================
+//                     Operand helpers
+// ======================================================
+/**
+ * @brief Collects the operands an instruction reads and the ones it writes. An operand that is
+ * read and then written (i.e the operand of negl) appears in both. Registers used implicitly
+ * (%eax by ret) are included.
+ * 
+ * @param instr 
+ * @param reads 
+ * @param writes 
+ */
+void instruction_operands(InstructionNode* instr, std::vector<OperandNode*>& reads, std::vector<OperandNode*>& writes);
+/**
+ * @brief Replaces every use of oldOp in the instruction by newOp
+ * 
+ * @param instr 
+ * @param oldOp 
+ * @param newOp 
+ */
+void replace_operand(InstructionNode* instr, OperandNode* oldOp, OperandNode* newOp);
+/**
+ * @brief Checks if two operands name the same location or value
+ * 
+ * @param a 
+ * @param b 
+ * @return bool
+ */
+bool operands_equal(OperandNode* a, OperandNode* b);
+/**
+ * @brief The assembler local symbol of a TAC label of the function (i.e .Lmain.else.0)
+ * 
+ * @param function 
+ * @param label 
+ * @return std::string
+ */
+std::string local_label(const std::string& function, const std::string& label);
+/**
+ * @brief Checks if the operand lives in memory (a Pseudo that hasn't been given a register or a stack slot)
+ * 
+ * @param op 
+ * @return bool
+ */
+bool is_memory_operand(OperandNode* op);
+
 class PseudoReplacer{
     private:
         std::unordered_map<std::string, int>& offsets;
@@ -0,0 +1,92 @@
+#include "CodeFolding.hpp"
+#include "X86Encoder.hpp"
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+// ======================================================
+//                     CodeFolder
+// ======================================================
+std::string CodeFolder::fingerprint(IRFunctionNode* function){
+    std::ostringstream body;
+    body << (function->hasFramePointer() ? "frame\n" : "leaf\n");
+    // labels are qualified with the name of the function, only the part after it tells two bodies apart
+    size_t prefix = local_label(function->getIdentifier(), "").size();
+    for(InstructionNode* instr: function->getInstructions()){
+        switch(instr->getType()){
+            case JMP:
+                body << "jmp " << static_cast<JumpInstruction*>(instr)->getTarget().substr(prefix) << '\n';
+                break;
+            case JMPCC: {
+                ConditionalJumpInstruction* branch = static_cast<ConditionalJumpInstruction*>(instr);
+                body << "j" << static_cast<int>(branch->getCondition()) << ' ' << branch->getTarget().substr(prefix) << '\n';
+                break;
+            }
+            case JMPTABLE: {
+                // the entries are relative, two functions with the same targets have the same table
+                JumpTableInstruction* dispatch = static_cast<JumpTableInstruction*>(instr);
+                body << "table " << dispatch->getIndex()->getRegStr() << ' ' << dispatch->getScratch()->getRegStr()
+                    << ' ' << dispatch->getBase().substr(prefix);
+                for(const std::string& target: dispatch->getTargets()){
+                    body << ' ' << target.substr(prefix);
+                }
+                body << '\n';
+                break;
+            }
+            case LABEL:
+                body << static_cast<LabelInstruction*>(instr)->getName().substr(prefix) << ":\n";
+                break;
+            default:
+                instr->filePrint(body);
+        }
+    }
+    return(body.str());
+}
+
+FoldingReport CodeFolder::fold(std::vector<FunctionUnit>& units){
+    FoldingReport report;
+    report.functions = units.size();
+    // fingerprint => index of the first unit with that body
+    std::unordered_map<std::string, size_t> bodies;
+    std::unordered_map<size_t, size_t> groupSizes;
+    for(size_t i = 0; i < units.size(); i++){
+        FunctionUnit& unit = units[i];
+        unit.foldedInto.clear();
+        if(unit.assembly == nullptr){
+            continue;
+        }
+        auto inserted = bodies.emplace(fingerprint(unit.assembly), i);
+        if(inserted.second){
+            continue;
+        }
+        size_t first = inserted.first->second;
+        unit.foldedInto = units[first].ast->getIdentifer();
+        report.folded++;
+        if(groupSizes[first]++ == 0){
+            report.groups++;
+        }
+        // the text path has no machine code to measure, the body is encoded just for the count
+        if(unit.code.empty()){
+            std::vector<uint8_t> callFrame, readOnlyData;
+            std::vector<CodeRelocation> relocations;
+            report.bytesSaved += X86Encoder::encodeFunction(unit.assembly, &callFrame, &relocations, &readOnlyData).size();
+        }else{
+            report.bytesSaved += unit.code.size();
+        }
+    }
+    return(report);
+}
+
+void CodeFolder::printReport(const std::vector<FunctionUnit>& units, const FoldingReport& report, std::ostream& out){
+    out << "===-------------------------------------------------------------===\n";
+    out << "                  Identical code folding report\n";
+    out << "===-------------------------------------------------------------===\n";
+    out << std::left << std::setw(32) << "function" << "alias of" << '\n';
+    for(const FunctionUnit& unit: units){
+        if(!unit.foldedInto.empty()){
+            out << std::left << std::setw(32) << unit.ast->getIdentifer() << unit.foldedInto << '\n';
+        }
+    }
+    out << report.folded << " of " << report.functions << " functions folded into " << report.groups
+        << " bodies, " << report.bytesSaved << " bytes of code saved\n";
+}
@@ -0,0 +1,63 @@
+#ifndef CODEFOLDING_HPP
+#define CODEFOLDING_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "PassManager.hpp"
+
+/**
+ * @brief What folding did to a program (-icf-report)
+ *
+ */
+struct FoldingReport {
+    size_t functions = 0;
+    /**
+     * @brief Functions turned into aliases
+     *
+     */
+    size_t folded = 0;
+    /**
+     * @brief Distinct bodies the folded functions now share
+     *
+     */
+    size_t groups = 0;
+    /**
+     * @brief Machine code bytes no longer emitted
+     *
+     */
+    size_t bytesSaved = 0;
+};
+
+// ======================================================
+//                     CodeFolder
+// ======================================================
+/**
+ * @brief Identical code folding: functions whose lowered instructions are the same are emitted once.
+ *
+ * Runs on the whole program once the pipeline is done with every function. The instruction stream of each
+ * IRFunctionNode (and whether it has a frame pointer) is printed into a fingerprint and the fingerprints are
+ * hashed into a table, so equal bodies are found in a single pass and compared in full, never by hash only.
+ * The first function of a group in source order keeps its body, the others get foldedInto set and are emitted
+ * as aliases of it: .set name, first in the assembly, a symbol at the same address in the ELF object and the
+ * same entry point in the JIT.
+ *
+ * Folding is always safe here: the language has no function pointers, so no program can tell two functions
+ * apart by their address. Units without assembly IR (direct-emit) are left alone. -fno-icf turns it off.
+ */
+class CodeFolder {
+    private:
+        static std::string fingerprint(IRFunctionNode* function);
+    public:
+        /**
+         * @brief Sets foldedInto on every function with the same body as an earlier one
+         *
+         * @param units in source order
+         * @return FoldingReport
+         */
+        static FoldingReport fold(std::vector<FunctionUnit>& units);
+        static void printReport(const std::vector<FunctionUnit>& units, const FoldingReport& report, std::ostream& out);
+};
+
+#endif // CODEFOLDING_HPP
@@ -0,0 +1,205 @@
+#include "ControlFlowGraph.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// Whether control never falls through to the next instruction
+static bool endsFlow(TackyInstruction* instr){
+    return(dynamic_cast<TackyJump*>(instr) != nullptr || dynamic_cast<TackyReturn*>(instr) != nullptr
+        || dynamic_cast<TackySwitch*>(instr) != nullptr);
+}
+
+// ======================================================
+//                     ControlFlowGraph
+// ======================================================
+ControlFlowGraph::ControlFlowGraph(const std::vector<TackyInstruction*>& body){
+    // leaders: the first instruction, every label, and whatever follows a jump or a return
+    std::unordered_map<std::string, uint32_t> blockOfLabel;
+    blockOfLabel.reserve(body.size() / 2);
+    bool startsBlock = true;
+    for(size_t i = 0; i < body.size(); i++){
+        TackyLabel* label = dynamic_cast<TackyLabel*>(body[i]);
+        if(startsBlock || label != nullptr){
+            if(!this->blocks.empty()){
+                this->blocks.back().end = i;
+            }
+            this->blocks.push_back(Block{i, body.size()});
+        }
+        if(label != nullptr){
+            if(!blockOfLabel.emplace(label->getIdentifier(), static_cast<uint32_t>(this->blocks.size() - 1)).second){
+                throw std::runtime_error("label " + label->getIdentifier() + " is defined twice");
+            }
+            startsBlock = false;
+        }else{
+            startsBlock = endsFlow(body[i]) || dynamic_cast<TackyJumpIfZero*>(body[i]) != nullptr;
+        }
+    }
+    auto targetOf = [&blockOfLabel](const std::string& label){
+        auto found = blockOfLabel.find(label);
+        if(found == blockOfLabel.end()){
+            throw std::runtime_error("jump to undefined label " + label);
+        }
+        return(found->second);
+    };
+
+    // the successors of each block are appended in block order, so the list is already grouped by block
+    uint32_t count = static_cast<uint32_t>(this->blocks.size());
+    this->successorStart.reserve(count + 1);
+    for(uint32_t b = 0; b < count; b++){
+        this->successorStart.push_back(static_cast<uint32_t>(this->successorList.size()));
+        TackyInstruction* last = body[this->blocks[b].end - 1];
+        if(TackyJump* jump = dynamic_cast<TackyJump*>(last)){
+            this->successorList.push_back(targetOf(jump->getTarget()));
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(last)){
+            // an edge is only listed once, however many cases share its label
+            size_t first = this->successorList.size();
+            this->successorList.push_back(targetOf(dispatch->getDefault()));
+            for(const std::pair<int32_t, std::string>& c: dispatch->getCases()){
+                this->successorList.push_back(targetOf(c.second));
+            }
+            std::sort(this->successorList.begin() + first, this->successorList.end());
+            this->successorList.erase(std::unique(this->successorList.begin() + first, this->successorList.end()), this->successorList.end());
+        }else if(dynamic_cast<TackyReturn*>(last) == nullptr){
+            if(b + 1 < count){
+                this->successorList.push_back(b + 1);
+            }
+            if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(last)){
+                uint32_t target = targetOf(branch->getTarget());
+                if(target != b + 1){
+                    this->successorList.push_back(target);
+                }
+            }
+        }
+    }
+    this->successorStart.push_back(static_cast<uint32_t>(this->successorList.size()));
+
+    // predecessors by counting sort of the edges on their target
+    this->predecessorStart.assign(count + 1, 0);
+    for(uint32_t target: this->successorList){
+        this->predecessorStart[target + 1]++;
+    }
+    for(uint32_t b = 0; b < count; b++){
+        this->predecessorStart[b + 1] += this->predecessorStart[b];
+    }
+    this->predecessorList.resize(this->successorList.size());
+    std::vector<uint32_t> next(this->predecessorStart.begin(), this->predecessorStart.end() - 1);
+    for(uint32_t b = 0; b < count; b++){
+        for(uint32_t target: successors(b)){
+            this->predecessorList[next[target]++] = b;
+        }
+    }
+}
+
+size_t ControlFlowGraph::size() const{
+    return(this->blocks.size());
+}
+
+const ControlFlowGraph::Block& ControlFlowGraph::getBlock(size_t block) const{
+    return(this->blocks[block]);
+}
+
+ControlFlowGraph::Edges ControlFlowGraph::successors(size_t block) const{
+    const uint32_t* list = this->successorList.data();
+    return(Edges{list + this->successorStart[block], list + this->successorStart[block + 1]});
+}
+
+ControlFlowGraph::Edges ControlFlowGraph::predecessors(size_t block) const{
+    const uint32_t* list = this->predecessorList.data();
+    return(Edges{list + this->predecessorStart[block], list + this->predecessorStart[block + 1]});
+}
+
+std::vector<uint32_t> ControlFlowGraph::reversePostorder() const{
+    std::vector<uint32_t> postorder;
+    if(this->blocks.empty()){
+        return(postorder);
+    }
+    postorder.reserve(this->blocks.size());
+    std::vector<char> visited(this->blocks.size(), 0);
+    // depth first with an explicit stack of (block, next successor to visit), a chain of 10^5 blocks would
+    // overflow the call stack
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    stack.push_back(std::make_pair(0u, this->successorStart[0]));
+    visited[0] = 1;
+    while(!stack.empty()){
+        std::pair<uint32_t, uint32_t>& top = stack.back();
+        if(top.second == this->successorStart[top.first + 1]){
+            postorder.push_back(top.first);
+            stack.pop_back();
+            continue;
+        }
+        uint32_t successor = this->successorList[top.second++];
+        if(!visited[successor]){
+            visited[successor] = 1;
+            stack.push_back(std::make_pair(successor, this->successorStart[successor]));
+        }
+    }
+    return(std::vector<uint32_t>(postorder.rbegin(), postorder.rend()));
+}
+
+std::vector<uint32_t> ControlFlowGraph::immediateDominators() const{
+    std::vector<uint32_t> idom(this->blocks.size(), UNREACHABLE);
+    std::vector<uint32_t> order = reversePostorder();
+    if(order.empty()){
+        return(idom);
+    }
+    // intersecting walks up the dominator tree, comparing positions in reverse postorder
+    std::vector<uint32_t> position(this->blocks.size(), 0);
+    for(uint32_t i = 0; i < order.size(); i++){
+        position[order[i]] = i;
+    }
+    auto intersect = [&idom, &position](uint32_t a, uint32_t b){
+        while(a != b){
+            while(position[a] > position[b]){
+                a = idom[a];
+            }
+            while(position[b] > position[a]){
+                b = idom[b];
+            }
+        }
+        return(a);
+    };
+    idom[order[0]] = order[0];
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(size_t i = 1; i < order.size(); i++){
+            uint32_t block = order[i];
+            uint32_t dominator = UNREACHABLE;
+            for(uint32_t predecessor: predecessors(block)){
+                if(idom[predecessor] == UNREACHABLE){
+                    continue;
+                }
+                dominator = dominator == UNREACHABLE ? predecessor : intersect(predecessor, dominator);
+            }
+            if(idom[block] != dominator){
+                idom[block] = dominator;
+                changed = true;
+            }
+        }
+    }
+    return(idom);
+}
+
+std::vector<char> ControlFlowGraph::reachable() const{
+    std::vector<char> flags(this->blocks.size(), 0);
+    for(uint32_t block: reversePostorder()){
+        flags[block] = 1;
+    }
+    return(flags);
+}
+
+void ControlFlowGraph::print(std::ostream& out) const{
+    for(size_t b = 0; b < this->blocks.size(); b++){
+        out << "block " << b << " [" << this->blocks[b].begin << ", " << this->blocks[b].end << ") preds:";
+        for(uint32_t predecessor: predecessors(b)){
+            out << " " << predecessor;
+        }
+        out << " succs:";
+        for(uint32_t successor: successors(b)){
+            out << " " << successor;
+        }
+        out << '\n';
+    }
+}
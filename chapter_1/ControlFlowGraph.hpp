@@ -0,0 +1,95 @@
+#ifndef CONTROLFLOWGRAPH_HPP
+#define CONTROLFLOWGRAPH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "Tacky.hpp"
+
+// ======================================================
+//                     ControlFlowGraph
+// ======================================================
+/**
+ * @brief The basic blocks of the TAC of a function and the edges between them.
+ *
+ * The body stays a single vector of instructions and a block is a range [begin, end) of it. A block starts at
+ * the first instruction, at every label and after every jump or return, so only the last instruction of a
+ * block can leave it. Blocks are numbered in body order, block 0 is the entry. A block ending with
+ *      Return          has no successor
+ *      Jump            has the block of the label
+ *      JumpIfZero      has the next block, then the block of the label (once if they are the same)
+ *      Switch          has the blocks of its labels, each once, in block order
+ *      anything else   has the next block, none for the last block
+ *
+ * The edges are kept in compressed arrays, the successors of block b are the indices
+ * successorList[successorStart[b] .. successorStart[b + 1]) and the same for the predecessors. Building them
+ * takes two walks over the body and a counting sort for the predecessors, with no allocation per block, and
+ * the analyses are iterative and look at each block and edge a constant number of times. Everything is linear
+ * in the size of the function.
+ */
+class ControlFlowGraph {
+    public:
+        struct Block {
+            size_t begin;
+            size_t end;
+        };
+        /**
+         * @brief The successor or predecessor indices of a block, pointing into the graph
+         *
+         */
+        struct Edges {
+            const uint32_t* first;
+            const uint32_t* last;
+            const uint32_t* begin() const { return first; }
+            const uint32_t* end() const { return last; }
+            size_t size() const { return static_cast<size_t>(last - first); }
+        };
+    private:
+        std::vector<Block> blocks;
+        std::vector<uint32_t> successorStart;
+        std::vector<uint32_t> successorList;
+        std::vector<uint32_t> predecessorStart;
+        std::vector<uint32_t> predecessorList;
+    public:
+        /**
+         * @brief Splits the body into blocks and links them. Throws if a jump targets a label the body doesn't have.
+         *
+         * @param body
+         */
+        explicit ControlFlowGraph(const std::vector<TackyInstruction*>& body);
+        size_t size() const;
+        const Block& getBlock(size_t block) const;
+        Edges successors(size_t block) const;
+        Edges predecessors(size_t block) const;
+        /**
+         * @brief The blocks reachable from the entry in reverse postorder: every block comes before its
+         * successors, except along the back edges of loops
+         *
+         * @return std::vector<uint32_t>
+         */
+        std::vector<uint32_t> reversePostorder() const;
+        /**
+         * @brief The immediate dominator of every block, by the iterative algorithm of Cooper, Harvey and Kennedy
+         * over the reverse postorder. The entry is its own immediate dominator and the blocks not reachable from
+         * the entry get UNREACHABLE. Without back edges one pass over the blocks settles every dominator.
+         *
+         * @return std::vector<uint32_t>
+         */
+        std::vector<uint32_t> immediateDominators() const;
+        static constexpr uint32_t UNREACHABLE = UINT32_MAX;
+        /**
+         * @brief One flag per block, set for the blocks reachable from the entry
+         *
+         * @return std::vector<char>
+         */
+        std::vector<char> reachable() const;
+        /**
+         * @brief Prints every block with its instruction range and its edges (print-cfg)
+         *
+         * @param out
+         */
+        void print(std::ostream& out) const;
+};
+
+#endif // CONTROLFLOWGRAPH_HPP
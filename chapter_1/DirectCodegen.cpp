@@ -0,0 +1,423 @@
+#include "DirectCodegen.hpp"
+#include "Optimizer.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// ======================================================
+//                     DirectCodeGenerator
+// ======================================================
+// Helper giving the operand a constant or a variable can be used as directly, empty for anything else
+static std::string leafOperand(ExpressionNode* exp, const std::unordered_map<std::string, std::string>& slots){
+    if(ConstantNode* constant = dynamic_cast<ConstantNode*>(exp)){
+        return("$" + std::to_string(TackySimplifier::wrapConstant(constant->getValue())));
+    }
+    if(VariableNode* variable = dynamic_cast<VariableNode*>(exp)){
+        return(slots.at(variable->getIdentifier()));
+    }
+    return("");
+}
+
+// Helper giving the condition suffix of setcc for a comparison operator, empty for any other operator
+static std::string conditionSuffix(BinaryOperator op){
+    switch(op){
+        case BinaryOperator::LessThan: return("l");
+        case BinaryOperator::LessOrEqual: return("le");
+        case BinaryOperator::GreaterThan: return("g");
+        case BinaryOperator::GreaterOrEqual: return("ge");
+        case BinaryOperator::Equal: return("e");
+        case BinaryOperator::NotEqual: return("ne");
+        default: return("");
+    }
+}
+
+void DirectCodeGenerator::emitExpression(ExpressionNode* exp, FunctionState& state, size_t depth, std::string& out){
+    if(ConstantNode* constant = dynamic_cast<ConstantNode*>(exp)){
+        out += "\tmovl $";
+        out += std::to_string(TackySimplifier::wrapConstant(constant->getValue()));
+        out += ", %eax\n";
+    }else if(UnaryNode* unary = dynamic_cast<UnaryNode*>(exp)){
+        emitExpression(unary->getExpression(), state, depth, out);
+        switch(unary->get_unary_operator()){
+            case UnaryOperator::Complement: out += "\tnotl %eax\n"; break;
+            case UnaryOperator::Negation: out += "\tnegl %eax\n"; break;
+            case UnaryOperator::Increment: out += "\tincl %eax\n"; break;
+            case UnaryOperator::Decrement: out += "\tdecl %eax\n"; break;
+            case UnaryOperator::LogicalNot: out += "\tcmpl $0, %eax\n\tsete %al\n\tmovzbl %al, %eax\n"; break;
+            default: throw std::runtime_error("Cannot generate code for unknown unary operator");
+        }
+    }else if(VariableNode* variable = dynamic_cast<VariableNode*>(exp)){
+        out += "\tmovl " + state.slots.at(variable->getIdentifier()) + ", %eax\n";
+    }else if(AssignmentNode* assignment = dynamic_cast<AssignmentNode*>(exp)){
+        emitExpression(assignment->getExpression(), state, depth, out);
+        out += "\tmovl %eax, " + state.slots.at(assignment->getVariable()->getIdentifier()) + "\n";
+    }else if(BinaryNode* binary = dynamic_cast<BinaryNode*>(exp)){
+        // the left operands of a chain are emitted in a loop, so a + b + ... + z doesn't recurse once per operator.
+        // Going down, a right operand that isn't a constant or a variable is computed first and kept in the
+        // temporary slot of its depth while the left operand is, the operators are applied on the way back up
+        std::vector<BinaryNode*> chain;
+        std::vector<size_t> depths;
+        std::vector<std::string> rights;
+        ExpressionNode* leaf = exp;
+        while((binary = dynamic_cast<BinaryNode*>(leaf)) != nullptr){
+            BinaryOperator op = binary->getBinaryOperator();
+            chain.push_back(binary);
+            depths.push_back(depth);
+            std::string right;
+            if(op != BinaryOperator::Comma && op != BinaryOperator::LogicalAnd && op != BinaryOperator::LogicalOr){
+                right = leafOperand(binary->getRight(), state.slots);
+                if(right.empty()){
+                    emitExpression(binary->getRight(), state, depth, out);
+                    right = std::to_string(-4 * static_cast<int>(state.variables + depth + 1)) + (state.framePointer ? "(%rbp)" : "(%rsp)");
+                    out += "\tmovl %eax, " + right + "\n";
+                    depth++;
+                }
+            }
+            rights.push_back(right);
+            leaf = binary->getLeft();
+        }
+        emitExpression(leaf, state, depth, out);
+        for(size_t i = chain.size(); i-- > 0;){
+            binary = chain[i];
+            std::string right = rights[i];
+            switch(binary->getBinaryOperator()){
+                case BinaryOperator::Comma:
+                    emitExpression(binary->getRight(), state, depths[i], out);
+                    break;
+                case BinaryOperator::LogicalAnd:
+                case BinaryOperator::LogicalOr: {
+                    // both paths reach the label with the flags of cmpl $0 on the last operand evaluated, which is
+                    // the value of the whole expression
+                    std::string done = ".L" + state.name + ".logical." + std::to_string(state.labels++);
+                    out += "\tcmpl $0, %eax\n";
+                    out += (binary->getBinaryOperator() == BinaryOperator::LogicalAnd ? "\tje " : "\tjne ") + done + "\n";
+                    emitExpression(binary->getRight(), state, depths[i], out);
+                    out += "\tcmpl $0, %eax\n" + done + ":\n\tsetne %al\n\tmovzbl %al, %eax\n";
+                    break;
+                }
+                case BinaryOperator::Add: out += "\taddl " + right + ", %eax\n"; break;
+                case BinaryOperator::Subtract: out += "\tsubl " + right + ", %eax\n"; break;
+                case BinaryOperator::Multiply: out += "\timull " + right + ", %eax\n"; break;
+                case BinaryOperator::BitwiseAnd: out += "\tandl " + right + ", %eax\n"; break;
+                case BinaryOperator::BitwiseOr: out += "\torl " + right + ", %eax\n"; break;
+                case BinaryOperator::BitwiseXor: out += "\txorl " + right + ", %eax\n"; break;
+                case BinaryOperator::LeftShift:
+                case BinaryOperator::RightShift: {
+                    std::string mnemonic = binary->getBinaryOperator() == BinaryOperator::LeftShift ? "\tsall " : "\tsarl ";
+                    if(right[0] == '$'){
+                        out += mnemonic + "$" + std::to_string(TackySimplifier::wrapConstant(right.substr(1)) & 31) + ", %eax\n";
+                    }else{
+                        out += "\tmovl " + right + ", %ecx\n" + mnemonic + "%cl, %eax\n";
+                    }
+                    break;
+                }
+                case BinaryOperator::Divide:
+                case BinaryOperator::Remainder:
+                    if(right[0] == '$'){
+                        // idivl has no immediate form
+                        out += "\tmovl " + right + ", %ecx\n";
+                        right = "%ecx";
+                    }
+                    out += "\tcltd\n\tidivl " + right + "\n";
+                    if(binary->getBinaryOperator() == BinaryOperator::Remainder){
+                        out += "\tmovl %edx, %eax\n";
+                    }
+                    break;
+                default: {
+                    std::string suffix = conditionSuffix(binary->getBinaryOperator());
+                    if(suffix.empty()){
+                        throw std::runtime_error("DirectCodegen: unhandled binary operator " + binary_operator_to_string(binary->getBinaryOperator()));
+                    }
+                    out += "\tcmpl " + right + ", %eax\n\tset" + suffix + " %al\n\tmovzbl %al, %eax\n";
+                }
+            }
+        }
+    }else if(ConditionalNode* conditional = dynamic_cast<ConditionalNode*>(exp)){
+        std::string number = std::to_string(state.labels++);
+        std::string end = ".L" + state.name + ".end." + number;
+        std::string otherwise = ".L" + state.name + ".else." + number;
+        emitExpression(conditional->getCondition(), state, depth, out);
+        out += "\tcmpl $0, %eax\n\tje " + otherwise + "\n";
+        emitExpression(conditional->getThen(), state, depth, out);
+        out += "\tjmp " + end + "\n" + otherwise + ":\n";
+        emitExpression(conditional->getElse(), state, depth, out);
+        out += end + ":\n";
+    }else if(FunctionCallNode* call = dynamic_cast<FunctionCallNode*>(exp)){
+        // the arguments that aren't a constant or a variable are computed in order, each one parked in the
+        // temporary slot of the next depth. A function making a call always has a %rbp frame
+        std::vector<std::string> operands;
+        for(ExpressionNode* argument: call->getArguments()){
+            std::string operand = leafOperand(argument, state.slots);
+            if(operand.empty()){
+                emitExpression(argument, state, depth, out);
+                operand = std::to_string(-4 * static_cast<int>(state.variables + depth + 1)) + "(%rbp)";
+                out += "\tmovl %eax, " + operand + "\n";
+                depth++;
+            }
+            operands.push_back(operand);
+        }
+        static const char* const registers[] = { "%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d" };
+        const size_t registerCount = sizeof(registers) / sizeof(registers[0]);
+        size_t stackArguments = operands.size() > registerCount ? operands.size() - registerCount : 0;
+        // the stack arguments are pushed last first, after a padding slot when %rsp would be left unaligned
+        if(stackArguments % 2 != 0){
+            out += "\tpushq $0\n";
+        }
+        for(size_t k = operands.size(); k-- > registerCount;){
+            if(operands[k][0] == '$'){
+                out += "\tpushq " + operands[k] + "\n";
+            }else{
+                out += "\tmovl " + operands[k] + ", %eax\n\tpushq %rax\n";
+            }
+        }
+        for(size_t k = 0; k < operands.size() && k < registerCount; k++){
+            out += "\tmovl " + operands[k] + ", " + registers[k] + "\n";
+        }
+        out += "\tcall " + call->getIdentifier() + "\n";
+        if(stackArguments > 0){
+            out += "\taddq $" + std::to_string(8 * (stackArguments + stackArguments % 2)) + ", %rsp\n";
+        }
+    }else{
+        throw std::runtime_error("Cannot generate code for unknown expression");
+    }
+}
+
+void DirectCodeGenerator::emitStatement(StatementNode* statement, FunctionState& state, std::string& out){
+    switch(statement->getType()){
+        case StatementType::RETURN:
+            emitExpression(static_cast<ReturnNode*>(statement)->getExpression(), state, 0, out);
+            if(state.framePointer){
+                // the code after the return still runs inside the frame
+                out += "\t.cfi_remember_state\n\tmovq %rbp, %rsp\n\tpopq %rbp\n\t.cfi_def_cfa %rsp, 8\n\tret\n";
+                out += "\t.cfi_restore_state\n";
+            }else{
+                out += "\tret\n";
+            }
+            break;
+        case StatementType::EXPRESSION:
+            emitExpression(static_cast<ExpressionStatementNode*>(statement)->getExpression(), state, 0, out);
+            break;
+        case StatementType::IF: {
+            IfNode* ifNode = static_cast<IfNode*>(statement);
+            std::string number = std::to_string(state.labels++);
+            std::string end = ".L" + state.name + ".end." + number;
+            std::string otherwise = ".L" + state.name + ".else." + number;
+            emitExpression(ifNode->getCondition(), state, 0, out);
+            out += "\tcmpl $0, %eax\n\tje " + (ifNode->getElse() == nullptr ? end : otherwise) + "\n";
+            emitStatement(ifNode->getThen(), state, out);
+            if(ifNode->getElse() != nullptr){
+                out += "\tjmp " + end + "\n" + otherwise + ":\n";
+                emitStatement(ifNode->getElse(), state, out);
+            }
+            out += end + ":\n";
+            break;
+        }
+        case StatementType::COMPOUND:
+            for(StatementNode* inner: static_cast<CompoundNode*>(statement)->getStatements()){
+                emitStatement(inner, state, out);
+            }
+            break;
+        case StatementType::NULL_STATEMENT:
+            break;
+        case StatementType::SWITCH: {
+            SwitchNode* switchNode = static_cast<SwitchNode*>(statement);
+            std::string number = std::to_string(state.labels++);
+            std::string end = ".L" + state.name + ".break." + number;
+            emitExpression(switchNode->getExpression(), state, 0, out);
+            for(size_t i = 0; i < switchNode->getCases().size(); i++){
+                CaseNode* caseNode = switchNode->getCases()[i];
+                std::string label = ".L" + state.name + ".case." + number + "." + std::to_string(i);
+                state.caseLabels[caseNode] = label;
+                out += "\tcmpl $" + std::to_string(caseNode->getValue()) + ", %eax\n\tje " + label + "\n";
+            }
+            std::string otherwise = end;
+            if(switchNode->getDefault() != nullptr){
+                otherwise = ".L" + state.name + ".default." + number;
+                state.caseLabels[switchNode->getDefault()] = otherwise;
+            }
+            out += "\tjmp " + otherwise + "\n";
+            state.breakLabels.push_back(end);
+            emitStatement(switchNode->getBody(), state, out);
+            state.breakLabels.pop_back();
+            out += end + ":\n";
+            break;
+        }
+        case StatementType::CASE:
+            out += state.caseLabels.at(statement) + ":\n";
+            emitStatement(static_cast<CaseNode*>(statement)->getStatement(), state, out);
+            break;
+        case StatementType::DEFAULT:
+            out += state.caseLabels.at(statement) + ":\n";
+            emitStatement(static_cast<DefaultNode*>(statement)->getStatement(), state, out);
+            break;
+        case StatementType::BREAK:
+            out += "\tjmp " + state.breakLabels.back() + "\n";
+            break;
+        case StatementType::DECLARATION: {
+            DeclarationNode* declaration = static_cast<DeclarationNode*>(statement);
+            int offset = -4 * static_cast<int>(state.slots.size() + 1);
+            std::string slot = std::to_string(offset) + (state.framePointer ? "(%rbp)" : "(%rsp)");
+            state.slots.emplace(declaration->getIdentifier(), slot);
+            if(declaration->getInit() != nullptr){
+                emitExpression(declaration->getInit(), state, 0, out);
+                out += "\tmovl %eax, " + slot + "\n";
+            }
+            break;
+        }
+    }
+}
+
+size_t DirectCodeGenerator::countDeclarations(StatementNode* statement){
+    switch(statement->getType()){
+        case StatementType::DECLARATION:
+            return(1);
+        case StatementType::IF: {
+            IfNode* ifNode = static_cast<IfNode*>(statement);
+            return(countDeclarations(ifNode->getThen()) + (ifNode->getElse() == nullptr ? 0 : countDeclarations(ifNode->getElse())));
+        }
+        case StatementType::COMPOUND: {
+            size_t count = 0;
+            for(StatementNode* inner: static_cast<CompoundNode*>(statement)->getStatements()){
+                count += countDeclarations(inner);
+            }
+            return(count);
+        }
+        case StatementType::SWITCH:
+            return(countDeclarations(static_cast<SwitchNode*>(statement)->getBody()));
+        case StatementType::CASE:
+            return(countDeclarations(static_cast<CaseNode*>(statement)->getStatement()));
+        case StatementType::DEFAULT:
+            return(countDeclarations(static_cast<DefaultNode*>(statement)->getStatement()));
+        default:
+            return(0);
+    }
+}
+
+size_t DirectCodeGenerator::countTemporaries(ExpressionNode* exp, bool& calls){
+    if(UnaryNode* unary = dynamic_cast<UnaryNode*>(exp)){
+        return(countTemporaries(unary->getExpression(), calls));
+    }else if(AssignmentNode* assignment = dynamic_cast<AssignmentNode*>(exp)){
+        return(countTemporaries(assignment->getExpression(), calls));
+    }else if(BinaryNode* binary = dynamic_cast<BinaryNode*>(exp)){
+        // the left operands of a chain are counted in a loop, bottom up
+        std::vector<BinaryNode*> chain;
+        ExpressionNode* leaf = exp;
+        while((binary = dynamic_cast<BinaryNode*>(leaf)) != nullptr){
+            chain.push_back(binary);
+            leaf = binary->getLeft();
+        }
+        size_t count = countTemporaries(leaf, calls);
+        for(size_t i = chain.size(); i-- > 0;){
+            BinaryOperator op = chain[i]->getBinaryOperator();
+            ExpressionNode* right = chain[i]->getRight();
+            if(op == BinaryOperator::Comma || op == BinaryOperator::LogicalAnd || op == BinaryOperator::LogicalOr){
+                count = std::max(count, countTemporaries(right, calls));
+            }else if(dynamic_cast<ConstantNode*>(right) == nullptr && dynamic_cast<VariableNode*>(right) == nullptr){
+                count = std::max(countTemporaries(right, calls), count + 1);
+            }
+        }
+        return(count);
+    }else if(ConditionalNode* conditional = dynamic_cast<ConditionalNode*>(exp)){
+        return(std::max(countTemporaries(conditional->getCondition(), calls),
+            std::max(countTemporaries(conditional->getThen(), calls), countTemporaries(conditional->getElse(), calls))));
+    }else if(FunctionCallNode* call = dynamic_cast<FunctionCallNode*>(exp)){
+        calls = true;
+        // the arguments computed before one stay parked while it is
+        size_t count = 0;
+        size_t parked = 0;
+        for(ExpressionNode* argument: call->getArguments()){
+            count = std::max(count, parked + countTemporaries(argument, calls));
+            if(dynamic_cast<ConstantNode*>(argument) == nullptr && dynamic_cast<VariableNode*>(argument) == nullptr){
+                parked++;
+            }
+        }
+        return(std::max(count, parked));
+    }
+    return(0);
+}
+
+size_t DirectCodeGenerator::countTemporaries(StatementNode* statement, bool& calls){
+    switch(statement->getType()){
+        case StatementType::RETURN:
+            return(countTemporaries(static_cast<ReturnNode*>(statement)->getExpression(), calls));
+        case StatementType::EXPRESSION:
+            return(countTemporaries(static_cast<ExpressionStatementNode*>(statement)->getExpression(), calls));
+        case StatementType::DECLARATION: {
+            ExpressionNode* init = static_cast<DeclarationNode*>(statement)->getInit();
+            return(init == nullptr ? 0 : countTemporaries(init, calls));
+        }
+        case StatementType::IF: {
+            IfNode* ifNode = static_cast<IfNode*>(statement);
+            size_t count = std::max(countTemporaries(ifNode->getCondition(), calls), countTemporaries(ifNode->getThen(), calls));
+            return(ifNode->getElse() == nullptr ? count : std::max(count, countTemporaries(ifNode->getElse(), calls)));
+        }
+        case StatementType::COMPOUND: {
+            size_t count = 0;
+            for(StatementNode* inner: static_cast<CompoundNode*>(statement)->getStatements()){
+                count = std::max(count, countTemporaries(inner, calls));
+            }
+            return(count);
+        }
+        case StatementType::SWITCH: {
+            SwitchNode* switchNode = static_cast<SwitchNode*>(statement);
+            return(std::max(countTemporaries(switchNode->getExpression(), calls), countTemporaries(switchNode->getBody(), calls)));
+        }
+        case StatementType::CASE:
+            return(countTemporaries(static_cast<CaseNode*>(statement)->getStatement(), calls));
+        case StatementType::DEFAULT:
+            return(countTemporaries(static_cast<DefaultNode*>(statement)->getStatement(), calls));
+        default:
+            return(0);
+    }
+}
+
+void DirectCodeGenerator::emitFunction(FunctionNode* function, std::string& out){
+    FunctionState state;
+    state.name = function->getIdentifer();
+    const std::string& name = state.name;
+    const std::vector<StatementNode*>& body = function->getBody();
+    const std::vector<std::string>& parameters = function->getParameters();
+    size_t variables = parameters.size();
+    size_t temporaries = 0;
+    bool calls = false;
+    for(StatementNode* statement: body){
+        variables += countDeclarations(statement);
+        temporaries = std::max(temporaries, countTemporaries(statement, calls));
+    }
+    state.variables = variables;
+    // a leaf only needs a frame for variables and temporaries that don't fit in the red zone, a call would push
+    // its return address over them
+    variables += temporaries;
+    state.framePointer = calls || 4 * variables > 128;
+    out += "\t.p2align 4\n";
+    if(!function->isInternal()){
+        out += "\t.global " + name + "\n";
+    }
+    out += "\t.type " + name + ", @function\n";
+    out += name + ":\n\t.cfi_startproc\n";
+    if(state.framePointer){
+        out += "\tpushq %rbp\n\t.cfi_def_cfa_offset 16\n\t.cfi_offset %rbp, -16\n\tmovq %rsp, %rbp\n";
+        out += "\t.cfi_def_cfa_register %rbp\n\tsubq $" + std::to_string((4 * variables + 15) / 16 * 16) + ", %rsp\n";
+    }
+    // each parameter is copied into the first slots, from its register or from above the return address
+    static const char* const registers[] = { "%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d" };
+    for(size_t k = 0; k < parameters.size(); k++){
+        std::string slot = std::to_string(-4 * static_cast<int>(k + 1)) + (state.framePointer ? "(%rbp)" : "(%rsp)");
+        state.slots.emplace(parameters[k], slot);
+        if(k < 6){
+            out += "\tmovl " + std::string(registers[k]) + ", " + slot + "\n";
+        }else{
+            int above = 8 * static_cast<int>(k - 6) + (state.framePointer ? 16 : 8);
+            out += "\tmovl " + std::to_string(above) + (state.framePointer ? "(%rbp)" : "(%rsp)") + ", %eax\n";
+            out += "\tmovl %eax, " + slot + "\n";
+        }
+    }
+    for(StatementNode* statement: body){
+        emitStatement(statement, state, out);
+    }
+    if(body.empty() || body.back()->getType() != StatementType::RETURN){
+        // falling off the end returns 0, like the TAC route
+        out += "\tmovl $0, %eax\n";
+        out += state.framePointer ? "\tmovq %rbp, %rsp\n\tpopq %rbp\n\t.cfi_def_cfa %rsp, 8\n\tret\n" : "\tret\n";
+    }
+    out += "\t.cfi_endproc\n\t.size " + name + ", .-" + name + "\n\n";
+}
@@ -0,0 +1,101 @@
+#ifndef DIRECTCODEGEN_HPP
+#define DIRECTCODEGEN_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AST.hpp"
+
+// ======================================================
+//                     DirectCodeGenerator
+// ======================================================
+/**
+ * @brief Fast compile path going straight from the AST to assembly text, without building the TAC or
+ * the assembly tree.
+ *
+ * It is an accumulator code generator: every expression leaves its value in %eax, so a constant is a single
+ * movl and each unary operator is one instruction applied to %eax on the way back up the tree. A binary operator
+ * whose right operand is a constant or a variable uses it in place (addl -4(%rsp), %eax), any other right operand
+ * is computed first and parked in a temporary slot, one per nesting depth. Division goes through cltd; idivl and a
+ * shift by anything but a constant moves its count into %ecx (sall %cl, %eax). A comparison is cmpl, setcc and
+ * movzbl. && and || jump over their right operand and meet on a single setne, ?: is a plain if/else. A switch
+ * compares %eax with each case in source order (cmpl/je) and then jumps to the default, no table or tree.
+ * A call parks its computed arguments in temporary slots, pushes the ones past the sixth and loads the rest into
+ * %edi, %esi, %edx, %ecx, %r8d and %r9d; the parameters are copied into the first slots at entry.
+ * Every variable and temporary gets a slot of its own, in the red zone when they all fit (32 of them) and nothing
+ * is called, below a %rbp frame otherwise. The text is appended to the caller's buffer as the tree is walked.
+ *
+ * The code is correct for the whole language but not optimized, use the Tacky route (-O1, -O2) for release builds.
+ * Selected with -fast, which runs the single pass direct-emit.
+ */
+class DirectCodeGenerator {
+    private:
+        /**
+         * @brief What the walk of one function needs to know
+         *
+         */
+        struct FunctionState {
+            std::string name;
+            /**
+             * @brief Number of ifs, ?:, &&, || and switches seen so far, labels are local to the function
+             *
+             */
+            int labels = 0;
+            /**
+             * @brief Label of every case and default of the switches seen so far
+             *
+             */
+            std::unordered_map<const StatementNode*, std::string> caseLabels;
+            /**
+             * @brief Where a break goes, the end of each enclosing switch (innermost last)
+             *
+             */
+            std::vector<std::string> breakLabels;
+            /**
+             * @brief The slot of every variable declared so far, as an operand (i.e "-4(%rsp)")
+             *
+             */
+            std::unordered_map<std::string, std::string> slots;
+            /**
+             * @brief Set when the variables don't fit in the red zone and the function has a %rbp frame
+             *
+             */
+            bool framePointer = false;
+            /**
+             * @brief Number of variables of the function, the temporary slots come after theirs
+             *
+             */
+            size_t variables = 0;
+        };
+        /**
+         * @brief Appends the code leaving the value of the expression in %eax
+         *
+         * @param depth number of temporary slots holding the right operands of the enclosing binary operators
+         */
+        static void emitExpression(ExpressionNode* exp, FunctionState& state, size_t depth, std::string& out);
+        /**
+         * @brief Appends the statement. An if tests %eax after its condition (cmpl $0, %eax; je), a variable
+         * lives in its own stack slot and is stored to on every assignment.
+         *
+         */
+        static void emitStatement(StatementNode* statement, FunctionState& state, std::string& out);
+        static size_t countDeclarations(StatementNode* statement);
+        /**
+         * @brief Number of temporary slots the expressions of the statement need at once
+         *
+         * @param statement
+         * @param calls set when a function is called, the function then needs a %rbp frame
+         */
+        static size_t countTemporaries(StatementNode* statement, bool& calls);
+        static size_t countTemporaries(ExpressionNode* exp, bool& calls);
+    public:
+        /**
+         * @brief Appends the assembly of the function to out
+         *
+         * @param function
+         * @param out
+         */
+        static void emitFunction(FunctionNode* function, std::string& out);
+};
+
+#endif // DIRECTCODEGEN_HPP
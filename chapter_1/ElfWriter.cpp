@@ -0,0 +1,402 @@
+#include "ElfWriter.hpp"
+#include <elf.h>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// Appends a plain struct to the byte buffer
+template <typename T>
+static void appendStruct(std::vector<uint8_t>& out, const T& value){
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static void alignTo(std::vector<uint8_t>& out, size_t alignment){
+    while(out.size() % alignment != 0){
+        out.push_back(0);
+    }
+}
+
+// Adds a name to a string table and returns its offset
+static uint32_t addString(std::vector<uint8_t>& table, const std::string& name){
+    uint32_t offset = static_cast<uint32_t>(table.size());
+    table.insert(table.end(), name.begin(), name.end());
+    table.push_back(0);
+    return(offset);
+}
+
+// ======================================================
+//                     ElfObjectWriter
+// ======================================================
+size_t ElfObjectWriter::symbolIndex(const std::string& name){
+    auto found = this->symbolIndices.find(name);
+    if(found != this->symbolIndices.end()){
+        return(found->second);
+    }
+    this->symbolIndices[name] = this->symbols.size();
+    this->symbols.push_back(Symbol{name, 0, 0, false, 0, true});
+    return(this->symbols.size() - 1);
+}
+
+int ElfObjectWriter::sectionIndex(const std::string& name) const{
+    for(size_t i = 0; i < this->sections.size(); i++){
+        if(this->sections[i].name == name){
+            return(static_cast<int>(i));
+        }
+    }
+    return(-1);
+}
+
+void ElfObjectWriter::setCodeSection(const std::string& name){
+    for(size_t i = 0; i < this->code.size(); i++){
+        if(this->code[i].name == name){
+            this->current = i;
+            return;
+        }
+    }
+    if(sectionIndex(name) != -1){
+        throw std::runtime_error("Section " + name + " already holds data");
+    }
+    this->code.push_back(CodeSection{name, {}, {}});
+    this->current = this->code.size() - 1;
+}
+
+uint64_t ElfObjectWriter::addFunction(const std::string& name, const std::vector<uint8_t>& code, const std::vector<uint8_t>& callFrame, bool global){
+    Symbol& symbol = this->symbols[symbolIndex(name)];
+    if(symbol.defined){
+        throw std::runtime_error("Function " + name + " is defined twice");
+    }
+    std::vector<uint8_t>& bytes = this->code[this->current].bytes;
+    symbol.value = bytes.size();
+    symbol.size = code.size();
+    symbol.defined = true;
+    symbol.section = this->current;
+    symbol.global = global;
+    this->frames.push_back(Frame{this->current, symbol.value, code.size(), callFrame});
+    bytes.insert(bytes.end(), code.begin(), code.end());
+    return(symbol.value);
+}
+
+void ElfObjectWriter::addPadding(const std::vector<uint8_t>& bytes){
+    std::vector<uint8_t>& text = this->code[this->current].bytes;
+    text.insert(text.end(), bytes.begin(), bytes.end());
+}
+
+uint64_t ElfObjectWriter::getTextSize() const{
+    return(this->code[this->current].bytes.size());
+}
+
+std::vector<uint8_t> ElfObjectWriter::buildEhFrame(std::vector<Relocation>& codeRelocations) const{
+    // CIE: version 1, "zR", code alignment 1, data alignment -8, return address in r16 (%rip), FDE pointers
+    // pc relative 4 bytes (0x1b), initial CFA %rsp + 8 with the return address at CFA - 8
+    std::vector<uint8_t> ehFrame = {
+        0x14, 0, 0, 0, 0, 0, 0, 0, 0x01, 'z', 'R', 0, 0x01, 0x78, 0x10, 0x01,
+        0x1B, 0x0C, 0x07, 0x08, 0x90, 0x01, 0, 0
+    };
+    for(size_t i = 0; i < this->frames.size(); i++){
+        const Frame& frame = this->frames[i];
+        size_t start = ehFrame.size();
+        appendStruct(ehFrame, uint32_t{0});
+        // CIE pointer: distance back from this field to the CIE
+        appendStruct(ehFrame, static_cast<uint32_t>(ehFrame.size()));
+        codeRelocations.push_back(Relocation{ehFrame.size(), this->code[frame.section].name, R_X86_64_PC32, static_cast<int64_t>(frame.offset)});
+        appendStruct(ehFrame, uint32_t{0});
+        appendStruct(ehFrame, static_cast<uint32_t>(frame.size));
+        // no augmentation data
+        ehFrame.push_back(0);
+        ehFrame.insert(ehFrame.end(), frame.callFrame.begin(), frame.callFrame.end());
+        // DW_CFA_nop up to 4 bytes, or 8 for the last FDE which ends the section
+        alignTo(ehFrame, i + 1 == this->frames.size() ? 8 : 4);
+        uint32_t length = static_cast<uint32_t>(ehFrame.size() - start - 4);
+        std::memcpy(ehFrame.data() + start, &length, sizeof(length));
+    }
+    return(ehFrame);
+}
+
+void ElfObjectWriter::addAlias(const std::string& name, const std::string& target, bool global){
+    auto found = this->symbolIndices.find(target);
+    if(found == this->symbolIndices.end() || !this->symbols[found->second].defined){
+        throw std::runtime_error("Alias " + name + " of the undefined function " + target);
+    }
+    Symbol aliased = this->symbols[found->second];
+    Symbol& symbol = this->symbols[symbolIndex(name)];
+    if(symbol.defined){
+        throw std::runtime_error("Function " + name + " is defined twice");
+    }
+    symbol.value = aliased.value;
+    symbol.size = aliased.size;
+    symbol.defined = true;
+    symbol.section = aliased.section;
+    symbol.global = global;
+}
+
+void ElfObjectWriter::addSection(const std::string& name, uint32_t type, uint64_t flags, uint64_t alignment,
+    const std::vector<uint8_t>& contents, uint64_t size){
+    if(sectionIndex(name) != -1){
+        throw std::runtime_error("Section " + name + " is added twice");
+    }
+    this->sections.push_back(Section{name, type, flags, alignment, contents, type == SHT_NOBITS ? size : contents.size()});
+}
+
+void ElfObjectWriter::addRelocation(uint64_t offset, const std::string& symbol, uint32_t type, int64_t addend){
+    if(sectionIndex(symbol) == -1){
+        symbolIndex(symbol);
+    }
+    this->code[this->current].relocations.push_back(Relocation{offset, symbol, type, addend});
+}
+
+void ElfObjectWriter::resolveLocalRelocations(){
+    for(size_t i = 0; i < this->code.size(); i++){
+        std::vector<Relocation> kept;
+        for(Relocation relocation: this->code[i].relocations){
+            auto found = this->symbolIndices.find(relocation.symbol);
+            if(found == this->symbolIndices.end() || !this->symbols[found->second].defined || this->symbols[found->second].global){
+                kept.push_back(relocation);
+                continue;
+            }
+            const Symbol& symbol = this->symbols[found->second];
+            if(symbol.section == i){
+                // S + A - P, both ends in the same section
+                int32_t value = static_cast<int32_t>(static_cast<int64_t>(symbol.value) + relocation.addend - static_cast<int64_t>(relocation.offset));
+                std::memcpy(this->code[i].bytes.data() + relocation.offset, &value, sizeof(value));
+                continue;
+            }
+            relocation.symbol = this->code[symbol.section].name;
+            relocation.type = R_X86_64_PC32;
+            relocation.addend += static_cast<int64_t>(symbol.value);
+            kept.push_back(relocation);
+        }
+        this->code[i].relocations = std::move(kept);
+    }
+}
+
+std::vector<uint8_t> ElfObjectWriter::serialize(){
+    resolveLocalRelocations();
+    // section indices, the optional sections come last so the others don't move when they are left out
+    const bool hasFrames = !this->frames.empty();
+    const uint16_t TEXT = 1, NOTE = 2, SYMTAB = 3, STRTAB = 4, SHSTRTAB = 5;
+    const uint16_t FIRST_DATA = 6;
+    uint16_t next = static_cast<uint16_t>(FIRST_DATA + this->sections.size());
+    // .text and then the other code sections
+    std::vector<uint16_t> codeIndices{TEXT};
+    for(size_t i = 1; i < this->code.size(); i++){
+        codeIndices.push_back(next++);
+    }
+    const uint16_t EH_FRAME = hasFrames ? next++ : 0;
+    const uint16_t RELA_EH_FRAME = hasFrames ? next++ : 0;
+    std::vector<uint16_t> relaIndices;
+    for(const CodeSection& section: this->code){
+        relaIndices.push_back(section.relocations.empty() ? 0 : next++);
+    }
+    const uint16_t sectionCount = next;
+    // the locals are the null symbol, the section symbols of the code sections (.text first) and those of the data
+    // sections relocations refer to
+    uint32_t firstGlobal = static_cast<uint32_t>(1 + this->code.size());
+    std::vector<int> sectionSymbols(this->sections.size(), 0);
+    for(const CodeSection& section: this->code){
+        for(const Relocation& relocation: section.relocations){
+            int data = sectionIndex(relocation.symbol);
+            if(data != -1 && sectionSymbols[data] == 0){
+                sectionSymbols[data] = static_cast<int>(firstGlobal++);
+            }
+        }
+    }
+    // then the static functions, the symbol table has every local before the first global
+    std::vector<size_t> symbolOrder;
+    for(size_t i = 0; i < this->symbols.size(); i++){
+        if(this->symbols[i].defined && !this->symbols[i].global){
+            symbolOrder.push_back(i);
+        }
+    }
+    const uint32_t firstSymbol = firstGlobal;
+    firstGlobal += static_cast<uint32_t>(symbolOrder.size());
+    for(size_t i = 0; i < this->symbols.size(); i++){
+        if(!this->symbols[i].defined || this->symbols[i].global){
+            symbolOrder.push_back(i);
+        }
+    }
+    std::vector<uint64_t> symbolEntries(this->symbols.size());
+    for(size_t k = 0; k < symbolOrder.size(); k++){
+        symbolEntries[symbolOrder[k]] = firstSymbol + k;
+    }
+    auto symbolOf = [this, &sectionSymbols, &symbolEntries](const std::string& name) -> uint64_t {
+        for(size_t i = 0; i < this->code.size(); i++){
+            if(this->code[i].name == name){
+                return(1 + i);
+            }
+        }
+        int data = sectionIndex(name);
+        return(data != -1 ? sectionSymbols[data] : symbolEntries[symbolIndex(name)]);
+    };
+
+    std::vector<uint8_t> strtab{0};
+    std::vector<uint8_t> symtab;
+    appendStruct(symtab, Elf64_Sym{});
+    Elf64_Sym sectionSymbol{};
+    sectionSymbol.st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+    for(uint16_t index: codeIndices){
+        sectionSymbol.st_shndx = index;
+        appendStruct(symtab, sectionSymbol);
+    }
+    for(size_t i = 0; i < this->sections.size(); i++){
+        if(sectionSymbols[i] != 0){
+            sectionSymbol.st_shndx = static_cast<uint16_t>(FIRST_DATA + i);
+            appendStruct(symtab, sectionSymbol);
+        }
+    }
+    for(size_t i: symbolOrder){
+        const Symbol& symbol = this->symbols[i];
+        Elf64_Sym sym{};
+        sym.st_name = addString(strtab, symbol.name);
+        sym.st_info = ELF64_ST_INFO(symbol.global ? STB_GLOBAL : STB_LOCAL, symbol.defined ? STT_FUNC : STT_NOTYPE);
+        sym.st_shndx = symbol.defined ? codeIndices[symbol.section] : SHN_UNDEF;
+        sym.st_value = symbol.value;
+        sym.st_size = symbol.size;
+        appendStruct(symtab, sym);
+    }
+
+    auto buildRela = [&symbolOf](const std::vector<Relocation>& relocations){
+        std::vector<uint8_t> rela;
+        for(const Relocation& relocation: relocations){
+            Elf64_Rela entry{};
+            entry.r_offset = relocation.offset;
+            entry.r_info = ELF64_R_INFO(symbolOf(relocation.symbol), relocation.type);
+            entry.r_addend = relocation.addend;
+            appendStruct(rela, entry);
+        }
+        return(rela);
+    };
+
+    std::vector<Relocation> frameRelocations;
+    std::vector<uint8_t> ehFrame = buildEhFrame(frameRelocations);
+    // against the section symbols of the code sections
+    std::vector<uint8_t> relaEhFrame = buildRela(frameRelocations);
+
+    std::vector<uint8_t> shstrtab{0};
+    uint32_t textName = addString(shstrtab, ".text");
+    uint32_t noteName = addString(shstrtab, ".note.GNU-stack");
+    uint32_t symtabName = addString(shstrtab, ".symtab");
+    uint32_t strtabName = addString(shstrtab, ".strtab");
+    uint32_t shstrtabName = addString(shstrtab, ".shstrtab");
+    uint32_t ehFrameName = addString(shstrtab, ".eh_frame");
+    uint32_t relaEhFrameName = addString(shstrtab, ".rela.eh_frame");
+    std::vector<uint32_t> codeNames, relaNames;
+    for(const CodeSection& section: this->code){
+        codeNames.push_back(section.name == ".text" ? textName : addString(shstrtab, section.name));
+        relaNames.push_back(section.relocations.empty() ? 0 : addString(shstrtab, ".rela" + section.name));
+    }
+    std::vector<uint32_t> dataNames;
+    for(const Section& section: this->sections){
+        dataNames.push_back(addString(shstrtab, section.name));
+    }
+
+    std::vector<uint8_t> out(sizeof(Elf64_Ehdr), 0);
+    std::vector<Elf64_Shdr> headers(sectionCount, Elf64_Shdr{});
+    auto place = [&out, &headers](uint16_t index, const std::vector<uint8_t>& contents, size_t alignment){
+        alignTo(out, alignment);
+        headers[index].sh_offset = out.size();
+        headers[index].sh_size = contents.size();
+        headers[index].sh_addralign = alignment;
+        out.insert(out.end(), contents.begin(), contents.end());
+    };
+
+    auto placeCode = [&](size_t i){
+        place(codeIndices[i], this->code[i].bytes, 16);
+        headers[codeIndices[i]].sh_name = codeNames[i];
+        headers[codeIndices[i]].sh_type = SHT_PROGBITS;
+        headers[codeIndices[i]].sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+    };
+    placeCode(0);
+
+    place(NOTE, std::vector<uint8_t>{}, 1);
+    headers[NOTE].sh_name = noteName;
+    headers[NOTE].sh_type = SHT_PROGBITS;
+
+    place(SYMTAB, symtab, 8);
+    headers[SYMTAB].sh_name = symtabName;
+    headers[SYMTAB].sh_type = SHT_SYMTAB;
+    headers[SYMTAB].sh_link = STRTAB;
+    headers[SYMTAB].sh_info = firstGlobal;
+    headers[SYMTAB].sh_entsize = sizeof(Elf64_Sym);
+
+    place(STRTAB, strtab, 1);
+    headers[STRTAB].sh_name = strtabName;
+    headers[STRTAB].sh_type = SHT_STRTAB;
+
+    place(SHSTRTAB, shstrtab, 1);
+    headers[SHSTRTAB].sh_name = shstrtabName;
+    headers[SHSTRTAB].sh_type = SHT_STRTAB;
+
+    for(size_t i = 0; i < this->sections.size(); i++){
+        const Section& section = this->sections[i];
+        uint16_t index = static_cast<uint16_t>(FIRST_DATA + i);
+        place(index, section.contents, section.alignment);
+        headers[index].sh_name = dataNames[i];
+        headers[index].sh_type = section.type;
+        headers[index].sh_flags = section.flags;
+        headers[index].sh_size = section.size;
+    }
+
+    for(size_t i = 1; i < this->code.size(); i++){
+        placeCode(i);
+    }
+
+    if(hasFrames){
+        place(EH_FRAME, ehFrame, 8);
+        headers[EH_FRAME].sh_name = ehFrameName;
+        headers[EH_FRAME].sh_type = SHT_PROGBITS;
+        headers[EH_FRAME].sh_flags = SHF_ALLOC;
+
+        place(RELA_EH_FRAME, relaEhFrame, 8);
+        headers[RELA_EH_FRAME].sh_name = relaEhFrameName;
+        headers[RELA_EH_FRAME].sh_type = SHT_RELA;
+        headers[RELA_EH_FRAME].sh_flags = SHF_INFO_LINK;
+        headers[RELA_EH_FRAME].sh_link = SYMTAB;
+        headers[RELA_EH_FRAME].sh_info = EH_FRAME;
+        headers[RELA_EH_FRAME].sh_entsize = sizeof(Elf64_Rela);
+    }
+
+    for(size_t i = 0; i < this->code.size(); i++){
+        uint16_t rela = relaIndices[i];
+        if(rela == 0){
+            continue;
+        }
+        place(rela, buildRela(this->code[i].relocations), 8);
+        headers[rela].sh_name = relaNames[i];
+        headers[rela].sh_type = SHT_RELA;
+        headers[rela].sh_flags = SHF_INFO_LINK;
+        headers[rela].sh_link = SYMTAB;
+        headers[rela].sh_info = codeIndices[i];
+        headers[rela].sh_entsize = sizeof(Elf64_Rela);
+    }
+
+    alignTo(out, 8);
+    Elf64_Ehdr header{};
+    std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    header.e_type = ET_REL;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_shoff = out.size();
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_shentsize = sizeof(Elf64_Shdr);
+    header.e_shnum = sectionCount;
+    header.e_shstrndx = SHSTRTAB;
+    std::memcpy(out.data(), &header, sizeof(header));
+    for(const Elf64_Shdr& section: headers){
+        appendStruct(out, section);
+    }
+    return(out);
+}
+
+void ElfObjectWriter::writeFile(const std::string& path){
+    std::vector<uint8_t> object = serialize();
+    std::ofstream file{path, std::ios::binary};
+    if(!file.is_open()){
+        throw std::runtime_error("Could not open " + path + " for writing");
+    }
+    file.write(reinterpret_cast<const char*>(object.data()), static_cast<std::streamsize>(object.size()));
+}
@@ -0,0 +1,188 @@
+#ifndef ELFWRITER_HPP
+#define ELFWRITER_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ======================================================
+//                     ElfObjectWriter
+// ======================================================
+/**
+ * @brief Builds an ELF64 relocatable object (x86-64, System V) out of already encoded functions.
+ *
+ * The object has the sections the assembler would create for the text of IRProgramNode::filePrint:
+ * .text with every function one after the other (16 byte aligned, the gaps are left to the caller), or another
+ * executable section picked with setCodeSection (.text.unlikely for the cold functions of -fprofile-use), a global
+ * STT_FUNC symbol with the size of each of them, an empty .note.GNU-stack (the stack isn't executable),
+ * .eh_frame with one FDE per function and its .rela.eh_frame, and a .rela section for each code section with relocations.
+ * .eh_frame is laid out byte for byte like the assembler does it: one CIE (CFA = %rsp + 8 on entry) shared by
+ * every FDE, each FDE padded to 4 bytes and the last one to 8.
+ * Data sections (addSection) come after .shstrtab, a relocation against one of them goes through its STT_SECTION
+ * symbol like the assembler does for a local label.
+ * A static function gets a STB_LOCAL symbol, listed before the global ones. As with the assembler, a call to it from
+ * its own section is resolved on the spot and one from another section is relocated against that section's symbol.
+ */
+class ElfObjectWriter {
+    private:
+        struct Symbol {
+            std::string name;
+            /**
+             * @brief Offset of the symbol in its code section, ignored when it is undefined
+             *
+             */
+            uint64_t value;
+            uint64_t size;
+            bool defined;
+            /**
+             * @brief Index of the code section in code
+             *
+             */
+            size_t section;
+            /**
+             * @brief STB_GLOBAL, false for a static function (STB_LOCAL)
+             *
+             */
+            bool global;
+        };
+        /**
+         * @brief A function's entry in .eh_frame
+         *
+         */
+        struct Frame {
+            size_t section;
+            uint64_t offset;
+            uint64_t size;
+            std::vector<uint8_t> callFrame;
+        };
+        struct Relocation {
+            uint64_t offset;
+            std::string symbol;
+            uint32_t type;
+            int64_t addend;
+        };
+        /**
+         * @brief A section added with addSection
+         *
+         */
+        struct Section {
+            std::string name;
+            uint32_t type;
+            uint64_t flags;
+            uint64_t alignment;
+            std::vector<uint8_t> contents;
+            uint64_t size;
+        };
+        /**
+         * @brief An executable section and the relocations of the fields of its code
+         *
+         */
+        struct CodeSection {
+            std::string name;
+            std::vector<uint8_t> bytes;
+            std::vector<Relocation> relocations;
+        };
+        /**
+         * @brief The code sections, .text first and then in the order setCodeSection created them
+         *
+         */
+        std::vector<CodeSection> code{CodeSection{".text", {}, {}}};
+        /**
+         * @brief The code section functions, padding and relocations go to
+         *
+         */
+        size_t current = 0;
+        std::vector<Section> sections;
+        std::vector<Symbol> symbols;
+        std::unordered_map<std::string, size_t> symbolIndices;
+        std::vector<Frame> frames;
+        size_t symbolIndex(const std::string& name);
+        /**
+         * @brief Index in sections of the section with that name, -1 if there is none
+         *
+         */
+        int sectionIndex(const std::string& name) const;
+        /**
+         * @brief Builds .eh_frame, with the offsets of the pc_begin fields to relocate against the code sections
+         *
+         */
+        std::vector<uint8_t> buildEhFrame(std::vector<Relocation>& codeRelocations) const;
+        /**
+         * @brief Resolves the relocations against static functions: fills in the field when the function is in
+         * the same section, moves the relocation to the section symbol otherwise
+         *
+         */
+        void resolveLocalRelocations();
+    public:
+        /**
+         * @brief Makes the functions, padding and relocations added from now on go to an executable section,
+         * created the first time it is named (.text at the start)
+         *
+         * @param name
+         */
+        void setCodeSection(const std::string& name);
+        /**
+         * @brief Appends the code of a function to the current code section and defines its symbol
+         *
+         * @param name
+         * @param code
+         * @param callFrame the call frame instructions of its FDE (X86Encoder::encodeFunction)
+         * @param global false for a static function
+         * @return uint64_t offset of the function in its section
+         */
+        uint64_t addFunction(const std::string& name, const std::vector<uint8_t>& code, const std::vector<uint8_t>& callFrame, bool global);
+        /**
+         * @brief Appends bytes belonging to no function to the current code section (i.e the nops aligning the next function)
+         *
+         * @param bytes
+         */
+        void addPadding(const std::vector<uint8_t>& bytes);
+        /**
+         * @brief Size of the current code section
+         *
+         * @return uint64_t
+         */
+        uint64_t getTextSize() const;
+        /**
+         * @brief Defines a symbol at the same address and with the same size as an already added function
+         * (what .set name, target gives with the assembler)
+         *
+         * @param name
+         * @param target
+         * @param global false for a static function
+         */
+        void addAlias(const std::string& name, const std::string& target, bool global);
+        /**
+         * @brief Adds a data section (i.e the profile counters). Sections relocations refer to have to be added
+         * before those relocations.
+         *
+         * @param name
+         * @param type SHT_PROGBITS, or SHT_NOBITS for zeroed memory taking no room in the file
+         * @param flags SHF_* constants of <elf.h>
+         * @param alignment
+         * @param contents the bytes of the section, empty for SHT_NOBITS
+         * @param size the size of the section in memory, only used for SHT_NOBITS
+         */
+        void addSection(const std::string& name, uint32_t type, uint64_t flags, uint64_t alignment,
+            const std::vector<uint8_t>& contents, uint64_t size = 0);
+        /**
+         * @brief Records a relocation against a symbol (i.e R_X86_64_PLT32 for a call). Symbols that no function
+         * defines become undefined symbols for the linker to resolve, the name of an added section refers to its start.
+         *
+         * @param offset offset in the current code section of the field to patch
+         * @param symbol
+         * @param type one of the R_X86_64_* constants of <elf.h>
+         * @param addend
+         */
+        void addRelocation(uint64_t offset, const std::string& symbol, uint32_t type, int64_t addend);
+        /**
+         * @brief Lays out the whole object file
+         *
+         * @return std::vector<uint8_t>
+         */
+        std::vector<uint8_t> serialize();
+        void writeFile(const std::string& path);
+};
+
+#endif // ELFWRITER_HPP
@@ -0,0 +1,79 @@
+#include "FrameLayout.hpp"
+#include <algorithm>
+
+// ======================================================
+//                     FrameLayout
+// ======================================================
+bool FrameLayout::isLeaf(IRFunctionNode* function){
+    for(InstructionNode* instr: function->getInstructions()){
+        if(instr->getType() == CALL){
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool FrameLayout::layout(IRFunctionNode* function){
+    if(!function->hasFramePointer()){
+        // laid out already, moving the stack parameters down again would point them 8 bytes too low
+        return(false);
+    }
+    std::vector<InstructionNode*> instructions = function->getInstructions();
+    int allocated = 0;
+    if(!instructions.empty()){
+        if(AllocateStack* allocate = dynamic_cast<AllocateStack*>(instructions.front())){
+            allocated = allocate->getStackDecrementAmount();
+        }
+    }
+    // bytes below the frame actually used by the slots, the allocation is rounded up to 16
+    int used = 0;
+    std::vector<Stack*> slots;
+    std::vector<OperandNode*> reads, writes;
+    for(InstructionNode* instr: instructions){
+        reads.clear();
+        writes.clear();
+        instruction_operands(instr, reads, writes);
+        reads.insert(reads.end(), writes.begin(), writes.end());
+        for(OperandNode* op: reads){
+            if(op->getType() == STACK){
+                Stack* stack = static_cast<Stack*>(op);
+                used = std::max(used, -stack->getAmount());
+                slots.push_back(stack);
+            }
+        }
+    }
+    // an operand both read and written is listed twice, it must only be moved once
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+    if(isLeaf(function) && used <= RED_ZONE_SIZE){
+        // without the pushed %rbp, the slot at -k(%rbp) becomes -k(%rsp), inside the red zone, and a stack
+        // parameter at k(%rbp) above the return address is at k - 8(%rsp)
+        for(Stack* stack: slots){
+            stack->setBase(FrameBase::RSP);
+            if(stack->getAmount() > 0){
+                stack->setAmount(stack->getAmount() - 8);
+            }
+        }
+        std::vector<InstructionNode*> frameless;
+        frameless.reserve(instructions.size());
+        for(InstructionNode* instr: instructions){
+            if(instr->getType() == ALLOCATE){
+                continue;
+            }
+            if(instr->getType() == RET){
+                static_cast<IRReturnNode*>(instr)->setRestoresFrame(false);
+            }
+            frameless.push_back(instr);
+        }
+        function->setInstructions(frameless);
+        function->setFramePointer(false);
+        return(true);
+    }
+
+    if(allocated == 0 && !instructions.empty() && instructions.front()->getType() == ALLOCATE){
+        instructions.erase(instructions.begin());
+        function->setInstructions(instructions);
+    }
+    return(false);
+}
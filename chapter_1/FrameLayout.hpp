@@ -0,0 +1,41 @@
+#ifndef FRAMELAYOUT_HPP
+#define FRAMELAYOUT_HPP
+
+#include "Assembly.hpp"
+
+// ======================================================
+//                     FrameLayout
+// ======================================================
+/**
+ * @brief Decides how the frame of a function is set up once every stack slot is known.
+ *
+ * A leaf function (one that calls nothing) whose slots fit in the 128 bytes the System V ABI reserves below
+ * %rsp (the red zone) gets no frame at all: no pushq/movq/subq in the prologue, its slots are addressed
+ * from %rsp and the return is a plain ret. Signal handlers skip the red zone so the slots can't be clobbered.
+ *
+ * Every other function keeps the %rbp frame. Its AllocateStack is already a multiple of 16 (assign-slots) so %rsp
+ * stays 16 byte aligned at calls, and it is removed when the function has no slot.
+ */
+class FrameLayout {
+    private:
+        static const int RED_ZONE_SIZE = 128;
+        /**
+         * @brief Checks that the function makes no call. A call needs %rsp 16 byte aligned, and would push its
+         * return address over the red zone.
+         *
+         * @param function
+         * @return bool
+         */
+        static bool isLeaf(IRFunctionNode* function);
+    public:
+        /**
+         * @brief Lays out the frame of the function. A function that already has no frame is left as it is, so
+         * running the pass twice changes nothing.
+         *
+         * @param function
+         * @return bool true if the frame was removed entirely
+         */
+        static bool layout(IRFunctionNode* function);
+};
+
+#endif // FRAMELAYOUT_HPP
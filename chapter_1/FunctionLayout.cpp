@@ -0,0 +1,154 @@
+#include "FunctionLayout.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <unordered_map>
+
+// ======================================================
+//                     FunctionLayout
+// ======================================================
+const char* const FunctionLayout::COLD_SECTION = ".text.unlikely";
+
+std::vector<CallEdge> FunctionLayout::callGraph(const std::vector<FunctionUnit>& units, const Profile& profile){
+    // a call to an alias runs the body it was folded into
+    std::unordered_map<std::string, size_t> bodies;
+    for(size_t i = 0; i < units.size(); i++){
+        bodies[units[i].ast->getIdentifer()] = i;
+    }
+    for(size_t i = 0; i < units.size(); i++){
+        if(!units[i].foldedInto.empty()){
+            bodies[units[i].ast->getIdentifer()] = bodies.at(units[i].foldedInto);
+        }
+    }
+    std::vector<CallEdge> edges;
+    for(size_t i = 0; i < units.size(); i++){
+        if(!units[i].foldedInto.empty() || units[i].assembly == nullptr){
+            continue;
+        }
+        uint64_t callerCount = profile.getCount(units[i].ast->getIdentifer());
+        for(InstructionNode* instr: units[i].assembly->getInstructions()){
+            if(instr->getType() != CALL){
+                continue;
+            }
+            const std::string callee = static_cast<CallInstruction*>(instr)->getName();
+            auto found = bodies.find(callee);
+            if(found != bodies.end() && found->second != i){
+                edges.push_back(CallEdge{i, found->second, std::min(callerCount, profile.getCount(callee))});
+            }
+        }
+    }
+    return(edges);
+}
+
+LayoutReport FunctionLayout::apply(std::vector<FunctionUnit>& units, const Profile& profile){
+    LayoutReport report;
+    // a body runs whenever one of the functions folded into it is called, their counts go to the unit keeping it
+    std::vector<uint64_t> counts(units.size(), 0);
+    std::vector<bool> known(units.size(), false);
+    std::unordered_map<std::string, size_t> indices;
+    for(size_t i = 0; i < units.size(); i++){
+        indices[units[i].ast->getIdentifer()] = i;
+    }
+    for(size_t i = 0; i < units.size(); i++){
+        const std::string name = units[i].ast->getIdentifer();
+        size_t body = units[i].foldedInto.empty() ? i : indices.at(units[i].foldedInto);
+        counts[body] += profile.getCount(name);
+        known[body] = known[body] || profile.getCounts().count(name) != 0;
+    }
+    // chain of every hot function, the others stay at -1
+    std::vector<int> chainOf(units.size(), -1);
+    std::vector<std::vector<size_t>> chains;
+    std::vector<size_t> unknown, cold, aliases;
+    for(size_t i = 0; i < units.size(); i++){
+        FunctionUnit& unit = units[i];
+        unit.cold = false;
+        if(!unit.foldedInto.empty()){
+            aliases.push_back(i);
+        }else if(counts[i] > 0){
+            chainOf[i] = static_cast<int>(chains.size());
+            chains.push_back({i});
+            report.hot++;
+        }else if(known[i]){
+            unit.cold = true;
+            cold.push_back(i);
+            report.cold++;
+        }else{
+            unknown.push_back(i);
+            report.unknown++;
+        }
+    }
+
+    std::vector<CallEdge> edges = callGraph(units, profile);
+    std::stable_sort(edges.begin(), edges.end(), [](const CallEdge& a, const CallEdge& b){
+        return(a.weight > b.weight);
+    });
+    for(const CallEdge& edge: edges){
+        int first = chainOf[edge.caller];
+        int second = chainOf[edge.callee];
+        if(first == -1 || second == -1 || first == second){
+            continue;
+        }
+        std::vector<size_t>& head = chains[first];
+        std::vector<size_t>& tail = chains[second];
+        // caller as close to the end of its chain and callee as close to the start of its own as they can be
+        size_t callerPosition = std::find(head.begin(), head.end(), edge.caller) - head.begin();
+        size_t calleePosition = std::find(tail.begin(), tail.end(), edge.callee) - tail.begin();
+        if(callerPosition < head.size() - 1 - callerPosition){
+            std::reverse(head.begin(), head.end());
+        }
+        if(calleePosition > tail.size() - 1 - calleePosition){
+            std::reverse(tail.begin(), tail.end());
+        }
+        for(size_t unit: tail){
+            chainOf[unit] = first;
+        }
+        head.insert(head.end(), tail.begin(), tail.end());
+        tail.clear();
+    }
+
+    std::vector<std::pair<uint64_t, size_t>> order;
+    for(size_t c = 0; c < chains.size(); c++){
+        if(chains[c].empty()){
+            continue;
+        }
+        uint64_t total = 0;
+        for(size_t unit: chains[c]){
+            total += counts[unit];
+        }
+        order.push_back(std::make_pair(total, c));
+        report.chains++;
+    }
+    // hottest chain first, chains as hot as each other stay in source order
+    std::stable_sort(order.begin(), order.end(), [](const std::pair<uint64_t, size_t>& a, const std::pair<uint64_t, size_t>& b){
+        return(a.first > b.first);
+    });
+    std::vector<size_t> layout;
+    for(const std::pair<uint64_t, size_t>& chain: order){
+        layout.insert(layout.end(), chains[chain.second].begin(), chains[chain.second].end());
+    }
+    layout.insert(layout.end(), unknown.begin(), unknown.end());
+    layout.insert(layout.end(), cold.begin(), cold.end());
+    layout.insert(layout.end(), aliases.begin(), aliases.end());
+
+    std::vector<FunctionUnit> ordered;
+    ordered.reserve(units.size());
+    for(size_t i: layout){
+        ordered.push_back(std::move(units[i]));
+    }
+    units.swap(ordered);
+    return(report);
+}
+
+void FunctionLayout::printReport(const std::vector<FunctionUnit>& units, const Profile& profile, const LayoutReport& report, std::ostream& out){
+    out << "===-------------------------------------------------------------===\n";
+    out << "                      Function layout report\n";
+    out << "===-------------------------------------------------------------===\n";
+    out << std::left << std::setw(32) << "function" << std::setw(16) << "section" << "count" << '\n';
+    for(const FunctionUnit& unit: units){
+        const std::string name = unit.ast->getIdentifer();
+        std::string section = !unit.foldedInto.empty() ? "alias" : unit.cold ? COLD_SECTION : ".text";
+        std::string count = profile.getCounts().count(name) != 0 ? std::to_string(profile.getCount(name)) : "-";
+        out << std::left << std::setw(32) << name << std::setw(16) << section << count << '\n';
+    }
+    out << report.hot << " hot functions in " << report.chains << " chains, " << report.unknown
+        << " not in the profile, " << report.cold << " cold\n";
+}
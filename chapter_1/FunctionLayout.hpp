@@ -0,0 +1,87 @@
+#ifndef FUNCTIONLAYOUT_HPP
+#define FUNCTIONLAYOUT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "PassManager.hpp"
+#include "Profile.hpp"
+
+/**
+ * @brief What the layout did to a program (-layout-report)
+ *
+ */
+struct LayoutReport {
+    /**
+     * @brief Functions the profile saw running
+     *
+     */
+    size_t hot = 0;
+    /**
+     * @brief Functions the profile knows but never saw running, moved to .text.unlikely
+     *
+     */
+    size_t cold = 0;
+    /**
+     * @brief Functions missing from the profile, left in source order after the hot ones
+     *
+     */
+    size_t unknown = 0;
+    /**
+     * @brief Chains the hot functions were merged into
+     *
+     */
+    size_t chains = 0;
+};
+
+/**
+ * @brief A call from one function to another, weighted by how often the profile says it runs
+ *
+ */
+struct CallEdge {
+    size_t caller;
+    size_t callee;
+    uint64_t weight;
+};
+
+// ======================================================
+//                     FunctionLayout
+// ======================================================
+/**
+ * @brief Profile guided function ordering (-fprofile-use=<file>), Pettis-Hansen style.
+ *
+ * Runs on the whole program once the pipeline is done, like CodeFolder, and only reorders the units: the emitters
+ * write them in the order of the vector. Every function the profile saw running starts as a chain of its own, the
+ * call graph edges are visited heaviest first and the chains at both ends of an edge are merged, each turned around
+ * if needed so that caller and callee end up next to each other. The chains are then laid out hottest first (sum of
+ * the counts), so the code that runs together shares cache lines and pages, and the functions that run the most are
+ * at the start of .text.
+ *
+ * Functions the profile knows but never saw running go to .text.unlikely, which the linker groups with the cold code
+ * of the other files, out of the way of the hot text. Functions the profile doesn't know (new since the training run)
+ * stay in .text after the hot ones, in source order. Aliases made by CodeFolder go last, they have no code, and the
+ * counts of the functions folded into a body are summed since they all run it.
+ */
+class FunctionLayout {
+    private:
+        /**
+         * @brief The call graph of the program, the weight of an edge is the count of the less frequent of the two
+         * functions since the profile only counts function entries
+         *
+         */
+        static std::vector<CallEdge> callGraph(const std::vector<FunctionUnit>& units, const Profile& profile);
+    public:
+        static const char* const COLD_SECTION;
+        /**
+         * @brief Reorders the units and sets cold on the functions that never ran
+         *
+         * @param units in source order
+         * @param profile
+         * @return LayoutReport
+         */
+        static LayoutReport apply(std::vector<FunctionUnit>& units, const Profile& profile);
+        static void printReport(const std::vector<FunctionUnit>& units, const Profile& profile, const LayoutReport& report, std::ostream& out);
+};
+
+#endif // FUNCTIONLAYOUT_HPP
@@ -0,0 +1,1684 @@
+#include "InstructionSelector.hpp"
+#include "Optimizer.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+typedef InstructionSelector::Cost Cost;
+typedef InstructionSelector::Binding Binding;
+typedef std::vector<InstructionNode*> Out;
+typedef std::vector<OperandNode*> Operands;
+
+static int immediateSize(int32_t value){
+    return(value >= -128 && value <= 127 ? 1 : 4);
+}
+
+static int32_t negate(int32_t value){
+    return(static_cast<int32_t>(0u - static_cast<uint32_t>(value)));
+}
+
+static int32_t immediateOf(OperandNode* op){
+    return(TackySimplifier::wrapConstant(static_cast<ImmediateNode*>(op)->getImm()));
+}
+
+static RegisterNode* reg(OperandNode* op){
+    return(static_cast<RegisterNode*>(op));
+}
+
+static void emitBinary(Out& out, BinaryOperator op, OperandNode* src, OperandNode* dst){
+    out.push_back(new BinaryInstruction{op, src, dst});
+}
+
+static void emitUnary(Out& out, UnaryOperator op, OperandNode* operand){
+    out.push_back(new UnaryInstruction{op, operand});
+}
+
+static ImmediateNode* immediate(int32_t value){
+    return(new ImmediateNode{std::to_string(value)});
+}
+
+// The register a tile computing into result may overwrite: trees are computed in %eax or %r10d and the other
+// one is the scratch (see InstructionSelector.hpp)
+static RegisterNode* scratchOf(OperandNode* result){
+    return(new RegisterNode{reg(result)->getRegEnum() == RegisterName::AX ? RegisterName::R10 : RegisterName::AX});
+}
+
+// ======================================================
+//                     Multiplication by a constant
+// ======================================================
+// idivl takes 20 to 40 cycles depending on the operands, the selector counts it as its worst common case
+static const int IDIV_LATENCY = 26;
+static const int IMUL_LATENCY = 3;
+
+enum class MultiplyOp { SHL, LEA, SHL_ADD, SHL_SUB, NEG, IMUL, ZERO };
+struct MultiplyStep {
+    MultiplyOp op;
+    int32_t amount;
+};
+struct MultiplyPlan {
+    Cost cost;
+    std::vector<MultiplyStep> steps;
+};
+
+static Cost stepCost(const MultiplyStep& step){
+    switch(step.op){
+        case MultiplyOp::SHL: return(Cost{1, 3});
+        case MultiplyOp::LEA: return(Cost{1, 3});
+        // movl %r, %s is free, the shift and the add or sub depend on each other
+        case MultiplyOp::SHL_ADD:
+        case MultiplyOp::SHL_SUB: return(Cost{2, 8});
+        case MultiplyOp::NEG: return(Cost{1, 2});
+        case MultiplyOp::IMUL: return(Cost{IMUL_LATENCY, 2 + immediateSize(step.amount)});
+        case MultiplyOp::ZERO: return(Cost{1, 5});
+    }
+    return(Cost{0, 0});
+}
+
+static int log2Exact(uint32_t value){
+    if(value == 0u || (value & (value - 1u)) != 0u){
+        return(-1);
+    }
+    int k = 0;
+    while((value >> k) != 1u){
+        k++;
+    }
+    return(k);
+}
+
+// shifts, leal (%r,%r,2|4|8) and one shift with an add or sub that compute m * x, false if there is none
+static bool decomposeMultiplier(uint32_t m, std::vector<MultiplyStep>& steps){
+    int k = log2Exact(m);
+    if(k >= 0){
+        steps.push_back(MultiplyStep{MultiplyOp::SHL, k});
+        return(true);
+    }
+    static const uint32_t leaFactors[] = {3u, 5u, 9u};
+    for(uint32_t f: leaFactors){
+        if(m % f != 0u){
+            continue;
+        }
+        uint32_t rest = m / f;
+        int shift = log2Exact(rest);
+        if(shift >= 0){
+            steps.push_back(MultiplyStep{MultiplyOp::LEA, static_cast<int32_t>(f)});
+            if(shift > 0){
+                steps.push_back(MultiplyStep{MultiplyOp::SHL, shift});
+            }
+            return(true);
+        }
+        for(uint32_t g: leaFactors){
+            if(rest == g){
+                steps.push_back(MultiplyStep{MultiplyOp::LEA, static_cast<int32_t>(f)});
+                steps.push_back(MultiplyStep{MultiplyOp::LEA, static_cast<int32_t>(g)});
+                return(true);
+            }
+        }
+    }
+    k = log2Exact(m - 1u);
+    if(k > 0){
+        steps.push_back(MultiplyStep{MultiplyOp::SHL_ADD, k});
+        return(true);
+    }
+    k = log2Exact(m + 1u);
+    if(k > 1){
+        steps.push_back(MultiplyStep{MultiplyOp::SHL_SUB, k});
+        return(true);
+    }
+    return(false);
+}
+
+// The cheapest way to multiply by the constant: imull $c, or a decomposition of c or -c (then negated)
+static MultiplyPlan planMultiply(int32_t constant){
+    uint32_t c = static_cast<uint32_t>(constant);
+    MultiplyPlan best{Cost{0, 0}, {MultiplyStep{MultiplyOp::IMUL, constant}}};
+    if(c == 0u){
+        best.steps[0] = MultiplyStep{MultiplyOp::ZERO, 0};
+    }else if(c == 1u){
+        best.steps.clear();
+    }
+    for(int negated = 0; negated < 2 && c > 1u; negated++){
+        std::vector<MultiplyStep> steps;
+        if(!decomposeMultiplier(negated ? 0u - c : c, steps)){
+            continue;
+        }
+        if(negated){
+            steps.push_back(MultiplyStep{MultiplyOp::NEG, 0});
+        }
+        Cost cost{0, 0};
+        for(const MultiplyStep& step: steps){
+            cost.latency += stepCost(step).latency;
+            cost.size += stepCost(step).size;
+        }
+        Cost bestCost{0, 0};
+        for(const MultiplyStep& step: best.steps){
+            bestCost.latency += stepCost(step).latency;
+            bestCost.size += stepCost(step).size;
+        }
+        if(InstructionSelector::costLess(cost, bestCost)){
+            best.steps = steps;
+        }
+    }
+    for(const MultiplyStep& step: best.steps){
+        best.cost.latency += stepCost(step).latency;
+        best.cost.size += stepCost(step).size;
+    }
+    return(best);
+}
+
+static void emitMultiply(Out& out, OperandNode* result, int32_t constant){
+    RegisterNode* r = reg(result);
+    for(const MultiplyStep& step: planMultiply(constant).steps){
+        switch(step.op){
+            case MultiplyOp::SHL: emitBinary(out, BinaryOperator::LeftShift, immediate(step.amount), r); break;
+            case MultiplyOp::LEA: out.push_back(new LeaInstruction{r, r, step.amount - 1, 0, r}); break;
+            case MultiplyOp::SHL_ADD: {
+                // r + (r << k)
+                RegisterNode* scratch = scratchOf(r);
+                out.push_back(new MoveInstruction{r, scratch});
+                emitBinary(out, BinaryOperator::LeftShift, immediate(step.amount), scratch);
+                emitBinary(out, BinaryOperator::Add, scratch, r);
+                break;
+            }
+            case MultiplyOp::SHL_SUB: {
+                // (r << k) - r
+                RegisterNode* scratch = scratchOf(r);
+                out.push_back(new MoveInstruction{r, scratch});
+                emitBinary(out, BinaryOperator::LeftShift, immediate(step.amount), r);
+                emitBinary(out, BinaryOperator::Subtract, scratch, r);
+                break;
+            }
+            case MultiplyOp::NEG: emitUnary(out, UnaryOperator::Negation, r); break;
+            case MultiplyOp::IMUL: emitBinary(out, BinaryOperator::Multiply, immediate(step.amount), r); break;
+            case MultiplyOp::ZERO: out.push_back(new MoveInstruction{immediate(0), r}); break;
+        }
+    }
+}
+
+// ======================================================
+//                     Division
+// ======================================================
+// cltd; idivl. The dividend is in a register or memory, the divisor in the other register, in memory or a constant.
+// Only %eax, %r10d and %edx are used: the dividend has to be in %eax, %edx receives its sign and the remainder.
+static void emitIdiv(Out& out, OperandNode* dividend, OperandNode* divisor, OperandNode* result, bool remainder){
+    RegisterNode* ax = new RegisterNode{RegisterName::AX};
+    RegisterNode* r10 = new RegisterNode{RegisterName::R10};
+    RegisterNode* dx = new RegisterNode{RegisterName::DX};
+    bool dividendInAx = dividend->getType() == REG && reg(dividend)->getRegEnum() == RegisterName::AX;
+    if(divisor->getType() == REG && reg(divisor)->getRegEnum() == RegisterName::AX){
+        if(dividend->getType() == REG){
+            // the two are the wrong way around, swapped through %edx
+            out.push_back(new MoveInstruction{ax, dx});
+            out.push_back(new MoveInstruction{r10, ax});
+            out.push_back(new MoveInstruction{dx, r10});
+        }else{
+            out.push_back(new MoveInstruction{ax, r10});
+            out.push_back(new MoveInstruction{dividend, ax});
+        }
+        divisor = r10;
+    }else{
+        if(!dividendInAx){
+            out.push_back(new MoveInstruction{dividend, ax});
+        }
+        if(divisor->getType() == IMM){
+            out.push_back(new MoveInstruction{divisor, r10});
+            divisor = r10;
+        }
+    }
+    out.push_back(new CdqInstruction{});
+    out.push_back(new IdivInstruction{divisor});
+    RegisterName value = remainder ? RegisterName::DX : RegisterName::AX;
+    if(reg(result)->getRegEnum() != value){
+        out.push_back(new MoveInstruction{remainder ? dx : ax, result});
+    }
+}
+
+/**
+ * The multiplier and shift of a signed division by a constant that isn't 0 or a power of two in absolute value:
+ * n / d is the high half of magic * n, corrected by n when magic and d don't have the same sign, shifted right by
+ * shift and plus one when negative (Hacker's Delight, 10-1 and 10-4).
+ */
+static void divisionMagic(int32_t divisor, int32_t& magic, int& shift){
+    const uint32_t two31 = 0x80000000u;
+    uint32_t d = static_cast<uint32_t>(divisor);
+    uint32_t ad = divisor < 0 ? 0u - d : d;
+    uint32_t t = two31 + (d >> 31);
+    // |nc|, the largest dividend with n mod d == d - 1
+    uint32_t anc = t - 1u - t % ad;
+    int p = 31;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / ad, r2 = two31 - q2 * ad;
+    uint32_t delta = 0u;
+    do{
+        p++;
+        q1 = 2u * q1;
+        r1 = 2u * r1;
+        if(r1 >= anc){
+            q1++;
+            r1 -= anc;
+        }
+        q2 = 2u * q2;
+        r2 = 2u * r2;
+        if(r2 >= ad){
+            q2++;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    }while(q1 < delta || (q1 == delta && r1 == 0u));
+    uint32_t m = q2 + 1u;
+    magic = static_cast<int32_t>(divisor < 0 ? 0u - m : m);
+    shift = p - 32;
+}
+
+static uint32_t absoluteValue(int32_t value){
+    return(value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value));
+}
+
+static Cost divisionCost(int32_t divisor, bool remainder){
+    uint32_t d = absoluteValue(divisor);
+    if(d == 0u){
+        return(Cost{IDIV_LATENCY + 1, 14});
+    }
+    if(d == 1u){
+        return(remainder ? Cost{1, 5} : divisor < 0 ? Cost{1, 2} : Cost{0, 0});
+    }
+    if(log2Exact(d) >= 0){
+        // bias (3 instructions), add, sar or and and sub, neg
+        return(remainder ? Cost{5, 17} : Cost{divisor < 0 ? 5 : 4, divisor < 0 ? 16 : 14});
+    }
+    int32_t magic = 0;
+    int shift = 0;
+    divisionMagic(divisor, magic, shift);
+    bool corrected = (divisor > 0 && magic < 0) || (divisor < 0 && magic > 0);
+    // movslq, imulq, sarq, then the correction and the rounding of negative quotients
+    Cost cost{IMUL_LATENCY + 2 + (corrected ? 2 : 0) + 2, 14 + (corrected ? 6 : 0) + 8};
+    if(remainder){
+        cost.latency += IMUL_LATENCY + 1;
+        cost.size += 2 + immediateSize(divisor) + 3;
+    }
+    return(cost);
+}
+
+// The quotient or remainder of the register result by a constant, without idivl but for a division by 0
+static void emitDivideByConstant(Out& out, OperandNode* result, int32_t divisor, bool remainder){
+    RegisterNode* r = reg(result);
+    RegisterNode* scratch = scratchOf(r);
+    uint32_t d = absoluteValue(divisor);
+    int k = log2Exact(d);
+    if(d == 0u){
+        // traps like the division the program asked for
+        emitIdiv(out, r, immediate(0), r, remainder);
+    }else if(d == 1u){
+        if(remainder){
+            out.push_back(new MoveInstruction{immediate(0), r});
+        }else if(divisor < 0){
+            emitUnary(out, UnaryOperator::Negation, r);
+        }
+    }else if(k > 0){
+        // a shift rounds towards -infinity, a negative n is first biased by 2^k - 1 to round towards 0
+        out.push_back(new MoveInstruction{r, scratch});
+        if(k > 1){
+            emitBinary(out, BinaryOperator::RightShift, immediate(31), scratch);
+        }
+        emitBinary(out, BinaryOperator::LogicalRightShift, immediate(32 - k), scratch);
+        emitBinary(out, BinaryOperator::Add, scratch, r);
+        if(remainder){
+            // n % 2^k == ((n + bias) & (2^k - 1)) - bias, whatever the sign of the divisor
+            emitBinary(out, BinaryOperator::BitwiseAnd, immediate(static_cast<int32_t>(d - 1u)), r);
+            emitBinary(out, BinaryOperator::Subtract, scratch, r);
+        }else{
+            emitBinary(out, BinaryOperator::RightShift, immediate(k), r);
+            if(divisor < 0){
+                emitUnary(out, UnaryOperator::Negation, r);
+            }
+        }
+    }else{
+        int32_t magic = 0;
+        int shift = 0;
+        divisionMagic(divisor, magic, shift);
+        bool corrected = (divisor > 0 && magic < 0) || (divisor < 0 && magic > 0);
+        out.push_back(new MultiplyHighInstruction{magic, corrected ? 0 : shift, r, scratch});
+        if(corrected){
+            emitBinary(out, divisor > 0 ? BinaryOperator::Add : BinaryOperator::Subtract, r, scratch);
+            if(shift > 0){
+                emitBinary(out, BinaryOperator::RightShift, immediate(shift), scratch);
+            }
+        }
+        // q + 1 when q is negative: the shifts rounded it down and C rounds towards 0
+        if(!remainder){
+            out.push_back(new MoveInstruction{scratch, r});
+            emitBinary(out, BinaryOperator::LogicalRightShift, immediate(31), r);
+            emitBinary(out, BinaryOperator::Add, scratch, r);
+        }else{
+            // n - q * d, n is still in result so the sign bit goes through %edx
+            RegisterNode* dx = new RegisterNode{RegisterName::DX};
+            out.push_back(new MoveInstruction{scratch, dx});
+            emitBinary(out, BinaryOperator::LogicalRightShift, immediate(31), dx);
+            emitBinary(out, BinaryOperator::Add, dx, scratch);
+            emitBinary(out, BinaryOperator::Multiply, immediate(divisor), scratch);
+            emitBinary(out, BinaryOperator::Subtract, scratch, r);
+        }
+    }
+}
+
+// ======================================================
+//                     Shifts
+// ======================================================
+// A shift by a variable count goes through %cl, the only register sall/sarl take a count from. The count is moved
+// there first, the value may still have to be loaded into the result register.
+static void emitShiftByRegister(Out& out, BinaryOperator op, OperandNode* value, OperandNode* count, OperandNode* result){
+    RegisterNode* cx = new RegisterNode{RegisterName::CX};
+    out.push_back(new MoveInstruction{count, cx});
+    if(value != result){
+        out.push_back(new MoveInstruction{value, result});
+    }
+    emitBinary(out, op, cx, result);
+}
+
+// Counts outside 0-31 are undefined in C, the instructions take them modulo 32 and so does the immediate
+static ImmediateNode* shiftCount(OperandNode* count){
+    return(immediate(immediateOf(count) & 31));
+}
+
+// ======================================================
+//                     Comparisons
+// ======================================================
+// r holds one operand, the other one is compared against it. cmpl other, r computes r - other, so when r holds
+// the right operand the condition is tested with its operands swapped (a < b is b > a).
+template<ConditionCode CC>
+static void emitSetCondition(Out& out, OperandNode* r, const Operands& o){
+    bool leftInResult = o[0] == r;
+    out.push_back(new CompareInstruction{leftInResult ? o[1] : o[0], r});
+    out.push_back(new SetConditionInstruction{leftInResult ? CC : swap_condition(CC), reg(r)});
+    out.push_back(new MoveZeroExtendInstruction{reg(r), reg(r)});
+}
+
+// cmpl, setcc and movzbl depend on each other, a memory operand adds its load
+static Cost comparisonCost(const std::vector<Binding>& b){
+    Cost cost{3, 6};
+    for(const Binding& binding: b){
+        if(binding.kind == InstructionSelector::BindingKind::MEM){
+            cost.latency += 4;
+            cost.size += 3;
+        }else if(binding.kind == InstructionSelector::BindingKind::IMM){
+            cost.size += 2 + immediateSize(binding.tree->value);
+        }
+    }
+    if(b[0].kind == InstructionSelector::BindingKind::REG && b[1].kind == InstructionSelector::BindingKind::REG){
+        cost.size += 3;
+    }
+    return(cost);
+}
+
+// ======================================================
+//                     Tiles
+// ======================================================
+// Costs are {latency in cycles, size in bytes}. A memory operand is counted as a stack slot with an 8 bit
+// displacement: 4 cycles to load, 6 for a read-modify-write.
+
+const std::vector<InstructionSelector::Tile> InstructionSelector::registerTiles = {
+    {"mem", [](const std::vector<Binding>&){ return(Cost{4, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ out.push_back(new MoveInstruction{o[0], r}); }},
+    {"imm", [](const std::vector<Binding>&){ return(Cost{1, 5}); },
+        [](Out& out, OperandNode* r, const Operands& o){ out.push_back(new MoveInstruction{o[0], r}); }},
+    {"NEG(reg)", [](const std::vector<Binding>&){ return(Cost{1, 2}); },
+        [](Out& out, OperandNode* r, const Operands&){ emitUnary(out, UnaryOperator::Negation, r); }},
+    {"NOT(reg)", [](const std::vector<Binding>&){ return(Cost{1, 2}); },
+        [](Out& out, OperandNode* r, const Operands&){ emitUnary(out, UnaryOperator::Complement, r); }},
+    // -~x == x + 1 and ~-x == x - 1
+    {"NEG(NOT(reg))", [](const std::vector<Binding>&){ return(Cost{1, 2}); },
+        [](Out& out, OperandNode* r, const Operands&){ emitUnary(out, UnaryOperator::Increment, r); }},
+    {"NOT(NEG(reg))", [](const std::vector<Binding>&){ return(Cost{1, 2}); },
+        [](Out& out, OperandNode* r, const Operands&){ emitUnary(out, UnaryOperator::Decrement, r); }},
+    {"ADD(reg,1)", [](const std::vector<Binding>&){ return(Cost{1, 2}); },
+        [](Out& out, OperandNode* r, const Operands&){ emitUnary(out, UnaryOperator::Increment, r); }},
+    {"SUB(reg,-1)", [](const std::vector<Binding>&){ return(Cost{1, 2}); },
+        [](Out& out, OperandNode* r, const Operands&){ emitUnary(out, UnaryOperator::Increment, r); }},
+    {"ADD(reg,-1)", [](const std::vector<Binding>&){ return(Cost{1, 2}); },
+        [](Out& out, OperandNode* r, const Operands&){ emitUnary(out, UnaryOperator::Decrement, r); }},
+    {"SUB(reg,1)", [](const std::vector<Binding>&){ return(Cost{1, 2}); },
+        [](Out& out, OperandNode* r, const Operands&){ emitUnary(out, UnaryOperator::Decrement, r); }},
+    {"ADD(reg,imm)", [](const std::vector<Binding>& b){ return(Cost{1, 2 + immediateSize(b[1].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[1], r); }},
+    {"ADD(imm,reg)", [](const std::vector<Binding>& b){ return(Cost{1, 2 + immediateSize(b[0].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[0], r); }},
+    {"SUB(reg,imm)", [](const std::vector<Binding>& b){ return(Cost{1, 2 + immediateSize(b[1].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::Subtract, o[1], r); }},
+    {"SUB(imm,reg)", [](const std::vector<Binding>& b){ return(Cost{2, 4 + immediateSize(b[0].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){
+            emitUnary(out, UnaryOperator::Negation, r);
+            emitBinary(out, BinaryOperator::Add, o[0], r);
+        }},
+    {"ADD(reg,mem)", [](const std::vector<Binding>&){ return(Cost{5, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[1], r); }},
+    {"ADD(mem,reg)", [](const std::vector<Binding>&){ return(Cost{5, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[0], r); }},
+    {"SUB(reg,mem)", [](const std::vector<Binding>&){ return(Cost{5, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::Subtract, o[1], r); }},
+    {"SUB(mem,reg)", [](const std::vector<Binding>&){ return(Cost{6, 5}); },
+        [](Out& out, OperandNode* r, const Operands& o){
+            emitUnary(out, UnaryOperator::Negation, r);
+            emitBinary(out, BinaryOperator::Add, o[0], r);
+        }},
+    // one of the two operands is in the result register, the other one in the scratch register
+    {"ADD(reg,reg)", [](const std::vector<Binding>&){ return(Cost{1, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[0] == r ? o[1] : o[0], r); }},
+    {"SUB(reg,reg)", [](const std::vector<Binding>&){ return(Cost{1, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){
+            if(o[0] == r){
+                emitBinary(out, BinaryOperator::Subtract, o[1], r);
+            }else{
+                emitUnary(out, UnaryOperator::Negation, r);
+                emitBinary(out, BinaryOperator::Add, o[0], r);
+            }
+        }},
+    {"ADD(reg,dup)", [](const std::vector<Binding>&){ return(Cost{1, 2}); },
+        [](Out& out, OperandNode* r, const Operands&){ emitBinary(out, BinaryOperator::Add, r, r); }},
+    // three operand additions in a single leal
+    {"ADD(ADD(reg,reg),imm)", [](const std::vector<Binding>& b){ return(Cost{1, 3 + immediateSize(b[2].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){
+            out.push_back(new LeaInstruction{reg(o[0]), reg(o[1]), 1, immediateOf(o[2]), reg(r)});
+        }},
+    {"SUB(ADD(reg,reg),imm)", [](const std::vector<Binding>& b){ return(Cost{1, 3 + immediateSize(negate(b[2].tree->value))}); },
+        [](Out& out, OperandNode* r, const Operands& o){
+            out.push_back(new LeaInstruction{reg(o[0]), reg(o[1]), 1, negate(immediateOf(o[2])), reg(r)});
+        }},
+    {"ADD(ADD(reg,imm),reg)", [](const std::vector<Binding>& b){ return(Cost{1, 3 + immediateSize(b[1].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){
+            out.push_back(new LeaInstruction{reg(o[0]), reg(o[2]), 1, immediateOf(o[1]), reg(r)});
+        }},
+    {"ADD(reg,ADD(reg,imm))", [](const std::vector<Binding>& b){ return(Cost{1, 3 + immediateSize(b[2].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){
+            out.push_back(new LeaInstruction{reg(o[0]), reg(o[1]), 1, immediateOf(o[2]), reg(r)});
+        }},
+    // scaled index: a + 2*b and 2*a + k
+    {"ADD(reg,ADD(reg,dup))", [](const std::vector<Binding>&){ return(Cost{1, 4}); },
+        [](Out& out, OperandNode* r, const Operands& o){ out.push_back(new LeaInstruction{reg(o[0]), reg(o[1]), 2, 0, reg(r)}); }},
+    {"ADD(ADD(reg,dup),reg)", [](const std::vector<Binding>&){ return(Cost{1, 4}); },
+        [](Out& out, OperandNode* r, const Operands& o){ out.push_back(new LeaInstruction{reg(o[1]), reg(o[0]), 2, 0, reg(r)}); }},
+    {"ADD(ADD(reg,dup),imm)", [](const std::vector<Binding>& b){ return(Cost{1, 3 + immediateSize(b[1].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){
+            out.push_back(new LeaInstruction{reg(o[0]), reg(o[0]), 1, immediateOf(o[1]), reg(r)});
+        }},
+    // multiplication by a constant as shifts, leal and add/sub when they beat imull (see planMultiply)
+    {"MUL(reg,imm)", [](const std::vector<Binding>& b){ return(planMultiply(b[1].tree->value).cost); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitMultiply(out, r, immediateOf(o[1])); }},
+    {"MUL(imm,reg)", [](const std::vector<Binding>& b){ return(planMultiply(b[0].tree->value).cost); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitMultiply(out, r, immediateOf(o[0])); }},
+    {"MUL(reg,reg)", [](const std::vector<Binding>&){ return(Cost{IMUL_LATENCY, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::Multiply, o[0] == r ? o[1] : o[0], r); }},
+    {"MUL(reg,dup)", [](const std::vector<Binding>&){ return(Cost{IMUL_LATENCY, 3}); },
+        [](Out& out, OperandNode* r, const Operands&){ emitBinary(out, BinaryOperator::Multiply, r, r); }},
+    {"MUL(reg,mem)", [](const std::vector<Binding>&){ return(Cost{IMUL_LATENCY + 4, 4}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::Multiply, o[1], r); }},
+    {"MUL(mem,reg)", [](const std::vector<Binding>&){ return(Cost{IMUL_LATENCY + 4, 4}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::Multiply, o[0], r); }},
+    // division by a constant with a multiply high or shifts (see emitDivideByConstant), by a variable with idivl
+    {"DIV(reg,imm)", [](const std::vector<Binding>& b){ return(divisionCost(b[1].tree->value, false)); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitDivideByConstant(out, r, immediateOf(o[1]), false); }},
+    {"MOD(reg,imm)", [](const std::vector<Binding>& b){ return(divisionCost(b[1].tree->value, true)); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitDivideByConstant(out, r, immediateOf(o[1]), true); }},
+    {"DIV(reg,reg)", [](const std::vector<Binding>&){ return(Cost{IDIV_LATENCY + 1, 5}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitIdiv(out, o[0], o[1], r, false); }},
+    {"MOD(reg,reg)", [](const std::vector<Binding>&){ return(Cost{IDIV_LATENCY + 1, 5}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitIdiv(out, o[0], o[1], r, true); }},
+    {"DIV(reg,mem)", [](const std::vector<Binding>&){ return(Cost{IDIV_LATENCY + 5, 6}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitIdiv(out, o[0], o[1], r, false); }},
+    {"MOD(reg,mem)", [](const std::vector<Binding>&){ return(Cost{IDIV_LATENCY + 5, 6}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitIdiv(out, o[0], o[1], r, true); }},
+    {"DIV(mem,reg)", [](const std::vector<Binding>&){ return(Cost{IDIV_LATENCY + 5, 8}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitIdiv(out, o[0], o[1], r, false); }},
+    {"MOD(mem,reg)", [](const std::vector<Binding>&){ return(Cost{IDIV_LATENCY + 5, 8}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitIdiv(out, o[0], o[1], r, true); }},
+    // the bitwise operators, commutative like ADD
+    {"AND(reg,imm)", [](const std::vector<Binding>& b){ return(Cost{1, 2 + immediateSize(b[1].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseAnd, o[1], r); }},
+    {"AND(imm,reg)", [](const std::vector<Binding>& b){ return(Cost{1, 2 + immediateSize(b[0].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseAnd, o[0], r); }},
+    {"AND(reg,mem)", [](const std::vector<Binding>&){ return(Cost{5, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseAnd, o[1], r); }},
+    {"AND(mem,reg)", [](const std::vector<Binding>&){ return(Cost{5, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseAnd, o[0], r); }},
+    {"AND(reg,reg)", [](const std::vector<Binding>&){ return(Cost{1, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseAnd, o[0] == r ? o[1] : o[0], r); }},
+    {"OR(reg,imm)", [](const std::vector<Binding>& b){ return(Cost{1, 2 + immediateSize(b[1].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseOr, o[1], r); }},
+    {"OR(imm,reg)", [](const std::vector<Binding>& b){ return(Cost{1, 2 + immediateSize(b[0].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseOr, o[0], r); }},
+    {"OR(reg,mem)", [](const std::vector<Binding>&){ return(Cost{5, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseOr, o[1], r); }},
+    {"OR(mem,reg)", [](const std::vector<Binding>&){ return(Cost{5, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseOr, o[0], r); }},
+    {"OR(reg,reg)", [](const std::vector<Binding>&){ return(Cost{1, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseOr, o[0] == r ? o[1] : o[0], r); }},
+    {"XOR(reg,imm)", [](const std::vector<Binding>& b){ return(Cost{1, 2 + immediateSize(b[1].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseXor, o[1], r); }},
+    {"XOR(imm,reg)", [](const std::vector<Binding>& b){ return(Cost{1, 2 + immediateSize(b[0].tree->value)}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseXor, o[0], r); }},
+    {"XOR(reg,mem)", [](const std::vector<Binding>&){ return(Cost{5, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseXor, o[1], r); }},
+    {"XOR(mem,reg)", [](const std::vector<Binding>&){ return(Cost{5, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseXor, o[0], r); }},
+    {"XOR(reg,reg)", [](const std::vector<Binding>&){ return(Cost{1, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::BitwiseXor, o[0] == r ? o[1] : o[0], r); }},
+    // x ^ x, always 0
+    {"XOR(reg,dup)", [](const std::vector<Binding>&){ return(Cost{1, 5}); },
+        [](Out& out, OperandNode* r, const Operands&){ out.push_back(new MoveInstruction{immediate(0), r}); }},
+    // shifts by a constant, or by a variable count moved into %cl (see emitShiftByRegister)
+    {"SHL(reg,imm)", [](const std::vector<Binding>&){ return(Cost{1, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::LeftShift, shiftCount(o[1]), r); }},
+    {"SAR(reg,imm)", [](const std::vector<Binding>&){ return(Cost{1, 3}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitBinary(out, BinaryOperator::RightShift, shiftCount(o[1]), r); }},
+    {"SHL(reg,reg)", [](const std::vector<Binding>&){ return(Cost{2, 5}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitShiftByRegister(out, BinaryOperator::LeftShift, o[0], o[1], r); }},
+    {"SAR(reg,reg)", [](const std::vector<Binding>&){ return(Cost{2, 5}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitShiftByRegister(out, BinaryOperator::RightShift, o[0], o[1], r); }},
+    {"SHL(reg,mem)", [](const std::vector<Binding>&){ return(Cost{5, 5}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitShiftByRegister(out, BinaryOperator::LeftShift, o[0], o[1], r); }},
+    {"SAR(reg,mem)", [](const std::vector<Binding>&){ return(Cost{5, 5}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitShiftByRegister(out, BinaryOperator::RightShift, o[0], o[1], r); }},
+    {"SHL(imm,reg)", [](const std::vector<Binding>&){ return(Cost{2, 9}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitShiftByRegister(out, BinaryOperator::LeftShift, o[0], o[1], r); }},
+    {"SAR(imm,reg)", [](const std::vector<Binding>&){ return(Cost{2, 9}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitShiftByRegister(out, BinaryOperator::RightShift, o[0], o[1], r); }},
+    {"SHL(mem,reg)", [](const std::vector<Binding>&){ return(Cost{5, 7}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitShiftByRegister(out, BinaryOperator::LeftShift, o[0], o[1], r); }},
+    {"SAR(mem,reg)", [](const std::vector<Binding>&){ return(Cost{5, 7}); },
+        [](Out& out, OperandNode* r, const Operands& o){ emitShiftByRegister(out, BinaryOperator::RightShift, o[0], o[1], r); }},
+    // comparisons as cmpl, setcc and movzbl (see emitSetCondition)
+    {"LT(reg,imm)", comparisonCost, emitSetCondition<ConditionCode::L>},
+    {"LT(imm,reg)", comparisonCost, emitSetCondition<ConditionCode::L>},
+    {"LT(reg,mem)", comparisonCost, emitSetCondition<ConditionCode::L>},
+    {"LT(mem,reg)", comparisonCost, emitSetCondition<ConditionCode::L>},
+    {"LT(reg,reg)", comparisonCost, emitSetCondition<ConditionCode::L>},
+    {"LE(reg,imm)", comparisonCost, emitSetCondition<ConditionCode::LE>},
+    {"LE(imm,reg)", comparisonCost, emitSetCondition<ConditionCode::LE>},
+    {"LE(reg,mem)", comparisonCost, emitSetCondition<ConditionCode::LE>},
+    {"LE(mem,reg)", comparisonCost, emitSetCondition<ConditionCode::LE>},
+    {"LE(reg,reg)", comparisonCost, emitSetCondition<ConditionCode::LE>},
+    {"GT(reg,imm)", comparisonCost, emitSetCondition<ConditionCode::G>},
+    {"GT(imm,reg)", comparisonCost, emitSetCondition<ConditionCode::G>},
+    {"GT(reg,mem)", comparisonCost, emitSetCondition<ConditionCode::G>},
+    {"GT(mem,reg)", comparisonCost, emitSetCondition<ConditionCode::G>},
+    {"GT(reg,reg)", comparisonCost, emitSetCondition<ConditionCode::G>},
+    {"GE(reg,imm)", comparisonCost, emitSetCondition<ConditionCode::GE>},
+    {"GE(imm,reg)", comparisonCost, emitSetCondition<ConditionCode::GE>},
+    {"GE(reg,mem)", comparisonCost, emitSetCondition<ConditionCode::GE>},
+    {"GE(mem,reg)", comparisonCost, emitSetCondition<ConditionCode::GE>},
+    {"GE(reg,reg)", comparisonCost, emitSetCondition<ConditionCode::GE>},
+    {"EQ(reg,imm)", comparisonCost, emitSetCondition<ConditionCode::E>},
+    {"EQ(imm,reg)", comparisonCost, emitSetCondition<ConditionCode::E>},
+    {"EQ(reg,mem)", comparisonCost, emitSetCondition<ConditionCode::E>},
+    {"EQ(mem,reg)", comparisonCost, emitSetCondition<ConditionCode::E>},
+    {"EQ(reg,reg)", comparisonCost, emitSetCondition<ConditionCode::E>},
+    {"NE(reg,imm)", comparisonCost, emitSetCondition<ConditionCode::NE>},
+    {"NE(imm,reg)", comparisonCost, emitSetCondition<ConditionCode::NE>},
+    {"NE(reg,mem)", comparisonCost, emitSetCondition<ConditionCode::NE>},
+    {"NE(mem,reg)", comparisonCost, emitSetCondition<ConditionCode::NE>},
+    {"NE(reg,reg)", comparisonCost, emitSetCondition<ConditionCode::NE>},
+};
+
+// result is the variable assigned to, reg operands are computed in %r10d. Memory to memory forms are left to
+// the legalize pass, they only need a detour through a register if both variables end up on the stack.
+const std::vector<InstructionSelector::Tile> InstructionSelector::storeTiles = {
+    {"dst", [](const std::vector<Binding>&){ return(Cost{0, 0}); },
+        [](Out&, OperandNode*, const Operands&){}},
+    {"mem", [](const std::vector<Binding>&){ return(Cost{5, 6}); },
+        [](Out& out, OperandNode* d, const Operands& o){ out.push_back(new MoveInstruction{o[0], d}); }},
+    {"reg", [](const std::vector<Binding>&){ return(Cost{1, 3}); },
+        [](Out& out, OperandNode* d, const Operands& o){ out.push_back(new MoveInstruction{o[0], d}); }},
+    {"imm", [](const std::vector<Binding>&){ return(Cost{1, 7}); },
+        [](Out& out, OperandNode* d, const Operands& o){ out.push_back(new MoveInstruction{o[0], d}); }},
+    {"NEG(dst)", [](const std::vector<Binding>&){ return(Cost{6, 3}); },
+        [](Out& out, OperandNode* d, const Operands&){ emitUnary(out, UnaryOperator::Negation, d); }},
+    {"NOT(dst)", [](const std::vector<Binding>&){ return(Cost{6, 3}); },
+        [](Out& out, OperandNode* d, const Operands&){ emitUnary(out, UnaryOperator::Complement, d); }},
+    {"ADD(dst,1)", [](const std::vector<Binding>&){ return(Cost{6, 3}); },
+        [](Out& out, OperandNode* d, const Operands&){ emitUnary(out, UnaryOperator::Increment, d); }},
+    {"SUB(dst,-1)", [](const std::vector<Binding>&){ return(Cost{6, 3}); },
+        [](Out& out, OperandNode* d, const Operands&){ emitUnary(out, UnaryOperator::Increment, d); }},
+    {"ADD(dst,-1)", [](const std::vector<Binding>&){ return(Cost{6, 3}); },
+        [](Out& out, OperandNode* d, const Operands&){ emitUnary(out, UnaryOperator::Decrement, d); }},
+    {"SUB(dst,1)", [](const std::vector<Binding>&){ return(Cost{6, 3}); },
+        [](Out& out, OperandNode* d, const Operands&){ emitUnary(out, UnaryOperator::Decrement, d); }},
+    {"ADD(dst,imm)", [](const std::vector<Binding>& b){ return(Cost{6, 3 + immediateSize(b[0].tree->value)}); },
+        [](Out& out, OperandNode* d, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[0], d); }},
+    {"ADD(imm,dst)", [](const std::vector<Binding>& b){ return(Cost{6, 3 + immediateSize(b[0].tree->value)}); },
+        [](Out& out, OperandNode* d, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[0], d); }},
+    {"SUB(dst,imm)", [](const std::vector<Binding>& b){ return(Cost{6, 3 + immediateSize(b[0].tree->value)}); },
+        [](Out& out, OperandNode* d, const Operands& o){ emitBinary(out, BinaryOperator::Subtract, o[0], d); }},
+    {"ADD(dst,reg)", [](const std::vector<Binding>&){ return(Cost{6, 3}); },
+        [](Out& out, OperandNode* d, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[0], d); }},
+    {"ADD(reg,dst)", [](const std::vector<Binding>&){ return(Cost{6, 3}); },
+        [](Out& out, OperandNode* d, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[0], d); }},
+    {"SUB(dst,reg)", [](const std::vector<Binding>&){ return(Cost{6, 3}); },
+        [](Out& out, OperandNode* d, const Operands& o){ emitBinary(out, BinaryOperator::Subtract, o[0], d); }},
+    {"ADD(dst,mem)", [](const std::vector<Binding>&){ return(Cost{9, 6}); },
+        [](Out& out, OperandNode* d, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[0], d); }},
+    {"ADD(mem,dst)", [](const std::vector<Binding>&){ return(Cost{9, 6}); },
+        [](Out& out, OperandNode* d, const Operands& o){ emitBinary(out, BinaryOperator::Add, o[0], d); }},
+    {"SUB(dst,mem)", [](const std::vector<Binding>&){ return(Cost{9, 6}); },
+        [](Out& out, OperandNode* d, const Operands& o){ emitBinary(out, BinaryOperator::Subtract, o[0], d); }},
+};
+
+// Generated by mycc -superoptimize (make superopt-table), see Superoptimizer.hpp
+const std::vector<InstructionSelector::Rewrite> InstructionSelector::rewrites = {
+#include "SuperoptTable.inc"
+};
+
+const std::vector<InstructionSelector::Rewrite>& InstructionSelector::getRewrites(){
+    return(rewrites);
+}
+
+void InstructionSelector::emitRewrite(std::vector<InstructionNode*>& out, RegisterNode* result, const std::vector<RewriteStep>& steps){
+    for(const RewriteStep& step: steps){
+        switch(step.op){
+            case StepOp::NEG: emitUnary(out, UnaryOperator::Negation, result); break;
+            case StepOp::NOT: emitUnary(out, UnaryOperator::Complement, result); break;
+            case StepOp::INC: emitUnary(out, UnaryOperator::Increment, result); break;
+            case StepOp::DEC: emitUnary(out, UnaryOperator::Decrement, result); break;
+            case StepOp::ADD: emitBinary(out, BinaryOperator::Add, new ImmediateNode{std::to_string(step.amount)}, result); break;
+        }
+    }
+}
+
+// ======================================================
+//                     Patterns
+// ======================================================
+InstructionSelector::PatternNode InstructionSelector::parsePattern(const char*& text){
+    static const std::vector<std::pair<std::string, TreeOp>> operators = {
+        {"NEG", TreeOp::NEG}, {"NOT", TreeOp::NOT}, {"ADD", TreeOp::ADD}, {"SUB", TreeOp::SUB},
+        {"MUL", TreeOp::MUL}, {"DIV", TreeOp::DIV}, {"MOD", TreeOp::MOD}, {"AND", TreeOp::AND}, {"OR", TreeOp::OR},
+        {"XOR", TreeOp::XOR}, {"SHL", TreeOp::SHL}, {"SAR", TreeOp::SAR}, {"LT", TreeOp::LT}, {"LE", TreeOp::LE},
+        {"GT", TreeOp::GT}, {"GE", TreeOp::GE}, {"EQ", TreeOp::EQ}, {"NE", TreeOp::NE}
+    };
+    static const std::vector<std::pair<std::string, PatternNode::Kind>> leaves = {
+        {"reg", PatternNode::REG}, {"mem", PatternNode::MEM}, {"imm", PatternNode::IMM},
+        {"dup", PatternNode::DUP}, {"dst", PatternNode::DST}
+    };
+    std::string word;
+    while(*text != '\0' && *text != '(' && *text != ',' && *text != ')'){
+        word += *text++;
+    }
+    PatternNode node{PatternNode::OP, TreeOp::CONST, 0, {}};
+    for(const auto& leaf: leaves){
+        if(leaf.first == word){
+            node.kind = leaf.second;
+            return(node);
+        }
+    }
+    if(!word.empty() && (word[0] == '-' || (word[0] >= '0' && word[0] <= '9'))){
+        node.kind = PatternNode::CONSTANT;
+        node.value = TackySimplifier::wrapConstant(word);
+        return(node);
+    }
+    bool known = false;
+    for(const auto& op: operators){
+        if(op.first == word){
+            node.op = op.second;
+            known = true;
+        }
+    }
+    if(!known || *text != '('){
+        throw std::runtime_error("Invalid tile pattern near: " + word);
+    }
+    text++;
+    node.children.push_back(parsePattern(text));
+    while(*text == ','){
+        text++;
+        node.children.push_back(parsePattern(text));
+    }
+    if(*text != ')'){
+        throw std::runtime_error("Invalid tile pattern, missing )");
+    }
+    text++;
+    return(node);
+}
+
+const std::vector<InstructionSelector::PatternNode>& InstructionSelector::registerPatterns(){
+    static const std::vector<PatternNode> patterns = [](){
+        std::vector<PatternNode> parsed;
+        for(const Tile& tile: registerTiles){
+            const char* text = tile.pattern;
+            parsed.push_back(parsePattern(text));
+        }
+        for(const Rewrite& rewrite: rewrites){
+            const char* text = rewrite.pattern;
+            parsed.push_back(parsePattern(text));
+        }
+        return(parsed);
+    }();
+    return(patterns);
+}
+
+const std::vector<InstructionSelector::PatternNode>& InstructionSelector::storePatterns(){
+    static const std::vector<PatternNode> patterns = [](){
+        std::vector<PatternNode> parsed;
+        for(const Tile& tile: storeTiles){
+            const char* text = tile.pattern;
+            parsed.push_back(parsePattern(text));
+        }
+        return(parsed);
+    }();
+    return(patterns);
+}
+
+const std::vector<std::vector<int>>& InstructionSelector::tilesByOp(){
+    static const std::vector<std::vector<int>> byOp = [](){
+        std::vector<std::vector<int>> lists(static_cast<size_t>(TreeOp::NE) + 1);
+        const std::vector<PatternNode>& patterns = registerPatterns();
+        for(size_t i = 0; i < patterns.size(); i++){
+            switch(patterns[i].kind){
+                case PatternNode::OP: lists[static_cast<size_t>(patterns[i].op)].push_back(static_cast<int>(i)); break;
+                case PatternNode::MEM: lists[static_cast<size_t>(TreeOp::VAR)].push_back(static_cast<int>(i)); break;
+                case PatternNode::IMM:
+                case PatternNode::CONSTANT: lists[static_cast<size_t>(TreeOp::CONST)].push_back(static_cast<int>(i)); break;
+                default: throw std::runtime_error("A register tile has to start with an operator, mem or imm");
+            }
+        }
+        return(lists);
+    }();
+    return(byOp);
+}
+
+// ======================================================
+//                     Matching and labelling
+// ======================================================
+bool InstructionSelector::costLess(Cost a, Cost b){
+    if(a.latency != b.latency){
+        return(a.latency < b.latency);
+    }
+    return(a.size < b.size);
+}
+
+bool InstructionSelector::isLeaf(Tree* tree){
+    return(tree->op == TreeOp::CONST || tree->op == TreeOp::VAR);
+}
+
+bool InstructionSelector::reads(Tree* tree, const std::string& name){
+    if(tree == nullptr){
+        return(false);
+    }
+    if(tree->op == TreeOp::VAR){
+        return(tree->name == name);
+    }
+    return(reads(tree->left, name) || reads(tree->right, name));
+}
+
+bool InstructionSelector::match(const PatternNode& pattern, Tree* tree, const std::string* dst, std::vector<Binding>& bindings){
+    switch(pattern.kind){
+        case PatternNode::OP:
+            if(tree->op != pattern.op){
+                return(false);
+            }
+            if(!match(pattern.children[0], tree->left, dst, bindings)){
+                return(false);
+            }
+            return(pattern.children.size() < 2 || match(pattern.children[1], tree->right, dst, bindings));
+        case PatternNode::REG:
+            if(tree->tile < 0){
+                return(false);
+            }
+            bindings.push_back(Binding{tree, BindingKind::REG});
+            return(true);
+        case PatternNode::MEM:
+            if(tree->op != TreeOp::VAR){
+                return(false);
+            }
+            bindings.push_back(Binding{tree, BindingKind::MEM});
+            return(true);
+        case PatternNode::IMM:
+            if(tree->op != TreeOp::CONST){
+                return(false);
+            }
+            bindings.push_back(Binding{tree, BindingKind::IMM});
+            return(true);
+        case PatternNode::CONSTANT:
+            return(tree->op == TreeOp::CONST && tree->value == pattern.value);
+        case PatternNode::DUP: {
+            if(bindings.empty()){
+                return(false);
+            }
+            Tree* previous = bindings.back().tree;
+            if(!isLeaf(previous) || previous->op != tree->op){
+                return(false);
+            }
+            return(tree->op == TreeOp::VAR ? previous->name == tree->name : previous->value == tree->value);
+        }
+        case PatternNode::DST:
+            return(dst != nullptr && tree->op == TreeOp::VAR && tree->name == *dst);
+    }
+    return(false);
+}
+
+bool InstructionSelector::usable(const std::vector<Binding>& bindings){
+    // only two registers to work with: the result and the scratch one
+    int registers = 0;
+    int subtrees = 0;
+    for(const Binding& binding: bindings){
+        if(binding.kind == BindingKind::REG){
+            registers++;
+            if(!isLeaf(binding.tree)){
+                subtrees++;
+            }
+        }
+    }
+    return(registers <= 2 && subtrees <= 1);
+}
+
+void InstructionSelector::label(Tree* tree, bool useRewrites){
+    const std::vector<PatternNode>& patterns = registerPatterns();
+    const int tileCount = static_cast<int>(registerTiles.size());
+    thread_local std::vector<Binding> bindings;
+    tree->tile = -1;
+    for(int i: tilesByOp()[static_cast<size_t>(tree->op)]){
+        if(i >= tileCount && !useRewrites){
+            continue;
+        }
+        bindings.clear();
+        if(!match(patterns[i], tree, nullptr, bindings) || !usable(bindings)){
+            continue;
+        }
+        Cost cost = i < tileCount ? registerTiles[i].cost(bindings) : rewrites[i - tileCount].cost;
+        for(const Binding& binding: bindings){
+            if(binding.kind == BindingKind::REG){
+                cost.latency += binding.tree->cost.latency;
+                cost.size += binding.tree->cost.size;
+            }
+        }
+        if(tree->tile < 0 || costLess(cost, tree->cost)){
+            tree->tile = i;
+            tree->cost = cost;
+        }
+    }
+}
+
+// ======================================================
+//                     Emission
+// ======================================================
+std::vector<OperandNode*> InstructionSelector::emitBindings(const std::vector<Binding>& bindings, RegisterNode* result, RegisterNode* scratch){
+    std::vector<OperandNode*> operands(bindings.size(), nullptr);
+    bool resultTaken = false;
+    // the subtree goes first, into the result register, while the scratch one is still free to use
+    for(size_t i = 0; i < bindings.size(); i++){
+        if(bindings[i].kind == BindingKind::REG && !isLeaf(bindings[i].tree)){
+            emitRegister(bindings[i].tree, result, scratch);
+            operands[i] = result;
+            resultTaken = true;
+        }
+    }
+    for(size_t i = 0; i < bindings.size(); i++){
+        Tree* tree = bindings[i].tree;
+        if(bindings[i].kind == BindingKind::REG && isLeaf(tree)){
+            RegisterNode* target = resultTaken ? scratch : result;
+            emitRegister(tree, target, nullptr);
+            operands[i] = target;
+            resultTaken = true;
+        }else if(bindings[i].kind == BindingKind::MEM){
+            operands[i] = new Pseudo{tree->name};
+        }else if(bindings[i].kind == BindingKind::IMM){
+            operands[i] = new ImmediateNode{std::to_string(tree->value)};
+        }
+    }
+    return(operands);
+}
+
+void InstructionSelector::emitRegister(Tree* tree, RegisterNode* result, RegisterNode* scratch){
+    if(tree->tile < 0){
+        throw std::runtime_error("No tile covers the expression tree");
+    }
+    std::vector<Binding> bindings;
+    match(registerPatterns()[tree->tile], tree, nullptr, bindings);
+    std::vector<OperandNode*> operands = emitBindings(bindings, result, scratch);
+    if(tree->tile < static_cast<int>(registerTiles.size())){
+        registerTiles[tree->tile].emit(this->out, result, operands);
+    }else{
+        emitRewrite(this->out, result, rewrites[tree->tile - registerTiles.size()].steps);
+    }
+}
+
+void InstructionSelector::emitStore(const std::string& dst, Tree* tree){
+    const std::vector<PatternNode>& patterns = storePatterns();
+    std::vector<Binding> bindings;
+    int best = -1;
+    Cost bestCost{0, 0};
+    for(size_t i = 0; i < storeTiles.size(); i++){
+        bindings.clear();
+        if(!match(patterns[i], tree, &dst, bindings) || !usable(bindings)){
+            continue;
+        }
+        Cost cost = storeTiles[i].cost(bindings);
+        for(const Binding& binding: bindings){
+            if(binding.kind == BindingKind::REG){
+                cost.latency += binding.tree->cost.latency;
+                cost.size += binding.tree->cost.size;
+            }
+        }
+        if(best < 0 || costLess(cost, bestCost)){
+            best = static_cast<int>(i);
+            bestCost = cost;
+        }
+    }
+    if(best < 0){
+        throw std::runtime_error("No tile stores the expression tree into " + dst);
+    }
+    bindings.clear();
+    match(patterns[best], tree, &dst, bindings);
+    std::vector<OperandNode*> operands = emitBindings(bindings, new RegisterNode{RegisterName::R10}, new RegisterNode{RegisterName::AX});
+    storeTiles[best].emit(this->out, new Pseudo{dst}, operands);
+    this->emitted.latency += bestCost.latency;
+    this->emitted.size += bestCost.size;
+}
+
+void InstructionSelector::emitReturn(Tree* tree){
+    // computed straight into %eax, %r10d is free as the scratch register
+    emitRegister(tree, new RegisterNode{RegisterName::AX}, new RegisterNode{RegisterName::R10});
+    this->out.push_back(new IRReturnNode{});
+    this->emitted.latency += tree->cost.latency;
+    this->emitted.size += tree->cost.size;
+}
+
+static bool isComparison(InstructionSelector::TreeOp op){
+    return(op >= InstructionSelector::TreeOp::LT && op <= InstructionSelector::TreeOp::NE);
+}
+
+static ConditionCode conditionOf(InstructionSelector::TreeOp op){
+    switch(op){
+        case InstructionSelector::TreeOp::LT: return(ConditionCode::L);
+        case InstructionSelector::TreeOp::LE: return(ConditionCode::LE);
+        case InstructionSelector::TreeOp::GT: return(ConditionCode::G);
+        case InstructionSelector::TreeOp::GE: return(ConditionCode::GE);
+        case InstructionSelector::TreeOp::EQ: return(ConditionCode::E);
+        default: return(ConditionCode::NE);
+    }
+}
+
+// The operand a leaf is used as in place
+static OperandNode* leafOperand(InstructionSelector::Tree* tree){
+    if(tree->op == InstructionSelector::TreeOp::CONST){
+        return(immediate(tree->value));
+    }
+    return(new Pseudo{tree->name});
+}
+
+ConditionCode InstructionSelector::emitCompare(Tree* tree, RegisterNode* work, RegisterNode* scratch, bool keepR10){
+    ConditionCode condition = conditionOf(tree->op);
+    Tree* left = tree->left;
+    Tree* right = tree->right;
+    if(!isLeaf(left)){
+        emitRegister(left, work, scratch);
+        this->out.push_back(new CompareInstruction{leafOperand(right), work});
+        return(condition);
+    }
+    if(!isLeaf(right)){
+        emitRegister(right, work, scratch);
+        this->out.push_back(new CompareInstruction{leafOperand(left), work});
+        return(swap_condition(condition));
+    }
+    if(left->op == TreeOp::CONST && right->op == TreeOp::VAR){
+        // cmpl takes its immediate as the first operand only
+        this->out.push_back(new CompareInstruction{leafOperand(left), leafOperand(right)});
+        return(swap_condition(condition));
+    }
+    if(left->op == TreeOp::CONST || (keepR10 && right->op == TreeOp::VAR)){
+        this->out.push_back(new MoveInstruction{leafOperand(left), work});
+        this->out.push_back(new CompareInstruction{leafOperand(right), work});
+        return(condition);
+    }
+    this->out.push_back(new CompareInstruction{leafOperand(right), leafOperand(left)});
+    return(condition);
+}
+
+void InstructionSelector::emitBranchIfZero(Tree* tree, const std::string& target){
+    if(isComparison(tree->op) && (isLeaf(tree->left) || isLeaf(tree->right))){
+        // the flags of the cmpl are tested directly, jumping when the comparison is false
+        ConditionCode condition = emitCompare(tree, new RegisterNode{RegisterName::R10}, new RegisterNode{RegisterName::AX}, false);
+        this->out.push_back(new ConditionalJumpInstruction{negate_condition(condition), target});
+        return;
+    }
+    OperandNode* condition = nullptr;
+    if(tree->op == TreeOp::VAR){
+        condition = new Pseudo{tree->name};
+    }else{
+        // like a store, computed in %r10d with %eax as the scratch
+        condition = new RegisterNode{RegisterName::R10};
+        emitRegister(tree, static_cast<RegisterNode*>(condition), new RegisterNode{RegisterName::AX});
+    }
+    this->out.push_back(new CompareInstruction{new ImmediateNode{"0"}, condition});
+    this->out.push_back(new ConditionalJumpInstruction{ConditionCode::E, target});
+}
+
+// ======================================================
+//                     Tree building
+// ======================================================
+InstructionSelector::Tree* InstructionSelector::treeOfPattern(const PatternNode& pattern, bool useRewrites){
+    Tree* tree = nullptr;
+    switch(pattern.kind){
+        case PatternNode::OP:
+            tree = newTree(pattern.op, treeOfPattern(pattern.children[0], useRewrites),
+                pattern.children.size() < 2 ? nullptr : treeOfPattern(pattern.children[1], useRewrites));
+            label(tree, useRewrites);
+            return(tree);
+        case PatternNode::REG:
+            // already in the result register: free, and loaded by a plain mov that selectPattern drops
+            tree = newTree(TreeOp::VAR);
+            tree->name = "reg";
+            tree->tile = 0;
+            return(tree);
+        case PatternNode::CONSTANT:
+            tree = newTree(TreeOp::CONST);
+            tree->value = pattern.value;
+            label(tree, useRewrites);
+            return(tree);
+        default:
+            throw std::runtime_error("Only operators, reg and constants can be selected from a pattern");
+    }
+}
+
+std::vector<InstructionNode*> InstructionSelector::selectPattern(const std::string& pattern, bool useRewrites, Cost& cost){
+    const char* text = pattern.c_str();
+    PatternNode root = parsePattern(text);
+    InstructionSelector selector;
+    Tree* tree = selector.treeOfPattern(root, useRewrites);
+    cost = tree->cost;
+    selector.emitRegister(tree, new RegisterNode{RegisterName::AX}, new RegisterNode{RegisterName::R10});
+    std::vector<InstructionNode*> instructions;
+    for(InstructionNode* instr: selector.out){
+        MoveInstruction* mov = dynamic_cast<MoveInstruction*>(instr);
+        if(mov == nullptr || dynamic_cast<Pseudo*>(mov->getSrc()) == nullptr){
+            instructions.push_back(instr);
+        }
+    }
+    return(instructions);
+}
+
+InstructionSelector::TreeOp InstructionSelector::treeOpOf(BinaryOperator op){
+    switch(op){
+        case BinaryOperator::Add: return(TreeOp::ADD);
+        case BinaryOperator::Subtract: return(TreeOp::SUB);
+        case BinaryOperator::Multiply: return(TreeOp::MUL);
+        case BinaryOperator::Divide: return(TreeOp::DIV);
+        case BinaryOperator::Remainder: return(TreeOp::MOD);
+        case BinaryOperator::BitwiseAnd: return(TreeOp::AND);
+        case BinaryOperator::BitwiseOr: return(TreeOp::OR);
+        case BinaryOperator::BitwiseXor: return(TreeOp::XOR);
+        case BinaryOperator::LeftShift: return(TreeOp::SHL);
+        case BinaryOperator::RightShift: return(TreeOp::SAR);
+        case BinaryOperator::LessThan: return(TreeOp::LT);
+        case BinaryOperator::LessOrEqual: return(TreeOp::LE);
+        case BinaryOperator::GreaterThan: return(TreeOp::GT);
+        case BinaryOperator::GreaterOrEqual: return(TreeOp::GE);
+        case BinaryOperator::Equal: return(TreeOp::EQ);
+        case BinaryOperator::NotEqual: return(TreeOp::NE);
+        default:
+            throw std::runtime_error("Cannot select instructions for binary operator " + binary_operator_to_string(op));
+    }
+}
+
+InstructionSelector::Tree* InstructionSelector::newTree(TreeOp op, Tree* left, Tree* right){
+    int depth = 1 + std::max(left == nullptr ? 0 : left->depth, right == nullptr ? 0 : right->depth);
+    this->trees.push_back(std::unique_ptr<Tree>(new Tree{op, "", 0, left, right, -1, Cost{0, 0}, depth}));
+    return(this->trees.back().get());
+}
+
+bool InstructionSelector::isPending(TackyVal* val){
+    TackyVariable* var = dynamic_cast<TackyVariable*>(val);
+    if(var == nullptr){
+        return(false);
+    }
+    for(auto it = this->pending.rbegin(); it != this->pending.rend(); it++){
+        if(it->first == var->getVariableIdentifier()){
+            return(true);
+        }
+    }
+    return(false);
+}
+
+bool InstructionSelector::isFoldable(TackyVal* dst){
+    TackyVariable* var = dynamic_cast<TackyVariable*>(dst);
+    if(var == nullptr){
+        return(false);
+    }
+    const std::string& name = var->getVariableIdentifier();
+    return(TackySimplifier::isTemporary(name) && this->definitions[name] == 1 && this->uses[name] == 1);
+}
+
+InstructionSelector::Tree* InstructionSelector::treeOf(TackyVal* val){
+    if(TackyConstant* constant = dynamic_cast<TackyConstant*>(val)){
+        Tree* tree = newTree(TreeOp::CONST);
+        tree->value = TackySimplifier::wrapConstant(constant->getValue());
+        label(tree);
+        return(tree);
+    }
+    TackyVariable* var = dynamic_cast<TackyVariable*>(val);
+    if(var == nullptr){
+        throw std::runtime_error("TAC value is neither TackyVariable nor TackyConstant");
+    }
+    const std::string& name = var->getVariableIdentifier();
+    for(auto it = this->pending.begin(); it != this->pending.end(); it++){
+        if(it->first == name){
+            // the only read of the temporary, its tree is folded in here
+            Tree* tree = it->second;
+            this->pending.erase(it);
+            return(tree);
+        }
+    }
+    Tree* tree = newTree(TreeOp::VAR);
+    tree->name = name;
+    label(tree);
+    return(tree);
+}
+
+void InstructionSelector::flushReaders(const std::string& name){
+    std::vector<std::pair<std::string, Tree*>> kept;
+    for(const auto& entry: this->pending){
+        if(reads(entry.second, name)){
+            emitStore(entry.first, entry.second);
+        }else{
+            kept.push_back(entry);
+        }
+    }
+    this->pending.swap(kept);
+}
+
+void InstructionSelector::flushPending(){
+    for(const auto& entry: this->pending){
+        emitStore(entry.first, entry.second);
+    }
+    this->pending.clear();
+}
+
+// Matching and emitting a tree recurse once per level, a deeper tree is stored into its temporary instead of folded
+static const int MAX_TREE_DEPTH = 256;
+
+void InstructionSelector::define(TackyVal* dst, Tree* tree){
+    TackyVariable* var = dynamic_cast<TackyVariable*>(dst);
+    if(var == nullptr){
+        throw std::runtime_error("TAC destination is not a TackyVariable");
+    }
+    if(isFoldable(dst) && tree->depth < MAX_TREE_DEPTH){
+        this->pending.push_back(std::make_pair(var->getVariableIdentifier(), tree));
+        return;
+    }
+    flushReaders(var->getVariableIdentifier());
+    emitStore(var->getVariableIdentifier(), tree);
+}
+
+InstructionSelector::Tree* InstructionSelector::treeOfInstruction(TackyInstruction* instr, TackyVal*& dst){
+    Tree* tree = nullptr;
+    if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instr)){
+        Tree* child = treeOf(unary->getSrc());
+        switch(unary->getUnaryOperator()){
+            case UnaryOperator::Negation: tree = newTree(TreeOp::NEG, child); break;
+            case UnaryOperator::Complement: tree = newTree(TreeOp::NOT, child); break;
+            case UnaryOperator::Increment:
+            case UnaryOperator::Decrement: {
+                Tree* one = newTree(TreeOp::CONST);
+                one->value = 1;
+                label(one);
+                tree = newTree(unary->getUnaryOperator() == UnaryOperator::Increment ? TreeOp::ADD : TreeOp::SUB, child, one);
+                break;
+            }
+            default:
+                throw std::runtime_error("Cannot select instructions for unknown unary operator");
+        }
+        label(tree);
+        dst = unary->getDst();
+    }else if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instr)){
+        tree = treeOf(copy->getSrc());
+        dst = copy->getDst();
+    }else if(TackyBinary* binary = dynamic_cast<TackyBinary*>(instr)){
+        if(isPending(binary->getSrc1()) && isPending(binary->getSrc2())){
+            // two subtrees would need three registers, the first one goes through its temporary instead
+            std::string name = dynamic_cast<TackyVariable*>(binary->getSrc1())->getVariableIdentifier();
+            Tree* first = treeOf(binary->getSrc1());
+            emitStore(name, first);
+        }
+        Tree* left = treeOf(binary->getSrc1());
+        Tree* right = treeOf(binary->getSrc2());
+        tree = newTree(treeOpOf(binary->getBinaryOperator()), left, right);
+        label(tree);
+        dst = binary->getDst();
+    }else{
+        throw std::runtime_error("Cannot select instructions for unknown TAC instruction");
+    }
+    return(tree);
+}
+
+// ======================================================
+//                     If-conversion
+// ======================================================
+// A mispredicted branch flushes the pipeline, ~16 cycles on the build machine (see InstructionSelector.hpp). With
+// no profile a data dependent condition is taken as unpredictable: half of the outcomes missed.
+static const int MISPREDICT_PENALTY = 16;
+static const int MISPREDICT_RATE_DIVISOR = 2;
+// movl %r10d, %r11d into the register cmov writes and the move out of it
+static const int CMOV_OVERHEAD = 2;
+
+static bool isArmInstruction(TackyInstruction* instr){
+    return(dynamic_cast<TackyUnary*>(instr) != nullptr || dynamic_cast<TackyBinary*>(instr) != nullptr
+        || dynamic_cast<TackyCopy*>(instr) != nullptr);
+}
+
+static std::string variableOf(TackyVal* val){
+    TackyVariable* var = dynamic_cast<TackyVariable*>(val);
+    return(var == nullptr ? "" : var->getVariableIdentifier());
+}
+
+static std::string labelOf(TackyInstruction* instr){
+    TackyLabel* label = dynamic_cast<TackyLabel*>(instr);
+    return(label == nullptr ? "" : label->getIdentifier());
+}
+
+bool InstructionSelector::isSpeculable(const std::vector<TackyInstruction*>& instructions, size_t begin, size_t end, std::string& result){
+    std::unordered_map<std::string, int> armUses;
+    std::vector<std::string> destinations;
+    for(size_t i = begin; i < end; i++){
+        std::vector<TackyVal*> reads;
+        if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instructions[i])){
+            reads.push_back(unary->getSrc());
+            destinations.push_back(variableOf(unary->getDst()));
+        }else if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instructions[i])){
+            reads.push_back(copy->getSrc());
+            destinations.push_back(variableOf(copy->getDst()));
+        }else{
+            TackyBinary* binary = static_cast<TackyBinary*>(instructions[i]);
+            BinaryOperator op = binary->getBinaryOperator();
+            if(op == BinaryOperator::Divide || op == BinaryOperator::Remainder){
+                // a division by a nonzero constant never traps, it is done without idivl
+                TackyConstant* divisor = dynamic_cast<TackyConstant*>(binary->getSrc2());
+                if(divisor == nullptr || TackySimplifier::wrapConstant(divisor->getValue()) == 0){
+                    return(false);
+                }
+            }
+            reads.push_back(binary->getSrc1());
+            reads.push_back(binary->getSrc2());
+            destinations.push_back(variableOf(binary->getDst()));
+        }
+        for(TackyVal* read: reads){
+            std::string name = variableOf(read);
+            if(!name.empty()){
+                armUses[name]++;
+            }
+        }
+    }
+    result = destinations.back();
+    for(size_t i = 0; i + 1 < destinations.size(); i++){
+        const std::string& name = destinations[i];
+        if(name == result || !TackySimplifier::isTemporary(name) || this->definitions[name] != 1
+            || this->uses[name] != armUses[name]){
+            return(false);
+        }
+    }
+    return(!result.empty());
+}
+
+bool InstructionSelector::emitSelect(const std::vector<TackyInstruction*>& instructions, size_t& index, const std::string& function){
+    TackyJumpIfZero* branch = static_cast<TackyJumpIfZero*>(instructions[index]);
+    const std::string& otherwise = branch->getTarget();
+    if(dynamic_cast<TackyConstant*>(branch->getCondition()) != nullptr || this->labelReferences[otherwise] != 1){
+        return(false);
+    }
+    // c; JumpIfZero(c, else); then; Jump(end); else: else; end:   or   c; JumpIfZero(c, end); then; end:
+    size_t thenBegin = index + 1;
+    size_t thenEnd = thenBegin;
+    while(thenEnd < instructions.size() && isArmInstruction(instructions[thenEnd])){
+        thenEnd++;
+    }
+    if(thenEnd == thenBegin || thenEnd >= instructions.size()){
+        return(false);
+    }
+    size_t elseBegin = thenEnd;
+    size_t elseEnd = thenEnd;
+    size_t last = thenEnd;
+    bool diamond = labelOf(instructions[thenEnd]) != otherwise;
+    if(diamond){
+        TackyJump* jump = dynamic_cast<TackyJump*>(instructions[thenEnd]);
+        if(jump == nullptr || thenEnd + 1 >= instructions.size() || labelOf(instructions[thenEnd + 1]) != otherwise
+            || this->labelReferences[jump->getTarget()] != 1){
+            return(false);
+        }
+        elseBegin = thenEnd + 2;
+        elseEnd = elseBegin;
+        while(elseEnd < instructions.size() && isArmInstruction(instructions[elseEnd])){
+            elseEnd++;
+        }
+        if(elseEnd == elseBegin || elseEnd >= instructions.size() || labelOf(instructions[elseEnd]) != jump->getTarget()){
+            return(false);
+        }
+        last = elseEnd;
+    }
+    std::string result;
+    std::string elseResult;
+    if(!isSpeculable(instructions, thenBegin, thenEnd, result)
+        || (diamond && (!isSpeculable(instructions, elseBegin, elseEnd, elseResult) || elseResult != result))){
+        return(false);
+    }
+
+    // each arm costs what the tiles make of it on its own. The branch runs one of them and pays for the misses,
+    // the cmov runs both
+    InstructionSelector armSelector;
+    armSelector.select(std::vector<TackyInstruction*>(instructions.begin() + thenBegin, instructions.begin() + thenEnd), function);
+    int thenLatency = armSelector.emitted.latency;
+    int elseLatency = 0;
+    Tree* old = newTree(TreeOp::VAR);
+    old->name = result;
+    label(old);
+    if(diamond){
+        armSelector.select(std::vector<TackyInstruction*>(instructions.begin() + elseBegin, instructions.begin() + elseEnd), function);
+        elseLatency = armSelector.emitted.latency;
+    }
+    int branchLatency = 1 + (thenLatency + elseLatency) / 2 + MISPREDICT_PENALTY / MISPREDICT_RATE_DIVISOR;
+    int selectLatency = thenLatency + (diamond ? elseLatency : old->cost.latency) + CMOV_OVERHEAD;
+    if(selectLatency > branchLatency){
+        return(false);
+    }
+
+    Tree* condition = treeOf(branch->getCondition());
+    flushPending();
+    if(condition->op != TreeOp::VAR && !(isComparison(condition->op) && isLeaf(condition->left)
+        && isLeaf(condition->right) && (condition->left->op == TreeOp::VAR || condition->right->op == TreeOp::VAR))){
+        // only %eax is left for the cmpl, anything more goes through the temporary first
+        std::string name = variableOf(branch->getCondition());
+        emitStore(name, condition);
+        condition = newTree(TreeOp::VAR);
+        condition->name = name;
+        label(condition);
+    }
+    Tree* thenValue = nullptr;
+    Tree* elseValue = old;
+    for(size_t i = thenBegin; i < thenEnd; i++){
+        TackyVal* dst = nullptr;
+        Tree* tree = treeOfInstruction(instructions[i], dst);
+        if(i + 1 < thenEnd){
+            define(dst, tree);
+        }else{
+            thenValue = tree;
+        }
+    }
+    for(size_t i = elseBegin; i < elseEnd; i++){
+        TackyVal* dst = nullptr;
+        Tree* tree = treeOfInstruction(instructions[i], dst);
+        if(i + 1 < elseEnd){
+            define(dst, tree);
+        }else{
+            elseValue = tree;
+        }
+    }
+    flushPending();
+
+    // the else value in %r11d, the then value in %r10d (or used in place), and the cmpl only touches %eax
+    RegisterNode* selected = new RegisterNode{RegisterName::R11};
+    if(isLeaf(elseValue)){
+        this->out.push_back(new MoveInstruction{leafOperand(elseValue), selected});
+    }else{
+        emitRegister(elseValue, new RegisterNode{RegisterName::R10}, new RegisterNode{RegisterName::AX});
+        this->out.push_back(new MoveInstruction{new RegisterNode{RegisterName::R10}, selected});
+    }
+    OperandNode* thenOperand = nullptr;
+    if(thenValue->op == TreeOp::VAR){
+        thenOperand = new Pseudo{thenValue->name};
+    }else{
+        thenOperand = new RegisterNode{RegisterName::R10};
+        emitRegister(thenValue, static_cast<RegisterNode*>(thenOperand), new RegisterNode{RegisterName::AX});
+    }
+    ConditionCode taken = ConditionCode::NE;
+    if(condition->op == TreeOp::VAR){
+        this->out.push_back(new CompareInstruction{immediate(0), new Pseudo{condition->name}});
+    }else{
+        taken = emitCompare(condition, new RegisterNode{RegisterName::AX}, nullptr, true);
+    }
+    this->out.push_back(new ConditionalMoveInstruction{taken, thenOperand, selected});
+    this->out.push_back(new MoveInstruction{selected, new Pseudo{result}});
+    index = last;
+    return(true);
+}
+
+// ======================================================
+//                     Switch lowering
+// ======================================================
+// A table is worth its bounds check and indirect jump from 4 cases on, as long as it is at least 40% full.
+// Up to 8 single cases are compared in a row rather than split further by the tree: a chain's je is rarely
+// taken, while each level of the tree is a coin flip on random values.
+static const size_t MIN_JUMP_TABLE_CASES = 4;
+static const int64_t MIN_JUMP_TABLE_DENSITY = 40;
+static const size_t MAX_LINEAR_CLUSTERS = 8;
+
+void InstructionSelector::emitSwitch(TackySwitch* dispatch, const std::string& function){
+    Tree* value = treeOf(dispatch->getValue());
+    flushPending();
+    if(value->op == TreeOp::CONST){
+        this->out.push_back(new JumpInstruction{local_label(function, dispatch->targetOf(value->value))});
+        return;
+    }
+    RegisterNode* index = new RegisterNode{RegisterName::AX};
+    if(value->op == TreeOp::VAR){
+        this->out.push_back(new MoveInstruction{new Pseudo{value->name}, index});
+    }else{
+        emitRegister(value, index, new RegisterNode{RegisterName::R10});
+    }
+
+    std::vector<std::pair<int32_t, std::string>> cases;
+    for(const std::pair<int32_t, std::string>& c: dispatch->getCases()){
+        cases.push_back(std::make_pair(c.first, local_label(function, c.second)));
+    }
+    std::sort(cases.begin(), cases.end());
+    // from each case, the furthest one the run up to which is dense enough for a table
+    std::vector<CaseCluster> clusters;
+    for(size_t begin = 0; begin < cases.size();){
+        size_t end = begin + 1;
+        for(size_t last = begin + MIN_JUMP_TABLE_CASES - 1; last < cases.size(); last++){
+            int64_t range = static_cast<int64_t>(cases[last].first) - cases[begin].first + 1;
+            if(static_cast<int64_t>(last - begin + 1) * 100 >= MIN_JUMP_TABLE_DENSITY * range){
+                end = last + 1;
+            }
+        }
+        clusters.push_back(CaseCluster{begin, end, end - begin >= MIN_JUMP_TABLE_CASES});
+        begin = end;
+    }
+    emitCaseTree(cases, clusters, 0, clusters.size(), INT32_MIN, INT32_MAX, local_label(function, dispatch->getDefault()), function);
+}
+
+void InstructionSelector::emitCaseTree(const std::vector<std::pair<int32_t, std::string>>& cases, const std::vector<CaseCluster>& clusters,
+    size_t first, size_t last, int64_t low, int64_t high, const std::string& otherwise, const std::string& function){
+    RegisterNode* index = new RegisterNode{RegisterName::AX};
+    bool linear = last - first <= MAX_LINEAR_CLUSTERS;
+    for(size_t k = first; k < last && linear; k++){
+        linear = !clusters[k].table;
+    }
+    if(linear){
+        // each compare that fails at a bound moves it, so the last case (or the default) may need no compare
+        for(size_t k = first; k < last && low <= high; k++){
+            const std::pair<int32_t, std::string>& c = cases[clusters[k].begin];
+            if(low == c.first && high == c.first){
+                this->out.push_back(new JumpInstruction{c.second});
+                return;
+            }
+            this->out.push_back(new CompareInstruction{immediate(c.first), index});
+            this->out.push_back(new ConditionalJumpInstruction{ConditionCode::E, c.second});
+            if(c.first == low){
+                low++;
+            }else if(c.first == high){
+                high--;
+            }
+        }
+        if(low <= high){
+            this->out.push_back(new JumpInstruction{otherwise});
+        }
+        return;
+    }
+    if(last - first == 1){
+        const CaseCluster& cluster = clusters[first];
+        int32_t tableLow = cases[cluster.begin].first;
+        int32_t tableHigh = cases[cluster.end - 1].first;
+        std::vector<std::string> targets;
+        size_t next = cluster.begin;
+        for(int64_t v = tableLow; v <= tableHigh; v++){
+            if(cases[next].first == v){
+                targets.push_back(cases[next++].second);
+            }else{
+                targets.push_back(otherwise);
+            }
+        }
+        if(tableLow != 0){
+            this->out.push_back(new BinaryInstruction{BinaryOperator::Subtract, immediate(tableLow), index});
+        }
+        if(low < tableLow || high > tableHigh){
+            // below tableLow the difference wraps around to a large unsigned value
+            this->out.push_back(new CompareInstruction{immediate(tableHigh - tableLow), index});
+            this->out.push_back(new ConditionalJumpInstruction{ConditionCode::A, otherwise});
+        }
+        std::string table = local_label(function, "table." + std::to_string(this->switchLabels++));
+        this->out.push_back(new JumpTableInstruction{index, new RegisterNode{RegisterName::R10}, table, targets, otherwise});
+        return;
+    }
+    // the upper half starts at the first value of the middle cluster
+    size_t middle = first + (last - first) / 2;
+    int32_t pivot = cases[clusters[middle].begin].first;
+    std::string upper = local_label(function, "dispatch." + std::to_string(this->switchLabels++));
+    this->out.push_back(new CompareInstruction{immediate(pivot), index});
+    this->out.push_back(new ConditionalJumpInstruction{ConditionCode::GE, upper});
+    emitCaseTree(cases, clusters, first, middle, low, pivot - static_cast<int64_t>(1), otherwise, function);
+    this->out.push_back(new LabelInstruction{upper});
+    emitCaseTree(cases, clusters, middle, last, pivot, high, otherwise, function);
+}
+
+// ======================================================
+//                     Calls
+// ======================================================
+void InstructionSelector::emitParameters(const std::vector<std::string>& params){
+    const std::vector<RegisterName>& registers = CallInstruction::argumentRegisters();
+    for(size_t k = 0; k < params.size(); k++){
+        if(k < registers.size()){
+            this->out.push_back(new MoveInstruction{new RegisterNode{registers[k]}, new Pseudo{params[k]}});
+        }else{
+            // above the return address and the saved %rbp, the seventh argument first
+            this->out.push_back(new MoveInstruction{new Stack{16 + 8 * static_cast<int>(k - registers.size())}, new Pseudo{params[k]}});
+        }
+    }
+}
+
+void InstructionSelector::emitCall(TackyFunctionCall* call){
+    // the callee clobbers %eax, %r10d and every argument register, no tree can stay pending over it
+    flushPending();
+    const std::vector<RegisterName>& registers = CallInstruction::argumentRegisters();
+    std::vector<TackyVal*>& args = call->getArgs();
+    size_t stackArguments = args.size() > registers.size() ? args.size() - registers.size() : 0;
+    // %rsp is 16 byte aligned at the call, the pushes keep it so when there is an even number of them
+    if(stackArguments % 2 != 0){
+        this->out.push_back(new PushInstruction{immediate(0)});
+    }
+    for(size_t k = args.size(); k-- > registers.size();){
+        Tree* arg = treeOf(args[k]);
+        if(arg->op == TreeOp::CONST){
+            this->out.push_back(new PushInstruction{immediate(arg->value)});
+        }else{
+            this->out.push_back(new MoveInstruction{leafOperand(arg), new RegisterNode{RegisterName::AX}});
+            this->out.push_back(new PushInstruction{new RegisterNode{RegisterName::AX}});
+        }
+    }
+    size_t registerArguments = std::min(args.size(), registers.size());
+    for(size_t k = 0; k < registerArguments; k++){
+        this->out.push_back(new MoveInstruction{leafOperand(treeOf(args[k])), new RegisterNode{registers[k]}});
+    }
+    this->out.push_back(new CallInstruction{call->getName(), static_cast<int>(registerArguments)});
+    size_t pushed = stackArguments + stackArguments % 2;
+    if(pushed > 0){
+        this->out.push_back(new DeallocateStack{static_cast<int>(8 * pushed)});
+    }
+    std::string dst = variableOf(call->getDst());
+    flushReaders(dst);
+    this->out.push_back(new MoveInstruction{new RegisterNode{RegisterName::AX}, new Pseudo{dst}});
+}
+
+std::vector<InstructionNode*> InstructionSelector::select(const std::vector<TackyInstruction*>& instructions, const std::string& function,
+    const std::vector<std::string>& params){
+    this->trees.clear();
+    this->uses.clear();
+    this->definitions.clear();
+    this->pending.clear();
+    this->out.clear();
+    this->labelReferences.clear();
+    this->emitted = Cost{0, 0};
+    this->switchLabels = 0;
+    emitParameters(params);
+
+    auto countUse = [this](TackyVal* val){
+        if(TackyVariable* var = dynamic_cast<TackyVariable*>(val)){
+            this->uses[var->getVariableIdentifier()]++;
+        }
+    };
+    auto countDefinition = [this](TackyVal* val){
+        if(TackyVariable* var = dynamic_cast<TackyVariable*>(val)){
+            this->definitions[var->getVariableIdentifier()]++;
+        }
+    };
+    for(TackyInstruction* instr: instructions){
+        if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+            countUse(ret->getVar());
+        }else if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instr)){
+            countUse(unary->getSrc());
+            countDefinition(unary->getDst());
+        }else if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instr)){
+            countUse(copy->getSrc());
+            countDefinition(copy->getDst());
+        }else if(TackyBinary* binary = dynamic_cast<TackyBinary*>(instr)){
+            countUse(binary->getSrc1());
+            countUse(binary->getSrc2());
+            countDefinition(binary->getDst());
+        }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+            countUse(branch->getCondition());
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+            countUse(dispatch->getValue());
+        }else if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+            // an argument is moved from its variable into its register: a tree computed there could clobber the
+            // registers of the arguments before it (%edx by idivl, %ecx by a shift), so counting it twice keeps
+            // it from being folded
+            for(TackyVal* arg: call->getArgs()){
+                countUse(arg);
+                countUse(arg);
+            }
+            countDefinition(call->getDst());
+        }
+    }
+
+    for(TackyInstruction* instr: instructions){
+        if(TackyJump* jump = dynamic_cast<TackyJump*>(instr)){
+            this->labelReferences[jump->getTarget()]++;
+        }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+            this->labelReferences[branch->getTarget()]++;
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+            this->labelReferences[dispatch->getDefault()]++;
+            for(const std::pair<int32_t, std::string>& c: dispatch->getCases()){
+                this->labelReferences[c.second]++;
+            }
+        }
+    }
+
+    for(size_t i = 0; i < instructions.size(); i++){
+        TackyInstruction* instr = instructions[i];
+        if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+            emitReturn(treeOf(ret->getVar()));
+        }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+            if(emitSelect(instructions, i, function)){
+                continue;
+            }
+            Tree* condition = treeOf(branch->getCondition());
+            flushPending();
+            emitBranchIfZero(condition, local_label(function, branch->getTarget()));
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+            emitSwitch(dispatch, function);
+        }else if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+            emitCall(call);
+        }else if(TackyJump* jump = dynamic_cast<TackyJump*>(instr)){
+            flushPending();
+            this->out.push_back(new JumpInstruction{local_label(function, jump->getTarget())});
+        }else if(TackyLabel* tackyLabel = dynamic_cast<TackyLabel*>(instr)){
+            flushPending();
+            this->out.push_back(new LabelInstruction{local_label(function, tackyLabel->getIdentifier())});
+        }else{
+            TackyVal* dst = nullptr;
+            Tree* tree = treeOfInstruction(instr, dst);
+            define(dst, tree);
+        }
+    }
+    return(this->out);
+}
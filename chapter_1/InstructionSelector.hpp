@@ -0,0 +1,333 @@
+#ifndef INSTRUCTIONSELECTOR_HPP
+#define INSTRUCTIONSELECTOR_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Tacky.hpp"
+#include "Assembly.hpp"
+
+// ======================================================
+//                     InstructionSelector
+// ======================================================
+/**
+ * @brief Lowers the TAC of a function to assembly by tiling expression trees (BURS style).
+ *
+ * The TAC is first turned back into trees: a temporary that is written once and read once is folded into the
+ * instruction reading it, so return -(~x + 3) becomes a single tree RETURN(NEG(ADD(NOT(x), 3))) instead of
+ * three instructions. A tree stops growing at 256 levels (MAX_TREE_DEPTH), the next instruction reads it back from
+ * its temporary, so the recursive tiling stays shallow however long a chain is. Every tree is then covered with
+ * tiles from a table. A tile is a pattern over the tree (i.e "ADD(ADD(reg,reg),imm)" for leal k(%a,%b), %r), a
+ * latency/size cost and a function emitting its instructions. Going up from the leaves, each node keeps the
+ * cheapest tile covering it, lowest latency first and then fewest bytes, so the whole tree gets the cheapest cover
+ * the table allows.
+ *
+ * Pattern leaves:
+ *      reg     any subtree, computed into a register by its own cheapest tile
+ *      mem     a variable, used as a memory (Pseudo) operand
+ *      imm     a constant, used as an immediate
+ *      dup     the same variable or constant as the leaf bound just before (x + x)
+ *      dst     the variable the tree is assigned to (store tiles only, for read-modify-write forms)
+ *      1, -1   that constant
+ *
+ * A tree is computed in a working register, %eax when it is returned (so no move is needed) and %r10d
+ * otherwise. The other one of the two is the scratch a tile can load a second operand into. To never need a
+ * third register, a temporary is only folded when the node reading it keeps at least one leaf operand, and
+ * a tile may only use one non leaf subtree in a register. Variables are used as operands as if any of them could
+ * be in a register, the memory to memory forms this gives are fixed by the Legalizer once the locations are known.
+ *
+ * A multiply by a constant is planned rather than tiled directly: the constant (or its negation, followed by
+ * negl) is split into shifts, leal with a scale of 2, 4 or 8 and add/sub of the original value, and that chain is
+ * only kept when its latency beats imull's 3 cycles (x * 10 is leal + sall, x * 641 stays imull). Division and
+ * remainder by a constant never use idivl: a power of two is a biased sarl (andl/subl for the remainder), any
+ * other divisor the magic multiply of Hacker's Delight 10-1 (movslq, imulq, sarq, a correction and the sign fix),
+ * the remainder then being x - q * d. Dividing by a variable uses cltd and idivl, which pins %eax and %edx, and a
+ * shift by a variable count moves it into %ecx first (sall %cl); the register allocator keeps away from both in a
+ * function naming them.
+ *
+ * Trees don't cross basic blocks: the pending trees are stored before every label and jump. A comparison whose
+ * value is used is cmpl, setcc and movzbl. A JumpIfZero on a comparison is fused into cmpl and the negated jcc,
+ * on anything else it becomes cmpl $0 on its condition (a variable is compared in place, a tree first computed
+ * into %r10d) and je.
+ *
+ * The diamonds and triangles the TAC makes for ?:, && and || (and if/else assigning one variable) are
+ * if-converted when both arms are speculable, i.e. can't trap and only define temporaries local to the arm besides
+ * the result: the else value goes into %r11d, the then value is cmov'ed over it and the result stored once. The
+ * cost model compares the latency of the arms as selected: a branch costs 1 + the mean of the two arms + a
+ * misprediction penalty of 16 cycles taken half of the time (the condition is assumed unpredictable), the select
+ * both arms + 2.
+ *
+ * A switch puts its value in %eax and splits its sorted cases into clusters: the longest run of at least 4 cases
+ * filling at least 40% of its range becomes a jump table, any other case stands alone. A balanced tree of
+ * cmpl/jge on the first value of the middle cluster picks the cluster, keeping track of the bounds each path
+ * proves. Up to 8 single cases are then a chain of cmpl/je, a table a subl of its first value, a cmpl/ja to
+ * the default (an unsigned compare, so one check covers both ends, dropped when the tree already proved the
+ * bounds) and an indirect jmp through .rodata (see JumpTableInstruction). A dense switch is then a bounds check
+ * and one jump whatever its size, a sparse one log2(n) compares instead of n, and 1, 2, 3, 10, 11, 12, 13,
+ * 1000 a tree over two chains and a table. Each level of the tree mispredicts half the time on random values
+ * while the je of a chain rarely does, hence the long chains at its leaves.
+ *
+ * A call flushes the pending trees, pushes its stack arguments, moves the others into %edi, %esi, %edx, %ecx,
+ * %r8d and %r9d straight from their variables and stores %eax into its result afterwards (see emitCall). The
+ * parameters are moved out of the same registers at the entry, the register allocator can then give a parameter
+ * its incoming register and drop the move.
+ *
+ * New tiles are added to the tables in InstructionSelector.cpp, the tree building and the lowering loop don't
+ * know about any of them. Chains of -, ~, +1 and -1 are also matched against the rewrites generated by the
+ * superoptimizer (SuperoptTable.inc), which compete with the tiles on the same costs.
+ */
+class InstructionSelector {
+    public:
+        enum class TreeOp { CONST, VAR, NEG, NOT, ADD, SUB, MUL, DIV, MOD, AND, OR, XOR, SHL, SAR, LT, LE, GT, GE, EQ, NE };
+        /**
+         * @brief Cost of a tile, the latency (cycles) is compared first and then the size (bytes)
+         *
+         */
+        struct Cost {
+            int latency;
+            int size;
+        };
+        struct Tree {
+            TreeOp op;
+            std::string name;
+            int32_t value;
+            Tree* left;
+            Tree* right;
+            /**
+             * @brief Index of the cheapest tile computing the node into a register, -1 if none covers it
+             *
+             */
+            int tile;
+            Cost cost;
+            /**
+             * @brief Number of nodes on the longest path down to a leaf, a leaf is 1
+             *
+             */
+            int depth;
+        };
+        enum class BindingKind { REG, MEM, IMM };
+        /**
+         * @brief A subtree matched by a reg, mem or imm leaf of a pattern
+         *
+         */
+        struct Binding {
+            Tree* tree;
+            BindingKind kind;
+        };
+        /**
+         * @brief Emits the instructions of a tile. result is the register (or for store tiles the variable) the
+         * value ends up in, operands holds one operand per binding in the order of the pattern.
+         *
+         */
+        typedef void (*TileEmitter)(std::vector<InstructionNode*>& out, OperandNode* result, const std::vector<OperandNode*>& operands);
+        typedef Cost (*TileCost)(const std::vector<Binding>& bindings);
+        struct Tile {
+            const char* pattern;
+            TileCost cost;
+            TileEmitter emit;
+        };
+        enum class StepOp { NEG, NOT, INC, DEC, ADD };
+        struct RewriteStep {
+            StepOp op;
+            int32_t amount;
+        };
+        /**
+         * @brief A chain of unary operators (i.e "NEG(ADD(NOT(reg),1))") and the cheaper instruction sequence the
+         * superoptimizer found for it, the steps are applied in order to the register holding the reg leaf.
+         * The table lives in SuperoptTable.inc and is generated, see Superoptimizer.hpp.
+         *
+         */
+        struct Rewrite {
+            const char* pattern;
+            Cost cost;
+            std::vector<RewriteStep> steps;
+        };
+    private:
+        struct PatternNode {
+            enum Kind { OP, REG, MEM, IMM, DUP, DST, CONSTANT } kind;
+            TreeOp op;
+            int32_t value;
+            std::vector<PatternNode> children;
+        };
+        /**
+         * @brief Tiles computing a tree into a register
+         *
+         */
+        static const std::vector<Tile> registerTiles;
+        /**
+         * @brief Tiles storing a tree into the variable it is assigned to
+         *
+         */
+        static const std::vector<Tile> storeTiles;
+        static const std::vector<Rewrite> rewrites;
+        /**
+         * @brief Patterns of the register tiles followed by those of the rewrites, a tile index past the end of
+         * registerTiles is a rewrite
+         *
+         */
+        static const std::vector<PatternNode>& registerPatterns();
+        static const std::vector<PatternNode>& storePatterns();
+        /**
+         * @brief The register tiles whose pattern can match a node, indexed by the TreeOp of the node
+         *
+         */
+        static const std::vector<std::vector<int>>& tilesByOp();
+        static PatternNode parsePattern(const char*& text);
+
+        std::vector<std::unique_ptr<Tree>> trees;
+        std::unordered_map<std::string, int> uses;
+        std::unordered_map<std::string, int> definitions;
+        /**
+         * @brief Trees of the foldable temporaries waiting for the instruction reading them, in definition order
+         *
+         */
+        std::vector<std::pair<std::string, Tree*>> pending;
+        std::vector<InstructionNode*> out;
+        /**
+         * @brief Number of jumps to each TAC label of the function
+         *
+         */
+        std::unordered_map<std::string, int> labelReferences;
+        /**
+         * @brief Sum of the costs of the trees stored or returned so far, how the cost of an arm is measured
+         *
+         */
+        Cost emitted{0, 0};
+        /**
+         * @brief A run of consecutive cases of a switch (in value order), dispatched through one jump table or,
+         * for a single case, compared
+         *
+         */
+        struct CaseCluster {
+            size_t begin;
+            size_t end;
+            bool table;
+        };
+        /**
+         * @brief Numbers the labels of the compare trees and tables of the switches in the function
+         *
+         */
+        int switchLabels = 0;
+
+        static TreeOp treeOpOf(BinaryOperator op);
+        Tree* newTree(TreeOp op, Tree* left = nullptr, Tree* right = nullptr);
+        Tree* treeOf(TackyVal* val);
+        bool isPending(TackyVal* val);
+        bool isFoldable(TackyVal* dst);
+        static bool isLeaf(Tree* tree);
+        static bool reads(Tree* tree, const std::string& name);
+        static bool match(const PatternNode& pattern, Tree* tree, const std::string* dst, std::vector<Binding>& bindings);
+        static bool usable(const std::vector<Binding>& bindings);
+        /**
+         * @brief Finds the cheapest register tile of a node, its children are already labelled
+         *
+         */
+        static void label(Tree* tree, bool useRewrites = true);
+        Tree* treeOfPattern(const PatternNode& pattern, bool useRewrites);
+        std::vector<OperandNode*> emitBindings(const std::vector<Binding>& bindings, RegisterNode* result, RegisterNode* scratch);
+        /**
+         * @brief Emits the tree into result, the scratch register may be overwritten
+         *
+         */
+        void emitRegister(Tree* tree, RegisterNode* result, RegisterNode* scratch);
+        void emitStore(const std::string& dst, Tree* tree);
+        void emitReturn(Tree* tree);
+        /**
+         * @brief Emits the cmpl of a comparison tree with at most one non leaf child, which is computed into work
+         * (scratch may be overwritten). With keepR10 two variables are compared through work rather than leaving
+         * the legalizer to go through %r10d.
+         *
+         * @return ConditionCode the condition holding when the comparison is true
+         */
+        ConditionCode emitCompare(Tree* tree, RegisterNode* work, RegisterNode* scratch, bool keepR10);
+        void emitBranchIfZero(Tree* tree, const std::string& target);
+        /**
+         * @brief Builds the tree of a Unary, Binary or Copy and sets dst to the value it defines
+         *
+         */
+        Tree* treeOfInstruction(TackyInstruction* instr, TackyVal*& dst);
+        /**
+         * @brief Folds the tree into the pending ones if dst is a foldable temporary, stores it otherwise
+         *
+         */
+        void define(TackyVal* dst, Tree* tree);
+        /**
+         * @brief Checks that the instructions can run whatever the condition: Unary, Binary and Copy that can't
+         * trap (no division by a variable or by 0), every destination but the last one being a temporary only
+         * read there. result is set to the variable the last one defines.
+         *
+         */
+        bool isSpeculable(const std::vector<TackyInstruction*>& instructions, size_t begin, size_t end, std::string& result);
+        /**
+         * @brief If-converts the diamond or triangle starting at the JumpIfZero at index when the cost model says
+         * so, index is then moved to its last label. False (and nothing emitted) otherwise.
+         *
+         */
+        bool emitSelect(const std::vector<TackyInstruction*>& instructions, size_t& index, const std::string& function);
+        /**
+         * @brief Lowers a switch: its value goes into %eax, the cases are grouped into clusters and a balanced tree
+         * of cmpl/jge over the clusters leads to a jump table or to a short chain of cmpl/je
+         *
+         */
+        void emitSwitch(TackySwitch* dispatch, const std::string& function);
+        /**
+         * @brief Emits the dispatch of the value in %eax over clusters [first, last), knowing low <= value <= high
+         *
+         * @param cases the (value, label) of every case, sorted by value
+         * @param otherwise label of the default
+         */
+        void emitCaseTree(const std::vector<std::pair<int32_t, std::string>>& cases, const std::vector<CaseCluster>& clusters,
+            size_t first, size_t last, int64_t low, int64_t high, const std::string& otherwise, const std::string& function);
+        /**
+         * @brief Moves the incoming arguments into the variables of the parameters: %edi to %r9d for the first
+         * six, 16(%rbp), 24(%rbp)... for the others
+         *
+         */
+        void emitParameters(const std::vector<std::string>& params);
+        /**
+         * @brief Lowers a call following the System V ABI: the arguments past the sixth are pushed last first
+         * (after a pushq $0 when their number is odd, so %rsp stays 16 byte aligned), the first six are moved
+         * into their registers, and after the call the stack arguments are popped with addq and %eax is stored
+         * into the destination
+         *
+         */
+        void emitCall(TackyFunctionCall* call);
+        /**
+         * @brief Emits the pending trees reading the variable, before it is overwritten
+         *
+         */
+        void flushReaders(const std::string& name);
+        /**
+         * @brief Emits every pending tree, at the end of a basic block
+         *
+         */
+        void flushPending();
+    public:
+        static bool costLess(Cost a, Cost b);
+        static const std::vector<Rewrite>& getRewrites();
+        static void emitRewrite(std::vector<InstructionNode*>& out, RegisterNode* result, const std::vector<RewriteStep>& steps);
+        /**
+         * @brief Selects the instructions of a pattern made of operators, reg and constants, with the value of
+         * its reg leaf already in %eax. Used by the superoptimizer to know what the tables make of a chain.
+         *
+         * @param pattern
+         * @param useRewrites false to only use the hand written tiles
+         * @param cost set to the cost of the cover
+         * @return std::vector<InstructionNode*> computing the pattern in %eax (%r10d may be overwritten)
+         */
+        static std::vector<InstructionNode*> selectPattern(const std::string& pattern, bool useRewrites, Cost& cost);
+        /**
+         * @brief Lowers the body of a function, without the AllocateStack placeholder
+         *
+         * @param instructions
+         * @param function name of the function, its labels are qualified with it (see local_label)
+         * @param params variables of the parameters, loaded from the argument registers first
+         * @return std::vector<InstructionNode*>
+         */
+        std::vector<InstructionNode*> select(const std::vector<TackyInstruction*>& instructions, const std::string& function,
+            const std::vector<std::string>& params = {});
+};
+
+#endif // INSTRUCTIONSELECTOR_HPP
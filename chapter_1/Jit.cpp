@@ -0,0 +1,165 @@
+#include "Jit.hpp"
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "CodeFolding.hpp"
+#include "X86Encoder.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <elf.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// ======================================================
+//                     JitModule
+// ======================================================
+JitModule::JitModule(const std::vector<FunctionUnit>& units):memory(nullptr), mappedSize(0), codeSize(0){
+    std::vector<Image> functions;
+    std::unordered_map<std::string, std::string> aliases;
+    for(const FunctionUnit& unit: units){
+        if(unit.foldedInto.empty()){
+            functions.push_back(Image{unit.ast->getIdentifer(), &unit.code, &unit.readOnlyData, &unit.relocations});
+        }else{
+            aliases[unit.ast->getIdentifer()] = unit.foldedInto;
+        }
+    }
+    for(const FunctionUnit& unit: units){
+        for(const CodeRelocation& relocation: unit.relocations){
+            if(relocation.type == R_X86_64_PLT32){
+                bool defined = aliases.count(relocation.symbol) != 0 || std::any_of(functions.begin(), functions.end(),
+                    [&relocation](const Image& function){ return(function.name == relocation.symbol); });
+                if(!defined){
+                    throw std::runtime_error("Function " + unit.ast->getIdentifer() + " calls " + relocation.symbol
+                        + ", which the program doesn't define");
+                }
+            }else if(relocation.symbol != X86Encoder::READ_ONLY_SECTION || relocation.type != R_X86_64_PC32){
+                throw std::runtime_error("Function " + unit.ast->getIdentifer() + " refers to symbols the JIT doesn't link (-fprofile-generate?)");
+            }
+        }
+    }
+    load(functions, aliases);
+}
+
+JitModule::JitModule(const std::string& name, const std::vector<uint8_t>& code):memory(nullptr), mappedSize(0), codeSize(0){
+    load({Image{name, &code, nullptr, nullptr}});
+}
+
+void JitModule::load(const std::vector<Image>& functions, const std::unordered_map<std::string, std::string>& aliases){
+    // every function starts on 16 bytes like in the object files, then the tables on 4 bytes like in .rodata
+    for(const Image& function: functions){
+        this->codeSize = (this->codeSize + 15) / 16 * 16 + function.code->size();
+    }
+    size_t dataSize = this->codeSize;
+    for(const Image& function: functions){
+        if(function.readOnlyData != nullptr && !function.readOnlyData->empty()){
+            dataSize = (dataSize + 3) / 4 * 4 + function.readOnlyData->size();
+        }
+    }
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    this->mappedSize = (dataSize + pageSize - 1) / pageSize * pageSize;
+    if(this->mappedSize == 0){
+        return;
+    }
+    this->memory = mmap(nullptr, this->mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(this->memory == MAP_FAILED){
+        this->memory = nullptr;
+        throw std::runtime_error("Could not map memory for the JIT");
+    }
+    uint8_t* bytes = static_cast<uint8_t*>(this->memory);
+    size_t offset = 0;
+    std::vector<size_t> starts;
+    for(const Image& function: functions){
+        std::vector<uint8_t> padding = X86Encoder::padding((16 - offset % 16) % 16);
+        std::memcpy(bytes + offset, padding.data(), padding.size());
+        offset += padding.size();
+        this->offsets[function.name] = offset;
+        starts.push_back(offset);
+        std::memcpy(bytes + offset, function.code->data(), function.code->size());
+        offset += function.code->size();
+    }
+    for(const auto& alias: aliases){
+        this->offsets[alias.first] = this->offsets.at(alias.second);
+    }
+    for(size_t i = 0; i < functions.size(); i++){
+        const Image& function = functions[i];
+        size_t tables = offset;
+        if(function.readOnlyData != nullptr && !function.readOnlyData->empty()){
+            tables = (offset + 3) / 4 * 4;
+            std::memcpy(bytes + tables, function.readOnlyData->data(), function.readOnlyData->size());
+            offset = tables + function.readOnlyData->size();
+        }
+        if(function.relocations == nullptr){
+            continue;
+        }
+        // what the linker does with the R_X86_64_PC32 of each leaq (against the tables) and the R_X86_64_PLT32
+        // of each call (against the callee, loaded above): S + A - P
+        for(const CodeRelocation& relocation: *function.relocations){
+            size_t target = relocation.type == R_X86_64_PLT32 ? this->offsets.at(relocation.symbol) : tables;
+            int64_t value = static_cast<int64_t>(target) + relocation.addend - static_cast<int64_t>(starts[i] + relocation.offset);
+            uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(value));
+            for(int k = 0; k < 4; k++){
+                bytes[starts[i] + relocation.offset + k] = static_cast<uint8_t>(bits >> (8 * k));
+            }
+        }
+    }
+    if(mprotect(this->memory, this->mappedSize, PROT_READ | PROT_EXEC) != 0){
+        munmap(this->memory, this->mappedSize);
+        this->memory = nullptr;
+        throw std::runtime_error("Could not make the JIT code executable");
+    }
+}
+
+JitModule::~JitModule(){
+    if(this->memory != nullptr){
+        munmap(this->memory, this->mappedSize);
+    }
+}
+
+JitFunction JitModule::getFunction(const std::string& name) const{
+    auto found = this->offsets.find(name);
+    if(found == this->offsets.end()){
+        return(nullptr);
+    }
+    return(reinterpret_cast<JitFunction>(static_cast<uint8_t*>(this->memory) + found->second));
+}
+
+size_t JitModule::getCodeSize() const{
+    return(this->codeSize);
+}
+
+// ======================================================
+//                     JitCompiler
+// ======================================================
+JitCompiler::JitCompiler(std::string pipeline, unsigned threadCount):backend(threadCount){
+    this->passManager.setPipeline(PassManager::objectPipeline(pipeline));
+}
+
+std::unique_ptr<JitModule> JitCompiler::compile(const std::string& source){
+    Lexer lexer{};
+    lexer.tokenize(source);
+    Parser parser{lexer.getTokens()};
+    AST ast{parser.parseProgram()};
+    std::vector<PassStatistics> statistics;
+    std::vector<FunctionUnit> units = this->backend.runPipeline(&ast, this->passManager, statistics);
+    CodeFolder::fold(units);
+    return(std::unique_ptr<JitModule>{new JitModule{units}});
+}
+
+std::string JitCompiler::preprocess(const std::string& sourceFile){
+    std::string command = "gcc -E -P " + sourceFile;
+    FILE* pipe = popen(command.c_str(), "r");
+    if(pipe == nullptr){
+        throw std::runtime_error("Could not run: " + command);
+    }
+    std::string output;
+    char buffer[4096];
+    size_t count;
+    while((count = fread(buffer, 1, sizeof(buffer), pipe)) > 0){
+        output.append(buffer, count);
+    }
+    if(pclose(pipe) != 0){
+        throw std::runtime_error("Preprocessing failed: " + command);
+    }
+    return(output);
+}
@@ -0,0 +1,120 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "PassManager.hpp"
+#include "ParallelBackend.hpp"
+
+/**
+ * @brief An entry point taking no argument, like main. A function with parameters is called through a cast to
+ * int (*)(int, ...) with as many ints.
+ *
+ */
+typedef int (*JitFunction)(void);
+
+// ======================================================
+//                     JitModule
+// ======================================================
+/**
+ * @brief The machine code of a compiled program, loaded in memory and ready to be called.
+ *
+ * The code is copied into pages mapped read/write, which are then switched to read/execute before any
+ * function is handed out, so the pages are never writable and executable at the same time (W^X). The jump tables
+ * of the functions follow the code in the same pages, the leaq of each table is patched to point at it, and
+ * every call to the function it calls (which has to be in the module, the JIT links against nothing else).
+ * The pages are unmapped when the module is destroyed, the function pointers must not outlive it.
+ */
+class JitModule {
+    private:
+        void* memory;
+        size_t mappedSize;
+        size_t codeSize;
+        std::unordered_map<std::string, size_t> offsets;
+        /**
+         * @brief A function to load, its jump tables and the relocations against them (nullptr for raw code)
+         *
+         */
+        struct Image {
+            std::string name;
+            const std::vector<uint8_t>* code;
+            const std::vector<uint8_t>* readOnlyData;
+            const std::vector<CodeRelocation>* relocations;
+        };
+
+        /**
+         * @brief Copies the functions and patches their relocations
+         *
+         * @param functions
+         * @param aliases the folded functions, entry points of the function they were folded into
+         */
+        void load(const std::vector<Image>& functions, const std::unordered_map<std::string, std::string>& aliases = {});
+    public:
+        /**
+         * @brief Loads the code of the units (pipeline ending with encode) one after the other, a folded unit
+         * (see CodeFolding.hpp) gets the entry point of the function it was folded into
+         *
+         * @param units
+         */
+        explicit JitModule(const std::vector<FunctionUnit>& units);
+        /**
+         * @brief Loads a single function from raw machine code (i.e the loops of the superoptimizer benchmark)
+         *
+         * @param name
+         * @param code
+         */
+        JitModule(const std::string& name, const std::vector<uint8_t>& code);
+        ~JitModule();
+        JitModule(const JitModule&) = delete;
+        JitModule& operator=(const JitModule&) = delete;
+        /**
+         * @brief Get the entry point of a function
+         *
+         * @param name
+         * @return JitFunction nullptr if the program has no such function
+         */
+        JitFunction getFunction(const std::string& name) const;
+        size_t getCodeSize() const;
+};
+
+// ======================================================
+//                     JitCompiler
+// ======================================================
+/**
+ * @brief Embeddable in-memory compiler: source text in, callable functions out, no file is written.
+ *
+ *      JitCompiler jit{};
+ *      std::unique_ptr<JitModule> module = jit.compile("int main(void) { return ~-3; }");
+ *      int result = module->getFunction("main")();
+ *
+ * The source must already be preprocessed (see preprocess). Errors are reported with exceptions like
+ * in the rest of the compiler.
+ */
+class JitCompiler {
+    private:
+        PassManager passManager;
+        ParallelBackend backend;
+    public:
+        /**
+         * @brief Construct a new Jit Compiler object
+         *
+         * @param pipeline the pipeline up to emit (i.e PassManager::pipelineForLevel), emit is replaced with encode
+         * @param threadCount threads of the backend, 0 picks the number of hardware threads
+         */
+        explicit JitCompiler(std::string pipeline = PassManager::defaultPipeline(), unsigned threadCount = 1);
+        std::unique_ptr<JitModule> compile(const std::string& source);
+        /**
+         * @brief Runs the C preprocessor on a file and returns its output, without creating the .i file
+         *
+         * @param sourceFile
+         * @return std::string
+         */
+        static std::string preprocess(const std::string& sourceFile);
+};
+
+#endif // JIT_HPP
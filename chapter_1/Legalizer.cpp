@@ -0,0 +1,99 @@
+#include "Legalizer.hpp"
+#include "Optimizer.hpp"
+
+// ======================================================
+//                     Legalizer
+// ======================================================
+OperandNode* Legalizer::legalImmediate(OperandNode* op){
+    if(op->getType() != IMM){
+        return(op);
+    }
+    // the assembler rejects (or silently truncates) a 32 bit immediate written outside of the int range
+    std::string value = static_cast<ImmediateNode*>(op)->getImm();
+    std::string wrapped = std::to_string(TackySimplifier::wrapConstant(value));
+    if(wrapped == value){
+        return(op);
+    }
+    return(new ImmediateNode{wrapped});
+}
+
+void Legalizer::legalizeMove(MoveInstruction* mov, std::vector<InstructionNode*>& out, size_t& moves){
+    mov->setSrc(legalImmediate(mov->getSrc()));
+    if(!is_memory_operand(mov->getSrc()) || !is_memory_operand(mov->getDst())){
+        out.push_back(mov);
+        return;
+    }
+    if(operands_equal(mov->getSrc(), mov->getDst())){
+        // two variables sharing a slot, nothing to move
+        return;
+    }
+    RegisterNode* scratch = new RegisterNode{RegisterName::R10};
+    out.push_back(new MoveInstruction{mov->getSrc(), scratch});
+    mov->setSrc(scratch);
+    out.push_back(mov);
+    moves++;
+}
+
+void Legalizer::legalizeBinary(BinaryInstruction* binary, std::vector<InstructionNode*>& out, size_t& moves){
+    binary->setSrc(legalImmediate(binary->getSrc()));
+    if(is_memory_operand(binary->getSrc()) && is_memory_operand(binary->getDst())){
+        RegisterNode* scratch = new RegisterNode{RegisterName::R10};
+        out.push_back(new MoveInstruction{binary->getSrc(), scratch});
+        binary->setSrc(scratch);
+        moves++;
+    }
+    out.push_back(binary);
+}
+
+void Legalizer::legalizeCompare(CompareInstruction* compare, std::vector<InstructionNode*>& out, size_t& moves){
+    compare->setSrc(legalImmediate(compare->getSrc()));
+    if(is_memory_operand(compare->getSrc()) && is_memory_operand(compare->getDst())){
+        RegisterNode* scratch = new RegisterNode{RegisterName::R10};
+        out.push_back(new MoveInstruction{compare->getSrc(), scratch});
+        compare->setSrc(scratch);
+        moves++;
+    }
+    out.push_back(compare);
+}
+
+size_t Legalizer::legalize(IRFunctionNode* function){
+    std::vector<InstructionNode*> instructions = function->getInstructions();
+    std::vector<InstructionNode*> legal;
+    legal.reserve(instructions.size());
+    size_t moves = 0;
+    for(InstructionNode* instr: instructions){
+        switch(instr->getType()){
+            case MOV:
+                legalizeMove(static_cast<MoveInstruction*>(instr), legal, moves);
+                break;
+            case BINARY:
+                legalizeBinary(static_cast<BinaryInstruction*>(instr), legal, moves);
+                break;
+            case CMP:
+                legalizeCompare(static_cast<CompareInstruction*>(instr), legal, moves);
+                break;
+            case UNARY:
+            case LEA:
+            case CDQ:
+            case IDIV:
+            case MULHI:
+            case RET:
+            case ALLOCATE:
+            case PROFILE:
+            case JMP:
+            case JMPCC:
+            case JMPTABLE:
+            case LABEL:
+            case SETCC:
+            case MOVZX:
+            case CMOV:
+            case PUSH:
+            case CALL:
+            case DEALLOCATE:
+                legal.push_back(instr);
+                break;
+        }
+    }
+    function->setInstructions(legal);
+    return(moves);
+}
@@ -0,0 +1,41 @@
+#ifndef LEGALIZER_HPP
+#define LEGALIZER_HPP
+
+#include <cstddef>
+#include <vector>
+#include "Assembly.hpp"
+
+// ======================================================
+//                     Legalizer
+// ======================================================
+/**
+ * @brief Rewrites the instructions x86-64 cannot encode, once every operand has its final location (after
+ * regalloc and the slot assignment). Lowering picks its instructions as if any operand could be anywhere, so
+ * whether movl x, y needs a detour is only decided here, where we know if x and y both ended up in memory.
+ *
+ *      movl M1, M2              => movl M1, %r10d; movl %r10d, M2      (removed if M1 and M2 are the same slot)
+ *      op M1, M2                => movl M1, %r10d; op %r10d, M2        (cmpl too)
+ *      $imm out of 32 bits      => the same value wrapped to 32 bits
+ *
+ * imull into memory, a shift by a variable count and idivl $imm are never selected, IRVerifier::verifyLegal rejects
+ * them. Each rule adds at most one move. %r10d is free to use as the scratch register because the instruction selector
+ * never keeps a value in it across the store of a tree, which is where memory to memory forms come from.
+ * Constraints of new instructions go in the switch of legalize, one function per instruction type.
+ */
+class Legalizer {
+    private:
+        static OperandNode* legalImmediate(OperandNode* op);
+        static void legalizeMove(MoveInstruction* mov, std::vector<InstructionNode*>& out, size_t& moves);
+        static void legalizeBinary(BinaryInstruction* binary, std::vector<InstructionNode*>& out, size_t& moves);
+        static void legalizeCompare(CompareInstruction* compare, std::vector<InstructionNode*>& out, size_t& moves);
+    public:
+        /**
+         * @brief Makes every instruction of the function encodable
+         *
+         * @param function
+         * @return size_t number of scratch moves added
+         */
+        static size_t legalize(IRFunctionNode* function);
+};
+
+#endif // LEGALIZER_HPP
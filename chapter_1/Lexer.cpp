@@ -3,6 +3,7 @@
 #include <unordered_set>
 #include<iostream>
 #include<stdexcept>
+#include <algorithm>
 
 // #include "AST.hpp"
 
@@ -49,6 +50,30 @@ std::string Lexer::createSymbol(std::string::iterator& it, std::string::iterator
     }
     return(symbol);
 }
+// The operators, a longer spelling before its prefixes so that <<= isn't read as << then =
+static const std::vector<Lexer::OperatorSpelling> operatorSpellings = {
+    {"<<=", LEFT_SHIFT_ASSIGN}, {">>=", RIGHT_SHIFT_ASSIGN},
+    {"--", DECREMENT}, {"<<", LEFT_SHIFT}, {">>", RIGHT_SHIFT}, {"<=", LESS_EQUAL}, {">=", GREATER_EQUAL},
+    {"==", EQUAL}, {"!=", NOT_EQUAL}, {"&&", LOGICAL_AND}, {"||", LOGICAL_OR},
+    {"+=", PLUS_ASSIGN}, {"-=", HYPHEN_ASSIGN}, {"*=", ASTERISK_ASSIGN}, {"/=", SLASH_ASSIGN}, {"%=", PERCENT_ASSIGN},
+    {"&=", AMPERSAND_ASSIGN}, {"^=", CARET_ASSIGN}, {"|=", PIPE_ASSIGN},
+    {"-", HYPHEN}, {"=", ASSIGN}, {"+", PLUS}, {"*", ASTERISK}, {"/", SLASH}, {"%", PERCENT}, {"~", TILDE},
+    {"!", EXCLAMATION}, {"<", LESS}, {">", GREATER}, {"&", AMPERSAND}, {"^", CARET}, {"|", PIPE}, {"?", QUESTION},
+    {":", COLON}, {",", COMMA}
+};
+
+const Lexer::OperatorSpelling* Lexer::matchOperator(std::string::iterator it, std::string::iterator end){
+    for(const OperatorSpelling& op: operatorSpellings){
+        if(op.text[0] != *it || static_cast<size_t>(end - it) < op.text.size()){
+            continue;
+        }
+        if(std::equal(op.text.begin(), op.text.end(), it)){
+            return(&op);
+        }
+    }
+    return(nullptr);
+}
+
 bool Lexer::isKeyword(std::string symbol){
     if(keywords.find(symbol) == keywords.end()){
         return(false);
@@ -81,18 +106,10 @@ void Lexer::tokenize(std::string str){
             Token t(";",SEMICOLON);
             tokens.push_back(t);
             it++;
-        }else if(*it == '-' && *lexerPeek(it,1)!='-'){
-            Token t("-",HYPHEN);
-            tokens.push_back(t);
-            it++;
-        }else if(*it == '-' && *lexerPeek(it,1)=='-'){
-            Token t("--",DECREMENT);
+        }else if(const OperatorSpelling* op = matchOperator(it, str.end())){
+            Token t(op->text, op->type);
             tokens.push_back(t);
-            it+=2;
-        }else if(*it == '~'){
-            Token t("~",TILDE);
-            tokens.push_back(t);
-            it++;
+            it += op->text.size();
         }else if(isDigit(*it)){
             //Expecting an valid number followed by a whitespace. (123L* is not valid L=[A-Z+a-z+_])
             Token t(createSymbol(it, str.end(),CONSTANTS),CONSTANTS);
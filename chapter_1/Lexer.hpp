@@ -14,8 +14,17 @@
     symbol: A string within the source code
 */
 class Lexer{
+    public:
+        /*
+            The text of an operator and the token it is read as
+        */
+        struct OperatorSpelling {
+            std::string text;
+            TokenType type;
+        };
+    private:
     std::vector<Token> tokens;
-    std::unordered_set<std::string> keywords={"int","return","void"};
+    std::unordered_set<std::string> keywords={"int","return","void","if","else","switch","case","default","break","static"};
     private:
         /*
             Checks if the current character is a whitespace
@@ -62,6 +71,13 @@ class Lexer{
             @return An iterator pos away from the current iterator.
         */
         std::string::iterator lexerPeek(std::string::iterator& it,int pos);
+        /*
+            Finds the operator starting at the current character, the longest one when several match (<<= over << and <)
+            @param it iterator of the current character
+            @param end An iterator pointing to the space after the end of the string representing the file.
+            @return The matching operator, nullptr if the character doesn't start one
+        */
+        const OperatorSpelling* matchOperator(std::string::iterator it, std::string::iterator end);
     public:
         /**
          * @brief Converte a string into a file, Intended to be used after opening the source file and converting the file into a string object.
@@ -0,0 +1,178 @@
+#include "Liveness.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+// ======================================================
+//                     PseudoLiveness
+// ======================================================
+PseudoLiveness::PseudoLiveness(const std::vector<InstructionNode*>& instructions){
+    // the operand table, numbering the Pseudos as they first appear
+    std::unordered_map<std::string, int> indexOf;
+    this->firstOperand.assign(instructions.size() + 1, 0);
+    this->readCount.assign(instructions.size(), 0);
+    std::vector<OperandNode*> reads, writes;
+    for(size_t i = 0; i < instructions.size(); i++){
+        reads.clear();
+        writes.clear();
+        instruction_operands(instructions[i], reads, writes);
+        this->firstOperand[i] = this->operandIndices.size();
+        this->readCount[i] = reads.size();
+        reads.insert(reads.end(), writes.begin(), writes.end());
+        for(OperandNode* op: reads){
+            int index = -1;
+            if(op->getType() == PSEUDO){
+                const std::string& name = static_cast<Pseudo*>(op)->getIdentifier();
+                auto inserted = indexOf.emplace(name, static_cast<int>(indexOf.size()));
+                if(inserted.second){
+                    this->names.push_back(name);
+                }
+                index = inserted.first->second;
+            }
+            this->operandIndices.push_back(index);
+        }
+    }
+    this->firstOperand[instructions.size()] = this->operandIndices.size();
+
+    // blocks, and the block of every label
+    std::unordered_map<std::string, uint32_t> blockOfLabel;
+    bool startsBlock = true;
+    for(size_t i = 0; i < instructions.size(); i++){
+        InstructionType type = instructions[i]->getType();
+        if(startsBlock || type == LABEL){
+            if(!this->blocks.empty()){
+                this->blocks.back().end = i;
+            }
+            this->blocks.push_back(Block{i, instructions.size()});
+        }
+        if(type == LABEL){
+            blockOfLabel[static_cast<LabelInstruction*>(instructions[i])->getName()] = static_cast<uint32_t>(this->blocks.size() - 1);
+        }
+        startsBlock = type == JMP || type == JMPCC || type == JMPTABLE || type == RET;
+    }
+    auto targetOf = [&blockOfLabel](const std::string& label){
+        auto found = blockOfLabel.find(label);
+        if(found == blockOfLabel.end()){
+            throw std::runtime_error("jump to undefined label " + label);
+        }
+        return(found->second);
+    };
+    uint32_t count = static_cast<uint32_t>(this->blocks.size());
+    bool backward = false;
+    for(uint32_t b = 0; b < count; b++){
+        this->successorStart.push_back(static_cast<uint32_t>(this->successorList.size()));
+        InstructionNode* last = instructions[this->blocks[b].end - 1];
+        if(last->getType() == JMP){
+            this->successorList.push_back(targetOf(static_cast<JumpInstruction*>(last)->getTarget()));
+        }else if(last->getType() == JMPTABLE){
+            // every entry of the table, and the default the bounds check jumps to is one of its labels or the base
+            JumpTableInstruction* dispatch = static_cast<JumpTableInstruction*>(last);
+            size_t first = this->successorList.size();
+            this->successorList.push_back(targetOf(dispatch->getBase()));
+            for(const std::string& target: dispatch->getTargets()){
+                this->successorList.push_back(targetOf(target));
+            }
+            std::sort(this->successorList.begin() + first, this->successorList.end());
+            this->successorList.erase(std::unique(this->successorList.begin() + first, this->successorList.end()), this->successorList.end());
+        }else if(last->getType() != RET){
+            if(b + 1 < count){
+                this->successorList.push_back(b + 1);
+            }
+            if(last->getType() == JMPCC){
+                this->successorList.push_back(targetOf(static_cast<ConditionalJumpInstruction*>(last)->getTarget()));
+            }
+        }
+        for(uint32_t k = this->successorStart[b]; k < this->successorList.size(); k++){
+            backward = backward || this->successorList[k] <= b;
+        }
+    }
+    this->successorStart.push_back(static_cast<uint32_t>(this->successorList.size()));
+
+    // backward dataflow. The live sets only grow, so a set changed iff its size did.
+    this->liveIn.assign(count, std::vector<int>());
+    this->liveOut.assign(count, std::vector<int>());
+    std::vector<int> positionInLive(this->names.size(), -1);
+    std::vector<int> live;
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(uint32_t b = count; b-- > 0;){
+            live.clear();
+            for(uint32_t k = this->successorStart[b]; k < this->successorStart[b + 1]; k++){
+                for(int pseudo: this->liveIn[this->successorList[k]]){
+                    if(positionInLive[pseudo] < 0){
+                        positionInLive[pseudo] = static_cast<int>(live.size());
+                        live.push_back(pseudo);
+                    }
+                }
+            }
+            this->liveOut[b] = live;
+            for(size_t i = this->blocks[b].end; i-- > this->blocks[b].begin;){
+                for(size_t k = this->firstOperand[i] + this->readCount[i]; k < this->firstOperand[i + 1]; k++){
+                    int written = this->operandIndices[k];
+                    if(written >= 0 && positionInLive[written] >= 0){
+                        int moved = live.back();
+                        live[positionInLive[written]] = moved;
+                        positionInLive[moved] = positionInLive[written];
+                        live.pop_back();
+                        positionInLive[written] = -1;
+                    }
+                }
+                for(size_t k = this->firstOperand[i]; k < this->firstOperand[i] + this->readCount[i]; k++){
+                    int read = this->operandIndices[k];
+                    if(read >= 0 && positionInLive[read] < 0){
+                        positionInLive[read] = static_cast<int>(live.size());
+                        live.push_back(read);
+                    }
+                }
+            }
+            if(live.size() != this->liveIn[b].size()){
+                this->liveIn[b] = live;
+                changed = backward;
+            }
+            for(int pseudo: live){
+                positionInLive[pseudo] = -1;
+            }
+        }
+    }
+}
+
+int PseudoLiveness::count() const{
+    return(static_cast<int>(this->names.size()));
+}
+
+const std::string& PseudoLiveness::getName(int pseudo) const{
+    return(this->names[pseudo]);
+}
+
+size_t PseudoLiveness::blockCount() const{
+    return(this->blocks.size());
+}
+
+const PseudoLiveness::Block& PseudoLiveness::getBlock(size_t block) const{
+    return(this->blocks[block]);
+}
+
+size_t PseudoLiveness::operandBegin(size_t instruction) const{
+    return(this->firstOperand[instruction]);
+}
+
+size_t PseudoLiveness::operandEnd(size_t instruction) const{
+    return(this->firstOperand[instruction + 1]);
+}
+
+size_t PseudoLiveness::reads(size_t instruction) const{
+    return(this->readCount[instruction]);
+}
+
+int PseudoLiveness::operand(size_t k) const{
+    return(this->operandIndices[k]);
+}
+
+const std::vector<int>& PseudoLiveness::getLiveIn(size_t block) const{
+    return(this->liveIn[block]);
+}
+
+const std::vector<int>& PseudoLiveness::getLiveOut(size_t block) const{
+    return(this->liveOut[block]);
+}
@@ -0,0 +1,79 @@
+#ifndef LIVENESS_HPP
+#define LIVENESS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Assembly.hpp"
+
+// ======================================================
+//                     PseudoLiveness
+// ======================================================
+/**
+ * @brief Which Pseudos of a function in the assembly tree are live at the ends of its basic blocks.
+ *
+ * A block starts at the first instruction, at every label and after every jmp, jcc and ret, like the blocks of
+ * ControlFlowGraph but on the lowered code. The Pseudos are numbered in the order they first appear, and the
+ * operands of every instruction (reads first, then writes, as instruction_operands lists them) are kept as those
+ * numbers, -1 for anything that isn't a Pseudo, so a name is only hashed once.
+ *
+ * The live sets are found with the usual backward dataflow: the blocks are walked from last to first, the live
+ * out set of a block being the union of the live in sets of its successors. When every jump goes forward (the only
+ * kind the language produces) that single walk is exact, otherwise it is repeated until nothing changes.
+ */
+class PseudoLiveness {
+    public:
+        struct Block {
+            size_t begin;
+            size_t end;
+        };
+    private:
+        std::vector<Block> blocks;
+        std::vector<uint32_t> successorStart;
+        std::vector<uint32_t> successorList;
+        std::vector<std::string> names;
+        std::vector<int> operandIndices;
+        std::vector<size_t> firstOperand;
+        std::vector<size_t> readCount;
+        std::vector<std::vector<int>> liveIn;
+        std::vector<std::vector<int>> liveOut;
+    public:
+        /**
+         * @brief Numbers the Pseudos, splits the instructions into blocks and computes the live sets. Throws if a
+         * jump targets a label the function doesn't have.
+         *
+         * @param instructions
+         */
+        explicit PseudoLiveness(const std::vector<InstructionNode*>& instructions);
+        /**
+         * @brief Number of distinct Pseudos
+         *
+         * @return int
+         */
+        int count() const;
+        const std::string& getName(int pseudo) const;
+        size_t blockCount() const;
+        const Block& getBlock(size_t block) const;
+        /**
+         * @brief The Pseudo numbers of the operands of instruction i are operand(k) for k in
+         * [operandBegin(i), operandEnd(i)), the reads being the first readCount(i) of them
+         *
+         */
+        size_t operandBegin(size_t instruction) const;
+        size_t operandEnd(size_t instruction) const;
+        size_t reads(size_t instruction) const;
+        int operand(size_t k) const;
+        /**
+         * @brief The Pseudos live when the block is entered, in no particular order
+         *
+         */
+        const std::vector<int>& getLiveIn(size_t block) const;
+        /**
+         * @brief The Pseudos live when the block is left, in no particular order
+         *
+         */
+        const std::vector<int>& getLiveOut(size_t block) const;
+};
+
+#endif // LIVENESS_HPP
@@ -0,0 +1,1258 @@
+#include "Optimizer.hpp"
+#include "ControlFlowGraph.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+// Helper returning the identifier of a TackyVariable
+static bool variableName(TackyVal* val, std::string& name){
+    if(TackyVariable* var = dynamic_cast<TackyVariable*>(val)){
+        name = var->getVariableIdentifier();
+        return(true);
+    }
+    return(false);
+}
+
+// Helper appending the values an instruction reads to reads and returning the one it writes (nullptr if none)
+static TackyVal* tacky_operands(TackyInstruction* instr, std::vector<TackyVal*>& reads){
+    if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instr)){
+        reads.push_back(unary->getSrc());
+        return(unary->getDst());
+    }else if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instr)){
+        reads.push_back(copy->getSrc());
+        return(copy->getDst());
+    }else if(TackyBinary* binary = dynamic_cast<TackyBinary*>(instr)){
+        reads.push_back(binary->getSrc1());
+        reads.push_back(binary->getSrc2());
+        return(binary->getDst());
+    }else if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+        reads.push_back(ret->getVar());
+    }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+        reads.push_back(branch->getCondition());
+    }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+        reads.push_back(dispatch->getValue());
+    }else if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+        reads.insert(reads.end(), call->getArgs().begin(), call->getArgs().end());
+        return(call->getDst());
+    }
+    return(nullptr);
+}
+
+// Helper returning one past the largest N of the tmp.N the instructions use
+static int next_temporary(const std::vector<TackyInstruction*>& instructions){
+    int next = 0;
+    std::vector<TackyVal*> operands;
+    std::string name;
+    for(TackyInstruction* instr: instructions){
+        operands.clear();
+        TackyVal* dst = tacky_operands(instr, operands);
+        if(dst != nullptr){
+            operands.push_back(dst);
+        }
+        for(TackyVal* val: operands){
+            if(variableName(val, name) && TackySimplifier::isTemporary(name)){
+                next = std::max(next, std::atoi(name.c_str() + 4) + 1);
+            }
+        }
+    }
+    return(next);
+}
+
+static TackyConstant* makeConstant(uint32_t value){
+    return(new TackyConstant{std::to_string(static_cast<int32_t>(value))});
+}
+
+// ======================================================
+//                     TackySimplifier
+// ======================================================
+int32_t TackySimplifier::wrapConstant(std::string value){
+    bool negative = false;
+    size_t i = 0;
+    if(!value.empty() && value[0] == '-'){
+        negative = true;
+        i++;
+    }
+    uint32_t result = 0;
+    for(; i < value.size(); i++){
+        if(value[i] < '0' || value[i] > '9'){
+            throw std::runtime_error("Invalid constant: " + value);
+        }
+        result = result * 10u + static_cast<uint32_t>(value[i] - '0');
+    }
+    if(negative){
+        result = 0u - result;
+    }
+    return(static_cast<int32_t>(result));
+}
+
+bool TackySimplifier::isTemporary(const std::string& name){
+    return(name.compare(0, 4, "tmp.") == 0);
+}
+
+TackySimplifier::AffineForm TackySimplifier::formOf(TackyVal* val){
+    if(TackyConstant* constant = dynamic_cast<TackyConstant*>(val)){
+        return(AffineForm{true, 1, nullptr, static_cast<uint32_t>(wrapConstant(constant->getValue()))});
+    }
+    std::string name;
+    if(variableName(val, name)){
+        auto found = this->forms.find(name);
+        if(found != this->forms.end()){
+            return(found->second);
+        }
+    }
+    return(AffineForm{false, 1, val, 0u});
+}
+
+TackySimplifier::AffineForm TackySimplifier::applyUnary(UnaryOperator op, AffineForm form){
+    switch(op){
+        case UnaryOperator::Negation:
+            form.sign = -form.sign;
+            form.offset = 0u - form.offset;
+            break;
+        case UnaryOperator::Complement:
+            // ~v == -v - 1
+            form.sign = -form.sign;
+            form.offset = ~form.offset;
+            break;
+        case UnaryOperator::Increment:
+            form.offset += 1u;
+            break;
+        case UnaryOperator::Decrement:
+            form.offset -= 1u;
+            break;
+        default:
+            throw std::runtime_error("Cannot simplify unknown unary operator");
+    }
+    if(form.isConstant){
+        // the sign only applies to the base, a constant is entirely held in the offset
+        form.sign = 1;
+    }
+    return(form);
+}
+
+// Helper folding a binary operator over two constants, false when the result is undefined
+static bool fold_binary(BinaryOperator op, uint32_t a, uint32_t b, uint32_t& result){
+    switch(op){
+        case BinaryOperator::Add: result = a + b; return(true);
+        case BinaryOperator::Subtract: result = a - b; return(true);
+        case BinaryOperator::Multiply: result = a * b; return(true);
+        case BinaryOperator::Divide:
+        case BinaryOperator::Remainder: {
+            if(b == 0u || (a == 0x80000000u && b == 0xFFFFFFFFu)){
+                return(false);
+            }
+            int32_t x = static_cast<int32_t>(a), y = static_cast<int32_t>(b);
+            result = static_cast<uint32_t>(op == BinaryOperator::Divide ? x / y : x % y);
+            return(true);
+        }
+        case BinaryOperator::BitwiseAnd: result = a & b; return(true);
+        case BinaryOperator::BitwiseOr: result = a | b; return(true);
+        case BinaryOperator::BitwiseXor: result = a ^ b; return(true);
+        // counts outside 0-31 are undefined in C, they are taken modulo 32 like sall/sarl/shrl do
+        case BinaryOperator::LeftShift: result = a << (b & 31u); return(true);
+        case BinaryOperator::RightShift: result = static_cast<uint32_t>(static_cast<int32_t>(a) >> (b & 31u)); return(true);
+        case BinaryOperator::LogicalRightShift: result = a >> (b & 31u); return(true);
+        case BinaryOperator::LessThan: result = static_cast<int32_t>(a) < static_cast<int32_t>(b); return(true);
+        case BinaryOperator::LessOrEqual: result = static_cast<int32_t>(a) <= static_cast<int32_t>(b); return(true);
+        case BinaryOperator::GreaterThan: result = static_cast<int32_t>(a) > static_cast<int32_t>(b); return(true);
+        case BinaryOperator::GreaterOrEqual: result = static_cast<int32_t>(a) >= static_cast<int32_t>(b); return(true);
+        case BinaryOperator::Equal: result = a == b; return(true);
+        case BinaryOperator::NotEqual: result = a != b; return(true);
+        default:
+            return(false);
+    }
+}
+
+bool TackySimplifier::simplifyBinary(BinaryOperator op, AffineForm left, AffineForm right, AffineForm& form){
+    uint32_t value = 0u;
+    if(left.isConstant && right.isConstant){
+        if(!fold_binary(op, left.offset, right.offset, value)){
+            return(false);
+        }
+        form = AffineForm{true, 1, nullptr, value};
+        return(true);
+    }
+    if(op == BinaryOperator::Add && (left.isConstant || right.isConstant)){
+        // x + c and c + x only move the offset of x
+        form = left.isConstant ? right : left;
+        form.offset += left.isConstant ? left.offset : right.offset;
+        return(true);
+    }
+    if(op == BinaryOperator::Subtract && right.isConstant){
+        form = left;
+        form.offset -= right.offset;
+        return(true);
+    }
+    if(op == BinaryOperator::Subtract && left.isConstant){
+        form = applyUnary(UnaryOperator::Negation, right);
+        form.offset += left.offset;
+        return(true);
+    }
+    bool commutative = op == BinaryOperator::Multiply || op == BinaryOperator::BitwiseAnd
+        || op == BinaryOperator::BitwiseOr || op == BinaryOperator::BitwiseXor;
+    if(!right.isConstant && !(commutative && left.isConstant)){
+        return(false);
+    }
+    AffineForm x = right.isConstant ? left : right;
+    uint32_t c = right.isConstant ? right.offset : left.offset;
+    AffineForm zero{true, 1, nullptr, 0u};
+    switch(op){
+        case BinaryOperator::Multiply:
+        case BinaryOperator::Divide:
+            if(op == BinaryOperator::Multiply && c == 0u){
+                form = zero;
+            }else if(c == 1u){
+                form = x;
+            }else if(c == 0xFFFFFFFFu){
+                form = applyUnary(UnaryOperator::Negation, x);
+            }else{
+                return(false);
+            }
+            return(true);
+        case BinaryOperator::Remainder:
+            if(c != 1u && c != 0xFFFFFFFFu){
+                return(false);
+            }
+            form = zero;
+            return(true);
+        case BinaryOperator::BitwiseAnd:
+            // x & 0 is 0, x & -1 is x
+            if(c != 0u && c != 0xFFFFFFFFu){
+                return(false);
+            }
+            form = c == 0u ? zero : x;
+            return(true);
+        case BinaryOperator::BitwiseOr:
+            if(c != 0u && c != 0xFFFFFFFFu){
+                return(false);
+            }
+            form = c == 0u ? x : AffineForm{true, 1, nullptr, 0xFFFFFFFFu};
+            return(true);
+        case BinaryOperator::BitwiseXor:
+            // x ^ -1 is ~x, which is an affine form too
+            if(c != 0u && c != 0xFFFFFFFFu){
+                return(false);
+            }
+            form = c == 0u ? x : applyUnary(UnaryOperator::Complement, x);
+            return(true);
+        case BinaryOperator::LeftShift:
+        case BinaryOperator::RightShift:
+        case BinaryOperator::LogicalRightShift:
+            if((c & 31u) != 0u){
+                return(false);
+            }
+            form = x;
+            return(true);
+        default:
+            return(false);
+    }
+}
+
+void TackySimplifier::materialize(AffineForm form, TackyVal* dst, std::vector<TackyInstruction*>& out){
+    if(form.isConstant){
+        out.push_back(new TackyCopy{makeConstant(form.offset), dst});
+    }else if(form.sign == 1 && form.offset == 0u){
+        out.push_back(new TackyCopy{form.base, dst});
+    }else if(form.sign == 1){
+        out.push_back(new TackyBinary{BinaryOperator::Add, form.base, makeConstant(form.offset), dst});
+    }else if(form.offset == 0u){
+        out.push_back(new TackyUnary{UnaryOperator::Negation, form.base, dst});
+    }else if(form.offset == 0xFFFFFFFFu){
+        out.push_back(new TackyUnary{UnaryOperator::Complement, form.base, dst});
+    }else{
+        out.push_back(new TackyUnary{UnaryOperator::Negation, form.base, dst});
+        out.push_back(new TackyBinary{BinaryOperator::Add, dst, makeConstant(form.offset), dst});
+    }
+}
+
+TackyVal* TackySimplifier::substitute(TackyVal* val){
+    std::string name;
+    if(!variableName(val, name)){
+        return(val);
+    }
+    auto found = this->forms.find(name);
+    if(found == this->forms.end()){
+        return(val);
+    }
+    AffineForm form = found->second;
+    if(form.isConstant){
+        return(makeConstant(form.offset));
+    }
+    if(form.sign == 1 && form.offset == 0u){
+        return(form.base);
+    }
+    return(val);
+}
+
+void TackySimplifier::recordForm(TackyVal* dst, AffineForm form){
+    std::string name;
+    if(!variableName(dst, name) || !isTemporary(name)){
+        return;
+    }
+    this->forms[name] = form;
+    std::string baseName;
+    if(!form.isConstant && variableName(form.base, baseName)){
+        this->dependents[baseName].push_back(name);
+    }
+}
+
+void TackySimplifier::invalidate(TackyVal* dst){
+    std::string name;
+    if(!variableName(dst, name)){
+        return;
+    }
+    this->forms.erase(name);
+    auto found = this->dependents.find(name);
+    if(found == this->dependents.end()){
+        return;
+    }
+    for(const std::string& dependent: found->second){
+        this->forms.erase(dependent);
+    }
+    this->dependents.erase(found);
+}
+
+std::vector<TackyInstruction*> remove_dead_temporaries(std::vector<TackyInstruction*> instructions){
+    std::unordered_set<std::string> used;
+    std::vector<TackyInstruction*> kept;
+    auto markUsed = [&used](TackyVal* val){
+        std::string name;
+        if(variableName(val, name)){
+            used.insert(name);
+        }
+    };
+    auto isDead = [&used](TackyVal* dst){
+        std::string name;
+        return(variableName(dst, name) && TackySimplifier::isTemporary(name) && used.find(name) == used.end());
+    };
+    for(auto it = instructions.rbegin(); it != instructions.rend(); it++){
+        TackyInstruction* instr = *it;
+        if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instr)){
+            if(isDead(unary->getDst())){
+                continue;
+            }
+            markUsed(unary->getSrc());
+        }else if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instr)){
+            if(isDead(copy->getDst())){
+                continue;
+            }
+            markUsed(copy->getSrc());
+        }else if(TackyBinary* binary = dynamic_cast<TackyBinary*>(instr)){
+            if(isDead(binary->getDst())){
+                continue;
+            }
+            markUsed(binary->getSrc1());
+            markUsed(binary->getSrc2());
+        }else if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+            markUsed(ret->getVar());
+        }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+            markUsed(branch->getCondition());
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+            markUsed(dispatch->getValue());
+        }else if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+            // the callee may have side effects, the call stays even when its result is unused
+            for(TackyVal* arg: call->getArgs()){
+                markUsed(arg);
+            }
+        }
+        kept.push_back(instr);
+    }
+    return(std::vector<TackyInstruction*>(kept.rbegin(), kept.rend()));
+}
+
+void TackySimplifier::simplifyFunction(TackyFunction* function){
+    this->forms.clear();
+    this->dependents.clear();
+    std::vector<TackyInstruction*> simplified;
+    for(TackyInstruction* instr: function->getBody()){
+        if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instr)){
+            AffineForm form = applyUnary(unary->getUnaryOperator(), formOf(unary->getSrc()));
+            invalidate(unary->getDst());
+            materialize(form, unary->getDst(), simplified);
+            recordForm(unary->getDst(), form);
+        }else if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instr)){
+            AffineForm form = formOf(copy->getSrc());
+            invalidate(copy->getDst());
+            simplified.push_back(new TackyCopy{substitute(copy->getSrc()), copy->getDst()});
+            recordForm(copy->getDst(), form);
+        }else if(TackyBinary* binary = dynamic_cast<TackyBinary*>(instr)){
+            AffineForm form;
+            if(simplifyBinary(binary->getBinaryOperator(), formOf(binary->getSrc1()), formOf(binary->getSrc2()), form)){
+                invalidate(binary->getDst());
+                materialize(form, binary->getDst(), simplified);
+                recordForm(binary->getDst(), form);
+            }else{
+                TackyVal* src1 = substitute(binary->getSrc1());
+                TackyVal* src2 = substitute(binary->getSrc2());
+                invalidate(binary->getDst());
+                simplified.push_back(new TackyBinary{binary->getBinaryOperator(), src1, src2, binary->getDst()});
+            }
+        }else if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+            simplified.push_back(new TackyReturn{substitute(ret->getVar())});
+        }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+            simplified.push_back(new TackyJumpIfZero{substitute(branch->getCondition()), branch->getTarget()});
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+            simplified.push_back(new TackySwitch{substitute(dispatch->getValue()), dispatch->getCases(), dispatch->getDefault()});
+        }else if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+            std::vector<TackyVal*> args;
+            for(TackyVal* arg: call->getArgs()){
+                args.push_back(substitute(arg));
+            }
+            invalidate(call->getDst());
+            simplified.push_back(new TackyFunctionCall{call->getName(), args, call->getDst()});
+        }else{
+            if(dynamic_cast<TackyLabel*>(instr) != nullptr){
+                // other paths join here, what is known on the one falling through may not hold on them.
+                // Swapping with empty maps is linear in what they hold, clear() would also scan every bucket
+                std::unordered_map<std::string, AffineForm>().swap(this->forms);
+                std::unordered_map<std::string, std::vector<std::string>>().swap(this->dependents);
+            }
+            simplified.push_back(instr);
+        }
+    }
+    function->setBody(remove_dead_temporaries(simplified));
+}
+
+void TackySimplifier::simplifyProgram(TackyProgram* program){
+    for(TackyFunction* f: program->getFunctions()){
+        simplifyFunction(f);
+    }
+}
+
+// ======================================================
+//                     TackyCopyPropagator
+// ======================================================
+TackyVal* TackyCopyPropagator::substitute(TackyVal* val){
+    std::string name;
+    if(!variableName(val, name)){
+        return(val);
+    }
+    auto found = this->copies.find(name);
+    if(found == this->copies.end()){
+        return(val);
+    }
+    return(found->second);
+}
+
+void TackyCopyPropagator::invalidate(TackyVal* dst){
+    std::string name;
+    if(!variableName(dst, name)){
+        return;
+    }
+    this->copies.erase(name);
+    auto found = this->dependents.find(name);
+    if(found == this->dependents.end()){
+        return;
+    }
+    for(const std::string& dependent: found->second){
+        auto copy = this->copies.find(dependent);
+        std::string source;
+        if(copy != this->copies.end() && variableName(copy->second, source) && source == name){
+            this->copies.erase(copy);
+        }
+    }
+    this->dependents.erase(found);
+}
+
+void TackyCopyPropagator::propagateFunction(TackyFunction* function){
+    this->copies.clear();
+    this->dependents.clear();
+    std::vector<TackyInstruction*> propagated;
+    for(TackyInstruction* instr: function->getBody()){
+        if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instr)){
+            TackyVal* src = substitute(copy->getSrc());
+            invalidate(copy->getDst());
+            propagated.push_back(new TackyCopy{src, copy->getDst()});
+            std::string dstName, srcName;
+            variableName(copy->getDst(), dstName);
+            if(variableName(src, srcName)){
+                if(srcName == dstName){
+                    continue;
+                }
+                this->dependents[srcName].push_back(dstName);
+            }
+            this->copies[dstName] = src;
+        }else if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instr)){
+            TackyVal* src = substitute(unary->getSrc());
+            invalidate(unary->getDst());
+            propagated.push_back(new TackyUnary{unary->getUnaryOperator(), src, unary->getDst()});
+        }else if(TackyBinary* binary = dynamic_cast<TackyBinary*>(instr)){
+            TackyVal* src1 = substitute(binary->getSrc1());
+            TackyVal* src2 = substitute(binary->getSrc2());
+            invalidate(binary->getDst());
+            propagated.push_back(new TackyBinary{binary->getBinaryOperator(), src1, src2, binary->getDst()});
+        }else if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+            propagated.push_back(new TackyReturn{substitute(ret->getVar())});
+        }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+            propagated.push_back(new TackyJumpIfZero{substitute(branch->getCondition()), branch->getTarget()});
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+            propagated.push_back(new TackySwitch{substitute(dispatch->getValue()), dispatch->getCases(), dispatch->getDefault()});
+        }else if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+            std::vector<TackyVal*> args;
+            for(TackyVal* arg: call->getArgs()){
+                args.push_back(substitute(arg));
+            }
+            invalidate(call->getDst());
+            propagated.push_back(new TackyFunctionCall{call->getName(), args, call->getDst()});
+        }else{
+            if(dynamic_cast<TackyLabel*>(instr) != nullptr){
+                // a join point, the copies made on the path falling through may not have been made on the others
+                std::unordered_map<std::string, TackyVal*>().swap(this->copies);
+                std::unordered_map<std::string, std::vector<std::string>>().swap(this->dependents);
+            }
+            propagated.push_back(instr);
+        }
+    }
+    function->setBody(remove_dead_temporaries(propagated));
+}
+
+// ======================================================
+//                     TackyCfgSimplifier
+// ======================================================
+size_t TackyCfgSimplifier::simplifyFunction(TackyFunction* function){
+    size_t removed = 0;
+    // branches on a constant always or never jump, a switch on a constant always goes to the same label
+    std::vector<TackyInstruction*> folded;
+    for(TackyInstruction* instr: function->getBody()){
+        if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+            if(TackyConstant* value = dynamic_cast<TackyConstant*>(dispatch->getValue())){
+                instr = new TackyJump{dispatch->targetOf(TackySimplifier::wrapConstant(value->getValue()))};
+            }
+        }
+        TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr);
+        TackyConstant* constant = branch == nullptr ? nullptr : dynamic_cast<TackyConstant*>(branch->getCondition());
+        if(constant == nullptr){
+            folded.push_back(instr);
+        }else if(TackySimplifier::wrapConstant(constant->getValue()) == 0){
+            folded.push_back(new TackyJump{branch->getTarget()});
+        }else{
+            removed++;
+        }
+    }
+
+    // blocks no path from the entry reaches
+    ControlFlowGraph cfg{folded};
+    std::vector<char> reachable = cfg.reachable();
+    std::vector<TackyInstruction*> live;
+    live.reserve(folded.size());
+    for(size_t b = 0; b < cfg.size(); b++){
+        const ControlFlowGraph::Block& block = cfg.getBlock(b);
+        if(reachable[b]){
+            live.insert(live.end(), folded.begin() + block.begin, folded.begin() + block.end);
+        }else{
+            removed += block.end - block.begin;
+        }
+    }
+
+    // jumps to a label right after them (only labels in between). A JumpIfZero going there too has nothing
+    // left to decide, its condition is dropped with the dead temporaries.
+    std::vector<TackyInstruction*> straightened;
+    straightened.reserve(live.size());
+    std::unordered_set<std::string> targets;
+    for(size_t i = 0; i < live.size(); i++){
+        std::string target;
+        if(TackyJump* jump = dynamic_cast<TackyJump*>(live[i])){
+            target = jump->getTarget();
+        }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(live[i])){
+            target = branch->getTarget();
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(live[i])){
+            // always kept, a table dispatch jumping to the next block costs no more than falling through
+            targets.insert(dispatch->getDefault());
+            for(const std::pair<int32_t, std::string>& c: dispatch->getCases()){
+                targets.insert(c.second);
+            }
+            straightened.push_back(live[i]);
+            continue;
+        }else{
+            straightened.push_back(live[i]);
+            continue;
+        }
+        bool next = false;
+        for(size_t j = i + 1; j < live.size() && !next; j++){
+            TackyLabel* label = dynamic_cast<TackyLabel*>(live[j]);
+            if(label == nullptr){
+                break;
+            }
+            next = label->getIdentifier() == target;
+        }
+        if(next){
+            removed++;
+            continue;
+        }
+        targets.insert(target);
+        straightened.push_back(live[i]);
+    }
+
+    // labels nothing jumps to anymore, the blocks around them merge
+    std::vector<TackyInstruction*> body;
+    body.reserve(straightened.size());
+    for(TackyInstruction* instr: straightened){
+        TackyLabel* label = dynamic_cast<TackyLabel*>(instr);
+        if(label != nullptr && targets.find(label->getIdentifier()) == targets.end()){
+            removed++;
+            continue;
+        }
+        body.push_back(instr);
+    }
+    function->setBody(remove_dead_temporaries(body));
+    return(removed);
+}
+
+// ======================================================
+//                     TackyPromoter
+// ======================================================
+size_t TackyPromoter::promoteFunction(TackyFunction* function){
+    std::vector<TackyInstruction*> body = function->getBody();
+
+    // number the locals, find the first temporary number the generator didn't use, and keep the local of every
+    // operand (reads first, then the write, -1 for anything else) so a name is only hashed once
+    std::unordered_map<std::string, int> localOf;
+    int nextTemporary = 0;
+    std::vector<int> operandLocal;
+    std::vector<size_t> firstOperand(body.size() + 1, 0);
+    std::vector<char> writes(body.size(), 0);
+    std::vector<TackyVal*> operands;
+    std::string name;
+    for(size_t i = 0; i < body.size(); i++){
+        firstOperand[i] = operandLocal.size();
+        operands.clear();
+        TackyVal* dst = tacky_operands(body[i], operands);
+        if(dst != nullptr){
+            operands.push_back(dst);
+            writes[i] = 1;
+        }
+        for(TackyVal* val: operands){
+            int local = -1;
+            if(variableName(val, name)){
+                if(TackySimplifier::isTemporary(name)){
+                    nextTemporary = std::max(nextTemporary, std::atoi(name.c_str() + 4) + 1);
+                }else{
+                    auto found = localOf.find(name);
+                    if(found == localOf.end()){
+                        found = localOf.emplace(name, static_cast<int>(localOf.size())).first;
+                    }
+                    local = found->second;
+                }
+            }
+            operandLocal.push_back(local);
+        }
+    }
+    firstOperand[body.size()] = operandLocal.size();
+    if(localOf.empty()){
+        return(0);
+    }
+    auto newTemporary = [&nextTemporary](){
+        return(new TackyVariable{"tmp." + std::to_string(nextTemporary++)});
+    };
+
+    ControlFlowGraph cfg{body};
+    size_t blockCount = cfg.size();
+    size_t localCount = localOf.size();
+    std::vector<uint32_t> idom = cfg.immediateDominators();
+
+    // the blocks writing each local, and whether a local is read before being written in some block
+    std::vector<std::vector<uint32_t>> writers(localCount);
+    std::vector<char> crossesBlocks(localCount, 0);
+    std::vector<uint32_t> writtenIn(localCount, ControlFlowGraph::UNREACHABLE);
+    for(uint32_t b = 0; b < blockCount; b++){
+        if(idom[b] == ControlFlowGraph::UNREACHABLE){
+            continue;
+        }
+        const ControlFlowGraph::Block& block = cfg.getBlock(b);
+        for(size_t i = block.begin; i < block.end; i++){
+            size_t write = firstOperand[i + 1] - writes[i];
+            for(size_t k = firstOperand[i]; k < write; k++){
+                int local = operandLocal[k];
+                if(local >= 0 && writtenIn[local] != b){
+                    crossesBlocks[local] = 1;
+                }
+            }
+            int local = writes[i] ? operandLocal[write] : -1;
+            if(local >= 0 && writtenIn[local] != b){
+                writtenIn[local] = b;
+                writers[local].push_back(b);
+            }
+        }
+    }
+
+    // dominance frontiers: a join block is in the frontier of its predecessors and of their dominators up to
+    // (not including) its own immediate dominator
+    std::vector<std::vector<uint32_t>> frontier(blockCount);
+    for(uint32_t b = 0; b < blockCount; b++){
+        if(idom[b] == ControlFlowGraph::UNREACHABLE || cfg.predecessors(b).size() < 2){
+            continue;
+        }
+        for(uint32_t predecessor: cfg.predecessors(b)){
+            for(uint32_t runner = predecessor; idom[runner] != ControlFlowGraph::UNREACHABLE && runner != idom[b]; runner = idom[runner]){
+                if(!frontier[runner].empty() && frontier[runner].back() == b){
+                    break;
+                }
+                frontier[runner].push_back(b);
+            }
+        }
+    }
+
+    // phis at the iterated dominance frontier of the writers
+    std::vector<std::vector<Phi>> phis(blockCount);
+    std::vector<int> hasPhi(blockCount, -1);
+    std::vector<int> queued(blockCount, -1);
+    std::vector<uint32_t> worklist;
+    for(size_t local = 0; local < localCount; local++){
+        if(!crossesBlocks[local]){
+            continue;
+        }
+        worklist = writers[local];
+        for(uint32_t b: worklist){
+            queued[b] = static_cast<int>(local);
+        }
+        while(!worklist.empty()){
+            uint32_t b = worklist.back();
+            worklist.pop_back();
+            for(uint32_t join: frontier[b]){
+                if(hasPhi[join] == static_cast<int>(local)){
+                    continue;
+                }
+                hasPhi[join] = static_cast<int>(local);
+                phis[join].push_back(Phi{static_cast<int>(local), newTemporary(), std::vector<TackyVal*>(cfg.predecessors(join).size(), nullptr)});
+                if(queued[join] != static_cast<int>(local)){
+                    queued[join] = static_cast<int>(local);
+                    worklist.push_back(join);
+                }
+            }
+        }
+    }
+
+    // the dominator tree, children grouped by parent with a counting sort
+    std::vector<uint32_t> childStart(blockCount + 1, 0);
+    for(uint32_t b = 0; b < blockCount; b++){
+        if(idom[b] != ControlFlowGraph::UNREACHABLE && idom[b] != b){
+            childStart[idom[b] + 1]++;
+        }
+    }
+    for(size_t b = 0; b < blockCount; b++){
+        childStart[b + 1] += childStart[b];
+    }
+    std::vector<uint32_t> children(childStart[blockCount]);
+    std::vector<uint32_t> next(childStart.begin(), childStart.end() - 1);
+    for(uint32_t b = 0; b < blockCount; b++){
+        if(idom[b] != ControlFlowGraph::UNREACHABLE && idom[b] != b){
+            children[next[idom[b]]++] = b;
+        }
+    }
+
+    // renaming, depth first over the dominator tree. Every value pushed is logged so that leaving a block pops
+    // exactly what it pushed.
+    std::vector<std::vector<TackyVal*>> values(localCount);
+    std::vector<int> pushed;
+    std::vector<std::vector<TackyInstruction*>> rewritten(blockCount);
+    auto push = [&values, &pushed](int local, TackyVal* val){
+        values[local].push_back(val);
+        pushed.push_back(local);
+    };
+    auto rename = [&](TackyVal* val, size_t k) -> TackyVal* {
+        int local = operandLocal[k];
+        if(local < 0){
+            return(val);
+        }
+        return(values[local].empty() ? new TackyConstant{"0"} : values[local].back());
+    };
+    auto define = [&](TackyVal* dst, size_t k) -> TackyVal* {
+        int local = operandLocal[k];
+        if(local < 0){
+            return(dst);
+        }
+        TackyVariable* temporary = newTemporary();
+        push(local, temporary);
+        return(temporary);
+    };
+    // (block, next child to visit, size of the log when the block was entered)
+    struct Frame {
+        uint32_t block;
+        uint32_t child;
+        size_t mark;
+    };
+    // a parameter holds the argument until it is first written, any other local starts out as 0
+    for(const std::string& param: function->getParams()){
+        auto found = localOf.find(param);
+        if(found != localOf.end()){
+            push(found->second, new TackyVariable{param});
+        }
+    }
+    std::vector<Frame> stack;
+    stack.push_back(Frame{0, childStart[0], 0});
+    bool entering = true;
+    while(!stack.empty()){
+        Frame& top = stack.back();
+        uint32_t b = top.block;
+        if(entering){
+            top.mark = pushed.size();
+            for(const Phi& phi: phis[b]){
+                push(phi.local, phi.result);
+            }
+            const ControlFlowGraph::Block& block = cfg.getBlock(b);
+            std::vector<TackyInstruction*>& out = rewritten[b];
+            for(size_t i = block.begin; i < block.end; i++){
+                TackyInstruction* instr = body[i];
+                size_t k = firstOperand[i];
+                if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instr)){
+                    TackyVal* src = rename(unary->getSrc(), k);
+                    out.push_back(new TackyUnary{unary->getUnaryOperator(), src, define(unary->getDst(), k + 1)});
+                }else if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instr)){
+                    TackyVal* src = rename(copy->getSrc(), k);
+                    if(operandLocal[k + 1] >= 0){
+                        push(operandLocal[k + 1], src);
+                    }else{
+                        out.push_back(new TackyCopy{src, copy->getDst()});
+                    }
+                }else if(TackyBinary* binary = dynamic_cast<TackyBinary*>(instr)){
+                    TackyVal* src1 = rename(binary->getSrc1(), k);
+                    TackyVal* src2 = rename(binary->getSrc2(), k + 1);
+                    out.push_back(new TackyBinary{binary->getBinaryOperator(), src1, src2, define(binary->getDst(), k + 2)});
+                }else if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+                    out.push_back(new TackyReturn{rename(ret->getVar(), k)});
+                }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+                    out.push_back(new TackyJumpIfZero{rename(branch->getCondition(), k), branch->getTarget()});
+                }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+                    out.push_back(new TackySwitch{rename(dispatch->getValue(), k), dispatch->getCases(), dispatch->getDefault()});
+                }else if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+                    std::vector<TackyVal*> args;
+                    for(TackyVal* arg: call->getArgs()){
+                        args.push_back(rename(arg, k++));
+                    }
+                    out.push_back(new TackyFunctionCall{call->getName(), args, define(call->getDst(), k)});
+                }else{
+                    out.push_back(instr);
+                }
+            }
+            // what the successors' phis receive along the edge from this block
+            for(uint32_t successor: cfg.successors(b)){
+                if(phis[successor].empty()){
+                    continue;
+                }
+                ControlFlowGraph::Edges predecessors = cfg.predecessors(successor);
+                size_t edge = static_cast<size_t>(std::find(predecessors.begin(), predecessors.end(), b) - predecessors.begin());
+                for(Phi& phi: phis[successor]){
+                    phi.inputs[edge] = values[phi.local].empty() ? nullptr : values[phi.local].back();
+                }
+            }
+            entering = false;
+        }
+        if(top.child < childStart[b + 1]){
+            uint32_t child = children[top.child++];
+            stack.push_back(Frame{child, childStart[child], 0});
+            entering = true;
+            continue;
+        }
+        while(pushed.size() > top.mark){
+            values[pushed.back()].pop_back();
+            pushed.pop_back();
+        }
+        stack.pop_back();
+    }
+
+    // phis whose inputs are all the same value (or unknown) are that value, in reverse postorder so that a phi
+    // reading another one sees what it became
+    std::unordered_map<std::string, TackyVal*> replacement;
+    auto resolve = [&replacement](TackyVal* val){
+        std::string name;
+        while(val != nullptr && variableName(val, name)){
+            auto found = replacement.find(name);
+            if(found == replacement.end()){
+                break;
+            }
+            val = found->second;
+        }
+        return(val);
+    };
+    auto sameValue = [](TackyVal* a, TackyVal* b){
+        std::string first, second;
+        if(variableName(a, first)){
+            return(variableName(b, second) && first == second);
+        }
+        TackyConstant* constantA = dynamic_cast<TackyConstant*>(a);
+        TackyConstant* constantB = dynamic_cast<TackyConstant*>(b);
+        return(constantA != nullptr && constantB != nullptr
+            && TackySimplifier::wrapConstant(constantA->getValue()) == TackySimplifier::wrapConstant(constantB->getValue()));
+    };
+    for(uint32_t b: cfg.reversePostorder()){
+        for(Phi& phi: phis[b]){
+            TackyVal* unique = nullptr;
+            bool trivial = true;
+            for(TackyVal*& input: phi.inputs){
+                input = resolve(input);
+                if(input == nullptr || sameValue(input, phi.result)){
+                    continue;
+                }
+                if(unique == nullptr){
+                    unique = input;
+                }else if(!sameValue(unique, input)){
+                    trivial = false;
+                }
+            }
+            if(trivial){
+                replacement[phi.result->getVariableIdentifier()] = unique == nullptr ? new TackyConstant{"0"} : unique;
+                phi.result = nullptr;
+            }
+        }
+    }
+
+    // the reachable blocks in their original order, with the phi copies before the jump ending each predecessor
+    auto substitute = [&](TackyInstruction* instr) -> TackyInstruction* {
+        if(replacement.empty()){
+            return(instr);
+        }
+        if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instr)){
+            TackyVal* src = resolve(unary->getSrc());
+            return(src == unary->getSrc() ? instr : new TackyUnary{unary->getUnaryOperator(), src, unary->getDst()});
+        }else if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instr)){
+            TackyVal* src = resolve(copy->getSrc());
+            return(src == copy->getSrc() ? instr : new TackyCopy{src, copy->getDst()});
+        }else if(TackyBinary* binary = dynamic_cast<TackyBinary*>(instr)){
+            TackyVal* src1 = resolve(binary->getSrc1());
+            TackyVal* src2 = resolve(binary->getSrc2());
+            if(src1 == binary->getSrc1() && src2 == binary->getSrc2()){
+                return(instr);
+            }
+            return(new TackyBinary{binary->getBinaryOperator(), src1, src2, binary->getDst()});
+        }else if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+            TackyVal* val = resolve(ret->getVar());
+            return(val == ret->getVar() ? instr : new TackyReturn{val});
+        }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+            TackyVal* condition = resolve(branch->getCondition());
+            return(condition == branch->getCondition() ? instr : new TackyJumpIfZero{condition, branch->getTarget()});
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+            TackyVal* val = resolve(dispatch->getValue());
+            return(val == dispatch->getValue() ? instr : new TackySwitch{val, dispatch->getCases(), dispatch->getDefault()});
+        }else if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+            std::vector<TackyVal*> args;
+            bool changed = false;
+            for(TackyVal* arg: call->getArgs()){
+                args.push_back(resolve(arg));
+                changed = changed || args.back() != arg;
+            }
+            return(changed ? new TackyFunctionCall{call->getName(), args, call->getDst()} : instr);
+        }
+        return(instr);
+    };
+    std::vector<TackyInstruction*> promoted;
+    promoted.reserve(body.size());
+    for(uint32_t b = 0; b < blockCount; b++){
+        if(idom[b] == ControlFlowGraph::UNREACHABLE){
+            continue;
+        }
+        std::vector<TackyInstruction*>& instructions = rewritten[b];
+        size_t end = instructions.size();
+        if(end > 0 && (dynamic_cast<TackyJump*>(instructions[end - 1]) != nullptr
+            || dynamic_cast<TackyJumpIfZero*>(instructions[end - 1]) != nullptr
+            || dynamic_cast<TackySwitch*>(instructions[end - 1]) != nullptr)){
+            end--;
+        }
+        for(size_t i = 0; i < end; i++){
+            promoted.push_back(substitute(instructions[i]));
+        }
+        for(uint32_t successor: cfg.successors(b)){
+            ControlFlowGraph::Edges predecessors = cfg.predecessors(successor);
+            size_t edge = static_cast<size_t>(std::find(predecessors.begin(), predecessors.end(), b) - predecessors.begin());
+            for(const Phi& phi: phis[successor]){
+                if(phi.result != nullptr){
+                    TackyVal* input = phi.inputs[edge];
+                    promoted.push_back(new TackyCopy{input == nullptr ? new TackyConstant{"0"} : input, phi.result});
+                }
+            }
+        }
+        for(size_t i = end; i < instructions.size(); i++){
+            promoted.push_back(substitute(instructions[i]));
+        }
+    }
+    function->setBody(remove_dead_temporaries(promoted));
+    return(localCount);
+}
+
+// ======================================================
+//                     Call graph
+// ======================================================
+// Helper returning, for every function, the functions of the program it calls (once per call). indexOf is filled
+// with the position of each function
+static std::vector<std::vector<size_t>> call_graph(const std::vector<TackyFunction*>& functions,
+    std::unordered_map<std::string, size_t>& indexOf){
+    for(size_t f = 0; f < functions.size(); f++){
+        indexOf.emplace(functions[f]->getIdentifier(), f);
+    }
+    std::vector<std::vector<size_t>> callees(functions.size());
+    for(size_t f = 0; f < functions.size(); f++){
+        for(TackyInstruction* instr: functions[f]->getBody()){
+            if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+                auto found = indexOf.find(call->getName());
+                if(found != indexOf.end()){
+                    callees[f].push_back(found->second);
+                }
+            }
+        }
+    }
+    return(callees);
+}
+
+// Helper returning the functions in post-order of the call graph, each after the functions it calls except along a
+// cycle. The stack is explicit since a chain of calls can be as long as the program
+static std::vector<size_t> post_order(const std::vector<std::vector<size_t>>& callees){
+    std::vector<size_t> order;
+    order.reserve(callees.size());
+    std::vector<bool> visited(callees.size(), false);
+    std::vector<std::pair<size_t, size_t>> stack;
+    for(size_t root = 0; root < callees.size(); root++){
+        if(visited[root]){
+            continue;
+        }
+        visited[root] = true;
+        stack.emplace_back(root, 0);
+        while(!stack.empty()){
+            std::pair<size_t, size_t>& top = stack.back();
+            if(top.second < callees[top.first].size()){
+                size_t callee = callees[top.first][top.second++];
+                if(!visited[callee]){
+                    visited[callee] = true;
+                    stack.emplace_back(callee, 0);
+                }
+                continue;
+            }
+            order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    return(order);
+}
+
+// ======================================================
+//                     TackyInliner
+// ======================================================
+bool TackyInliner::isLeaf(TackyFunction* function){
+    for(TackyInstruction* instr: function->getBody()){
+        if(dynamic_cast<TackyFunctionCall*>(instr) != nullptr){
+            return(false);
+        }
+    }
+    return(true);
+}
+
+void TackyInliner::inlineCall(TackyFunctionCall* call, TackyFunction* callee, size_t site, int& nextTemporary,
+    std::vector<TackyInstruction*>& out){
+    std::vector<TackyInstruction*> body = callee->getBody();
+    const std::vector<std::string>& params = callee->getParams();
+    const std::string suffix = ".i" + std::to_string(site);
+
+    std::unordered_set<std::string> written;
+    std::vector<TackyVal*> operands;
+    std::string name;
+    for(TackyInstruction* instr: body){
+        operands.clear();
+        if(variableName(tacky_operands(instr, operands), name)){
+            written.insert(name);
+        }
+    }
+    // variable of the callee => value in the copy
+    std::unordered_map<std::string, TackyVal*> values;
+    for(size_t k = 0; k < params.size(); k++){
+        if(written.find(params[k]) == written.end()){
+            values.emplace(params[k], call->getArgs()[k]);
+        }else{
+            TackyVariable* param = new TackyVariable{params[k] + suffix};
+            values.emplace(params[k], param);
+            out.push_back(new TackyCopy{call->getArgs()[k], param});
+        }
+    }
+    const int base = nextTemporary;
+    nextTemporary += next_temporary(body);
+    auto rename = [&values, &suffix, base](TackyVal* val) -> TackyVal* {
+        std::string name;
+        if(!variableName(val, name)){
+            return(val);
+        }
+        auto found = values.find(name);
+        if(found == values.end()){
+            std::string renamed = TackySimplifier::isTemporary(name) ? "tmp." + std::to_string(base + std::atoi(name.c_str() + 4)) : name + suffix;
+            found = values.emplace(name, new TackyVariable{renamed}).first;
+        }
+        return(found->second);
+    };
+
+    const std::string end = "inline_end" + suffix;
+    bool jumpsToEnd = false;
+    for(size_t i = 0; i < body.size(); i++){
+        TackyInstruction* instr = body[i];
+        if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+            out.push_back(new TackyCopy{rename(ret->getVar()), call->getDst()});
+            if(i + 1 < body.size()){
+                out.push_back(new TackyJump{end});
+                jumpsToEnd = true;
+            }
+        }else if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instr)){
+            out.push_back(new TackyUnary{unary->getUnaryOperator(), rename(unary->getSrc()), rename(unary->getDst())});
+        }else if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instr)){
+            out.push_back(new TackyCopy{rename(copy->getSrc()), rename(copy->getDst())});
+        }else if(TackyBinary* binary = dynamic_cast<TackyBinary*>(instr)){
+            out.push_back(new TackyBinary{binary->getBinaryOperator(), rename(binary->getSrc1()), rename(binary->getSrc2()), rename(binary->getDst())});
+        }else if(TackyLabel* label = dynamic_cast<TackyLabel*>(instr)){
+            out.push_back(new TackyLabel{label->getIdentifier() + suffix});
+        }else if(TackyJump* jump = dynamic_cast<TackyJump*>(instr)){
+            out.push_back(new TackyJump{jump->getTarget() + suffix});
+        }else if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+            out.push_back(new TackyJumpIfZero{rename(branch->getCondition()), branch->getTarget() + suffix});
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+            std::vector<std::pair<int32_t, std::string>> cases = dispatch->getCases();
+            for(std::pair<int32_t, std::string>& entry: cases){
+                entry.second += suffix;
+            }
+            out.push_back(new TackySwitch{rename(dispatch->getValue()), cases, dispatch->getDefault() + suffix});
+        }else{
+            throw std::runtime_error("Can't inline an instruction of " + callee->getIdentifier());
+        }
+    }
+    if(jumpsToEnd){
+        out.push_back(new TackyLabel{end});
+    }
+}
+
+size_t TackyInliner::inlineProgram(const std::vector<TackyFunction*>& functions){
+    std::unordered_map<std::string, size_t> indexOf;
+    std::vector<std::vector<size_t>> callees = call_graph(functions, indexOf);
+    std::vector<size_t> order = post_order(callees);
+
+    // set once a function is done, a callee still on the stack is part of a cycle and so never a leaf
+    std::vector<bool> inlinable(functions.size(), false);
+    size_t inlined = 0;
+    for(size_t f: order){
+        std::vector<TackyInstruction*> body = functions[f]->getBody();
+        std::vector<TackyInstruction*> rewritten;
+        int nextTemporary = -1;
+        size_t sites = 0;
+        for(TackyInstruction* instr: body){
+            if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+                auto found = indexOf.find(call->getName());
+                if(found != indexOf.end() && inlinable[found->second]){
+                    if(nextTemporary < 0){
+                        nextTemporary = next_temporary(body);
+                    }
+                    inlineCall(call, functions[found->second], sites++, nextTemporary, rewritten);
+                    continue;
+                }
+            }
+            rewritten.push_back(instr);
+        }
+        if(sites > 0){
+            functions[f]->setBody(rewritten);
+            inlined += sites;
+        }
+        inlinable[f] = rewritten.size() <= INLINE_BUDGET && isLeaf(functions[f]);
+    }
+    return(inlined);
+}
+
+// ======================================================
+//                     TackyInterprocedural
+// ======================================================
+bool TackyInterprocedural::returnedConstant(TackyFunction* function, int32_t& value){
+    bool found = false;
+    for(TackyInstruction* instr: function->getBody()){
+        if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+            TackyConstant* constant = dynamic_cast<TackyConstant*>(ret->getVar());
+            if(constant == nullptr){
+                return(false);
+            }
+            int32_t returned = TackySimplifier::wrapConstant(constant->getValue());
+            if(found && returned != value){
+                return(false);
+            }
+            value = returned;
+            found = true;
+        }
+    }
+    return(found);
+}
+
+size_t TackyInterprocedural::propagateReturns(const std::vector<TackyFunction*>& functions){
+    std::unordered_map<std::string, size_t> indexOf;
+    std::vector<std::vector<size_t>> callees = call_graph(functions, indexOf);
+    std::vector<size_t> order = post_order(callees);
+
+    // set once a function is done, a callee still on the stack is part of a cycle and stays unknown and impure
+    std::vector<bool> done(functions.size(), false);
+    std::vector<bool> pure(functions.size(), false);
+    std::vector<TackyConstant*> returned(functions.size(), nullptr);
+    size_t replaced = 0;
+    for(size_t f: order){
+        std::vector<TackyInstruction*> body = functions[f]->getBody();
+        std::vector<TackyInstruction*> rewritten;
+        int nextTemporary = -1;
+        size_t calls = 0;
+        for(TackyInstruction* instr: body){
+            TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr);
+            if(call == nullptr){
+                rewritten.push_back(instr);
+                continue;
+            }
+            auto found = indexOf.find(call->getName());
+            if(found == indexOf.end() || !done[found->second] || returned[found->second] == nullptr){
+                rewritten.push_back(instr);
+                continue;
+            }
+            size_t callee = found->second;
+            if(!pure[callee]){
+                // the call stays for what it does, its value is known
+                if(nextTemporary < 0){
+                    nextTemporary = next_temporary(body);
+                }
+                TackyVariable* ignored = new TackyVariable{"tmp." + std::to_string(nextTemporary++)};
+                rewritten.push_back(new TackyFunctionCall{call->getName(), call->getArgs(), ignored});
+            }
+            rewritten.push_back(new TackyCopy{returned[callee], call->getDst()});
+            calls++;
+        }
+        if(calls > 0){
+            functions[f]->setBody(rewritten);
+            TackySimplifier simplifier{};
+            simplifier.simplifyFunction(functions[f]);
+            TackyCopyPropagator propagator{};
+            propagator.propagateFunction(functions[f]);
+            TackyCfgSimplifier::simplifyFunction(functions[f]);
+            replaced += calls;
+        }
+
+        bool isPure = true;
+        for(TackyInstruction* instr: functions[f]->getBody()){
+            if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+                auto found = indexOf.find(call->getName());
+                isPure = isPure && found != indexOf.end() && done[found->second] && pure[found->second];
+            }
+        }
+        int32_t value = 0;
+        if(returnedConstant(functions[f], value)){
+            returned[f] = makeConstant(static_cast<uint32_t>(value));
+        }
+        pure[f] = isPure;
+        done[f] = true;
+    }
+    return(replaced);
+}
+
+std::vector<bool> TackyInterprocedural::liveFunctions(const std::vector<TackyFunction*>& functions, const std::vector<bool>& visible){
+    std::unordered_map<std::string, size_t> indexOf;
+    std::vector<std::vector<size_t>> callees = call_graph(functions, indexOf);
+    std::vector<bool> live(functions.size(), false);
+    std::vector<size_t> worklist;
+    for(size_t f = 0; f < functions.size(); f++){
+        if(visible[f]){
+            live[f] = true;
+            worklist.push_back(f);
+        }
+    }
+    while(!worklist.empty()){
+        size_t f = worklist.back();
+        worklist.pop_back();
+        for(size_t callee: callees[f]){
+            if(!live[callee]){
+                live[callee] = true;
+                worklist.push_back(callee);
+            }
+        }
+    }
+    return(live);
+}
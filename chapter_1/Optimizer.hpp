@@ -0,0 +1,287 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "Tacky.hpp"
+
+// ======================================================
+//                     TackySimplifier
+// ======================================================
+/**
+ * @brief Algebraic simplification of unary operator chains in the TAC.
+ *
+ * Any chain of -, ~ applied to a single value x can be written as sign*x + k (mod 2^32):
+ *      -(sign*x + k) = (-sign)*x + (-k)
+ *      ~(sign*x + k) = (-sign)*x + (-k - 1)
+ * so -(-x) and ~~x cancel out, -~x becomes x + 1 and ~-x becomes x - 1. When x is a constant
+ * the whole chain folds to a constant. All the arithmetic is done on uint32_t so the folded
+ * value wraps around exactly like the 32 bit int the generated code operates on (-(-2147483648) == -2147483648).
+ *
+ * Adding or subtracting a constant only moves k, and c - x is -x + c. *, / and % fold when both operands are
+ * constant, except for a division by 0 or of INT_MIN by -1 which are left to trap at run time like with gcc -O0.
+ * x * 1 and x / 1 are x, x * -1 and x / -1 are -x, x * 0, x % 1 and x % -1 are 0. The bitwise operators fold
+ * too, with x & -1, x | 0, x ^ 0 and shifts by a multiple of 32 giving x, x & 0 giving 0, x | -1 giving -1 and
+ * x ^ -1 giving ~x. Shift counts are taken modulo 32, as the shift instructions do. A comparison of two constants
+ * folds to 0 or 1.
+ *
+ * The forms are known along straight line code and forgotten at every label, where other paths join in.
+ * After rewriting, the temporaries that are no longer read are removed.
+ */
+class TackySimplifier {
+    private:
+        /**
+         * @brief The value of a temporary expressed as sign*base + offset.
+         * If isConstant is true base is unused and the value is offset.
+         *
+         */
+        struct AffineForm {
+            bool isConstant;
+            int sign;
+            TackyVal* base;
+            uint32_t offset;
+        };
+        /**
+         * @brief Known form of every temporary defined so far in the current function
+         *
+         */
+        std::unordered_map<std::string, AffineForm> forms;
+        /**
+         * @brief The temporaries whose form reads a given variable. Used to forget the forms
+         * when that variable is written to.
+         *
+         */
+        std::unordered_map<std::string, std::vector<std::string>> dependents;
+
+        AffineForm formOf(TackyVal* val);
+        AffineForm applyUnary(UnaryOperator op, AffineForm form);
+        /**
+         * @brief The form of left op right, false if it isn't affine in a single value or can't be folded
+         *
+         */
+        bool simplifyBinary(BinaryOperator op, AffineForm left, AffineForm right, AffineForm& form);
+        /**
+         * @brief Emit the cheapest TAC computing the form into dst.
+         *
+         */
+        void materialize(AffineForm form, TackyVal* dst, std::vector<TackyInstruction*>& out);
+        /**
+         * @brief Replace a read of a temporary by the constant or the variable it is equal to.
+         *
+         */
+        TackyVal* substitute(TackyVal* val);
+        void recordForm(TackyVal* dst, AffineForm form);
+        void invalidate(TackyVal* dst);
+    public:
+        /**
+         * @brief Converts the string of a constant to the 32 bit value it represents, wrapping around
+         * on overflow (i.e "4294967297" => 1).
+         *
+         * @param value
+         * @return int32_t
+         */
+        static int32_t wrapConstant(std::string value);
+        /**
+         * @brief Checks if the name belongs to a temporary created by the TackyGenerator
+         *
+         * @param name
+         * @return bool
+         */
+        static bool isTemporary(const std::string& name);
+        void simplifyFunction(TackyFunction* function);
+        void simplifyProgram(TackyProgram* program);
+};
+
+// ======================================================
+//                     TackyCopyPropagator
+// ======================================================
+/**
+ * @brief Forward copy propagation. After dst = src every read of dst is replaced by src, until either of them is
+ * written again or a label joins other paths in. Copies of temporaries that end up unread are then removed.
+ *
+ */
+class TackyCopyPropagator {
+    private:
+        /**
+         * @brief The value each variable currently holds a copy of
+         *
+         */
+        std::unordered_map<std::string, TackyVal*> copies;
+        /**
+         * @brief The variables holding a copy of a given variable
+         *
+         */
+        std::unordered_map<std::string, std::vector<std::string>> dependents;
+        TackyVal* substitute(TackyVal* val);
+        void invalidate(TackyVal* dst);
+    public:
+        void propagateFunction(TackyFunction* function);
+};
+
+// ======================================================
+//                     TackyPromoter
+// ======================================================
+/**
+ * @brief mem2reg: rewrites the locals of a function (the variables the Parser named, see Parser::declareVariable)
+ * into SSA values, so that what is left after it are temporaries the backend can keep in registers.
+ *
+ * Nothing can take the address of a local yet, so every local is promoted. The pass follows Cytron et al.:
+ *      phis        placed at the iterated dominance frontier of the blocks writing the local, only for the
+ *                  locals read in some block before being written there (semi-pruned SSA)
+ *      renaming    a walk of the dominator tree with a stack of values per local. x = v only pushes v, so
+ *                  constants and copies flow into every read x dominates; x = op v writes a new temporary.
+ *                  A read with no write above it reads 0 for an uninitialized local, the incoming value
+ *                  (the variable itself, which is never written afterwards) for a parameter
+ *      phis out    a phi whose inputs are all the same value is replaced by that value. Any other gets a new
+ *                  temporary, written at the end of each predecessor (before its jump). Every edge goes forward,
+ *                  so these copies never overwrite a value still needed on another edge
+ * Dominators come from ControlFlowGraph::immediateDominators, the dominance frontiers from the runner walk of
+ * Cooper, Harvey and Kennedy. Blocks not reachable from the entry are dropped.
+ *
+ * The local of every operand is looked up once, in the first walk, and kept in a table the later walks index.
+ */
+class TackyPromoter {
+    private:
+        /**
+         * @brief A phi of a local at the start of a block, one input per predecessor (nullptr while unknown or
+         * uninitialized)
+         *
+         */
+        struct Phi {
+            int local;
+            TackyVariable* result;
+            std::vector<TackyVal*> inputs;
+        };
+    public:
+        /**
+         * @brief Promotes every local of the function
+         *
+         * @param function
+         * @return size_t number of locals promoted
+         */
+        static size_t promoteFunction(TackyFunction* function);
+};
+
+// ======================================================
+//                     TackyCfgSimplifier
+// ======================================================
+/**
+ * @brief Cleans up the control flow of a function, on its ControlFlowGraph:
+ *      JumpIfZero on a constant            => Jump (constant 0) or removed
+ *      Switch on a constant                => Jump to the label of that case
+ *      blocks not reachable from the entry => removed (i.e the code after a return, the else of if(1))
+ *      Jump/JumpIfZero to the next label   => removed
+ *      labels no jump targets              => removed, merging the blocks around them
+ * Each step is one linear walk over the body, so the pass stays linear in the size of the function.
+ *
+ */
+class TackyCfgSimplifier {
+    public:
+        /**
+         * @brief Simplifies the control flow of the function
+         *
+         * @param function
+         * @return size_t number of instructions removed
+         */
+        static size_t simplifyFunction(TackyFunction* function);
+};
+
+// ======================================================
+//                     TackyInliner
+// ======================================================
+/**
+ * @brief Bottom-up inlining of small leaf functions, the one TAC pass that sees the whole program at once.
+ *
+ * The functions are visited in post-order of the call graph, so a callee is done before its callers and a caller
+ * whose calls were all inlined is a leaf itself when its own callers come. A call is replaced by the body of the
+ * callee when the callee is defined in the program, makes no call (which also rules out recursion) and has at most
+ * INLINE_BUDGET instructions. Functions whose address is taken don't exist yet, so the callee is still emitted.
+ *
+ * The body is copied with its temporaries renumbered after the caller's, its labels and other variables suffixed
+ * with the call site (.i<k>) and every return turned into a copy to the result of the call and a jump to a label
+ * after the body. A parameter the callee never writes reads the argument itself, so constant arguments fold
+ * in the simplify and simplify-cfg passes that run after this one.
+ */
+class TackyInliner {
+    private:
+        static const size_t INLINE_BUDGET = 32;
+        static bool isLeaf(TackyFunction* function);
+        /**
+         * @brief Appends the body of the callee in place of the call
+         *
+         * @param call
+         * @param callee
+         * @param site index of the call site in the caller, tells the copies of the labels apart
+         * @param nextTemporary first free temporary of the caller, moved past the ones of the copy
+         * @param out
+         */
+        static void inlineCall(TackyFunctionCall* call, TackyFunction* callee, size_t site, int& nextTemporary,
+            std::vector<TackyInstruction*>& out);
+    public:
+        /**
+         * @brief Inlines the calls to small leaf functions in every function of the program
+         *
+         * @param functions every function of the program
+         * @return size_t number of calls inlined
+         */
+        static size_t inlineProgram(const std::vector<TackyFunction*>& functions);
+};
+
+// ======================================================
+//                     TackyInterprocedural
+// ======================================================
+/**
+ * @brief Whole program passes over the call graph of the TAC.
+ *
+ * propagateReturns (ipcp) visits the functions bottom-up, like TackyInliner. A function whose returns all give
+ * the same constant hands it to its callers. A call to a pure function (one calling nothing but pure functions of
+ * the program, so it always returns and does nothing else) becomes a copy of the constant. Any other call stays
+ * for what it does, only its value is replaced. A caller that changed is simplified again on the spot (simplify,
+ * copy-prop, simplify-cfg), so its own returns can fold in turn: a chain of constant functions folds into main in
+ * a single pass.
+ *
+ * liveFunctions (dead-functions) keeps the functions reachable from the externally visible ones, every function
+ * but the static ones. A static function no one calls any more (i.e all its calls were folded or inlined) can't be
+ * called from anywhere and is dropped.
+ */
+class TackyInterprocedural {
+    private:
+        /**
+         * @brief Checks that every return of the function gives the same constant
+         *
+         * @param function
+         * @param value set to the constant
+         * @return bool
+         */
+        static bool returnedConstant(TackyFunction* function, int32_t& value);
+    public:
+        /**
+         * @brief Replaces the value of the calls to the functions returning a constant
+         *
+         * @param functions every function of the program
+         * @return size_t number of calls replaced
+         */
+        static size_t propagateReturns(const std::vector<TackyFunction*>& functions);
+        /**
+         * @brief Marks the functions reachable through calls from the visible ones
+         *
+         * @param functions every function of the program
+         * @param visible the functions other files can call
+         * @return std::vector<bool> one entry per function
+         */
+        static std::vector<bool> liveFunctions(const std::vector<TackyFunction*>& functions, const std::vector<bool>& visible);
+};
+
+/**
+ * @brief Removes the instructions defining a temporary that is never read. Temporaries are defined before they
+ * are read, so a single backwards walk finds all of them.
+ *
+ * @param instructions
+ * @return std::vector<TackyInstruction*>
+ */
+std::vector<TackyInstruction*> remove_dead_temporaries(std::vector<TackyInstruction*> instructions);
+
+#endif // OPTIMIZER_HPP
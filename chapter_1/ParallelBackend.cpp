@@ -0,0 +1,149 @@
+#include "ParallelBackend.hpp"
+#include "X86Encoder.hpp"
+#include "Profile.hpp"
+#include "FunctionLayout.hpp"
+#include <elf.h>
+#include <sstream>
+
+// ======================================================
+//                     ParallelBackend
+// ======================================================
+ParallelBackend::ParallelBackend(unsigned threadCount):pool(threadCount){}
+
+std::vector<FunctionUnit> ParallelBackend::runPipeline(AST* ast, const PassManager& passManager, std::vector<PassStatistics>& statistics){
+    std::vector<FunctionNode*> functions = ast->getRoot()->getFunctions();
+    std::vector<FunctionUnit> units(functions.size());
+    for(size_t i = 0; i < functions.size(); i++){
+        units[i].index = i;
+        units[i].ast = functions[i];
+    }
+    // one set of statistics per function, so the jobs never write to the same counters
+    std::vector<std::vector<PassStatistics>> functionStatistics(functions.size());
+    statistics.assign(passManager.getPipelineLength(), PassStatistics{});
+    // the functions go through the pipeline in parallel up to each module pass, which waits for all of them
+    size_t begin = 0;
+    while(true){
+        size_t end = begin;
+        while(end < passManager.getPipelineLength() && !passManager.isModulePass(end)){
+            end++;
+        }
+        // a module pass may have dropped functions
+        this->pool.parallelFor(units.size(), [&](size_t i){
+            passManager.runOnFunction(units[i], functionStatistics[i], begin, end);
+        });
+        if(end == passManager.getPipelineLength()){
+            break;
+        }
+        passManager.runOnModule(units, statistics, end);
+        begin = end + 1;
+    }
+
+    for(const std::vector<PassStatistics>& perFunction: functionStatistics){
+        for(size_t p = 0; p < perFunction.size(); p++){
+            statistics[p].nanoseconds += perFunction[p].nanoseconds;
+            statistics[p].sizeBefore += perFunction[p].sizeBefore;
+            statistics[p].sizeAfter += perFunction[p].sizeAfter;
+            statistics[p].functions += perFunction[p].functions;
+        }
+    }
+
+    return(units);
+}
+
+// Names of the functions in the order of their profile counters (source order, the layout may have moved the
+// units), empty when no function is instrumented
+static std::vector<std::string> counter_names(const std::vector<FunctionUnit>& units){
+    std::vector<std::string> names;
+    bool profiled = false;
+    for(const FunctionUnit& unit: units){
+        profiled = profiled || unit.profiled;
+    }
+    if(profiled){
+        names.resize(units.size());
+        for(const FunctionUnit& unit: units){
+            names[unit.index] = unit.ast->getIdentifer();
+        }
+    }
+    return(names);
+}
+
+std::string ParallelBackend::joinAssembly(const std::vector<FunctionUnit>& units){
+    std::ostringstream assembly;
+    bool cold = false;
+    for(const FunctionUnit& unit: units){
+        if(unit.foldedInto.empty()){
+            if(unit.cold != cold){
+                cold = unit.cold;
+                assembly << (cold ? std::string{"\t.section "} + FunctionLayout::COLD_SECTION + ",\"ax\",@progbits\n" : "\t.text\n");
+            }
+            assembly << unit.text;
+        }else{
+            if(!unit.ast->isInternal()){
+                assembly << "\t.global " << unit.ast->getIdentifer() << "\n";
+            }
+            assembly << "\t.set " << unit.ast->getIdentifer() << ", " << unit.foldedInto << "\n\n";
+        }
+    }
+    std::vector<std::string> names = counter_names(units);
+    if(!names.empty()){
+        // one counter per function, zeroed at load time, and the names of the functions in the same order
+        assembly << "\t.section " << Profile::COUNTERS_SECTION << ",\"aw\",@nobits\n";
+        assembly << "\t.p2align 3\n";
+        assembly << Profile::COUNTERS_LABEL << ":\n";
+        assembly << "\t.zero " << 8 * names.size() << "\n";
+        assembly << "\t.section " << Profile::NAMES_SECTION << ",\"a\",@progbits\n";
+        for(const std::string& name: names){
+            assembly << "\t.string \"" << name << "\"\n";
+        }
+        assembly << '\n';
+    }
+    IRProgramNode::filePrintEpilogue(assembly);
+    return(assembly.str());
+}
+
+ElfObjectWriter ParallelBackend::buildObject(const std::vector<FunctionUnit>& units){
+    ElfObjectWriter writer{};
+    std::vector<std::string> names = counter_names(units);
+    if(!names.empty()){
+        // same sections as joinAssembly writes, added first so the relocations can refer to the counters
+        std::vector<uint8_t> strings;
+        for(const std::string& name: names){
+            strings.insert(strings.end(), name.begin(), name.end());
+            strings.push_back(0);
+        }
+        writer.addSection(Profile::COUNTERS_SECTION, SHT_NOBITS, SHF_WRITE | SHF_ALLOC, 8, {}, 8 * names.size());
+        writer.addSection(Profile::NAMES_SECTION, SHT_PROGBITS, SHF_ALLOC, 1, strings);
+    }
+    // the jump tables of the functions one after the other, each on 4 bytes like the .p2align 2 before a table
+    std::vector<uint8_t> readOnlyData;
+    std::vector<size_t> readOnlyStart(units.size(), 0);
+    for(size_t i = 0; i < units.size(); i++){
+        if(units[i].foldedInto.empty() && !units[i].readOnlyData.empty()){
+            readOnlyData.resize((readOnlyData.size() + 3) / 4 * 4, 0);
+            readOnlyStart[i] = readOnlyData.size();
+            readOnlyData.insert(readOnlyData.end(), units[i].readOnlyData.begin(), units[i].readOnlyData.end());
+        }
+    }
+    if(!readOnlyData.empty()){
+        writer.addSection(X86Encoder::READ_ONLY_SECTION, SHT_PROGBITS, SHF_ALLOC, 4, readOnlyData);
+    }
+    for(size_t i = 0; i < units.size(); i++){
+        const FunctionUnit& unit = units[i];
+        if(unit.foldedInto.empty()){
+            writer.setCodeSection(unit.cold ? FunctionLayout::COLD_SECTION : ".text");
+            // .p2align 4
+            writer.addPadding(X86Encoder::padding((16 - writer.getTextSize() % 16) % 16));
+            uint64_t start = writer.addFunction(unit.ast->getIdentifer(), unit.code, unit.callFrame, !unit.ast->isInternal());
+            for(const CodeRelocation& relocation: unit.relocations){
+                int64_t addend = relocation.addend;
+                if(relocation.symbol == X86Encoder::READ_ONLY_SECTION){
+                    addend += static_cast<int64_t>(readOnlyStart[i]);
+                }
+                writer.addRelocation(start + relocation.offset, relocation.symbol, relocation.type, addend);
+            }
+        }else{
+            writer.addAlias(unit.ast->getIdentifer(), unit.foldedInto, !unit.ast->isInternal());
+        }
+    }
+    return(writer);
+}
@@ -0,0 +1,66 @@
+#ifndef PARALLELBACKEND_HPP
+#define PARALLELBACKEND_HPP
+
+#include <string>
+#include <vector>
+#include "AST.hpp"
+#include "Tacky.hpp"
+#include "Assembly.hpp"
+#include "ThreadPool.hpp"
+#include "PassManager.hpp"
+#include "ElfWriter.hpp"
+
+// ======================================================
+//                     ParallelBackend
+// ======================================================
+/**
+ * @brief Runs the PassManager pipeline (by default Tacky generation, simplification, lowering, stack slot
+ * assignment and emission) one function at a time on a ThreadPool.
+ *
+ * Functions share no state once temporaries are numbered per function, so each job writes its assembly into
+ * its own buffer. The buffers are joined in source order, which makes the output byte-identical no matter
+ * how many threads are used. A module pass (i.e inline) needs every function at once: the pipeline runs in parallel
+ * up to it, the pass runs on the whole program and the functions go on in parallel after it.
+ */
+class ParallelBackend {
+    private:
+        ThreadPool pool;
+    public:
+        /**
+         * @brief Construct a new Parallel Backend object
+         *
+         * @param threadCount 0 picks the number of hardware threads
+         */
+        explicit ParallelBackend(unsigned threadCount);
+        /**
+         * @brief Runs the pipeline on every function, the units are returned in source order
+         *
+         * @param ast
+         * @param passManager
+         * @param statistics set to the statistics of each pass, summed over all functions
+         * @return std::vector<FunctionUnit>
+         */
+        std::vector<FunctionUnit> runPipeline(AST* ast, const PassManager& passManager, std::vector<PassStatistics>& statistics);
+        /**
+         * @brief Joins the text of the units (pipeline ending with emit) into the assembly for the whole file,
+         * a folded unit is emitted as a .set alias of the function it was folded into and a cold one in .text.unlikely
+         * (see FunctionLayout.hpp). With instrumented units the
+         * profile sections (see Profile.hpp) follow the functions.
+         *
+         * @param units
+         * @return std::string
+         */
+        static std::string joinAssembly(const std::vector<FunctionUnit>& units);
+        /**
+         * @brief Puts the machine code of the units (pipeline ending with encode) in an ELF object, a folded
+         * unit gets a symbol aliasing the function it was folded into and a cold one goes to .text.unlikely, the
+         * relocations of the units go to the .rela section of their code section. The jump tables of the units
+         * are concatenated into .rodata, what the text path gets from the .pushsection of each table
+         *
+         * @param units
+         * @return ElfObjectWriter
+         */
+        static ElfObjectWriter buildObject(const std::vector<FunctionUnit>& units);
+};
+
+#endif // PARALLELBACKEND_HPP
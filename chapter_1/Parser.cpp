@@ -1,4 +1,6 @@
 #include "Parser.hpp"
+#include <array>
+#include <cstdint>
 Parser::Parser(std::vector<Token> tokens){
             this->tokens = tokens;
             this->it =  this->tokens.begin();
@@ -9,7 +11,10 @@ ProgramNode* Parser::parseProgram(){
 
         std::vector<FunctionNode*> functions;
         while(it != this->tokens.end()){
-            functions.push_back(parseFunction());
+            FunctionNode* function = parseFunction();
+            if(function != nullptr){
+                functions.push_back(function);
+            }
         }
 
         ProgramNode* AST_Root = new ProgramNode{functions};
@@ -36,19 +41,14 @@ std::string Parser::parseIdentifier(){
     it++;
     return(str);
 }
-UnaryNode* Parser::parseUnaryExpression(){
-    TokenType type = this->it->getTokenType();
-    UnaryOperator unary;
-    if(type  == HYPHEN){
-        unary = UnaryOperator::Negation;
-    }else if(type == TILDE){
-        unary = UnaryOperator::Complement;
-    }else{
-        unary = UnaryOperator::Error;
+// The operator of a prefix token, see isUnaryOperator
+static UnaryOperator unary_operator_of(TokenType type){
+    switch(type){
+        case HYPHEN: return(UnaryOperator::Negation);
+        case TILDE: return(UnaryOperator::Complement);
+        case EXCLAMATION: return(UnaryOperator::LogicalNot);
+        default: return(UnaryOperator::Error);
     }
-    it++;
-    return(new UnaryNode{unary,parseExpression()});
-    // return(nullptr);
 }
 std::string Parser::parseInt(){
     if(it == this->tokens.end()){
@@ -62,45 +62,470 @@ std::string Parser::parseInt(){
 
     throw std::runtime_error("Expected Terminal CONSTANT but got: "+ it->getValue() +" of type: "+token_to_string(it->getTokenType()));
 }
-ExpressionNode* Parser::parseExpression(){
+ExpressionNode* Parser::parseFactor(){
+    // a run of prefix operators is stepped over in a loop and applied once the operand is parsed, innermost
+    // first, so - - - x costs no recursion
+    std::vector<Token>::iterator prefixes = it;
+    while(isUnaryOperator(*parserPeek(0))){
+        it++;
+    }
+    std::vector<Token>::iterator operand = it;
+    ExpressionNode* node = nullptr;
     //If the current expression is a constant integer value i.e (54)
     if(parserPeek(0)->getTokenType() == CONSTANTS ){
         std::string constant = parseInt();
-        return (new ConstantNode{constant});
-    }else if(isUnaryOperator(*parserPeek(0))){
-        UnaryNode* node =  parseUnaryExpression();
-        // node->print();std::cout<<'\n';
-        return(node);
+        node = new ConstantNode{constant};
     }else if(parserPeek(0)->getTokenType() == OPEN_PARENTHESIS){
-        expect(OPEN_PARENTHESIS,"("); 
-        ExpressionNode* node = parseExpression();
-        expect(CLOSED_PARENTHESIS,")"); 
-        return(node);
+        expect(OPEN_PARENTHESIS,"(");
+        enterNesting();
+        node = parseExpression();
+        this->nesting--;
+        expect(CLOSED_PARENTHESIS,")");
+    }else if(parserPeek(0)->getTokenType() == IDENTIFIER){
+        std::string name = parseIdentifier();
+        if(it != this->tokens.end() && it->getTokenType() == OPEN_PARENTHESIS){
+            enterNesting();
+            node = parseCall(name);
+            this->nesting--;
+        }else{
+            node = new VariableNode{resolveVariable(name)};
+        }
     }else{
-        throw std::runtime_error("Malformed Expression");\
+        throw std::runtime_error("Malformed Expression");
+    }
+    while(operand != prefixes){
+        operand--;
+        node = new UnaryNode{unary_operator_of(operand->getTokenType()), node};
+    }
+    return(node);
+}
+
+// ======================================================
+//                     Operator table
+// ======================================================
+// The precedence levels of the C infix operators, loosest first
+enum Precedence : int {
+    NOT_INFIX, COMMA_LEVEL, ASSIGNMENT_LEVEL, CONDITIONAL_LEVEL, LOGICAL_OR_LEVEL, LOGICAL_AND_LEVEL, BITWISE_OR_LEVEL,
+    BITWISE_XOR_LEVEL, BITWISE_AND_LEVEL, EQUALITY_LEVEL, RELATIONAL_LEVEL, SHIFT_LEVEL, ADDITIVE_LEVEL,
+    MULTIPLICATIVE_LEVEL
+};
+
+// Binary operators are left associative, the other three kinds right associative
+enum class InfixKind { NONE, BINARY, ASSIGNMENT, COMPOUND_ASSIGNMENT, CONDITIONAL };
+
+struct InfixOperator {
+    Precedence precedence;
+    InfixKind kind;
+    /**
+     * @brief The operator of a binary token, and the one a compound assignment applies (+= adds)
+     *
+     */
+    BinaryOperator op;
+};
+
+static constexpr std::array<InfixOperator, TOKEN_TYPE_COUNT> make_infix_table(){
+    std::array<InfixOperator, TOKEN_TYPE_COUNT> table{};
+    for(InfixOperator& entry: table){
+        entry = InfixOperator{NOT_INFIX, InfixKind::NONE, BinaryOperator::Add};
+    }
+    table[ASTERISK] = InfixOperator{MULTIPLICATIVE_LEVEL, InfixKind::BINARY, BinaryOperator::Multiply};
+    table[SLASH] = InfixOperator{MULTIPLICATIVE_LEVEL, InfixKind::BINARY, BinaryOperator::Divide};
+    table[PERCENT] = InfixOperator{MULTIPLICATIVE_LEVEL, InfixKind::BINARY, BinaryOperator::Remainder};
+    table[PLUS] = InfixOperator{ADDITIVE_LEVEL, InfixKind::BINARY, BinaryOperator::Add};
+    table[HYPHEN] = InfixOperator{ADDITIVE_LEVEL, InfixKind::BINARY, BinaryOperator::Subtract};
+    table[LEFT_SHIFT] = InfixOperator{SHIFT_LEVEL, InfixKind::BINARY, BinaryOperator::LeftShift};
+    table[RIGHT_SHIFT] = InfixOperator{SHIFT_LEVEL, InfixKind::BINARY, BinaryOperator::RightShift};
+    table[LESS] = InfixOperator{RELATIONAL_LEVEL, InfixKind::BINARY, BinaryOperator::LessThan};
+    table[LESS_EQUAL] = InfixOperator{RELATIONAL_LEVEL, InfixKind::BINARY, BinaryOperator::LessOrEqual};
+    table[GREATER] = InfixOperator{RELATIONAL_LEVEL, InfixKind::BINARY, BinaryOperator::GreaterThan};
+    table[GREATER_EQUAL] = InfixOperator{RELATIONAL_LEVEL, InfixKind::BINARY, BinaryOperator::GreaterOrEqual};
+    table[EQUAL] = InfixOperator{EQUALITY_LEVEL, InfixKind::BINARY, BinaryOperator::Equal};
+    table[NOT_EQUAL] = InfixOperator{EQUALITY_LEVEL, InfixKind::BINARY, BinaryOperator::NotEqual};
+    table[AMPERSAND] = InfixOperator{BITWISE_AND_LEVEL, InfixKind::BINARY, BinaryOperator::BitwiseAnd};
+    table[CARET] = InfixOperator{BITWISE_XOR_LEVEL, InfixKind::BINARY, BinaryOperator::BitwiseXor};
+    table[PIPE] = InfixOperator{BITWISE_OR_LEVEL, InfixKind::BINARY, BinaryOperator::BitwiseOr};
+    table[LOGICAL_AND] = InfixOperator{LOGICAL_AND_LEVEL, InfixKind::BINARY, BinaryOperator::LogicalAnd};
+    table[LOGICAL_OR] = InfixOperator{LOGICAL_OR_LEVEL, InfixKind::BINARY, BinaryOperator::LogicalOr};
+    table[QUESTION] = InfixOperator{CONDITIONAL_LEVEL, InfixKind::CONDITIONAL, BinaryOperator::Add};
+    table[ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::ASSIGNMENT, BinaryOperator::Add};
+    table[PLUS_ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::COMPOUND_ASSIGNMENT, BinaryOperator::Add};
+    table[HYPHEN_ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::COMPOUND_ASSIGNMENT, BinaryOperator::Subtract};
+    table[ASTERISK_ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::COMPOUND_ASSIGNMENT, BinaryOperator::Multiply};
+    table[SLASH_ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::COMPOUND_ASSIGNMENT, BinaryOperator::Divide};
+    table[PERCENT_ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::COMPOUND_ASSIGNMENT, BinaryOperator::Remainder};
+    table[AMPERSAND_ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::COMPOUND_ASSIGNMENT, BinaryOperator::BitwiseAnd};
+    table[CARET_ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::COMPOUND_ASSIGNMENT, BinaryOperator::BitwiseXor};
+    table[PIPE_ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::COMPOUND_ASSIGNMENT, BinaryOperator::BitwiseOr};
+    table[LEFT_SHIFT_ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::COMPOUND_ASSIGNMENT, BinaryOperator::LeftShift};
+    table[RIGHT_SHIFT_ASSIGN] = InfixOperator{ASSIGNMENT_LEVEL, InfixKind::COMPOUND_ASSIGNMENT, BinaryOperator::RightShift};
+    table[COMMA] = InfixOperator{COMMA_LEVEL, InfixKind::BINARY, BinaryOperator::Comma};
+    return(table);
+}
+
+// Indexed by TokenType, built at compile time
+static constexpr std::array<InfixOperator, TOKEN_TYPE_COUNT> infix_table = make_infix_table();
+static_assert(infix_table[ASTERISK].precedence > infix_table[PLUS].precedence && infix_table[SEMICOLON].kind == InfixKind::NONE,
+    "the operator table is built at compile time");
+
+// A right associative operator whose right operand is still being parsed
+struct PendingOperator {
+    InfixOperator infix;
+    // the variable assigned to, or the condition
+    ExpressionNode* left;
+    // the then branch of a conditional
+    ExpressionNode* middle;
+};
+
+// Applies the pending operators to the operand that ends their chain, last one first: a = b = c is a = (b = c)
+static ExpressionNode* fold_pending(std::vector<PendingOperator>& pending, ExpressionNode* operand){
+    while(!pending.empty()){
+        PendingOperator top = pending.back();
+        pending.pop_back();
+        if(top.infix.kind == InfixKind::CONDITIONAL){
+            operand = new ConditionalNode{top.left, top.middle, operand};
+        }else{
+            VariableNode* variable = static_cast<VariableNode*>(top.left);
+            if(top.infix.kind == InfixKind::COMPOUND_ASSIGNMENT){
+                // x += e is x = x + (e), the variable has no side effect to repeat
+                operand = new BinaryNode{top.infix.op, new VariableNode{variable->getIdentifier()}, operand};
+            }
+            operand = new AssignmentNode{variable, operand};
+        }
+    }
+    return(operand);
+}
+
+void Parser::enterNesting(){
+    if(++this->nesting > MAX_NESTING){
+        throw std::runtime_error("Expression nested more than " + std::to_string(MAX_NESTING) + " levels deep");
+    }
+}
+
+ExpressionNode* Parser::parseExpression(int minPrecedence){
+    // a chain of right associative operators is kept here rather than parsed by a recursive call per operator,
+    // the vector only allocates when there is one
+    std::vector<PendingOperator> pending;
+    ExpressionNode* node = parseFactor();
+    while(it != this->tokens.end()){
+        const InfixOperator& infix = infix_table[it->getTokenType()];
+        if(infix.kind == InfixKind::NONE || infix.precedence < minPrecedence){
+            break;
+        }
+        if(!pending.empty() && infix.precedence < pending.back().infix.precedence){
+            // a looser operator ends the chain: in a = b, c the assignment is complete before the comma
+            node = fold_pending(pending, node);
+        }
+        const Token& token = *it;
+        it++;
+        switch(infix.kind){
+            case InfixKind::BINARY:
+                // the right operand only takes the operators binding tighter, which makes a - b - c (a - b) - c
+                node = new BinaryNode{infix.op, node, parseExpression(infix.precedence + 1)};
+                break;
+            case InfixKind::ASSIGNMENT:
+            case InfixKind::COMPOUND_ASSIGNMENT:
+                if(dynamic_cast<VariableNode*>(node) == nullptr){
+                    throw std::runtime_error("Invalid lvalue on the left of " + token.getValue() + ": " + node->getValue());
+                }
+                pending.push_back(PendingOperator{infix, node, nullptr});
+                node = parseExpression(infix.precedence + 1);
+                break;
+            case InfixKind::CONDITIONAL: {
+                // between ? and : anything goes, like inside parentheses
+                enterNesting();
+                ExpressionNode* middle = parseExpression();
+                this->nesting--;
+                expect(COLON,":");
+                pending.push_back(PendingOperator{infix, node, middle});
+                node = parseExpression(infix.precedence + 1);
+                break;
+            }
+            case InfixKind::NONE:
+                break;
+        }
+    }
+    node = fold_pending(pending, node);
+    if(node->getNesting() > MAX_NESTING){
+        throw std::runtime_error("Expression nested more than " + std::to_string(MAX_NESTING) + " levels deep");
+    }
+    return(node);
+}
+// Folds an integer constant expression (the value of a case) with the wrapping 32 bit arithmetic of the generated
+// code. False when it reads a variable, assigns, uses the comma operator or divides by 0 (or INT_MIN by -1).
+static bool evaluate_constant(ExpressionNode* exp, uint32_t& value){
+    switch(exp->getType()){
+        case ExpressionType::CONSTANT:
+            value = 0u;
+            for(char digit: exp->getValue()){
+                value = value * 10u + static_cast<uint32_t>(digit - '0');
+            }
+            return(true);
+        case ExpressionType::UNARY: {
+            UnaryNode* unary = static_cast<UnaryNode*>(exp);
+            if(!evaluate_constant(unary->getExpression(), value)){
+                return(false);
+            }
+            switch(unary->get_unary_operator()){
+                case UnaryOperator::Negation: value = 0u - value; return(true);
+                case UnaryOperator::Complement: value = ~value; return(true);
+                case UnaryOperator::LogicalNot: value = value == 0u; return(true);
+                default: return(false);
+            }
+        }
+        case ExpressionType::CONDITIONAL: {
+            ConditionalNode* conditional = static_cast<ConditionalNode*>(exp);
+            uint32_t condition = 0u;
+            return(evaluate_constant(conditional->getCondition(), condition)
+                && evaluate_constant(condition != 0u ? conditional->getThen() : conditional->getElse(), value));
+        }
+        case ExpressionType::BINARY: {
+            // the left operands of a chain are folded in a loop, bottom up
+            std::vector<BinaryNode*> chain;
+            ExpressionNode* leaf = exp;
+            while(leaf->getType() == ExpressionType::BINARY){
+                chain.push_back(static_cast<BinaryNode*>(leaf));
+                leaf = chain.back()->getLeft();
+            }
+            uint32_t a = 0u;
+            if(!evaluate_constant(leaf, a)){
+                return(false);
+            }
+            for(size_t i = chain.size(); i-- > 0;){
+                BinaryNode* binary = chain[i];
+                uint32_t b = 0u;
+                if(!evaluate_constant(binary->getRight(), b)){
+                    return(false);
+                }
+                int32_t x = static_cast<int32_t>(a), y = static_cast<int32_t>(b);
+                switch(binary->getBinaryOperator()){
+                    case BinaryOperator::Add: a = a + b; break;
+                    case BinaryOperator::Subtract: a = a - b; break;
+                    case BinaryOperator::Multiply: a = a * b; break;
+                    case BinaryOperator::Divide:
+                    case BinaryOperator::Remainder:
+                        if(y == 0 || (x == INT32_MIN && y == -1)){
+                            return(false);
+                        }
+                        a = static_cast<uint32_t>(binary->getBinaryOperator() == BinaryOperator::Divide ? x / y : x % y);
+                        break;
+                    case BinaryOperator::BitwiseAnd: a = a & b; break;
+                    case BinaryOperator::BitwiseOr: a = a | b; break;
+                    case BinaryOperator::BitwiseXor: a = a ^ b; break;
+                    case BinaryOperator::LeftShift: a = a << (b & 31u); break;
+                    case BinaryOperator::RightShift: a = static_cast<uint32_t>(x >> (b & 31u)); break;
+                    case BinaryOperator::LessThan: a = x < y; break;
+                    case BinaryOperator::LessOrEqual: a = x <= y; break;
+                    case BinaryOperator::GreaterThan: a = x > y; break;
+                    case BinaryOperator::GreaterOrEqual: a = x >= y; break;
+                    case BinaryOperator::Equal: a = a == b; break;
+                    case BinaryOperator::NotEqual: a = a != b; break;
+                    case BinaryOperator::LogicalAnd: a = a != 0u && b != 0u; break;
+                    case BinaryOperator::LogicalOr: a = a != 0u || b != 0u; break;
+                    default: return(false);
+                }
+            }
+            value = a;
+            return(true);
+        }
+        default:
+            return(false);
     }
-    //Need to implement binary operators in  the future
-    // return (new ConstantNode{"constant"});
 }
 StatementNode* Parser::parseStatement(){
-    expect(KEYWORD,"return");
-    
-    ExpressionNode* exp =  parseExpression();
+    Token next = *parserPeek(0);
+    if(next.getTokenType() == KEYWORD && next.getValue() == "return"){
+        expect(KEYWORD,"return");
+        ExpressionNode* exp =  parseExpression();
+        expect(SEMICOLON,";");
+        return(new ReturnNode{exp});
+    }else if(next.getTokenType() == KEYWORD && next.getValue() == "if"){
+        expect(KEYWORD,"if");
+        expect(OPEN_PARENTHESIS,"(");
+        ExpressionNode* condition = parseExpression();
+        expect(CLOSED_PARENTHESIS,")");
+        StatementNode* thenStatement = parseStatement();
+        StatementNode* elseStatement = nullptr;
+        // a dangling else belongs to the closest if
+        if(it != this->tokens.end() && it->getTokenType() == KEYWORD && it->getValue() == "else"){
+            expect(KEYWORD,"else");
+            elseStatement = parseStatement();
+        }
+        return(new IfNode{condition, thenStatement, elseStatement});
+    }else if(next.getTokenType() == KEYWORD && next.getValue() == "switch"){
+        expect(KEYWORD,"switch");
+        expect(OPEN_PARENTHESIS,"(");
+        ExpressionNode* exp = parseExpression();
+        expect(CLOSED_PARENTHESIS,")");
+        this->switches.emplace_back();
+        StatementNode* body = parseStatement();
+        SwitchLabels labels = std::move(this->switches.back());
+        this->switches.pop_back();
+        return(new SwitchNode{exp, body, labels.cases, labels.defaultCase});
+    }else if(next.getTokenType() == KEYWORD && next.getValue() == "case"){
+        expect(KEYWORD,"case");
+        if(this->switches.empty()){
+            throw std::runtime_error("case label not within a switch statement");
+        }
+        // a constant expression is a conditional expression, the : after it ends the label
+        ExpressionNode* exp = parseExpression(CONDITIONAL_LEVEL);
+        uint32_t value = 0u;
+        if(!evaluate_constant(exp, value)){
+            throw std::runtime_error("case label " + exp->getValue() + " is not an integer constant expression");
+        }
+        if(!this->switches.back().values.insert(static_cast<int32_t>(value)).second){
+            throw std::runtime_error("Duplicate case value " + std::to_string(static_cast<int32_t>(value)));
+        }
+        expect(COLON,":");
+        CaseNode* caseNode = new CaseNode{static_cast<int32_t>(value), parseStatement()};
+        this->switches.back().cases.push_back(caseNode);
+        return(caseNode);
+    }else if(next.getTokenType() == KEYWORD && next.getValue() == "default"){
+        expect(KEYWORD,"default");
+        expect(COLON,":");
+        if(this->switches.empty()){
+            throw std::runtime_error("default label not within a switch statement");
+        }
+        if(this->switches.back().hasDefault){
+            throw std::runtime_error("Multiple default labels in one switch");
+        }
+        // set before the statement is parsed, so a second default inside it is caught too
+        this->switches.back().hasDefault = true;
+        DefaultNode* defaultNode = new DefaultNode{parseStatement()};
+        this->switches.back().defaultCase = defaultNode;
+        return(defaultNode);
+    }else if(next.getTokenType() == KEYWORD && next.getValue() == "break"){
+        expect(KEYWORD,"break");
+        expect(SEMICOLON,";");
+        if(this->switches.empty()){
+            throw std::runtime_error("break statement not within a switch statement");
+        }
+        return(new BreakNode{});
+    }else if(next.getTokenType() == OPEN_BRACKETS){
+        return(new CompoundNode{parseBlock()});
+    }else if(next.getTokenType() == SEMICOLON){
+        expect(SEMICOLON,";");
+        return(new NullNode{});
+    }
+    ExpressionNode* exp = parseExpression();
     expect(SEMICOLON,";");
-    // StatementNode* node = new StatementNode{exp};
-    return(new ReturnNode{exp});
+    return(new ExpressionStatementNode{exp});
+}
+FunctionCallNode* Parser::parseCall(const std::string& name){
+    for(auto scope = this->scopes.rbegin(); scope != this->scopes.rend(); scope++){
+        if(scope->count(name)){
+            throw std::runtime_error("Called object " + name + " is not a function");
+        }
+    }
+    auto function = this->functions.find(name);
+    if(function == this->functions.end()){
+        throw std::runtime_error("Undeclared function " + name);
+    }
+    expect(OPEN_PARENTHESIS,"(");
+    std::vector<ExpressionNode*> arguments;
+    if(parserPeek(0)->getTokenType() != CLOSED_PARENTHESIS){
+        // a comma here separates the arguments, it isn't the comma operator
+        arguments.push_back(parseExpression(ASSIGNMENT_LEVEL));
+        while(parserPeek(0)->getTokenType() == COMMA){
+            expect(COMMA,",");
+            arguments.push_back(parseExpression(ASSIGNMENT_LEVEL));
+        }
+    }
+    expect(CLOSED_PARENTHESIS,")");
+    if(arguments.size() != function->second){
+        throw std::runtime_error("Function " + name + " takes " + std::to_string(function->second) + " arguments, "
+            + std::to_string(arguments.size()) + " given");
+    }
+    return(new FunctionCallNode{name, arguments});
+}
+DeclarationNode* Parser::parseDeclaration(){
+    expect(KEYWORD,"int");
+    std::string identifier = declareVariable(parseIdentifier());
+    ExpressionNode* init = nullptr;
+    if(parserPeek(0)->getTokenType() == ASSIGN){
+        expect(ASSIGN,"=");
+        // an initializer is an assignment expression, a comma would start the next declarator
+        init = parseExpression(ASSIGNMENT_LEVEL);
+    }
+    expect(SEMICOLON,";");
+    return(new DeclarationNode{identifier, init});
+}
+std::string Parser::declareVariable(const std::string& name){
+    std::string unique = "var." + name + "." + std::to_string(this->variable_counter++);
+    if(!this->scopes.back().emplace(name, unique).second){
+        throw std::runtime_error("Duplicate declaration of variable " + name);
+    }
+    return(unique);
+}
+std::string Parser::resolveVariable(const std::string& name){
+    for(auto scope = this->scopes.rbegin(); scope != this->scopes.rend(); scope++){
+        auto found = scope->find(name);
+        if(found != scope->end()){
+            return(found->second);
+        }
+    }
+    throw std::runtime_error("Undeclared variable " + name);
+}
+std::vector<StatementNode*> Parser::parseBlock(std::unordered_map<std::string, std::string> scope){
+    expect(OPEN_BRACKETS,"{");
+    this->scopes.push_back(std::move(scope));
+    std::vector<StatementNode*> statements;
+    while(parserPeek(0)->getTokenType() != CLOSED_BRACKETS){
+        Token next = *parserPeek(0);
+        if(next.getTokenType() == KEYWORD && next.getValue() == "int"){
+            statements.push_back(parseDeclaration());
+        }else{
+            statements.push_back(parseStatement());
+        }
+    }
+    this->scopes.pop_back();
+    expect(CLOSED_BRACKETS,"}");
+    return(statements);
 }
 FunctionNode* Parser::parseFunction(){
+    bool isStatic = parserPeek(0)->getTokenType() == KEYWORD && parserPeek(0)->getValue() == "static";
+    if(isStatic){
+        expect(KEYWORD,"static");
+    }
     expect(KEYWORD,"int");
     std::string name = parseIdentifier();
     expect(OPEN_PARENTHESIS,"(");
-    expect(KEYWORD,"void");
+    this->variable_counter = 0;
+    // the parameters get their unique names like the variables of the body, in a scope of their own
+    this->scopes.emplace_back();
+    std::vector<std::string> parameters;
+    if(parserPeek(0)->getTokenType() == KEYWORD && parserPeek(0)->getValue() == "void"){
+        expect(KEYWORD,"void");
+    }else{
+        do{
+            if(!parameters.empty()){
+                expect(COMMA,",");
+            }
+            expect(KEYWORD,"int");
+            parameters.push_back(declareVariable(parseIdentifier()));
+        }while(parserPeek(0)->getTokenType() == COMMA);
+    }
     expect(CLOSED_PARENTHESIS,")");
-    expect(OPEN_BRACKETS,"{");
-    StatementNode* function_body =  parseStatement();
+    std::unordered_map<std::string, std::string> parameterScope = std::move(this->scopes.back());
+    this->scopes.pop_back();
 
-    expect(CLOSED_BRACKETS,"}");
-    return(new FunctionNode{name,function_body});
+    auto declared = this->functions.emplace(name, parameters.size());
+    if(!declared.second && declared.first->second != parameters.size()){
+        throw std::runtime_error("Conflicting declarations of function " + name);
+    }
+    if(declared.second && isStatic){
+        this->internalFunctions.insert(name);
+    }else if(isStatic && this->internalFunctions.count(name) == 0){
+        throw std::runtime_error("Static declaration of " + name + " follows non-static declaration");
+    }
+    if(parserPeek(0)->getTokenType() == SEMICOLON){
+        expect(SEMICOLON,";");
+        return(nullptr);
+    }
+    if(!this->definitions.insert(name).second){
+        throw std::runtime_error("Redefinition of function " + name);
+    }
+    std::vector<StatementNode*> function_body =  parseBlock(std::move(parameterScope));
+    return(new FunctionNode{name,parameters,function_body,this->internalFunctions.count(name) != 0});
 }
 
 std::vector<Token>::iterator Parser::parserPeek(int pos) {
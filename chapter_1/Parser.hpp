@@ -3,6 +3,8 @@
 #include<vector>
 #include<string>
 #include<stdexcept>
+#include<unordered_map>
+#include<unordered_set>
 #include "AST.hpp"
 #include"Token.hpp"
 class Parser{
@@ -15,6 +17,61 @@ class Parser{
     private:
         std::vector<Token> tokens;
         std::vector<Token>::iterator it;
+        /**
+         * @brief The variables visible in each enclosing block, innermost last, from their source name to their
+         * unique name
+         *
+         */
+        std::vector<std::unordered_map<std::string, std::string>> scopes;
+        /**
+         * @brief Number of variables declared so far in the current function
+         *
+         */
+        int variable_counter = 0;
+        /**
+         * @brief The labels found so far in the body of a switch
+         *
+         */
+        struct SwitchLabels {
+            std::vector<CaseNode*> cases;
+            std::unordered_set<int32_t> values;
+            bool hasDefault = false;
+            DefaultNode* defaultCase = nullptr;
+        };
+        /**
+         * @brief The switches being parsed, innermost last. A case, default or break belongs to the last one.
+         *
+         */
+        std::vector<SwitchLabels> switches;
+        /**
+         * @brief The functions declared so far, from their name to their number of parameters. A function is
+         * declared by its first prototype or definition, so it can call itself and the functions above it.
+         *
+         */
+        std::unordered_map<std::string, size_t> functions;
+        /**
+         * @brief The functions that have a body so far, a second definition is an error
+         *
+         */
+        std::unordered_set<std::string> definitions;
+        /**
+         * @brief The functions first declared static. A later declaration without static keeps the internal linkage,
+         * static after a declaration without it is an error (as in C)
+         *
+         */
+        std::unordered_set<std::string> internalFunctions;
+        /**
+         * @brief The deepest an expression can nest, in the parser (see nesting) and in the tree it builds (see
+         * ExpressionNode::getNesting). Deeper input is rejected instead of overflowing the stack of a recursive walk.
+         *
+         */
+        static const int MAX_NESTING = 1024;
+        /**
+         * @brief Number of parentheses, call arguments and ?: middles being parsed, the places parseExpression
+         * recurses into itself without a bound
+         *
+         */
+        int nesting = 0;
         // ProgramNode* root;
         /*
          if the current Token matches the expected token based on the syntax of the language. Auto advances the iterator 
@@ -22,10 +79,92 @@ class Parser{
         */
         void expect(TokenType type,std::string value ="");
         std::string parseInt();
-        UnaryNode* parseUnaryExpression();
-        ExpressionNode* parseExpression();
+        /**
+         * @brief Parses a constant, a variable or a parenthesised expression, with any number of unary operators
+         * in front
+         *
+         * @return ExpressionNode*
+         */
+        ExpressionNode* parseFactor();
+        /**
+         * @brief Precedence climbing over the C infix operators: parses a factor, then keeps folding in the operators
+         * that bind at least as tightly as minPrecedence. Their level and kind come from a constexpr table indexed by
+         * TokenType (infix_table in Parser.cpp), so deciding what a token does is a single load.
+         *
+         * A left associative operator parses its right operand with a strictly higher minimum, so a call only recurses
+         * when the next operator binds tighter and the depth is bounded by the number of levels (13), whatever the
+         * length of the expression. Chains of right associative operators (=, the compound assignments, ?:) are
+         * stacked in a loop instead of recursing once per operator. x op= e is parsed as x = x op (e). Each token is
+         * looked at a constant number of times, so parsing is linear in the number of operators. The walks after the
+         * parser only loop over the left operands of a chain, so an expression nesting deeper than MAX_NESTING any
+         * other way is an error.
+         *
+         * @param minPrecedence 0 for a full expression (comma included)
+         * @return ExpressionNode*
+         */
+        ExpressionNode* parseExpression(int minPrecedence = 0);
+        /**
+         * @brief Counts one more level of nesting before a nested parseExpression, throws past MAX_NESTING. The
+         * caller decrements nesting once the nested expression is parsed.
+         *
+         */
+        void enterNesting();
+        /**
+         * @brief Parses the arguments of a call to name, the ( is next. Each argument is an assignment expression,
+         * the commas separate them. Throws if the function isn't declared, is hidden by a variable or takes a
+         * different number of arguments.
+         *
+         * @param name
+         * @return FunctionCallNode*
+         */
+        FunctionCallNode* parseCall(const std::string& name);
+        /**
+         * @brief Parses a statement. switch (e) statement collects the case and default labels of its body, at any
+         * depth but outside of a nested switch, into the SwitchNode. The value of a case is folded here, it has to
+         * be an integer constant expression and unique in its switch.
+         *
+         * @return StatementNode*
+         */
         StatementNode* parseStatement();
+        /**
+         * @brief Parses int x; or int x = expression;. The initializer already sees x, like in C.
+         *
+         * @return DeclarationNode*
+         */
+        DeclarationNode* parseDeclaration();
+        /**
+         * @brief Adds the variable to the innermost block and gives it a name unique within the function
+         * ("var.x.3", the prefix keeps it apart from the temporaries of the TAC). Throws if the block already
+         * declares it.
+         *
+         * @param name
+         * @return std::string the unique name
+         */
+        std::string declareVariable(const std::string& name);
+        /**
+         * @brief The unique name of the closest declaration of the variable. Throws if none is visible.
+         *
+         * @param name
+         * @return std::string
+         */
+        std::string resolveVariable(const std::string& name);
+        /**
+         * @brief Parses the statements and declarations between { and }, a function body or a compound statement.
+         * The block opens a new scope, which starts with the given variables: the parameters of a function are in
+         * the outermost block of its body, so int a; there redeclares the parameter a.
+         *
+         * @param scope
+         * @return std::vector<StatementNode*>
+         */
+        std::vector<StatementNode*> parseBlock(std::unordered_map<std::string, std::string> scope = {});
         std::string parseIdentifier();
+        /**
+         * @brief Parses int name(void) or int name(int a, int b, ...), followed by a body or by ; for a prototype.
+         * All the declarations of a function have to agree on its number of parameters. A leading static gives the
+         * function internal linkage.
+         *
+         * @return FunctionNode* the definition, nullptr for a prototype
+         */
         FunctionNode* parseFunction();
         std::vector<Token>::iterator parserPeek(int pos);
 };
@@ -0,0 +1,791 @@
+#include "PassManager.hpp"
+#include "Optimizer.hpp"
+#include "RegisterAllocator.hpp"
+#include "Peephole.hpp"
+#include "Legalizer.hpp"
+#include "FrameLayout.hpp"
+#include "DirectCodegen.hpp"
+#include "X86Encoder.hpp"
+#include "ControlFlowGraph.hpp"
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+std::string ir_level_to_string(IRLevel level){
+    switch(level){
+        case IRLevel::AST: return "AST";
+        case IRLevel::TACKY: return "TACKY";
+        case IRLevel::ASSEMBLY: return "ASSEMBLY";
+        case IRLevel::TEXT: return "TEXT";
+        case IRLevel::OBJECT: return "OBJECT";
+    }
+    return "";
+}
+
+// ======================================================
+//                     Built-in passes
+// ======================================================
+namespace {
+
+class TackyGenPass : public Pass {
+    public:
+        std::string getName() const override { return "tacky-gen"; }
+        IRLevel getInputLevel() const override { return IRLevel::AST; }
+        IRLevel getOutputLevel() const override { return IRLevel::TACKY; }
+        void run(FunctionUnit& unit) const override {
+            TackyGenerator tackyGenerator{};
+            unit.tacky = tackyGenerator.convertFunction(unit.ast);
+        }
+};
+
+class PromotePass : public Pass {
+    public:
+        std::string getName() const override { return "mem2reg"; }
+        IRLevel getInputLevel() const override { return IRLevel::TACKY; }
+        IRLevel getOutputLevel() const override { return IRLevel::TACKY; }
+        void run(FunctionUnit& unit) const override {
+            TackyPromoter::promoteFunction(unit.tacky);
+        }
+};
+
+class SimplifyPass : public Pass {
+    public:
+        std::string getName() const override { return "simplify"; }
+        IRLevel getInputLevel() const override { return IRLevel::TACKY; }
+        IRLevel getOutputLevel() const override { return IRLevel::TACKY; }
+        void run(FunctionUnit& unit) const override {
+            TackySimplifier simplifier{};
+            simplifier.simplifyFunction(unit.tacky);
+        }
+};
+
+class CopyPropagationPass : public Pass {
+    public:
+        std::string getName() const override { return "copy-prop"; }
+        IRLevel getInputLevel() const override { return IRLevel::TACKY; }
+        IRLevel getOutputLevel() const override { return IRLevel::TACKY; }
+        void run(FunctionUnit& unit) const override {
+            TackyCopyPropagator propagator{};
+            propagator.propagateFunction(unit.tacky);
+        }
+};
+
+class SimplifyCfgPass : public Pass {
+    public:
+        std::string getName() const override { return "simplify-cfg"; }
+        IRLevel getInputLevel() const override { return IRLevel::TACKY; }
+        IRLevel getOutputLevel() const override { return IRLevel::TACKY; }
+        void run(FunctionUnit& unit) const override {
+            TackyCfgSimplifier::simplifyFunction(unit.tacky);
+        }
+};
+
+class PrintCfgPass : public Pass {
+    public:
+        std::string getName() const override { return "print-cfg"; }
+        IRLevel getInputLevel() const override { return IRLevel::TACKY; }
+        IRLevel getOutputLevel() const override { return IRLevel::TACKY; }
+        void run(FunctionUnit& unit) const override {
+            std::cout << "function " << unit.tacky->getIdentifier() << ":\n";
+            ControlFlowGraph{unit.tacky->getBody()}.print(std::cout);
+        }
+};
+
+class PrintTackyPass : public Pass {
+    public:
+        std::string getName() const override { return "print-tacky"; }
+        IRLevel getInputLevel() const override { return IRLevel::TACKY; }
+        IRLevel getOutputLevel() const override { return IRLevel::TACKY; }
+        void run(FunctionUnit& unit) const override {
+            unit.tacky->prettyPrint();
+        }
+};
+
+class InlinePass : public ModulePass {
+    public:
+        std::string getName() const override { return "inline"; }
+        IRLevel getInputLevel() const override { return IRLevel::TACKY; }
+        IRLevel getOutputLevel() const override { return IRLevel::TACKY; }
+        void runOnModule(std::vector<FunctionUnit>& units) const override {
+            std::vector<TackyFunction*> functions;
+            functions.reserve(units.size());
+            for(FunctionUnit& unit: units){
+                functions.push_back(unit.tacky);
+            }
+            TackyInliner::inlineProgram(functions);
+        }
+};
+
+class ConstantReturnsPass : public ModulePass {
+    public:
+        std::string getName() const override { return "ipcp"; }
+        IRLevel getInputLevel() const override { return IRLevel::TACKY; }
+        IRLevel getOutputLevel() const override { return IRLevel::TACKY; }
+        void runOnModule(std::vector<FunctionUnit>& units) const override {
+            std::vector<TackyFunction*> functions;
+            functions.reserve(units.size());
+            for(FunctionUnit& unit: units){
+                functions.push_back(unit.tacky);
+            }
+            TackyInterprocedural::propagateReturns(functions);
+        }
+};
+
+class DeadFunctionsPass : public ModulePass {
+    public:
+        std::string getName() const override { return "dead-functions"; }
+        IRLevel getInputLevel() const override { return IRLevel::TACKY; }
+        IRLevel getOutputLevel() const override { return IRLevel::TACKY; }
+        void runOnModule(std::vector<FunctionUnit>& units) const override {
+            std::vector<TackyFunction*> functions;
+            std::vector<bool> visible;
+            for(FunctionUnit& unit: units){
+                functions.push_back(unit.tacky);
+                visible.push_back(!unit.ast->isInternal());
+            }
+            std::vector<bool> live = TackyInterprocedural::liveFunctions(functions, visible);
+            // the units left are renumbered in source order, the index is the slot of the profile counter
+            std::vector<FunctionUnit> kept;
+            kept.reserve(units.size());
+            for(size_t i = 0; i < units.size(); i++){
+                if(live[i]){
+                    kept.push_back(std::move(units[i]));
+                    kept.back().index = kept.size() - 1;
+                }
+            }
+            units = std::move(kept);
+        }
+};
+
+class LowerPass : public Pass {
+    public:
+        std::string getName() const override { return "lower"; }
+        IRLevel getInputLevel() const override { return IRLevel::TACKY; }
+        IRLevel getOutputLevel() const override { return IRLevel::ASSEMBLY; }
+        void run(FunctionUnit& unit) const override {
+            IRTree lowering{};
+            unit.assembly = lowering.lowerFunction(unit.tacky);
+            unit.assembly->setGlobal(!unit.ast->isInternal());
+        }
+};
+
+class AssignSlotsPass : public Pass {
+    public:
+        std::string getName() const override { return "assign-slots"; }
+        IRLevel getInputLevel() const override { return IRLevel::ASSEMBLY; }
+        IRLevel getOutputLevel() const override { return IRLevel::ASSEMBLY; }
+        void run(FunctionUnit& unit) const override {
+            std::unordered_map<std::string, int> offsets;
+            int currentOffset = -4;
+            IRTree::replacePseudoOperands(unit.assembly, offsets, currentOffset);
+            std::vector<InstructionNode*> instructions = unit.assembly->getInstructions();
+            if(!instructions.empty() && instructions.front()->getType() == ALLOCATE){
+                int bytes = static_cast<AllocateStack*>(instructions.front())->getStackDecrementAmount();
+                unit.frame = FrameSize{bytes, bytes};
+            }
+        }
+};
+
+class ColorSlotsPass : public Pass {
+    public:
+        std::string getName() const override { return "color-slots"; }
+        IRLevel getInputLevel() const override { return IRLevel::ASSEMBLY; }
+        IRLevel getOutputLevel() const override { return IRLevel::ASSEMBLY; }
+        void run(FunctionUnit& unit) const override {
+            unit.frame = StackSlotAllocator::assign(unit.assembly);
+        }
+};
+
+class RegisterAllocationPass : public Pass {
+    public:
+        std::string getName() const override { return "regalloc"; }
+        IRLevel getInputLevel() const override { return IRLevel::ASSEMBLY; }
+        IRLevel getOutputLevel() const override { return IRLevel::ASSEMBLY; }
+        void run(FunctionUnit& unit) const override {
+            RegisterAllocator::allocate(unit.assembly);
+        }
+};
+
+class LegalizePass : public Pass {
+    public:
+        std::string getName() const override { return "legalize"; }
+        IRLevel getInputLevel() const override { return IRLevel::ASSEMBLY; }
+        IRLevel getOutputLevel() const override { return IRLevel::ASSEMBLY; }
+        void run(FunctionUnit& unit) const override {
+            Legalizer::legalize(unit.assembly);
+        }
+};
+
+class PeepholePass : public Pass {
+    public:
+        std::string getName() const override { return "peephole"; }
+        IRLevel getInputLevel() const override { return IRLevel::ASSEMBLY; }
+        IRLevel getOutputLevel() const override { return IRLevel::ASSEMBLY; }
+        void run(FunctionUnit& unit) const override {
+            PeepholeOptimizer::optimize(unit.assembly);
+        }
+};
+
+class InstrumentPass : public Pass {
+    public:
+        std::string getName() const override { return "instrument"; }
+        IRLevel getInputLevel() const override { return IRLevel::ASSEMBLY; }
+        IRLevel getOutputLevel() const override { return IRLevel::ASSEMBLY; }
+        void run(FunctionUnit& unit) const override {
+            std::vector<InstructionNode*> instructions = unit.assembly->getInstructions();
+            // first thing after the prologue, the frame passes only look at a leading AllocateStack
+            size_t position = !instructions.empty() && instructions.front()->getType() == ALLOCATE ? 1 : 0;
+            instructions.insert(instructions.begin() + position, new ProfileCounterInstruction{unit.index});
+            unit.assembly->setInstructions(instructions);
+            unit.profiled = true;
+        }
+};
+
+class FrameLayoutPass : public Pass {
+    public:
+        std::string getName() const override { return "frame"; }
+        IRLevel getInputLevel() const override { return IRLevel::ASSEMBLY; }
+        IRLevel getOutputLevel() const override { return IRLevel::ASSEMBLY; }
+        void run(FunctionUnit& unit) const override {
+            FrameLayout::layout(unit.assembly);
+        }
+};
+
+class PrintAssemblyPass : public Pass {
+    public:
+        std::string getName() const override { return "print-asm"; }
+        IRLevel getInputLevel() const override { return IRLevel::ASSEMBLY; }
+        IRLevel getOutputLevel() const override { return IRLevel::ASSEMBLY; }
+        void run(FunctionUnit& unit) const override {
+            unit.assembly->prettyPrint();
+        }
+};
+
+class EmitPass : public Pass {
+    public:
+        std::string getName() const override { return "emit"; }
+        IRLevel getInputLevel() const override { return IRLevel::ASSEMBLY; }
+        IRLevel getOutputLevel() const override { return IRLevel::TEXT; }
+        void run(FunctionUnit& unit) const override {
+            IRVerifier::verifyNoPseudo(unit.assembly);
+            IRVerifier::verifyLegal(unit.assembly);
+            std::ostringstream assembly;
+            unit.assembly->filePrint(assembly);
+            assembly << '\n';
+            unit.text = assembly.str();
+        }
+};
+
+class EncodePass : public Pass {
+    public:
+        std::string getName() const override { return "encode"; }
+        IRLevel getInputLevel() const override { return IRLevel::ASSEMBLY; }
+        IRLevel getOutputLevel() const override { return IRLevel::OBJECT; }
+        void run(FunctionUnit& unit) const override {
+            IRVerifier::verifyNoPseudo(unit.assembly);
+            IRVerifier::verifyLegal(unit.assembly);
+            unit.code = X86Encoder::encodeFunction(unit.assembly, &unit.callFrame, &unit.relocations, &unit.readOnlyData);
+        }
+};
+
+class DirectEmitPass : public Pass {
+    public:
+        std::string getName() const override { return "direct-emit"; }
+        IRLevel getInputLevel() const override { return IRLevel::AST; }
+        IRLevel getOutputLevel() const override { return IRLevel::TEXT; }
+        void run(FunctionUnit& unit) const override {
+            DirectCodeGenerator::emitFunction(unit.ast, unit.text);
+        }
+};
+
+}
+
+// ======================================================
+//                     ModulePass
+// ======================================================
+void ModulePass::run(FunctionUnit& unit) const{
+    throw std::runtime_error("Module pass " + getName() + " can't run on " + unit.ast->getIdentifer() + " alone");
+}
+
+// ======================================================
+//                     PassManager
+// ======================================================
+PassManager::PassManager():verifyEach(false){
+    registerPass("tacky-gen", [](){ return new TackyGenPass{}; });
+    registerPass("mem2reg", [](){ return new PromotePass{}; });
+    registerPass("simplify", [](){ return new SimplifyPass{}; });
+    registerPass("copy-prop", [](){ return new CopyPropagationPass{}; });
+    registerPass("simplify-cfg", [](){ return new SimplifyCfgPass{}; });
+    registerPass("inline", [](){ return new InlinePass{}; });
+    registerPass("ipcp", [](){ return new ConstantReturnsPass{}; });
+    registerPass("dead-functions", [](){ return new DeadFunctionsPass{}; });
+    registerPass("print-cfg", [](){ return new PrintCfgPass{}; });
+    registerPass("print-tacky", [](){ return new PrintTackyPass{}; });
+    registerPass("lower", [](){ return new LowerPass{}; });
+    registerPass("regalloc", [](){ return new RegisterAllocationPass{}; });
+    registerPass("assign-slots", [](){ return new AssignSlotsPass{}; });
+    registerPass("color-slots", [](){ return new ColorSlotsPass{}; });
+    registerPass("legalize", [](){ return new LegalizePass{}; });
+    registerPass("peephole", [](){ return new PeepholePass{}; });
+    registerPass("instrument", [](){ return new InstrumentPass{}; });
+    registerPass("frame", [](){ return new FrameLayoutPass{}; });
+    registerPass("print-asm", [](){ return new PrintAssemblyPass{}; });
+    registerPass("emit", [](){ return new EmitPass{}; });
+    registerPass("encode", [](){ return new EncodePass{}; });
+    registerPass("direct-emit", [](){ return new DirectEmitPass{}; });
+    setPipeline(defaultPipeline());
+}
+
+void PassManager::registerPass(std::string name, std::function<Pass*()> factory){
+    this->registry[name] = factory;
+}
+
+std::string PassManager::defaultPipeline(){
+    return(pipelineForLevel(1));
+}
+
+std::string PassManager::pipelineForLevel(int level){
+    switch(level){
+        case 0: return("tacky-gen,lower,assign-slots,legalize,frame,emit");
+        case 1: return("tacky-gen,mem2reg,simplify,copy-prop,simplify-cfg,ipcp,dead-functions,lower,color-slots,legalize,peephole,frame,emit");
+        default: return("tacky-gen,mem2reg,simplify,copy-prop,simplify-cfg,ipcp,inline,simplify,copy-prop,simplify-cfg,dead-functions,lower,regalloc,color-slots,legalize,peephole,frame,emit");
+    }
+}
+
+std::string PassManager::objectPipeline(const std::string& pipeline){
+    const std::string emit = "emit";
+    if(pipeline != emit && (pipeline.size() < emit.size() + 1 || pipeline.compare(pipeline.size() - emit.size() - 1, std::string::npos, "," + emit) != 0)){
+        throw std::runtime_error("-c and --jit need a pipeline ending with emit (" + pipeline + " doesn't), the encoder works on the assembly tree");
+    }
+    return(pipeline.substr(0, pipeline.size() - emit.size()) + "encode");
+}
+
+std::string PassManager::instrumentedPipeline(const std::string& pipeline){
+    std::vector<std::string> names;
+    std::stringstream list{pipeline};
+    std::string name;
+    while(std::getline(list, name, ',')){
+        if(name == "direct-emit"){
+            throw std::runtime_error("-fprofile-generate needs the assembly tree, it can't be used with -fast");
+        }
+        if(!name.empty()){
+            names.push_back(name);
+        }
+    }
+    size_t position = 0;
+    while(position < names.size() && names[position] != "frame" && names[position] != "emit" && names[position] != "encode"){
+        position++;
+    }
+    names.insert(names.begin() + position, "instrument");
+    std::string instrumented;
+    for(const std::string& pass: names){
+        instrumented += (instrumented.empty() ? "" : ",") + pass;
+    }
+    return(instrumented);
+}
+
+void PassManager::setPipeline(std::string passes){
+    std::vector<std::unique_ptr<Pass>> newPipeline;
+    IRLevel level = IRLevel::AST;
+    std::stringstream list{passes};
+    std::string name;
+    while(std::getline(list, name, ',')){
+        if(name.empty()){
+            continue;
+        }
+        auto found = this->registry.find(name);
+        if(found == this->registry.end()){
+            std::string known;
+            for(auto& entry: this->registry){
+                known += " " + entry.first;
+            }
+            throw std::runtime_error("Unknown pass: " + name + ". Known passes:" + known);
+        }
+        std::unique_ptr<Pass> pass{found->second()};
+        if(pass->getInputLevel() != level){
+            throw std::runtime_error("Pass " + name + " expects " + ir_level_to_string(pass->getInputLevel())
+                + " but the pipeline is at " + ir_level_to_string(level));
+        }
+        level = pass->getOutputLevel();
+        newPipeline.push_back(std::move(pass));
+    }
+    if(level != IRLevel::TEXT && level != IRLevel::OBJECT){
+        throw std::runtime_error("Pipeline ends at " + ir_level_to_string(level) + ", it has to end with emit or encode");
+    }
+    this->pipeline = std::move(newPipeline);
+}
+
+void PassManager::setVerifyEach(bool enable){
+    this->verifyEach = enable;
+}
+
+bool PassManager::isModulePass(size_t index) const{
+    return(this->pipeline[index]->isModulePass());
+}
+
+size_t PassManager::getPipelineLength() const{
+    return(this->pipeline.size());
+}
+
+uint64_t PassManager::sizeOf(const FunctionUnit& unit, IRLevel level){
+    switch(level){
+        case IRLevel::AST: return 0;
+        case IRLevel::TACKY: return unit.tacky->getBody().size();
+        case IRLevel::ASSEMBLY: return unit.assembly->getInstructions().size();
+        case IRLevel::TEXT: return unit.text.size();
+        case IRLevel::OBJECT: return unit.code.size();
+    }
+    return 0;
+}
+
+void PassManager::verify(const Pass& pass, FunctionUnit& unit, bool legalized){
+    try{
+        if(pass.getOutputLevel() == IRLevel::TACKY){
+            IRVerifier::verifyTacky(unit.tacky);
+        }else if(pass.getOutputLevel() == IRLevel::ASSEMBLY){
+            IRVerifier::verifyAssembly(unit.assembly);
+            if(legalized){
+                IRVerifier::verifyLegal(unit.assembly);
+            }
+        }
+    }catch(const std::exception& e){
+        throw std::runtime_error("Verification failed after pass " + pass.getName()
+            + " in function " + unit.ast->getIdentifer() + ": " + e.what());
+    }
+}
+
+void PassManager::runOnFunction(FunctionUnit& unit, std::vector<PassStatistics>& statistics) const{
+    runOnFunction(unit, statistics, 0, this->pipeline.size());
+}
+
+void PassManager::runOnFunction(FunctionUnit& unit, std::vector<PassStatistics>& statistics, size_t begin, size_t end) const{
+    statistics.resize(this->pipeline.size());
+    // every pass after legalize has to keep the instructions encodable
+    bool legalized = false;
+    for(size_t i = 0; i < begin; i++){
+        legalized = legalized || this->pipeline[i]->getName() == "legalize";
+    }
+    for(size_t i = begin; i < end; i++){
+        const Pass& pass = *this->pipeline[i];
+        PassStatistics& stats = statistics[i];
+        stats.sizeBefore += sizeOf(unit, pass.getInputLevel());
+
+        auto start = std::chrono::steady_clock::now();
+        pass.run(unit);
+        auto finish = std::chrono::steady_clock::now();
+
+        stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count();
+        stats.sizeAfter += sizeOf(unit, pass.getOutputLevel());
+        stats.functions++;
+        legalized = legalized || pass.getName() == "legalize";
+
+        if(this->verifyEach){
+            verify(pass, unit, legalized);
+        }
+    }
+}
+
+void PassManager::runOnModule(std::vector<FunctionUnit>& units, std::vector<PassStatistics>& statistics, size_t index) const{
+    statistics.resize(this->pipeline.size());
+    const Pass& pass = *this->pipeline[index];
+    PassStatistics& stats = statistics[index];
+    bool legalized = false;
+    for(size_t i = 0; i <= index; i++){
+        legalized = legalized || this->pipeline[i]->getName() == "legalize";
+    }
+    for(const FunctionUnit& unit: units){
+        stats.sizeBefore += sizeOf(unit, pass.getInputLevel());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pass.runOnModule(units);
+    auto finish = std::chrono::steady_clock::now();
+
+    stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count();
+    for(FunctionUnit& unit: units){
+        stats.sizeAfter += sizeOf(unit, pass.getOutputLevel());
+        stats.functions++;
+        if(this->verifyEach){
+            verify(pass, unit, legalized);
+        }
+    }
+}
+
+void PassManager::printReport(const std::vector<PassStatistics>& statistics, std::ostream& out) const{
+    uint64_t total = 0;
+    for(const PassStatistics& stats: statistics){
+        total += stats.nanoseconds;
+    }
+    out << "===-------------------------------------------------------------===\n";
+    out << "                      Pass execution report\n";
+    out << "===-------------------------------------------------------------===\n";
+    out << std::left << std::setw(16) << "pass" << std::right
+        << std::setw(12) << "time(ms)" << std::setw(8) << "%"
+        << std::setw(12) << "size in" << std::setw(12) << "size out" << std::setw(10) << "delta" << '\n';
+    for(size_t i = 0; i < this->pipeline.size() && i < statistics.size(); i++){
+        const Pass& pass = *this->pipeline[i];
+        const PassStatistics& stats = statistics[i];
+        double percent = total == 0 ? 0.0 : 100.0 * stats.nanoseconds / total;
+        out << std::left << std::setw(16) << pass.getName() << std::right
+            << std::setw(12) << std::fixed << std::setprecision(3) << stats.nanoseconds / 1e6
+            << std::setw(8) << std::setprecision(1) << percent
+            << std::setw(12) << stats.sizeBefore << std::setw(12) << stats.sizeAfter;
+        // the size of two different IRs can't be compared
+        if(pass.getInputLevel() == pass.getOutputLevel()){
+            out << std::setw(10) << (static_cast<int64_t>(stats.sizeAfter) - static_cast<int64_t>(stats.sizeBefore));
+        }else{
+            out << std::setw(10) << "-";
+        }
+        out << '\n';
+    }
+    out << std::left << std::setw(16) << "total" << std::right
+        << std::setw(12) << std::fixed << std::setprecision(3) << total / 1e6 << '\n';
+}
+
+void PassManager::printFrameReport(const std::vector<FunctionUnit>& units, std::ostream& out){
+    int64_t before = 0, after = 0;
+    out << "===-------------------------------------------------------------===\n";
+    out << "                      Frame size report\n";
+    out << "===-------------------------------------------------------------===\n";
+    out << std::left << std::setw(32) << "function" << std::right << std::setw(12) << "before" << std::setw(12) << "after" << '\n';
+    for(const FunctionUnit& unit: units){
+        out << std::left << std::setw(32) << unit.ast->getIdentifer() << std::right
+            << std::setw(12) << unit.frame.before << std::setw(12) << unit.frame.after << '\n';
+        before += unit.frame.before;
+        after += unit.frame.after;
+    }
+    out << std::left << std::setw(32) << "total" << std::right << std::setw(12) << before << std::setw(12) << after << '\n';
+}
+
+// ======================================================
+//                     IRVerifier
+// ======================================================
+void IRVerifier::verifyTacky(TackyFunction* function){
+    std::unordered_set<std::string> defined;
+    auto checkRead = [&defined](TackyVal* val){
+        if(val == nullptr){
+            throw std::runtime_error("instruction reads a null value");
+        }
+        if(TackyVariable* var = dynamic_cast<TackyVariable*>(val)){
+            std::string name = var->getVariableIdentifier();
+            if(TackySimplifier::isTemporary(name) && defined.find(name) == defined.end()){
+                throw std::runtime_error("temporary " + name + " is read before it is defined");
+            }
+        }
+    };
+    auto checkWrite = [&defined](TackyVal* val){
+        TackyVariable* var = dynamic_cast<TackyVariable*>(val);
+        if(var == nullptr){
+            throw std::runtime_error("instruction writes to something other than a variable");
+        }
+        defined.insert(var->getVariableIdentifier());
+    };
+    for(TackyInstruction* instr: function->getBody()){
+        if(instr == nullptr){
+            throw std::runtime_error("null instruction");
+        }
+        if(TackyJumpIfZero* branch = dynamic_cast<TackyJumpIfZero*>(instr)){
+            checkRead(branch->getCondition());
+        }else if(TackySwitch* dispatch = dynamic_cast<TackySwitch*>(instr)){
+            checkRead(dispatch->getValue());
+        }
+        if(TackyReturn* ret = dynamic_cast<TackyReturn*>(instr)){
+            checkRead(ret->getVar());
+        }else if(TackyUnary* unary = dynamic_cast<TackyUnary*>(instr)){
+            checkRead(unary->getSrc());
+            checkWrite(unary->getDst());
+        }else if(TackyCopy* copy = dynamic_cast<TackyCopy*>(instr)){
+            checkRead(copy->getSrc());
+            checkWrite(copy->getDst());
+        }else if(TackyBinary* binary = dynamic_cast<TackyBinary*>(instr)){
+            BinaryOperator op = binary->getBinaryOperator();
+            if(op == BinaryOperator::Comma || op == BinaryOperator::LogicalAnd || op == BinaryOperator::LogicalOr){
+                throw std::runtime_error("binary instruction " + binary_operator_to_string(op) + ", which decides what is evaluated");
+            }
+            checkRead(binary->getSrc1());
+            checkRead(binary->getSrc2());
+            checkWrite(binary->getDst());
+        }else if(TackyFunctionCall* call = dynamic_cast<TackyFunctionCall*>(instr)){
+            for(TackyVal* arg: call->getArgs()){
+                checkRead(arg);
+            }
+            checkWrite(call->getDst());
+        }
+    }
+    // every jump has its label, each label is defined once and the last block can't fall off the end. Jumps only
+    // go forward, which the phi copies of mem2reg and the checks above rely on
+    ControlFlowGraph cfg{function->getBody()};
+    for(size_t b = 0; b < cfg.size(); b++){
+        for(uint32_t successor: cfg.successors(b)){
+            if(successor <= b){
+                throw std::runtime_error("block " + std::to_string(b) + " jumps back to block " + std::to_string(successor));
+            }
+        }
+    }
+    if(cfg.size() > 0){
+        const ControlFlowGraph::Block& last = cfg.getBlock(cfg.size() - 1);
+        TackyInstruction* end = function->getBody()[last.end - 1];
+        if(dynamic_cast<TackyReturn*>(end) == nullptr && dynamic_cast<TackyJump*>(end) == nullptr){
+            throw std::runtime_error("the last block falls off the end of the function");
+        }
+    }
+}
+
+void IRVerifier::verifyAssembly(IRFunctionNode* function){
+    std::vector<InstructionNode*> instructions = function->getInstructions();
+    for(InstructionNode* instr: instructions){
+        if(instr == nullptr){
+            throw std::runtime_error("null instruction");
+        }
+        if(MoveInstruction* mov = dynamic_cast<MoveInstruction*>(instr)){
+            if(mov->getSrc() == nullptr || mov->getDst() == nullptr){
+                throw std::runtime_error("movl with a null operand");
+            }
+            if(mov->getDst()->getType() == IMM){
+                throw std::runtime_error("movl into an immediate");
+            }
+        }else if(UnaryInstruction* unary = dynamic_cast<UnaryInstruction*>(instr)){
+            if(unary->getOperand() == nullptr || unary->getOperand()->getType() == IMM){
+                throw std::runtime_error("unary instruction on a null or immediate operand");
+            }
+        }else if(BinaryInstruction* binary = dynamic_cast<BinaryInstruction*>(instr)){
+            if(binary->getSrc() == nullptr || binary->getDst() == nullptr){
+                throw std::runtime_error("binary instruction with a null operand");
+            }
+            if(binary->getDst()->getType() == IMM){
+                throw std::runtime_error("binary instruction into an immediate");
+            }
+            BinaryOperator op = binary->getBinaryOperator();
+            if(op == BinaryOperator::Divide || op == BinaryOperator::Remainder){
+                throw std::runtime_error("binary instruction dividing, idivl is an instruction of its own");
+            }
+            if(op == BinaryOperator::LeftShift || op == BinaryOperator::RightShift || op == BinaryOperator::LogicalRightShift){
+                RegisterNode* count = dynamic_cast<RegisterNode*>(binary->getSrc());
+                if(binary->getSrc()->getType() != IMM && (count == nullptr || count->getRegEnum() != RegisterName::CX)){
+                    throw std::runtime_error("shift by a count that is neither an immediate nor %cl");
+                }
+            }
+            if(op != BinaryOperator::Add && op != BinaryOperator::Subtract && op != BinaryOperator::Multiply
+                && op != BinaryOperator::BitwiseAnd && op != BinaryOperator::BitwiseOr && op != BinaryOperator::BitwiseXor
+                && op != BinaryOperator::LeftShift && op != BinaryOperator::RightShift && op != BinaryOperator::LogicalRightShift){
+                throw std::runtime_error("binary instruction with an operator x86 has no instruction for: " + binary_operator_to_string(op));
+            }
+        }else if(IdivInstruction* idiv = dynamic_cast<IdivInstruction*>(instr)){
+            if(idiv->getOperand() == nullptr || idiv->getOperand()->getType() == IMM){
+                throw std::runtime_error("idivl by a null or immediate operand");
+            }
+        }else if(MultiplyHighInstruction* multiply = dynamic_cast<MultiplyHighInstruction*>(instr)){
+            if(multiply->getSrc() == nullptr || multiply->getDst() == nullptr){
+                throw std::runtime_error("multiply high with a null register");
+            }
+            if(multiply->getShift() < 0 || multiply->getShift() > 31){
+                throw std::runtime_error("multiply high shifting by more than 63");
+            }
+        }else if(LeaInstruction* lea = dynamic_cast<LeaInstruction*>(instr)){
+            if(lea->getBase() == nullptr || lea->getDst() == nullptr){
+                throw std::runtime_error("leal with a null register");
+            }
+            int scale = lea->getScale();
+            if(scale != 1 && scale != 2 && scale != 4 && scale != 8){
+                throw std::runtime_error("leal with a scale other than 1, 2, 4 or 8");
+            }
+        }else if(CompareInstruction* compare = dynamic_cast<CompareInstruction*>(instr)){
+            if(compare->getSrc() == nullptr || compare->getDst() == nullptr){
+                throw std::runtime_error("cmpl with a null operand");
+            }
+            if(compare->getDst()->getType() == IMM){
+                throw std::runtime_error("cmpl with an immediate as its second operand");
+            }
+        }else if(ConditionalMoveInstruction* cmov = dynamic_cast<ConditionalMoveInstruction*>(instr)){
+            if(cmov->getSrc() == nullptr || cmov->getDst() == nullptr || cmov->getSrc()->getType() == IMM){
+                throw std::runtime_error("cmov with a null or immediate operand");
+            }
+        }
+    }
+    std::unordered_set<std::string> labels;
+    for(InstructionNode* instr: instructions){
+        if(instr->getType() == LABEL && !labels.insert(static_cast<LabelInstruction*>(instr)->getName()).second){
+            throw std::runtime_error("label " + static_cast<LabelInstruction*>(instr)->getName() + " is defined twice");
+        }
+    }
+    for(InstructionNode* instr: instructions){
+        std::string target;
+        if(instr->getType() == JMP){
+            target = static_cast<JumpInstruction*>(instr)->getTarget();
+        }else if(instr->getType() == JMPCC){
+            target = static_cast<ConditionalJumpInstruction*>(instr)->getTarget();
+        }else if(instr->getType() == JMPTABLE){
+            JumpTableInstruction* dispatch = static_cast<JumpTableInstruction*>(instr);
+            target = dispatch->getBase();
+            for(const std::string& entry: dispatch->getTargets()){
+                if(labels.find(entry) == labels.end()){
+                    throw std::runtime_error("jump table entry to undefined label " + entry);
+                }
+            }
+        }else{
+            continue;
+        }
+        if(labels.find(target) == labels.end()){
+            throw std::runtime_error("jump to undefined label " + target);
+        }
+    }
+    for(size_t i = 1; i < instructions.size(); i++){
+        if(instructions[i]->getType() == ALLOCATE){
+            throw std::runtime_error("AllocateStack in the middle of the function");
+        }
+    }
+}
+
+void IRVerifier::verifyLegal(IRFunctionNode* function){
+    auto checkImmediate = [](OperandNode* op){
+        if(op->getType() == IMM){
+            std::string value = static_cast<ImmediateNode*>(op)->getImm();
+            if(std::to_string(TackySimplifier::wrapConstant(value)) != value){
+                throw std::runtime_error("immediate " + value + " does not fit in 32 bits");
+            }
+        }
+    };
+    for(InstructionNode* instr: function->getInstructions()){
+        if(instr->getType() == MOV){
+            MoveInstruction* mov = static_cast<MoveInstruction*>(instr);
+            if(is_memory_operand(mov->getSrc()) && is_memory_operand(mov->getDst())){
+                throw std::runtime_error("movl from memory to memory in function " + function->getIdentifier()
+                    + ", the pipeline is missing legalize");
+            }
+            checkImmediate(mov->getSrc());
+        }else if(instr->getType() == BINARY){
+            BinaryInstruction* binary = static_cast<BinaryInstruction*>(instr);
+            if(is_memory_operand(binary->getSrc()) && is_memory_operand(binary->getDst())){
+                throw std::runtime_error("binary instruction from memory to memory in function " + function->getIdentifier()
+                    + ", the pipeline is missing legalize");
+            }
+            if(binary->getBinaryOperator() == BinaryOperator::Multiply && is_memory_operand(binary->getDst())){
+                throw std::runtime_error("imull into memory in function " + function->getIdentifier());
+            }
+            checkImmediate(binary->getSrc());
+        }else if(instr->getType() == CMP){
+            CompareInstruction* compare = static_cast<CompareInstruction*>(instr);
+            if(is_memory_operand(compare->getSrc()) && is_memory_operand(compare->getDst())){
+                throw std::runtime_error("cmpl from memory to memory in function " + function->getIdentifier()
+                    + ", the pipeline is missing legalize");
+            }
+            checkImmediate(compare->getSrc());
+        }
+    }
+}
+
+void IRVerifier::verifyNoPseudo(IRFunctionNode* function){
+    for(InstructionNode* instr: function->getInstructions()){
+        std::vector<OperandNode*> reads, writes;
+        instruction_operands(instr, reads, writes);
+        reads.insert(reads.end(), writes.begin(), writes.end());
+        for(OperandNode* op: reads){
+            if(Pseudo* pseudo = dynamic_cast<Pseudo*>(op)){
+                throw std::runtime_error("Pseudo " + pseudo->getIdentifier() + " of function " + function->getIdentifier()
+                    + " was never assigned a location, the pipeline is missing assign-slots");
+            }
+        }
+    }
+}
@@ -0,0 +1,343 @@
+#ifndef PASSMANAGER_HPP
+#define PASSMANAGER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AST.hpp"
+#include "Tacky.hpp"
+#include "Assembly.hpp"
+#include "StackSlots.hpp"
+#include "X86Encoder.hpp"
+
+// ======================================================
+//                     Enums
+// ======================================================
+/**
+ * @brief The representation a function is in at a given point of the pipeline
+ *
+ */
+enum class IRLevel { AST, TACKY, ASSEMBLY, TEXT, OBJECT };
+std::string ir_level_to_string(IRLevel level);
+
+// ======================================================
+//                     FunctionUnit
+// ======================================================
+/**
+ * @brief A single function travelling through the pipeline. Every pass reads the representation
+ * of its input level and leaves behind the one of its output level.
+ *
+ */
+struct FunctionUnit {
+    /**
+     * @brief Position of the function in the source file
+     *
+     */
+    size_t index = 0;
+    FunctionNode* ast = nullptr;
+    TackyFunction* tacky = nullptr;
+    IRFunctionNode* assembly = nullptr;
+    /**
+     * @brief The emitted assembly for the function
+     *
+     */
+    std::string text;
+    /**
+     * @brief The machine code of the function (-c)
+     *
+     */
+    std::vector<uint8_t> code;
+    /**
+     * @brief The DWARF call frame instructions of the function's FDE (-c)
+     *
+     */
+    std::vector<uint8_t> callFrame;
+    /**
+     * @brief The fields of the machine code left to the linker, offsets from the start of the function (-c)
+     *
+     */
+    std::vector<CodeRelocation> relocations;
+    /**
+     * @brief The jump tables of the function, relocations against X86Encoder::READ_ONLY_SECTION are offsets
+     * into them (-c)
+     *
+     */
+    std::vector<uint8_t> readOnlyData;
+    /**
+     * @brief Set by the instrument pass, the function counts its calls in the counter at its index
+     *
+     */
+    bool profiled = false;
+    /**
+     * @brief Set by FunctionLayout on a function the profile never saw running, emitted in .text.unlikely
+     *
+     */
+    bool cold = false;
+    /**
+     * @brief Size of the stack slots, set by assign-slots and color-slots (-frame-report)
+     *
+     */
+    FrameSize frame;
+    /**
+     * @brief Name of the earlier function with the same body this one is an alias of (see CodeFolding.hpp),
+     * empty when the function keeps its own body
+     *
+     */
+    std::string foldedInto;
+};
+
+// ======================================================
+//                     Pass(Base)
+// ======================================================
+/**
+ * @brief Base class for every pass. Passes are shared by all the threads of the backend
+ * so run() must not modify the pass itself.
+ *
+ */
+class Pass {
+    public:
+        virtual ~Pass(){}
+        virtual std::string getName() const = 0;
+        virtual IRLevel getInputLevel() const = 0;
+        virtual IRLevel getOutputLevel() const = 0;
+        virtual void run(FunctionUnit& unit) const = 0;
+        /**
+         * @brief A module pass runs once on every function of the program together (runOnModule) instead of
+         * on each function by itself, the backend waits for every function to reach it
+         *
+         * @return bool
+         */
+        virtual bool isModulePass() const { return(false); }
+        virtual void runOnModule(std::vector<FunctionUnit>& units) const {
+            for(FunctionUnit& unit: units){
+                run(unit);
+            }
+        }
+};
+
+// ======================================================
+//                     ModulePass : Pass
+// ======================================================
+/**
+ * @brief Base class for the passes that need the whole program (i.e to inline a function into its callers).
+ * They run on the thread of the backend, between two parallel parts of the pipeline.
+ *
+ */
+class ModulePass : public Pass {
+    public:
+        bool isModulePass() const override { return(true); }
+        /**
+         * @brief Throws, a module pass only runs on the whole program
+         *
+         * @param unit
+         */
+        void run(FunctionUnit& unit) const override;
+        void runOnModule(std::vector<FunctionUnit>& units) const override = 0;
+};
+
+// ======================================================
+//                     PassStatistics
+// ======================================================
+/**
+ * @brief What a pass cost and what it did, summed over every function it ran on
+ *
+ */
+struct PassStatistics {
+    uint64_t nanoseconds = 0;
+    /**
+     * @brief Number of instructions (bytes of text for the TEXT level) before and after the pass
+     *
+     */
+    uint64_t sizeBefore = 0;
+    uint64_t sizeAfter = 0;
+    uint64_t functions = 0;
+};
+
+// ======================================================
+//                     PassManager
+// ======================================================
+/**
+ * @brief Keeps a registry of named passes and runs a pipeline of them on each function.
+ *
+ * A pipeline is written as a comma separated list of pass names (i.e "tacky-gen,simplify,lower,assign-slots,emit").
+ * It has to start at the AST and end at the TEXT (or OBJECT with -c) level, and the input level of each pass must match the output
+ * level of the previous one. The registered passes are:
+ *      tacky-gen       AST      -> TACKY      TackyGenerator
+ *      mem2reg         TACKY    -> TACKY      TackyPromoter, turns the locals into SSA temporaries
+ *      simplify        TACKY    -> TACKY      TackySimplifier
+ *      copy-prop       TACKY    -> TACKY      TackyCopyPropagator
+ *      simplify-cfg    TACKY    -> TACKY      TackyCfgSimplifier, folds constant branches and drops unreachable blocks
+ *      inline          TACKY    -> TACKY      TackyInliner (module pass), copies small leaf functions into their callers
+ *      ipcp            TACKY    -> TACKY      TackyInterprocedural (module pass), folds the calls to functions returning a constant
+ *      dead-functions  TACKY    -> TACKY      TackyInterprocedural (module pass), drops the static functions no visible one reaches
+ *      print-cfg       TACKY    -> TACKY      prints the basic blocks and their edges (use with -j1)
+ *      print-tacky     TACKY    -> TACKY      prints the TAC (use with -j1)
+ *      lower           TACKY    -> ASSEMBLY   IRTree::lowerFunction, instructions picked by InstructionSelector (tree tiling)
+ *      regalloc        ASSEMBLY -> ASSEMBLY   RegisterAllocator, Pseudos that fit go in registers
+ *      assign-slots    ASSEMBLY -> ASSEMBLY   replaces the remaining Pseudos with stack slots, one per Pseudo
+ *      color-slots     ASSEMBLY -> ASSEMBLY   StackSlotAllocator, same but Pseudos that are never live together share a slot
+ *      legalize        ASSEMBLY -> ASSEMBLY   Legalizer, fixes the instructions that can't be encoded (memory to memory)
+ *      peephole        ASSEMBLY -> ASSEMBLY   PeepholeOptimizer
+ *      instrument      ASSEMBLY -> ASSEMBLY   counts the calls of the function in the profile counters (see Profile.hpp)
+ *      frame           ASSEMBLY -> ASSEMBLY   FrameLayout, drops the frame of leaf functions that fit in the red zone
+ *      print-asm       ASSEMBLY -> ASSEMBLY   prints the assembly tree (use with -j1)
+ *      emit            ASSEMBLY -> TEXT       IRFunctionNode::filePrint
+ *      encode          ASSEMBLY -> OBJECT     X86Encoder, replaces emit with -c
+ *      direct-emit     AST      -> TEXT       DirectCodeGenerator, skips the TAC and the assembly tree
+ *
+ * Optimization levels (pipelineForLevel):
+ *      -O0  tacky-gen,lower,assign-slots,legalize,frame,emit
+ *           The TAC goes straight to assembly, every variable left after instruction selection gets its own
+ *           stack slot and each local is loaded and stored at every use. Fastest to compile, meant for CI smoke builds.
+ *      -O1  tacky-gen,mem2reg,simplify,copy-prop,simplify-cfg,ipcp,dead-functions,lower,color-slots,legalize,peephole,frame,emit
+ *           (the default)
+ *           Locals become SSA temporaries, unary chains are folded, copies propagated, branches on constants
+ *           resolved, constant return values passed on to the callers, static functions no one calls dropped and
+ *           the moves through %r10d cleaned up. Costs little more than -O0 because the TAC it lowers
+ *           is much smaller.
+ *      -O2  -O1 plus inline,simplify,copy-prop,simplify-cfg after ipcp (dead-functions comes after them, to drop the
+ *           functions inlined everywhere) and regalloc before color-slots
+ *           Small leaf functions are copied into their callers and the copies folded with the arguments.
+ *           Temporaries, and so the promoted locals, live in registers and the values never go through the
+ *           stack. For release builds.
+ * Inlining is left out of -O1: with nothing to inline, the inline pass and the second round of simplification
+ * still cost compile time.
+ */
+class PassManager {
+    private:
+        std::map<std::string, std::function<Pass*()>> registry;
+        std::vector<std::unique_ptr<Pass>> pipeline;
+        bool verifyEach;
+        static uint64_t sizeOf(const FunctionUnit& unit, IRLevel level);
+        /**
+         * @brief Runs the IR verifier on the output of the pass (-verify-each)
+         *
+         * @param pass
+         * @param unit
+         * @param legalized a legalize pass ran before, the instructions must stay encodable
+         */
+        static void verify(const Pass& pass, FunctionUnit& unit, bool legalized);
+    public:
+        PassManager();
+        /**
+         * @brief Makes a pass available to pipelines under its name
+         *
+         * @param name
+         * @param factory creates a new instance of the pass
+         */
+        void registerPass(std::string name, std::function<Pass*()> factory);
+        /**
+         * @brief Replaces the pipeline with the passes listed in the string. Throws if a name is unknown
+         * or the levels of consecutive passes don't match.
+         *
+         * @param passes comma separated pass names
+         */
+        void setPipeline(std::string passes);
+        /**
+         * @brief The pipeline the compiler runs when none is given
+         *
+         * @return std::string
+         */
+        static std::string defaultPipeline();
+        /**
+         * @brief The pipeline of an optimization level (0, 1 or 2, anything above 2 is treated as 2)
+         *
+         * @param level
+         * @return std::string
+         */
+        static std::string pipelineForLevel(int level);
+        /**
+         * @brief Turns a pipeline ending with emit into the one producing machine code (-c)
+         *
+         * @param pipeline
+         * @return std::string
+         */
+        static std::string objectPipeline(const std::string& pipeline);
+        /**
+         * @brief Adds instrument to a pipeline, before frame or else right before emit/encode (-fprofile-generate).
+         * Throws for direct-emit, which has no assembly tree to instrument.
+         *
+         * @param pipeline
+         * @return std::string
+         */
+        static std::string instrumentedPipeline(const std::string& pipeline);
+        /**
+         * @brief Run the IR verifier after every pass
+         *
+         * @param enable
+         */
+        void setVerifyEach(bool enable);
+        /**
+         * @brief Runs the pipeline on one function. Safe to call from several threads at once
+         * as long as each call gets its own unit and statistics.
+         *
+         * @param unit
+         * @param statistics one entry per pass of the pipeline, accumulated into
+         */
+        void runOnFunction(FunctionUnit& unit, std::vector<PassStatistics>& statistics) const;
+        /**
+         * @brief Same, for the passes [begin, end) of the pipeline only, none of which may be a module pass
+         *
+         * @param unit
+         * @param statistics
+         * @param begin
+         * @param end
+         */
+        void runOnFunction(FunctionUnit& unit, std::vector<PassStatistics>& statistics, size_t begin, size_t end) const;
+        /**
+         * @brief Runs the module pass at the given position of the pipeline on every function
+         *
+         * @param units every function, all of them at the input level of the pass
+         * @param statistics one entry per pass of the pipeline, accumulated into
+         * @param index
+         */
+        void runOnModule(std::vector<FunctionUnit>& units, std::vector<PassStatistics>& statistics, size_t index) const;
+        bool isModulePass(size_t index) const;
+        size_t getPipelineLength() const;
+        /**
+         * @brief Prints the time and the instruction count change of every pass
+         *
+         * @param statistics
+         * @param out
+         */
+        void printReport(const std::vector<PassStatistics>& statistics, std::ostream& out) const;
+        /**
+         * @brief Prints the stack slot bytes of every function before and after slot sharing (-frame-report)
+         *
+         * @param units
+         * @param out
+         */
+        static void printFrameReport(const std::vector<FunctionUnit>& units, std::ostream& out);
+};
+
+// ======================================================
+//                     IRVerifier
+// ======================================================
+/**
+ * @brief Cheap structural checks of the IR. Each function throws a std::runtime_error describing
+ * the first problem found.
+ *
+ */
+class IRVerifier {
+    public:
+        static void verifyTacky(TackyFunction* function);
+        static void verifyAssembly(IRFunctionNode* function);
+        /**
+         * @brief Checks that every instruction can be encoded (no memory to memory operands, 32 bit immediates),
+         * which holds from the legalize pass on
+         *
+         * @param function
+         */
+        static void verifyLegal(IRFunctionNode* function);
+        /**
+         * @brief Checks that every Pseudo was replaced, which has to hold before the function is emitted
+         *
+         * @param function
+         */
+        static void verifyNoPseudo(IRFunctionNode* function);
+};
+
+#endif // PASSMANAGER_HPP
@@ -0,0 +1,153 @@
+#include "Peephole.hpp"
+
+// ======================================================
+//                     PeepholeOptimizer
+// ======================================================
+PeepholeOptimizer::InstructionList::InstructionList(const std::vector<InstructionNode*>& instructions)
+    : instructions(instructions), next(instructions.size()), previous(instructions.size()){
+    for(size_t i = 0; i < instructions.size(); i++){
+        this->next[i] = i + 1;
+        this->previous[i] = i == 0 ? npos : i - 1;
+    }
+}
+
+void PeepholeOptimizer::InstructionList::remove(size_t index){
+    // the links of the removed entry are kept, the caller steps back or forward from it
+    this->instructions[index] = nullptr;
+    if(this->previous[index] != npos){
+        this->next[this->previous[index]] = this->next[index];
+    }
+    if(this->next[index] < this->instructions.size()){
+        this->previous[this->next[index]] = this->previous[index];
+    }
+}
+
+InstructionNode* PeepholeOptimizer::InstructionList::after(size_t index) const{
+    size_t i = this->next[index];
+    return(i < this->instructions.size() ? this->instructions[i] : nullptr);
+}
+
+std::vector<InstructionNode*> PeepholeOptimizer::InstructionList::compact() const{
+    std::vector<InstructionNode*> live;
+    live.reserve(this->instructions.size());
+    for(InstructionNode* instr: this->instructions){
+        if(instr != nullptr){
+            live.push_back(instr);
+        }
+    }
+    return(live);
+}
+
+bool PeepholeOptimizer::isDeadAfter(const InstructionList& list, size_t index, OperandNode* op){
+    std::vector<OperandNode*> reads, writes;
+    for(size_t i = list.next[index]; i < list.instructions.size(); i = list.next[i]){
+        reads.clear();
+        writes.clear();
+        instruction_operands(list.instructions[i], reads, writes);
+        for(OperandNode* read: reads){
+            if(operands_equal(read, op)){
+                return(false);
+            }
+        }
+        for(OperandNode* write: writes){
+            if(operands_equal(write, op)){
+                return(true);
+            }
+        }
+        if(list.instructions[i]->getType() == RET){
+            // only %eax (reported as read above) survives the return
+            return(true);
+        }
+        InstructionType type = list.instructions[i]->getType();
+        if(type == JMP || type == JMPCC || type == JMPTABLE || type == LABEL){
+            // the block ends, the value may be read on another path
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool PeepholeOptimizer::rewrite(InstructionList& list, size_t index){
+    InstructionNode* first = list.instructions[index];
+    InstructionNode* second = list.after(index);
+    size_t secondIndex = list.next[index];
+    InstructionNode* third = second != nullptr ? list.after(secondIndex) : nullptr;
+    size_t thirdIndex = second != nullptr ? list.next[secondIndex] : list.instructions.size();
+
+    MoveInstruction* mov = dynamic_cast<MoveInstruction*>(first);
+    if(mov != nullptr && operands_equal(mov->getSrc(), mov->getDst())){
+        list.remove(index);
+        return(true);
+    }
+
+    if(mov != nullptr && second != nullptr){
+        OperandNode* src = mov->getSrc();
+        OperandNode* tmp = mov->getDst();
+        // movl S, T; movl T, D => movl S, D
+        MoveInstruction* next = dynamic_cast<MoveInstruction*>(second);
+        if(next != nullptr && operands_equal(next->getSrc(), tmp) && !operands_equal(next->getDst(), tmp)
+            && !(is_memory_operand(src) && is_memory_operand(next->getDst()))
+            && isDeadAfter(list, secondIndex, tmp)){
+            mov->setDst(next->getDst());
+            list.remove(secondIndex);
+            return(true);
+        }
+        // movl S, T; op T; movl T, D => movl S, D; op D
+        UnaryInstruction* unary = dynamic_cast<UnaryInstruction*>(second);
+        MoveInstruction* store = dynamic_cast<MoveInstruction*>(third);
+        if(unary != nullptr && store != nullptr && operands_equal(unary->getOperand(), tmp)
+            && operands_equal(store->getSrc(), tmp) && !operands_equal(store->getDst(), tmp)
+            && !(is_memory_operand(src) && is_memory_operand(store->getDst()))
+            && isDeadAfter(list, thirdIndex, tmp)){
+            mov->setDst(store->getDst());
+            unary->setOperand(store->getDst());
+            list.remove(thirdIndex);
+            return(true);
+        }
+        // movl %a, %t; leal k(%t), %t => leal k(%a), %t (same for the index)
+        LeaInstruction* lea = dynamic_cast<LeaInstruction*>(second);
+        RegisterNode* srcReg = dynamic_cast<RegisterNode*>(src);
+        if(lea != nullptr && srcReg != nullptr && operands_equal(lea->getDst(), tmp)
+            && (operands_equal(lea->getBase(), tmp) || operands_equal(lea->getIndex(), tmp))){
+            RegisterNode* base = operands_equal(lea->getBase(), tmp) ? srcReg : lea->getBase();
+            RegisterNode* indexReg = operands_equal(lea->getIndex(), tmp) ? srcReg : lea->getIndex();
+            list.instructions[index] = new LeaInstruction{base, indexReg, lea->getScale(), lea->getDisplacement(), lea->getDst()};
+            list.remove(secondIndex);
+            return(true);
+        }
+    }
+
+    // leal k(%b), %t; movl %t, %d => leal k(%b), %d
+    LeaInstruction* lea = dynamic_cast<LeaInstruction*>(first);
+    MoveInstruction* next = dynamic_cast<MoveInstruction*>(second);
+    if(lea != nullptr && next != nullptr && operands_equal(next->getSrc(), lea->getDst())){
+        RegisterNode* dst = dynamic_cast<RegisterNode*>(next->getDst());
+        if(dst != nullptr && isDeadAfter(list, secondIndex, lea->getDst())){
+            list.instructions[index] = new LeaInstruction{lea->getBase(), lea->getIndex(), lea->getScale(), lea->getDisplacement(), dst};
+            list.remove(secondIndex);
+            return(true);
+        }
+    }
+    return(false);
+}
+
+size_t PeepholeOptimizer::optimize(IRFunctionNode* function){
+    InstructionList list(function->getInstructions());
+    size_t rewrites = 0;
+    size_t i = 0;
+    while(i < list.instructions.size()){
+        if(rewrite(list, i)){
+            rewrites++;
+            // the rewrite may have created a new match with the instruction before
+            if(list.previous[i] != InstructionList::npos){
+                i = list.previous[i];
+            }else if(list.instructions[i] == nullptr){
+                i = list.next[i];
+            }
+        }else{
+            i = list.next[i];
+        }
+    }
+    function->setInstructions(list.compact());
+    return(rewrites);
+}
@@ -0,0 +1,59 @@
+#ifndef PEEPHOLE_HPP
+#define PEEPHOLE_HPP
+
+#include <vector>
+#include "Assembly.hpp"
+
+// ======================================================
+//                     PeepholeOptimizer
+// ======================================================
+/**
+ * @brief Rewrites short windows of assembly once every operand has a location. Mostly removes the
+ * moves through %r10d the lowering adds, which become redundant once the values are in registers:
+ *      movl X, X                               => (removed)
+ *      movl S, T; movl T, D                    => movl S, D                  (T dead afterwards)
+ *      movl S, T; op T; movl T, D              => movl S, D; op D            (T dead afterwards)
+ *      movl %a, %t; leal k(%t), %t             => leal k(%a), %t             (also when %t is the index)
+ *      leal k(%b), %t; movl %t, %d             => leal k(%b), %d             (t dead afterwards)
+ * A rewrite is only done when the result doesn't move memory to memory. Whether a value is dead is only
+ * looked for up to the end of its basic block, a value still unread there is taken as live.
+ * Removed instructions are unlinked in place and dropped in one pass at the end, so the pass stays linear.
+ */
+class PeepholeOptimizer {
+    private:
+        /**
+         * @brief The instructions of the function, a removed one is left as nullptr and skipped through the links
+         */
+        struct InstructionList {
+            std::vector<InstructionNode*> instructions;
+            // index of the next live instruction (instructions.size() at the end) and of the previous one (npos)
+            std::vector<size_t> next;
+            std::vector<size_t> previous;
+            static const size_t npos = static_cast<size_t>(-1);
+
+            explicit InstructionList(const std::vector<InstructionNode*>& instructions);
+            void remove(size_t index);
+            InstructionNode* after(size_t index) const;
+            std::vector<InstructionNode*> compact() const;
+        };
+        /**
+         * @brief Checks if the value in the operand is never read after the instruction at index
+         *
+         * @param list
+         * @param index
+         * @param op
+         * @return bool
+         */
+        static bool isDeadAfter(const InstructionList& list, size_t index, OperandNode* op);
+        static bool rewrite(InstructionList& list, size_t index);
+    public:
+        /**
+         * @brief Runs the rewrites until none applies
+         *
+         * @param function
+         * @return size_t number of rewrites done
+         */
+        static size_t optimize(IRFunctionNode* function);
+};
+
+#endif // PEEPHOLE_HPP
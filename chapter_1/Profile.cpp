@@ -0,0 +1,74 @@
+#include "Profile.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// ======================================================
+//                     Profile
+// ======================================================
+const char* const Profile::COUNTERS_SECTION = "mycc_profile_counters";
+const char* const Profile::NAMES_SECTION = "mycc_profile_names";
+const char* const Profile::COUNTERS_LABEL = ".Lmycc_profile_counters";
+
+Profile Profile::read(const std::string& path){
+    std::ifstream file{path};
+    if(!file.is_open()){
+        throw std::runtime_error("Could not open the profile " + path);
+    }
+    Profile profile;
+    std::string line;
+    size_t number = 0;
+    while(std::getline(file, line)){
+        number++;
+        if(line.empty() || line[0] == '#'){
+            continue;
+        }
+        std::istringstream fields{line};
+        std::string first, second;
+        if(!(fields >> first >> second)){
+            throw std::runtime_error(path + ":" + std::to_string(number) + ": expected two fields");
+        }
+        try{
+            if(first == "runs"){
+                profile.runs += std::stoull(second);
+            }else{
+                profile.counts[second] += std::stoull(first);
+            }
+        }catch(const std::logic_error&){
+            throw std::runtime_error(path + ":" + std::to_string(number) + ": invalid count " + (first == "runs" ? second : first));
+        }
+    }
+    return(profile);
+}
+
+void Profile::write(const std::string& path) const{
+    std::ofstream file{path};
+    if(!file.is_open()){
+        throw std::runtime_error("Could not open " + path + " for writing");
+    }
+    file << "# mycc profile\n";
+    file << "runs " << this->runs << '\n';
+    for(const auto& entry: this->counts){
+        file << entry.second << ' ' << entry.first << '\n';
+    }
+}
+
+void Profile::merge(const Profile& other){
+    for(const auto& entry: other.counts){
+        this->counts[entry.first] += entry.second;
+    }
+    this->runs += other.runs;
+}
+
+uint64_t Profile::getCount(const std::string& function) const{
+    auto found = this->counts.find(function);
+    return(found == this->counts.end() ? 0 : found->second);
+}
+
+const std::map<std::string, uint64_t>& Profile::getCounts() const{
+    return(this->counts);
+}
+
+uint64_t Profile::getRuns() const{
+    return(this->runs);
+}
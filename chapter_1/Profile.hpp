@@ -0,0 +1,73 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// ======================================================
+//                     Profile
+// ======================================================
+/**
+ * @brief Execution counts of the functions of a program, as written by the profiling runtime
+ * (ProfileRuntime.c) of a -fprofile-generate build.
+ *
+ * Instrumentation: the instrument pass puts a ProfileCounterInstruction (incq) at the entry of every function.
+ * Each file gets its counters in a NOBITS section (zeroed like .bss) and the names of its functions, in the
+ * same order, in a second section:
+ *
+ *      mycc_profile_counters   8 bytes per function, "aw", @nobits
+ *      mycc_profile_names      the names, each followed by a 0
+ *
+ * The linker puts the sections of every file one after the other and defines __start_/__stop_ symbols around
+ * them, so the runtime walks the counters of the whole program without any registration code. At exit it writes
+ * them to $MYCC_PROFILE_FILE (default mycc.profraw, %p is replaced with the pid):
+ *
+ *      # mycc profile
+ *      runs 1
+ *      <count> <function>
+ *
+ * mycc -profile-merge=<out> <in>... sums the counts (and runs) of many files into one.
+ *
+ * The counter costs one incq per call.
+ */
+class Profile {
+    private:
+        std::map<std::string, uint64_t> counts;
+        uint64_t runs = 0;
+    public:
+        static const char* const COUNTERS_SECTION;
+        static const char* const NAMES_SECTION;
+        /**
+         * @brief Local label at the start of the counter table of a file
+         *
+         */
+        static const char* const COUNTERS_LABEL;
+
+        /**
+         * @brief Reads a profile written by the runtime or by write
+         *
+         * @param path
+         * @return Profile
+         */
+        static Profile read(const std::string& path);
+        void write(const std::string& path) const;
+        /**
+         * @brief Adds the counts and runs of another profile, functions only one of them has are kept
+         *
+         * @param other
+         */
+        void merge(const Profile& other);
+        /**
+         * @brief Get the execution count of a function
+         *
+         * @param function
+         * @return uint64_t 0 for a function the profile doesn't know
+         */
+        uint64_t getCount(const std::string& function) const;
+        const std::map<std::string, uint64_t>& getCounts() const;
+        uint64_t getRuns() const;
+};
+
+#endif // PROFILE_HPP
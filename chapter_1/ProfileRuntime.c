@@ -0,0 +1,60 @@
+/*
+ * Runtime of -fprofile-generate, linked into the instrumented program:
+ *
+ *      ./mycc -fprofile-generate -c prog.c && gcc prog.o ProfileRuntime.o -o prog
+ *
+ * Every instrumented file adds its counters to mycc_profile_counters and the names of its functions to
+ * mycc_profile_names (see Profile.hpp). The linker joins the sections of all the files in the same order and
+ * brackets them with __start_ and __stop_ symbols, so the n-th counter belongs to the n-th name. At exit the
+ * table is written to $MYCC_PROFILE_FILE, mycc.profraw by default, with %p replaced by the pid so runs in
+ * parallel don't overwrite each other.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* weak, a program without instrumented files has neither section */
+extern uint64_t __start_mycc_profile_counters[] __attribute__((weak));
+extern uint64_t __stop_mycc_profile_counters[] __attribute__((weak));
+extern const char __start_mycc_profile_names[] __attribute__((weak));
+extern const char __stop_mycc_profile_names[] __attribute__((weak));
+
+static void profile_path(char* path, size_t size){
+    const char* pattern = getenv("MYCC_PROFILE_FILE");
+    if(pattern == NULL || pattern[0] == '\0'){
+        pattern = "mycc.profraw";
+    }
+    size_t length = 0;
+    for(const char* c = pattern; *c != '\0' && length + 1 < size; c++){
+        if(c[0] == '%' && c[1] == 'p'){
+            length += (size_t)snprintf(path + length, size - length, "%ld", (long)getpid());
+            c++;
+        }else{
+            path[length++] = *c;
+        }
+    }
+    path[length < size ? length : size - 1] = '\0';
+}
+
+__attribute__((destructor))
+static void mycc_profile_dump(void){
+    if(__start_mycc_profile_counters == NULL){
+        return;
+    }
+    char path[4096];
+    profile_path(path, sizeof(path));
+    FILE* file = fopen(path, "w");
+    if(file == NULL){
+        perror(path);
+        return;
+    }
+    fprintf(file, "# mycc profile\nruns 1\n");
+    const char* name = __start_mycc_profile_names;
+    for(uint64_t* counter = __start_mycc_profile_counters; counter < __stop_mycc_profile_counters && name < __stop_mycc_profile_names; counter++){
+        fprintf(file, "%llu %s\n", (unsigned long long)*counter, name);
+        name += strlen(name) + 1;
+    }
+    fclose(file);
+}
@@ -0,0 +1,205 @@
+#include "RegisterAllocator.hpp"
+#include "Liveness.hpp"
+#include <algorithm>
+
+// ======================================================
+//                     RegisterAllocator
+// ======================================================
+const std::vector<RegisterName> RegisterAllocator::allocatable = {
+    RegisterName::CX, RegisterName::DX, RegisterName::SI, RegisterName::DI,
+    RegisterName::R8, RegisterName::R9, RegisterName::R11
+};
+
+size_t RegisterAllocator::allocate(IRFunctionNode* function){
+    std::vector<InstructionNode*> instructions = function->getInstructions();
+
+    PseudoLiveness liveness(instructions);
+
+    // live intervals, from the first to the last instruction mentioning each Pseudo, stretched to the start of the
+    // blocks it is live into and the end of the blocks it is live out of
+    std::vector<Interval> intervals(liveness.count());
+    std::vector<char> seen(liveness.count(), 0);
+    for(size_t i = 0; i < instructions.size(); i++){
+        for(size_t k = liveness.operandBegin(i); k < liveness.operandEnd(i); k++){
+            int pseudo = liveness.operand(k);
+            if(pseudo < 0){
+                continue;
+            }
+            if(!seen[pseudo]){
+                seen[pseudo] = 1;
+                intervals[pseudo] = Interval{liveness.getName(pseudo), i, i, -1};
+            }else{
+                intervals[pseudo].end = i;
+            }
+        }
+    }
+    for(size_t b = 0; b < liveness.blockCount(); b++){
+        const PseudoLiveness::Block& block = liveness.getBlock(b);
+        for(int pseudo: liveness.getLiveIn(b)){
+            intervals[pseudo].start = std::min(intervals[pseudo].start, block.begin);
+        }
+        for(int pseudo: liveness.getLiveOut(b)){
+            intervals[pseudo].end = std::max(intervals[pseudo].end, block.end);
+        }
+    }
+    // the Pseudos are numbered in the order they first appear, so only a stretched start can move an interval
+    std::vector<size_t> order(intervals.size());
+    for(size_t p = 0; p < order.size(); p++){
+        order[p] = p;
+    }
+    std::stable_sort(order.begin(), order.end(), [&intervals](size_t a, size_t b){
+        return(intervals[a].start < intervals[b].start);
+    });
+
+    // the registers a call reads and clobbers are only busy around it: from the movl loading an argument
+    // register (or from the entry, for the parameters moved out of them) to the call or the movl reading it.
+    // Those instructions are left out of the scan for named registers below. The ranges of the calls are found in
+    // call order, so sorted by their end
+    std::vector<FixedRange> fixed;
+    std::vector<FixedRange> parameters;
+    std::vector<size_t> calls;
+    std::vector<char> callSequence(instructions.size(), 0);
+    const std::vector<RegisterName>& arguments = CallInstruction::argumentRegisters();
+    auto argumentIndex = [&arguments](OperandNode* op) -> int {
+        if(op->getType() != REG){
+            return(-1);
+        }
+        auto found = std::find(arguments.begin(), arguments.end(), static_cast<RegisterNode*>(op)->getRegEnum());
+        return(found == arguments.end() ? -1 : static_cast<int>(found - arguments.begin()));
+    };
+    for(size_t i = 0; i < instructions.size(); i++){
+        if(instructions[i]->getType() != CALL){
+            continue;
+        }
+        calls.push_back(i);
+        callSequence[i] = 1;
+        for(size_t j = i; j-- > 0 && instructions[j]->getType() == MOV;){
+            int argument = argumentIndex(static_cast<MoveInstruction*>(instructions[j])->getDst());
+            if(argument < 0){
+                break;
+            }
+            fixed.push_back(FixedRange{j, i, arguments[argument]});
+            callSequence[j] = 1;
+        }
+    }
+    for(size_t i = 0; i < instructions.size(); i++){
+        if(instructions[i]->getType() == ALLOCATE){
+            continue;
+        }
+        MoveInstruction* mov = dynamic_cast<MoveInstruction*>(instructions[i]);
+        if(mov == nullptr || argumentIndex(mov->getSrc()) < 0){
+            break;
+        }
+        parameters.push_back(FixedRange{0, i, static_cast<RegisterNode*>(mov->getSrc())->getRegEnum()});
+        callSequence[i] = 1;
+    }
+    // the registers an interval can't have: all of them when it lives across a call, and the argument registers
+    // busy somewhere inside it. With no call inside, those can only be the ones loaded for the next call (the
+    // movls right before it) and the incoming ones, so the interval only looks at those
+    auto forbidden = [&](const Interval& interval){
+        std::vector<char> excluded(allocatable.size(), 0);
+        auto exclude = [&](const FixedRange& range){
+            if(interval.start < range.end && interval.end > range.begin){
+                for(size_t r = 0; r < allocatable.size(); r++){
+                    excluded[r] |= allocatable[r] == range.reg;
+                }
+            }
+        };
+        auto call = std::upper_bound(calls.begin(), calls.end(), interval.start);
+        if(call != calls.end()){
+            if(*call < interval.end){
+                std::fill(excluded.begin(), excluded.end(), 1);
+                return(excluded);
+            }
+            auto range = std::lower_bound(fixed.begin(), fixed.end(), *call, [](const FixedRange& r, size_t end){ return(r.end < end); });
+            for(; range != fixed.end() && range->end == *call; range++){
+                exclude(*range);
+            }
+        }
+        for(const FixedRange& range: parameters){
+            exclude(range);
+        }
+        return(excluded);
+    };
+
+    // a register the function already uses, named or implied (%edx by cltd and idivl), is kept out of the
+    // allocation for the whole function since the intervals of the registers themselves aren't tracked
+    std::vector<char> named(allocatable.size(), 0);
+    std::vector<OperandNode*> reads, writes;
+    for(size_t i = 0; i < instructions.size(); i++){
+        InstructionNode* instr = instructions[i];
+        if(callSequence[i]){
+            continue;
+        }
+        reads.clear();
+        writes.clear();
+        instruction_operands(instr, reads, writes);
+        reads.insert(reads.end(), writes.begin(), writes.end());
+        for(OperandNode* op: reads){
+            if(op->getType() != REG){
+                continue;
+            }
+            for(size_t r = 0; r < allocatable.size(); r++){
+                if(allocatable[r] == static_cast<RegisterNode*>(op)->getRegEnum()){
+                    named[r] = 1;
+                }
+            }
+        }
+    }
+    std::vector<int> freeRegisters;
+    for(int r = static_cast<int>(allocatable.size()) - 1; r >= 0; r--){
+        if(!named[r]){
+            freeRegisters.push_back(r);
+        }
+    }
+    // indices of the intervals holding a register, sorted by increasing end
+    std::vector<size_t> active;
+    auto byEnd = [&intervals](size_t a, size_t b){ return(intervals[a].end < intervals[b].end); };
+    for(size_t current: order){
+        // an interval ending where this one starts can hand over its register: the instruction reads the old
+        // value before writing the new one
+        while(!active.empty() && intervals[active.front()].end <= intervals[current].start){
+            freeRegisters.push_back(intervals[active.front()].reg);
+            active.erase(active.begin());
+        }
+        std::vector<char> excluded = forbidden(intervals[current]);
+        auto free = std::find_if(freeRegisters.rbegin(), freeRegisters.rend(), [&excluded](int r){ return(!excluded[r]); });
+        if(free != freeRegisters.rend()){
+            intervals[current].reg = *free;
+            freeRegisters.erase(std::next(free).base());
+        }else{
+            if(active.empty()){
+                continue;
+            }
+            size_t last = active.back();
+            if(intervals[last].end <= intervals[current].end || excluded[intervals[last].reg]){
+                continue;
+            }
+            // the interval ending last is the cheapest to keep in memory
+            intervals[current].reg = intervals[last].reg;
+            intervals[last].reg = -1;
+            active.pop_back();
+        }
+        active.insert(std::upper_bound(active.begin(), active.end(), current, byEnd), current);
+    }
+
+    size_t allocated = 0;
+    for(const Interval& interval: intervals){
+        if(interval.reg >= 0){
+            allocated++;
+        }
+    }
+    for(size_t i = 0; i < instructions.size(); i++){
+        reads.clear();
+        writes.clear();
+        instruction_operands(instructions[i], reads, writes);
+        reads.insert(reads.end(), writes.begin(), writes.end());
+        for(size_t k = 0; k < reads.size(); k++){
+            int pseudo = liveness.operand(liveness.operandBegin(i) + k);
+            if(pseudo >= 0 && intervals[pseudo].reg >= 0){
+                replace_operand(instructions[i], reads[k], new RegisterNode{allocatable[intervals[pseudo].reg]});
+            }
+        }
+    }
+    return(allocated);
+}
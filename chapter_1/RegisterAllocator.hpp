@@ -0,0 +1,57 @@
+#ifndef REGISTERALLOCATOR_HPP
+#define REGISTERALLOCATOR_HPP
+
+#include <string>
+#include <vector>
+#include "Assembly.hpp"
+
+// ======================================================
+//                     RegisterAllocator
+// ======================================================
+/**
+ * @brief Linear scan register allocation (Poletto & Sarkar) of the Pseudos of a function.
+ *
+ * The live interval of a Pseudo runs from the first to the last instruction that mentions it, widened to cover
+ * every block PseudoLiveness finds it live into or out of (with forward jumps only this never changes anything,
+ * it keeps the intervals right if a loop ever jumps back over a use). Intervals are
+ * visited in order of their start, and each one takes a free register from the allocatable set. When none is
+ * free, the interval that ends last stays a Pseudo and is given a stack slot later by assign-slots.
+ *
+ * %eax and %r10d are never handed out, the instruction selector computes its trees in them. Neither is a register
+ * the function already uses, explicitly or implicitly: divisions put %edx in the code, and a function that has one
+ * allocates from the six others. Only caller saved registers are used so no register has to be saved in the prologue.
+ *
+ * Calls are the exception: the argument registers are only busy from the movl loading them to the call (and the
+ * incoming ones from the entry to the movl saving the parameter), so they are only kept from the intervals
+ * overlapping those ranges. A call clobbers every caller saved register, an interval living across one stays in
+ * memory.
+ */
+class RegisterAllocator {
+    private:
+        struct Interval {
+            std::string name;
+            size_t start;
+            size_t end;
+            int reg;
+        };
+        /**
+         * @brief An argument register holding a value from begin to end
+         *
+         */
+        struct FixedRange {
+            size_t begin;
+            size_t end;
+            RegisterName reg;
+        };
+        static const std::vector<RegisterName> allocatable;
+    public:
+        /**
+         * @brief Replaces the Pseudos of the function that fit in a register with that register
+         *
+         * @param function
+         * @return size_t number of Pseudos that were given a register
+         */
+        static size_t allocate(IRFunctionNode* function);
+};
+
+#endif // REGISTERALLOCATOR_HPP
@@ -0,0 +1,111 @@
+#include "StackSlots.hpp"
+#include "Liveness.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+static int alignFrame(int bytes){
+    return((bytes + 15) / 16 * 16);
+}
+
+// ======================================================
+//                     StackSlotAllocator
+// ======================================================
+FrameSize StackSlotAllocator::assign(IRFunctionNode* function){
+    std::vector<InstructionNode*> instructions = function->getInstructions();
+    PseudoLiveness liveness(instructions);
+    int count = liveness.count();
+
+    // backward liveness through each block from its live out set, adding the interferences at every write. The
+    // live set is a list plus the position of each Pseudo in it, so insertion and removal are O(1).
+    std::vector<std::vector<int>> interferences(count);
+    std::vector<int> live;
+    std::vector<int> positionInLive(count, -1);
+    for(size_t b = liveness.blockCount(); b-- > 0;){
+        for(int pseudo: live){
+            positionInLive[pseudo] = -1;
+        }
+        live = liveness.getLiveOut(b);
+        for(size_t k = 0; k < live.size(); k++){
+            positionInLive[live[k]] = static_cast<int>(k);
+        }
+        const PseudoLiveness::Block& block = liveness.getBlock(b);
+        for(size_t i = block.end; i-- > block.begin;){
+            size_t firstRead = liveness.operandBegin(i);
+            size_t firstWrite = firstRead + liveness.reads(i);
+            int moveSource = -1;
+            if(instructions[i]->getType() == MOV){
+                moveSource = liveness.operand(firstRead);
+            }
+            for(size_t k = firstWrite; k < liveness.operandEnd(i); k++){
+                int written = liveness.operand(k);
+                if(written < 0){
+                    continue;
+                }
+                for(int other: live){
+                    if(other != written && other != moveSource){
+                        interferences[written].push_back(other);
+                        interferences[other].push_back(written);
+                    }
+                }
+                if(positionInLive[written] >= 0){
+                    int last = live.back();
+                    live[positionInLive[written]] = last;
+                    positionInLive[last] = positionInLive[written];
+                    live.pop_back();
+                    positionInLive[written] = -1;
+                }
+            }
+            for(size_t k = firstRead; k < firstWrite; k++){
+                int read = liveness.operand(k);
+                if(read >= 0 && positionInLive[read] < 0){
+                    positionInLive[read] = static_cast<int>(live.size());
+                    live.push_back(read);
+                }
+            }
+        }
+    }
+
+    std::vector<int> slot(count, -1);
+    int slotCount = 0;
+    std::vector<char> taken;
+    for(int p = 0; p < count; p++){
+        taken.assign(slotCount + 1, 0);
+        for(int neighbour: interferences[p]){
+            if(slot[neighbour] >= 0){
+                taken[slot[neighbour]] = 1;
+            }
+        }
+        int chosen = static_cast<int>(std::find(taken.begin(), taken.end(), 0) - taken.begin());
+        slot[p] = chosen;
+        slotCount = std::max(slotCount, chosen + 1);
+    }
+
+    std::unordered_set<Pseudo*> pseudoNodes;
+    std::vector<OperandNode*> reads, writes;
+    for(size_t i = 0; i < instructions.size(); i++){
+        reads.clear();
+        writes.clear();
+        instruction_operands(instructions[i], reads, writes);
+        reads.insert(reads.end(), writes.begin(), writes.end());
+        for(size_t k = 0; k < reads.size(); k++){
+            int index = liveness.operand(liveness.operandBegin(i) + k);
+            if(index >= 0){
+                pseudoNodes.insert(static_cast<Pseudo*>(reads[k]));
+                replace_operand(instructions[i], reads[k], new Stack{-4 * (slot[index] + 1)});
+            }
+        }
+    }
+    for(Pseudo* p: pseudoNodes){
+        delete p;
+    }
+
+    FrameSize size;
+    size.before = alignFrame(4 * count);
+    size.after = alignFrame(4 * slotCount);
+    if(!instructions.empty()){
+        if(AllocateStack* allocate = dynamic_cast<AllocateStack*>(instructions.front())){
+            allocate->setStackDecrementAmount(size.after);
+        }
+    }
+    return(size);
+}
@@ -0,0 +1,265 @@
+#include "Superoptimizer.hpp"
+#include "Jit.hpp"
+#include "X86Encoder.hpp"
+#include <algorithm>
+#include <climits>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+#include <x86intrin.h>
+
+typedef InstructionSelector::Cost Cost;
+
+// ======================================================
+//                     Superoptimizer
+// ======================================================
+Superoptimizer::Superoptimizer(Options options):options(options){
+    const uint32_t edges[] = {0u, 1u, 2u, 3u, 0xFFFFFFFFu, 0xFFFFFFFEu, 0xFFFFFFFDu, 0x7FFFFFFFu, 0x80000000u,
+        0x7FFFFFFEu, 0x80000001u, 0x55555555u, 0xAAAAAAAAu, 0x0000FFFFu, 0xFFFF0000u};
+    this->inputs.assign(std::begin(edges), std::end(edges));
+    // fixed seed, the table must not change from one run to the next
+    std::mt19937 random{20240601u};
+    for(int i = 0; i < 4096; i++){
+        this->inputs.push_back(static_cast<uint32_t>(random()));
+    }
+    this->alphabet = {{StepOp::NEG, 0}, {StepOp::NOT, 0}, {StepOp::INC, 0}, {StepOp::DEC, 0}};
+    for(int32_t amount = -8; amount <= 8; amount++){
+        if(amount < -1 || amount > 1){
+            this->alphabet.push_back(RewriteStep{StepOp::ADD, amount});
+        }
+    }
+}
+
+uint32_t Superoptimizer::apply(StepOp op, int32_t amount, uint32_t value){
+    switch(op){
+        case StepOp::NEG: return(0u - value);
+        case StepOp::NOT: return(~value);
+        case StepOp::INC: return(value + 1u);
+        case StepOp::DEC: return(value - 1u);
+        case StepOp::ADD: return(value + static_cast<uint32_t>(amount));
+    }
+    return(value);
+}
+
+uint32_t Superoptimizer::execute(const std::vector<RewriteStep>& steps, uint32_t value){
+    for(const RewriteStep& step: steps){
+        value = apply(step.op, step.amount, value);
+    }
+    return(value);
+}
+
+Cost Superoptimizer::stepCost(const RewriteStep& step){
+    // same costs as the tiles emitting these instructions: incl %eax is 2 bytes, addl $k, %eax 3
+    return(step.op == StepOp::ADD ? Cost{1, 3} : Cost{1, 2});
+}
+
+std::string Superoptimizer::patternOf(const std::vector<StepOp>& chain){
+    std::string pattern = "reg";
+    for(StepOp op: chain){
+        switch(op){
+            case StepOp::NEG: pattern = "NEG(" + pattern + ")"; break;
+            case StepOp::NOT: pattern = "NOT(" + pattern + ")"; break;
+            case StepOp::INC: pattern = "ADD(" + pattern + ",1)"; break;
+            case StepOp::DEC: pattern = "SUB(" + pattern + ",1)"; break;
+            case StepOp::ADD: throw std::runtime_error("A chain is only made of -, ~, +1 and -1");
+        }
+    }
+    return(pattern);
+}
+
+std::string Superoptimizer::describe(const std::vector<InstructionNode*>& instructions){
+    if(instructions.empty()){
+        return("(nothing)");
+    }
+    std::string text;
+    for(InstructionNode* instr: instructions){
+        std::ostringstream line;
+        instr->filePrint(line);
+        std::string printed = line.str();
+        size_t first = printed.find_first_not_of(" \t\n");
+        size_t last = printed.find_last_not_of(" \t\n");
+        if(!text.empty()){
+            text += "; ";
+        }
+        text += first == std::string::npos ? "" : printed.substr(first, last - first + 1);
+    }
+    return(text);
+}
+
+bool Superoptimizer::equivalent(const std::vector<StepOp>& chain, const std::vector<RewriteStep>& steps) const{
+    for(uint32_t input: this->inputs){
+        uint32_t expected = input;
+        for(StepOp op: chain){
+            expected = apply(op, 0, expected);
+        }
+        if(execute(steps, input) != expected){
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool Superoptimizer::equivalentEverywhere(const std::vector<StepOp>& chain, const std::vector<RewriteStep>& steps) const{
+    for(uint64_t input = 0; input <= UINT32_MAX; input++){
+        uint32_t expected = static_cast<uint32_t>(input);
+        for(StepOp op: chain){
+            expected = apply(op, 0, expected);
+        }
+        if(execute(steps, static_cast<uint32_t>(input)) != expected){
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool Superoptimizer::search(const std::vector<StepOp>& chain, std::vector<RewriteStep>& best, Cost& bestCost) const{
+    bool found = false;
+    std::vector<RewriteStep> sequence;
+    // depth first over the alphabet, a sequence already as expensive as the best one is not extended
+    auto extend = [&](auto& self, Cost cost) -> void {
+        if(found && !InstructionSelector::costLess(cost, bestCost)){
+            return;
+        }
+        if(equivalent(chain, sequence)){
+            best = sequence;
+            bestCost = cost;
+            found = true;
+            return;
+        }
+        if(static_cast<int>(sequence.size()) == this->options.sequenceLength){
+            return;
+        }
+        for(const RewriteStep& step: this->alphabet){
+            Cost next = stepCost(step);
+            sequence.push_back(step);
+            self(self, Cost{cost.latency + next.latency, cost.size + next.size});
+            sequence.pop_back();
+        }
+    };
+    extend(extend, Cost{0, 0});
+    return(found);
+}
+
+std::vector<Superoptimizer::Result> Superoptimizer::run(){
+    const std::vector<StepOp> operators = {StepOp::NEG, StepOp::NOT, StepOp::INC, StepOp::DEC};
+    // cheapest known cover of every chain searched so far, rewrites included
+    std::unordered_map<std::string, Cost> known;
+    std::vector<Result> results;
+    std::vector<std::vector<StepOp>> chains = {{}};
+    for(int length = 1; length <= this->options.chainLength; length++){
+        std::vector<std::vector<StepOp>> longer;
+        for(const std::vector<StepOp>& chain: chains){
+            for(StepOp op: operators){
+                std::vector<StepOp> next = chain;
+                next.push_back(op);
+                longer.push_back(next);
+            }
+        }
+        chains.swap(longer);
+        for(const std::vector<StepOp>& chain: chains){
+            Result result{patternOf(chain), Cost{0, 0}, Cost{0, 0}, {}};
+            InstructionSelector::selectPattern(result.pattern, false, result.before);
+            // what the selector reaches by combining the rewrites of the shorter chains
+            Cost reachable = result.before;
+            for(size_t split = 1; split < chain.size(); split++){
+                Cost inner = known[patternOf(std::vector<StepOp>(chain.begin(), chain.begin() + split))];
+                Cost outer = known[patternOf(std::vector<StepOp>(chain.begin() + split, chain.end()))];
+                Cost combined{inner.latency + outer.latency, inner.size + outer.size};
+                if(InstructionSelector::costLess(combined, reachable)){
+                    reachable = combined;
+                }
+            }
+            known[result.pattern] = reachable;
+            if(!search(chain, result.steps, result.after) || !InstructionSelector::costLess(result.after, reachable)){
+                continue;
+            }
+            if(this->options.exhaustive && !equivalentEverywhere(chain, result.steps)){
+                throw std::runtime_error("The randomized check was wrong about " + result.pattern);
+            }
+            known[result.pattern] = result.after;
+            results.push_back(result);
+        }
+    }
+    return(results);
+}
+
+void Superoptimizer::writeTable(const std::vector<Result>& results, std::ostream& out) const{
+    out<<"// Generated by mycc -superoptimize="<<this->options.chainLength<<" (make superopt-table), do not edit.\n";
+    out<<"// Chains of up to "<<this->options.chainLength<<" operators, sequences of up to "<<this->options.sequenceLength
+        <<" instructions, checked on "<<(this->options.exhaustive ? std::string{"every 32 bit input"} : std::to_string(this->inputs.size()) + " inputs")<<".\n";
+    out<<"// {pattern, {latency, size}, steps}, // cover with the hand written tiles {latency, size}\n";
+    for(const Result& result: results){
+        out<<"{\""<<result.pattern<<"\", {"<<result.after.latency<<", "<<result.after.size<<"}, {";
+        for(size_t i = 0; i < result.steps.size(); i++){
+            static const char* const names[] = {"NEG", "NOT", "INC", "DEC", "ADD"};
+            out<<(i == 0 ? "" : ", ")<<"{StepOp::"<<names[static_cast<int>(result.steps[i].op)]<<", "<<result.steps[i].amount<<"}";
+        }
+        Cost cost;
+        out<<"}}, // "<<describe(InstructionSelector::selectPattern(result.pattern, false, cost))
+            <<" {"<<result.before.latency<<", "<<result.before.size<<"}\n";
+    }
+}
+
+// ======================================================
+//                     Benchmark
+// ======================================================
+double Superoptimizer::measure(const std::vector<InstructionNode*>& instructions){
+    const int32_t iterations = 1 << 22;
+    IRFunctionNode body{"body", instructions};
+    body.setFramePointer(false);
+    std::vector<uint8_t> loop = X86Encoder::encodeFunction(&body);
+    // movl $0, %eax; movl $iterations, %ecx; L: body; decl %ecx; jnz L; ret
+    std::vector<uint8_t> code = {0xB8, 0, 0, 0, 0, 0xB9};
+    for(int i = 0; i < 4; i++){
+        code.push_back(static_cast<uint8_t>(static_cast<uint32_t>(iterations) >> (8 * i)));
+    }
+    code.insert(code.end(), loop.begin(), loop.end());
+    code.push_back(0xFF);
+    code.push_back(0xC9);
+    int32_t back = -static_cast<int32_t>(loop.size() + 2 + 6);
+    code.push_back(0x0F);
+    code.push_back(0x85);
+    for(int i = 0; i < 4; i++){
+        code.push_back(static_cast<uint8_t>(static_cast<uint32_t>(back) >> (8 * i)));
+    }
+    code.push_back(0xC3);
+    JitModule module{"loop", code};
+    JitFunction function = module.getFunction("loop");
+    unsigned long long best = ULLONG_MAX;
+    for(int run = 0; run < 5; run++){
+        unsigned long long start = __rdtsc();
+        function();
+        best = std::min(best, __rdtsc() - start);
+    }
+    return(static_cast<double>(best) / iterations);
+}
+
+void Superoptimizer::writeBenchmark(const std::vector<Result>& results, std::ostream& out) const{
+    std::ostringstream line;
+    line.setf(std::ios::fixed);
+    line.precision(2);
+    line<<"Each chain runs on %eax in a loop of 4M iterations, TSC cycles per iteration, best of 5\n";
+    line<<"empty loop: "<<measure({})<<"\n";
+    int modelBefore = 0;
+    int modelAfter = 0;
+    double measuredBefore = 0;
+    double measuredAfter = 0;
+    for(const Result& result: results){
+        Cost cost;
+        std::vector<InstructionNode*> before = InstructionSelector::selectPattern(result.pattern, false, cost);
+        std::vector<InstructionNode*> after;
+        InstructionSelector::emitRewrite(after, new RegisterNode{RegisterName::AX}, result.steps);
+        double cyclesBefore = measure(before);
+        double cyclesAfter = measure(after);
+        line<<result.pattern<<"\n    "<<describe(before)<<" => "<<describe(after)
+            <<"\n    model "<<result.before.latency<<" -> "<<result.after.latency
+            <<", measured "<<cyclesBefore<<" -> "<<cyclesAfter<<"\n";
+        modelBefore += result.before.latency;
+        modelAfter += result.after.latency;
+        measuredBefore += cyclesBefore;
+        measuredAfter += cyclesAfter;
+    }
+    line<<results.size()<<" rewrites, model "<<modelBefore<<" -> "<<modelAfter<<" cycles, measured "
+        <<measuredBefore<<" -> "<<measuredAfter<<" cycles\n";
+    out<<line.str();
+}
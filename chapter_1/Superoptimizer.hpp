@@ -0,0 +1,102 @@
+#ifndef SUPEROPTIMIZER_HPP
+#define SUPEROPTIMIZER_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "InstructionSelector.hpp"
+
+// ======================================================
+//                     Superoptimizer
+// ======================================================
+/**
+ * @brief Offline search for the shortest instruction sequences computing chains of unary operators, whose
+ * winners become the rewrite table of the instruction selector (SuperoptTable.inc).
+ *
+ * Every chain of -, ~, +1 and -1 up to a given length (i.e -(~x + 1)) is compared with every sequence of negl,
+ * notl, incl, decl and addl $k (|k| <= 8) up to three instructions long, the empty sequence included. A sequence
+ * is equivalent when it gives the same result on a set of test inputs: the edge values (0, +-1, INT_MIN,
+ * INT_MAX, ...) and 4096 random ones, or every one of the 2^32 inputs with the exhaustive option. All the
+ * operators wrap around on 32 bits, so the randomized check is in practice as strong as the exhaustive one.
+ *
+ * The cheapest equivalent sequence (latency, then size, with the costs of the tiles) is kept only when it beats
+ * the cover the selector already finds for the chain with the hand written tiles and the shorter rewrites, so
+ * the table holds no entry the tile matching would reach anyway. Chains are searched shortest first for that.
+ *
+ *      make superopt-table     regenerates SuperoptTable.inc (mycc -superoptimize=4 > SuperoptTable.inc)
+ *      make superopt-bench     also runs every rewritten chain before and after in a JIT compiled loop
+ */
+class Superoptimizer {
+    public:
+        struct Options {
+            /**
+             * @brief Longest chain of operators searched
+             *
+             */
+            int chainLength = 4;
+            /**
+             * @brief Longest instruction sequence tried
+             *
+             */
+            int sequenceLength = 3;
+            bool exhaustive = false;
+            bool benchmark = false;
+        };
+        /**
+         * @brief A chain and what the search made of it
+         *
+         */
+        struct Result {
+            std::string pattern;
+            InstructionSelector::Cost before;
+            InstructionSelector::Cost after;
+            std::vector<InstructionSelector::RewriteStep> steps;
+        };
+    private:
+        typedef InstructionSelector::StepOp StepOp;
+        typedef InstructionSelector::RewriteStep RewriteStep;
+
+        Options options;
+        std::vector<uint32_t> inputs;
+        /**
+         * @brief The instructions a sequence is made of, with their costs
+         *
+         */
+        std::vector<RewriteStep> alphabet;
+
+        static uint32_t apply(StepOp op, int32_t amount, uint32_t value);
+        static uint32_t execute(const std::vector<RewriteStep>& steps, uint32_t value);
+        static InstructionSelector::Cost stepCost(const RewriteStep& step);
+        static std::string patternOf(const std::vector<StepOp>& chain);
+        static std::string describe(const std::vector<InstructionNode*>& instructions);
+        bool equivalent(const std::vector<StepOp>& chain, const std::vector<RewriteStep>& steps) const;
+        bool equivalentEverywhere(const std::vector<StepOp>& chain, const std::vector<RewriteStep>& steps) const;
+        /**
+         * @brief Cheapest sequence equivalent to the chain, false if none up to sequenceLength is
+         *
+         */
+        bool search(const std::vector<StepOp>& chain, std::vector<RewriteStep>& best, InstructionSelector::Cost& bestCost) const;
+        /**
+         * @brief Runs the instructions (on %eax) in a loop of JIT compiled code
+         *
+         * @return double TSC cycles per iteration
+         */
+        static double measure(const std::vector<InstructionNode*>& instructions);
+    public:
+        explicit Superoptimizer(Options options);
+        std::vector<Result> run();
+        /**
+         * @brief Writes the results as the entries of SuperoptTable.inc
+         *
+         */
+        void writeTable(const std::vector<Result>& results, std::ostream& out) const;
+        /**
+         * @brief Times every rewritten chain before (hand written tiles) and after (rewrite), together with the
+         * cycles of the cost model
+         *
+         */
+        void writeBenchmark(const std::vector<Result>& results, std::ostream& out) const;
+};
+
+#endif // SUPEROPTIMIZER_HPP
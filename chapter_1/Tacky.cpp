@@ -1,4 +1,5 @@
 #include "Tacky.hpp"
+#include <algorithm>
 
 // Helper for indentation
 static void printIndent(int indent) {
@@ -116,20 +117,278 @@ void TackyUnary::prettyPrint(int indent) const {
     if (this->src) this->src->prettyPrint(0); else std::cout << "None\n";
 }
 
+// ======================================================
+//                     TackyCopy:TackyInstruction
+// ======================================================
+TackyCopy::TackyCopy(TackyVal* src,TackyVal* dst):src(src),dst(dst){}
+
+TackyCopy::~TackyCopy(){}
+
+TackyVal* TackyCopy::getSrc(){
+    return(this->src);
+}
+
+TackyVal* TackyCopy::getDst(){
+    return(this->dst);
+}
+
+void TackyCopy::print() const {
+    std::cout << "  ";
+    if (this->dst) this->dst->print();
+    std::cout << " = ";
+    if (this->src) this->src->print();
+    std::cout << ";\n";
+}
+
+void TackyCopy::prettyPrint(int indent) const {
+    printIndent(indent);
+    std::cout << "Copy:\n";
+    printIndent(indent + 1);
+    std::cout << "Dst -> ";
+    if (this->dst) this->dst->prettyPrint(0); else std::cout << "None\n";
+    printIndent(indent + 1);
+    std::cout << "Src -> ";
+    if (this->src) this->src->prettyPrint(0); else std::cout << "None\n";
+}
+
+// ======================================================
+//                     TackyBinary:TackyInstruction
+// ======================================================
+TackyBinary::TackyBinary(BinaryOperator binary_operator,TackyVal* src1,TackyVal* src2,TackyVal* dst):
+    binary_operator(binary_operator),
+    src1(src1),
+    src2(src2),
+    dst(dst){}
+
+TackyBinary::~TackyBinary(){}
+
+BinaryOperator TackyBinary::getBinaryOperator(){
+    return(this->binary_operator);
+}
+
+TackyVal* TackyBinary::getSrc1(){
+    return(this->src1);
+}
+
+TackyVal* TackyBinary::getSrc2(){
+    return(this->src2);
+}
+
+TackyVal* TackyBinary::getDst(){
+    return(this->dst);
+}
+
+void TackyBinary::print() const {
+    std::cout << "  ";
+    if (this->dst) this->dst->print();
+    std::cout << " = ";
+    if (this->src1) this->src1->print();
+    std::cout << " " << binary_operator_to_string(this->binary_operator) << " ";
+    if (this->src2) this->src2->print();
+    std::cout << ";\n";
+}
+
+void TackyBinary::prettyPrint(int indent) const {
+    printIndent(indent);
+    std::cout << "Binary(" << binary_operator_to_string(this->binary_operator) << "):\n";
+    printIndent(indent + 1);
+    std::cout << "Dst -> ";
+    if (this->dst) this->dst->prettyPrint(0); else std::cout << "None\n";
+    printIndent(indent + 1);
+    std::cout << "Src1 -> ";
+    if (this->src1) this->src1->prettyPrint(0); else std::cout << "None\n";
+    printIndent(indent + 1);
+    std::cout << "Src2 -> ";
+    if (this->src2) this->src2->prettyPrint(0); else std::cout << "None\n";
+}
+
+// ======================================================
+//                     TackyLabel:TackyInstruction
+// ======================================================
+TackyLabel::TackyLabel(std::string identifier):identifier(identifier){}
+
+TackyLabel::~TackyLabel(){}
+
+std::string TackyLabel::getIdentifier(){
+    return(this->identifier);
+}
+
+void TackyLabel::print() const {
+    std::cout << this->identifier << ":\n";
+}
+
+void TackyLabel::prettyPrint(int indent) const {
+    printIndent(indent);
+    std::cout << "Label(" << this->identifier << ")\n";
+}
+
+// ======================================================
+//                     TackyJump:TackyInstruction
+// ======================================================
+TackyJump::TackyJump(std::string target):target(target){}
+
+TackyJump::~TackyJump(){}
+
+std::string TackyJump::getTarget(){
+    return(this->target);
+}
+
+void TackyJump::print() const {
+    std::cout << "  jump " << this->target << ";\n";
+}
+
+void TackyJump::prettyPrint(int indent) const {
+    printIndent(indent);
+    std::cout << "Jump(" << this->target << ")\n";
+}
+
+// ======================================================
+//                     TackyJumpIfZero:TackyInstruction
+// ======================================================
+TackyJumpIfZero::TackyJumpIfZero(TackyVal* condition, std::string target):condition(condition), target(target){}
+
+TackyJumpIfZero::~TackyJumpIfZero(){}
+
+TackyVal* TackyJumpIfZero::getCondition(){
+    return(this->condition);
+}
+
+std::string TackyJumpIfZero::getTarget(){
+    return(this->target);
+}
+
+void TackyJumpIfZero::print() const {
+    std::cout << "  if(";
+    if (this->condition) this->condition->print();
+    std::cout << " == 0) jump " << this->target << ";\n";
+}
+
+void TackyJumpIfZero::prettyPrint(int indent) const {
+    printIndent(indent);
+    std::cout << "JumpIfZero(" << this->target << "):\n";
+    printIndent(indent + 1);
+    std::cout << "Condition -> ";
+    if (this->condition) this->condition->prettyPrint(0); else std::cout << "None\n";
+}
+
+// ======================================================
+//                     TackySwitch:TackyInstruction
+// ======================================================
+TackySwitch::TackySwitch(TackyVal* value, std::vector<std::pair<int32_t, std::string>> cases, std::string defaultTarget)
+    :value(value), cases(cases), defaultTarget(defaultTarget){}
+
+TackySwitch::~TackySwitch(){}
+
+TackyVal* TackySwitch::getValue(){
+    return(this->value);
+}
+
+const std::vector<std::pair<int32_t, std::string>>& TackySwitch::getCases(){
+    return(this->cases);
+}
+
+std::string TackySwitch::getDefault(){
+    return(this->defaultTarget);
+}
+
+std::string TackySwitch::targetOf(int32_t value){
+    for(const std::pair<int32_t, std::string>& c: this->cases){
+        if(c.first == value){
+            return(c.second);
+        }
+    }
+    return(this->defaultTarget);
+}
+
+void TackySwitch::print() const {
+    std::cout << "  switch(";
+    if (this->value) this->value->print();
+    std::cout << ") {";
+    for(const std::pair<int32_t, std::string>& c: this->cases){
+        std::cout << " " << c.first << ": " << c.second << ";";
+    }
+    std::cout << " default: " << this->defaultTarget << "; }\n";
+}
+
+void TackySwitch::prettyPrint(int indent) const {
+    printIndent(indent);
+    std::cout << "Switch(default " << this->defaultTarget << "):\n";
+    printIndent(indent + 1);
+    std::cout << "Value -> ";
+    if (this->value) this->value->prettyPrint(0); else std::cout << "None\n";
+    for(const std::pair<int32_t, std::string>& c: this->cases){
+        printIndent(indent + 1);
+        std::cout << c.first << " -> " << c.second << "\n";
+    }
+}
+
+// ======================================================
+//                     TackyFunctionCall:TackyInstruction
+// ======================================================
+TackyFunctionCall::TackyFunctionCall(std::string name, std::vector<TackyVal*> args, TackyVal* dst)
+    :name(name), args(args), dst(dst){}
+
+TackyFunctionCall::~TackyFunctionCall(){}
+
+std::string TackyFunctionCall::getName(){
+    return(this->name);
+}
+
+std::vector<TackyVal*>& TackyFunctionCall::getArgs(){
+    return(this->args);
+}
+
+TackyVal* TackyFunctionCall::getDst(){
+    return(this->dst);
+}
+
+void TackyFunctionCall::print() const {
+    std::cout << "  ";
+    if (this->dst) this->dst->print();
+    std::cout << " = " << this->name << "(";
+    for(size_t i = 0; i < this->args.size(); i++){
+        if(i) std::cout << ", ";
+        this->args[i]->print();
+    }
+    std::cout << ");\n";
+}
+
+void TackyFunctionCall::prettyPrint(int indent) const {
+    printIndent(indent);
+    std::cout << "FunctionCall(" << this->name << "):\n";
+    printIndent(indent + 1);
+    std::cout << "Dst -> ";
+    if (this->dst) this->dst->prettyPrint(0); else std::cout << "None\n";
+    for(TackyVal* arg: this->args){
+        printIndent(indent + 1);
+        std::cout << "Arg -> ";
+        arg->prettyPrint(0);
+    }
+}
+
 // ======================================================
 //                     TackyFunction
 // ======================================================
 
-TackyFunction::TackyFunction(std::string identifier, std::vector<TackyInstruction*> body):identifier(identifier), body(body){}
+TackyFunction::TackyFunction(std::string identifier, std::vector<std::string> params, std::vector<TackyInstruction*> body)
+    :identifier(identifier), params(params), body(body){}
 
 std::string TackyFunction::getIdentifier(){
     return(this->identifier);
 }
 
+const std::vector<std::string>& TackyFunction::getParams(){
+    return(this->params);
+}
+
 std::vector<TackyInstruction*> TackyFunction::getBody(){
     return(this->body);
 }
 
+void TackyFunction::setBody(std::vector<TackyInstruction*> newBody){
+    this->body = newBody;
+}
+
 // void TackyFunction::print() const {
 //     std::cout << "function " << identifier << "():\n";
 //     for (auto* instr : body) {
@@ -139,7 +398,11 @@ std::vector<TackyInstruction*> TackyFunction::getBody(){
 // }
 
 void TackyFunction::print() const {
-    std::cout << "function " << identifier << "():\n";
+    std::cout << "function " << identifier << "(";
+    for(size_t i = 0; i < params.size(); i++){
+        std::cout << (i ? ", " : "") << params[i];
+    }
+    std::cout << "):\n";
     for (auto* instr : body)
         instr->print();
     std::cout << "\n";
@@ -178,6 +441,56 @@ void TackyProgram::prettyPrint(int indent) const {
 // ======================================================
 //                     TackyGenerator
 // ======================================================
+int TackyGenerator::labelExpression(ExpressionNode* expression){
+    // the left operands of a chain of binary operators are labelled in a loop, so a + b + ... + z doesn't recurse
+    // once per operator
+    std::vector<BinaryNode*> chain;
+    while(BinaryNode* binaryNode = dynamic_cast<BinaryNode*>(expression)){
+        chain.push_back(binaryNode);
+        expression = binaryNode->getLeft();
+    }
+    int need = 0;
+    if(UnaryNode* unaryNode = dynamic_cast<UnaryNode*>(expression)){
+        need = std::max(1, labelExpression(unaryNode->getExpression()));
+    }else if(AssignmentNode* assignmentNode = dynamic_cast<AssignmentNode*>(expression)){
+        need = labelExpression(assignmentNode->getExpression());
+    }else if(ConditionalNode* conditionalNode = dynamic_cast<ConditionalNode*>(expression)){
+        need = std::max(labelExpression(conditionalNode->getCondition()),
+            std::max(labelExpression(conditionalNode->getThen()), labelExpression(conditionalNode->getElse())));
+    }else if(FunctionCallNode* callNode = dynamic_cast<FunctionCallNode*>(expression)){
+        // the result comes back in a temporary of its own
+        need = 1;
+        const std::vector<ExpressionNode*>& arguments = callNode->getArguments();
+        for(size_t i = 0; i < arguments.size(); i++){
+            need = std::max(need, labelExpression(arguments[i]) + static_cast<int>(i));
+        }
+    }
+    expression->setRegisterNeed(need);
+    for(size_t i = chain.size(); i-- > 0;){
+        BinaryOperator op = chain[i]->getBinaryOperator();
+        int right = labelExpression(chain[i]->getRight());
+        if(op == BinaryOperator::Comma || op == BinaryOperator::LogicalAnd || op == BinaryOperator::LogicalOr){
+            // the value of the left operand is dropped (or tested) before the right one is evaluated
+            need = std::max(need, right);
+        }else{
+            need = combineNeeds(need, right);
+        }
+        chain[i]->setRegisterNeed(need);
+    }
+    return(need);
+}
+
+int TackyGenerator::combineNeeds(int first, int second){
+    if(first == second){
+        return(first + 1);
+    }
+    return(std::max(first, second));
+}
+
+bool TackyGenerator::evaluateSecondFirst(ExpressionNode* first, ExpressionNode* second){
+    return(second->getRegisterNeed() > first->getRegisterNeed());
+}
+
 TackyVal*  TackyGenerator::convertExpression(ExpressionNode* expression,std::vector<TackyInstruction*>& instructions){
     
     ExpressionType type =  expression->getType();
@@ -192,30 +505,235 @@ TackyVal*  TackyGenerator::convertExpression(ExpressionNode* expression,std::vec
         TackyVal* src = convertExpression(unaryNode->getExpression(), instructions);
         
         TackyVariable* dst = new TackyVariable{this->make_temporary()};
+        if(unaryOperator == UnaryOperator::LogicalNot){
+            // !e is e == 0
+            instructions.push_back(new TackyBinary{BinaryOperator::Equal, src, new TackyConstant{"0"}, dst});
+            return dst;
+        }
         TackyUnary* inst =  new TackyUnary{unaryOperator,src,dst};
         instructions.push_back(inst);
         return dst;
         
+    }else if(type == ExpressionType::VARIABLE){
+        return(new TackyVariable{dynamic_cast<VariableNode*>(expression)->getIdentifier()});
+    }else if(type == ExpressionType::ASSIGNMENT){
+        AssignmentNode* assignmentNode = dynamic_cast<AssignmentNode*>(expression);
+        TackyVal* src = convertExpression(assignmentNode->getExpression(), instructions);
+        std::string variable = assignmentNode->getVariable()->getIdentifier();
+        instructions.push_back(new TackyCopy{src, new TackyVariable{variable}});
+        return(new TackyVariable{variable});
+    }else if(type == ExpressionType::BINARY){
+        // the left operands of a chain are converted in a loop, so a + b + ... + z doesn't recurse once per operator.
+        // C leaves the order of the operands unspecified, so a right operand heavier than the left one is converted
+        // on the way down, before it, and the others on the way back up
+        std::vector<BinaryNode*> chain;
+        std::vector<TackyVal*> rights;
+        ExpressionNode* leaf = expression;
+        while(BinaryNode* binaryNode = dynamic_cast<BinaryNode*>(leaf)){
+            BinaryOperator op = binaryNode->getBinaryOperator();
+            bool arithmetic = op != BinaryOperator::Comma && op != BinaryOperator::LogicalAnd && op != BinaryOperator::LogicalOr;
+            chain.push_back(binaryNode);
+            rights.push_back(arithmetic && evaluateSecondFirst(binaryNode->getLeft(), binaryNode->getRight())
+                ? convertExpression(binaryNode->getRight(), instructions) : nullptr);
+            leaf = binaryNode->getLeft();
+        }
+        TackyVal* value = convertExpression(leaf, instructions);
+        for(size_t i = chain.size(); i-- > 0;){
+            BinaryNode* binaryNode = chain[i];
+            BinaryOperator op = binaryNode->getBinaryOperator();
+            if(op == BinaryOperator::Comma){
+                // the left operand is only evaluated for its side effects, and always first
+                value = convertExpression(binaryNode->getRight(), instructions);
+            }else if(op == BinaryOperator::LogicalAnd || op == BinaryOperator::LogicalOr){
+                value = convertLogical(binaryNode, value, instructions);
+            }else{
+                TackyVal* right = rights[i] != nullptr ? rights[i] : convertExpression(binaryNode->getRight(), instructions);
+                TackyVariable* dst = new TackyVariable{this->make_temporary()};
+                instructions.push_back(new TackyBinary{op, value, right, dst});
+                value = dst;
+            }
+        }
+        return(value);
+    }else if(type == ExpressionType::CONDITIONAL){
+        ConditionalNode* conditionalNode = dynamic_cast<ConditionalNode*>(expression);
+        std::string otherwise = make_label("else");
+        std::string end = make_label("end");
+        TackyVariable* dst = new TackyVariable{this->make_temporary()};
+        TackyVal* condition = convertExpression(conditionalNode->getCondition(), instructions);
+        instructions.push_back(new TackyJumpIfZero{condition, otherwise});
+        instructions.push_back(new TackyCopy{convertExpression(conditionalNode->getThen(), instructions), dst});
+        instructions.push_back(new TackyJump{end});
+        instructions.push_back(new TackyLabel{otherwise});
+        instructions.push_back(new TackyCopy{convertExpression(conditionalNode->getElse(), instructions), dst});
+        instructions.push_back(new TackyLabel{end});
+        return(new TackyVariable{dst->getVariableIdentifier()});
+    }else if(type == ExpressionType::FUNCTION_CALL){
+        FunctionCallNode* callNode = dynamic_cast<FunctionCallNode*>(expression);
+        std::vector<TackyVal*> args;
+        for(ExpressionNode* argument: callNode->getArguments()){
+            args.push_back(convertExpression(argument, instructions));
+        }
+        TackyVariable* dst = new TackyVariable{this->make_temporary()};
+        instructions.push_back(new TackyFunctionCall{callNode->getIdentifier(), args, dst});
+        return(new TackyVariable{dst->getVariableIdentifier()});
     }
     return(nullptr);
 }
 
-std::vector<TackyInstruction*> TackyGenerator::convertStatement(StatementNode* statement){
-    std::vector<TackyInstruction*> instructions;
-    StatementType type = statement->getType();
-    if (type == StatementType::RETURN) {
-        ReturnNode* returnNode = dynamic_cast<ReturnNode*>(statement);
-        TackyVal* val = convertExpression(returnNode->getExpression(), instructions);
-        TackyReturn* tackyReturn = new TackyReturn{val};
-        instructions.push_back(tackyReturn);
+// Checks if the value of the expression can only be 0 or 1
+static bool is_boolean(ExpressionNode* expression){
+    if(BinaryNode* binaryNode = dynamic_cast<BinaryNode*>(expression)){
+        switch(binaryNode->getBinaryOperator()){
+            case BinaryOperator::LessThan:
+            case BinaryOperator::LessOrEqual:
+            case BinaryOperator::GreaterThan:
+            case BinaryOperator::GreaterOrEqual:
+            case BinaryOperator::Equal:
+            case BinaryOperator::NotEqual:
+            case BinaryOperator::LogicalAnd:
+            case BinaryOperator::LogicalOr:
+                return(true);
+            default:
+                return(false);
+        }
+    }
+    UnaryNode* unaryNode = dynamic_cast<UnaryNode*>(expression);
+    return(unaryNode != nullptr && unaryNode->get_unary_operator() == UnaryOperator::LogicalNot);
+}
+
+TackyVal* TackyGenerator::convertLogical(BinaryNode* binaryNode, TackyVal* left, std::vector<TackyInstruction*>& instructions){
+    bool isAnd = binaryNode->getBinaryOperator() == BinaryOperator::LogicalAnd;
+    std::string shortCircuit = make_label(isAnd ? "false" : "right");
+    std::string end = make_label("end");
+    TackyVariable* dst = new TackyVariable{this->make_temporary()};
+    instructions.push_back(new TackyJumpIfZero{left, shortCircuit});
+    if(!isAnd){
+        instructions.push_back(new TackyCopy{new TackyConstant{"1"}, dst});
+        instructions.push_back(new TackyJump{end});
+        instructions.push_back(new TackyLabel{shortCircuit});
+    }
+    TackyVal* right = convertExpression(binaryNode->getRight(), instructions);
+    if(is_boolean(binaryNode->getRight())){
+        instructions.push_back(new TackyCopy{right, dst});
+    }else{
+        instructions.push_back(new TackyBinary{BinaryOperator::NotEqual, right, new TackyConstant{"0"}, dst});
+    }
+    if(isAnd){
+        instructions.push_back(new TackyJump{end});
+        instructions.push_back(new TackyLabel{shortCircuit});
+        instructions.push_back(new TackyCopy{new TackyConstant{"0"}, dst});
+    }
+    instructions.push_back(new TackyLabel{end});
+    return(new TackyVariable{dst->getVariableIdentifier()});
+}
+
+void TackyGenerator::convertStatement(StatementNode* statement, std::vector<TackyInstruction*>& instructions){
+    switch(statement->getType()){
+        case StatementType::RETURN: {
+            ReturnNode* returnNode = dynamic_cast<ReturnNode*>(statement);
+            labelExpression(returnNode->getExpression());
+            TackyVal* val = convertExpression(returnNode->getExpression(), instructions);
+            instructions.push_back(new TackyReturn{val});
+            break;
+        }
+        case StatementType::EXPRESSION: {
+            ExpressionStatementNode* expressionNode = dynamic_cast<ExpressionStatementNode*>(statement);
+            labelExpression(expressionNode->getExpression());
+            convertExpression(expressionNode->getExpression(), instructions);
+            break;
+        }
+        case StatementType::IF: {
+            IfNode* ifNode = dynamic_cast<IfNode*>(statement);
+            labelExpression(ifNode->getCondition());
+            TackyVal* condition = convertExpression(ifNode->getCondition(), instructions);
+            std::string end = make_label("end");
+            if(ifNode->getElse() == nullptr){
+                instructions.push_back(new TackyJumpIfZero{condition, end});
+                convertStatement(ifNode->getThen(), instructions);
+            }else{
+                std::string otherwise = make_label("else");
+                instructions.push_back(new TackyJumpIfZero{condition, otherwise});
+                convertStatement(ifNode->getThen(), instructions);
+                instructions.push_back(new TackyJump{end});
+                instructions.push_back(new TackyLabel{otherwise});
+                convertStatement(ifNode->getElse(), instructions);
+            }
+            instructions.push_back(new TackyLabel{end});
+            break;
+        }
+        case StatementType::COMPOUND:
+            for(StatementNode* inner: dynamic_cast<CompoundNode*>(statement)->getStatements()){
+                convertStatement(inner, instructions);
+            }
+            break;
+        case StatementType::SWITCH: {
+            SwitchNode* switchNode = dynamic_cast<SwitchNode*>(statement);
+            labelExpression(switchNode->getExpression());
+            TackyVal* value = convertExpression(switchNode->getExpression(), instructions);
+            std::string end = make_label("break");
+            std::vector<std::pair<int32_t, std::string>> cases;
+            for(CaseNode* caseNode: switchNode->getCases()){
+                std::string label = make_label("case");
+                this->caseLabels[caseNode] = label;
+                cases.push_back(std::make_pair(caseNode->getValue(), label));
+            }
+            std::string defaultTarget = end;
+            if(switchNode->getDefault() != nullptr){
+                defaultTarget = make_label("default");
+                this->caseLabels[switchNode->getDefault()] = defaultTarget;
+            }
+            instructions.push_back(new TackySwitch{value, cases, defaultTarget});
+            this->breakLabels.push_back(end);
+            convertStatement(switchNode->getBody(), instructions);
+            this->breakLabels.pop_back();
+            instructions.push_back(new TackyLabel{end});
+            break;
+        }
+        case StatementType::CASE: {
+            CaseNode* caseNode = dynamic_cast<CaseNode*>(statement);
+            instructions.push_back(new TackyLabel{this->caseLabels.at(caseNode)});
+            convertStatement(caseNode->getStatement(), instructions);
+            break;
+        }
+        case StatementType::DEFAULT: {
+            DefaultNode* defaultNode = dynamic_cast<DefaultNode*>(statement);
+            instructions.push_back(new TackyLabel{this->caseLabels.at(defaultNode)});
+            convertStatement(defaultNode->getStatement(), instructions);
+            break;
+        }
+        case StatementType::BREAK:
+            instructions.push_back(new TackyJump{this->breakLabels.back()});
+            break;
+        case StatementType::NULL_STATEMENT:
+            break;
+        case StatementType::DECLARATION: {
+            DeclarationNode* declarationNode = dynamic_cast<DeclarationNode*>(statement);
+            if(declarationNode->getInit() != nullptr){
+                labelExpression(declarationNode->getInit());
+                TackyVal* src = convertExpression(declarationNode->getInit(), instructions);
+                instructions.push_back(new TackyCopy{src, new TackyVariable{declarationNode->getIdentifier()}});
+            }
+            break;
+        }
     }
-    return(instructions);
 }
 
 TackyFunction* TackyGenerator::convertFunction(FunctionNode* function){
+    // Temporaries and labels are local to the function, numbering them per function keeps the output
+    // the same no matter which order (or thread) the functions are converted in
+    this->temp_counter = 0;
+    this->label_counter = 0;
+    this->caseLabels.clear();
     std::string identifier =  function->getIdentifer();
-    std::vector<TackyInstruction*> instructions = convertStatement(function->getStatement());
-    return(new TackyFunction{identifier,instructions});
+    std::vector<TackyInstruction*> instructions;
+    for(StatementNode* statement: function->getBody()){
+        convertStatement(statement, instructions);
+    }
+    if(instructions.empty() || dynamic_cast<TackyReturn*>(instructions.back()) == nullptr){
+        // falling off the end returns 0 (what C requires of main). It may be unreachable, simplify-cfg drops it then
+        instructions.push_back(new TackyReturn{new TackyConstant{"0"}});
+    }
+    return(new TackyFunction{identifier,function->getParameters(),instructions});
 }
 
 TackyProgram* TackyGenerator::convertProgram(AST* ast){
@@ -225,12 +743,16 @@ TackyProgram* TackyGenerator::convertProgram(AST* ast){
     }
     return(new TackyProgram{tackyFunctions});
 }
-TackyGenerator::TackyGenerator():temp_counter(0){}
+TackyGenerator::TackyGenerator():temp_counter(0), label_counter(0){}
 
 std::string TackyGenerator::make_temporary(){
     return( "tmp."+std::to_string(this->temp_counter++));
 }
 
+std::string TackyGenerator::make_label(const std::string& name){
+    return(name + "." + std::to_string(this->label_counter++));
+}
+
 /*
 Lexer: goes throgh the source file and construct Tokens based on the sybmols it sees.
 -------
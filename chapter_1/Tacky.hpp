@@ -219,6 +219,226 @@ class TackyUnary : public TackyInstruction {
         void prettyPrint(int indent = 0) const override;
 };
 
+// ======================================================
+//                     TackyCopy : TackyInstruction
+// ======================================================
+/**
+ * @brief TackyCopy : TackyInstruction
+ * dst = src. Produced for assignments to variables, and by the optimizer when a chain of operations cancels out
+ * (i.e -(-x) => x).
+ * 
+ */
+class TackyCopy : public TackyInstruction {
+    private:
+        /**
+         * @brief The value being copied
+         * 
+         */
+        TackyVal* src;
+        /**
+         * @brief Where the value is copied to
+         * 
+         */
+        TackyVal* dst;
+
+    public:
+        TackyCopy(TackyVal* src, TackyVal* dst);
+        ~TackyCopy() override;
+        /**
+         * @brief Get the Src object
+         * 
+         * @return TackyVal* 
+         */
+        TackyVal* getSrc();
+        /**
+         * @brief Get the Dst object
+         * 
+         * @return TackyVal* 
+         */
+        TackyVal* getDst();
+
+        void print() const override;
+        void prettyPrint(int indent = 0) const override;
+};
+
+// ======================================================
+//                     TackyBinary : TackyInstruction
+// ======================================================
+/**
+ * @brief TackyBinary : TackyInstruction
+ * dst = src1 op src2.
+ * 
+ */
+class TackyBinary : public TackyInstruction {
+    private:
+        /**
+         * @brief The Binary Operator being performed
+         * 
+         */
+        BinaryOperator binary_operator;
+        /**
+         * @brief The left operand
+         * 
+         */
+        TackyVal* src1;
+        /**
+         * @brief The right operand
+         * 
+         */
+        TackyVal* src2;
+        /**
+         * @brief The Destination of the Binary Operation
+         * 
+         */
+        TackyVal* dst;
+
+    public:
+        TackyBinary(BinaryOperator binary_operator, TackyVal* src1, TackyVal* src2, TackyVal* dst);
+        ~TackyBinary() override;
+        /**
+         * @brief Get the Binary Operator object
+         * 
+         * @return BinaryOperator 
+         */
+        BinaryOperator getBinaryOperator();
+        TackyVal* getSrc1();
+        TackyVal* getSrc2();
+        TackyVal* getDst();
+
+        void print() const override;
+        void prettyPrint(int indent = 0) const override;
+};
+
+// ======================================================
+//                     TackyLabel : TackyInstruction
+// ======================================================
+/**
+ * @brief TackyLabel : TackyInstruction
+ * A jump target. Labels are local to their function, the lowering qualifies them with its name.
+ * 
+ */
+class TackyLabel : public TackyInstruction {
+    private:
+        std::string identifier;
+
+    public:
+        explicit TackyLabel(std::string identifier);
+        ~TackyLabel() override;
+        std::string getIdentifier();
+
+        void print() const override;
+        void prettyPrint(int indent = 0) const override;
+};
+
+// ======================================================
+//                     TackyJump : TackyInstruction
+// ======================================================
+/**
+ * @brief TackyJump : TackyInstruction
+ * goto target
+ * 
+ */
+class TackyJump : public TackyInstruction {
+    private:
+        /**
+         * @brief Identifier of the TackyLabel jumped to
+         * 
+         */
+        std::string target;
+
+    public:
+        explicit TackyJump(std::string target);
+        ~TackyJump() override;
+        std::string getTarget();
+
+        void print() const override;
+        void prettyPrint(int indent = 0) const override;
+};
+
+// ======================================================
+//                     TackyJumpIfZero : TackyInstruction
+// ======================================================
+/**
+ * @brief TackyJumpIfZero : TackyInstruction
+ * if(condition == 0) goto target, falls through to the next instruction otherwise
+ * 
+ */
+class TackyJumpIfZero : public TackyInstruction {
+    private:
+        TackyVal* condition;
+        std::string target;
+
+    public:
+        TackyJumpIfZero(TackyVal* condition, std::string target);
+        ~TackyJumpIfZero() override;
+        TackyVal* getCondition();
+        std::string getTarget();
+
+        void print() const override;
+        void prettyPrint(int indent = 0) const override;
+};
+
+// ======================================================
+//                     TackySwitch : TackyInstruction
+// ======================================================
+/**
+ * @brief TackySwitch : TackyInstruction
+ * goto the label of the case equal to value, or to the default label when there is none. It never falls
+ * through. How the comparison is made (jump table or compare tree) is left to the instruction selector.
+ *
+ */
+class TackySwitch : public TackyInstruction {
+    private:
+        TackyVal* value;
+        /**
+         * @brief (case value, label) pairs, the values are unique
+         *
+         */
+        std::vector<std::pair<int32_t, std::string>> cases;
+        std::string defaultTarget;
+
+    public:
+        TackySwitch(TackyVal* value, std::vector<std::pair<int32_t, std::string>> cases, std::string defaultTarget);
+        ~TackySwitch() override;
+        TackyVal* getValue();
+        const std::vector<std::pair<int32_t, std::string>>& getCases();
+        std::string getDefault();
+        /**
+         * @brief The label the switch jumps to for a value
+         *
+         */
+        std::string targetOf(int32_t value);
+
+        void print() const override;
+        void prettyPrint(int indent = 0) const override;
+};
+
+// ======================================================
+//                     TackyFunctionCall
+// ======================================================
+/**
+ * @brief TackyFunctionCall : TackyInstruction
+ * dst = name(args...). The arguments are read when the call is made, in order. The callee may be defined in
+ * another translation unit, so a call is never dropped even when dst is unused.
+ *
+ */
+class TackyFunctionCall : public TackyInstruction {
+    private:
+        std::string name;
+        std::vector<TackyVal*> args;
+        TackyVal* dst;
+
+    public:
+        TackyFunctionCall(std::string name, std::vector<TackyVal*> args, TackyVal* dst);
+        ~TackyFunctionCall() override;
+        std::string getName();
+        std::vector<TackyVal*>& getArgs();
+        TackyVal* getDst();
+
+        void print() const override;
+        void prettyPrint(int indent = 0) const override;
+};
+
 // ======================================================
 //                     TackyFunction
 // ======================================================
@@ -233,6 +453,11 @@ class TackyFunction {
          * 
          */
         std::string identifier;
+        /**
+         * @brief The variables holding the parameters on entry, in order
+         *
+         */
+        std::vector<std::string> params;
         /**
          * @brief The body of the function in TAC representation.
          * 
@@ -240,11 +465,18 @@ class TackyFunction {
         std::vector<TackyInstruction*> body;
 
     public:
-        TackyFunction(std::string identifier, std::vector<TackyInstruction*> body);
+        TackyFunction(std::string identifier, std::vector<std::string> params, std::vector<TackyInstruction*> body);
         ~TackyFunction();
 
         std::string getIdentifier();
+        const std::vector<std::string>& getParams();
         std::vector<TackyInstruction*> getBody();
+        /**
+         * @brief Replace the body of the function. Used by the passes that rewrite the TAC.
+         * 
+         * @param newBody 
+         */
+        void setBody(std::vector<TackyInstruction*> newBody);
 
         void print() const;
         void prettyPrint(int indent = 0) const;
@@ -285,13 +517,110 @@ public:
 class TackyGenerator {
     private:
         int temp_counter;
+        int label_counter;
+        /**
+         * @brief The label given to each case and default of the switches being converted
+         *
+         */
+        std::unordered_map<const StatementNode*, std::string> caseLabels;
+        /**
+         * @brief Where a break goes, the end of each enclosing switch, innermost last
+         *
+         */
+        std::vector<std::string> breakLabels;
 
     public:
         TackyGenerator();
         std::string make_temporary();
+        /**
+         * @brief Makes a label unique within the function (i.e "else.3")
+         * 
+         * @param name what the label is for
+         * @return std::string 
+         */
+        std::string make_label(const std::string& name);
+        /**
+         * @brief Computes the Sethi-Ullman label of every node of the expression, bottom up:
+         *      constant            0 (it is an immediate operand, no temporary needed)
+         *      variable            0 (read in place)
+         *      variable = e        need(e) (the value of e is copied into the variable)
+         *      unary op e          max(1, need(e)) (the result can reuse the temporary of e)
+         *      e1 op e2            max(need(e1), need(e2)) if they differ, need(e1) + 1 otherwise (combineNeeds)
+         *      e1, e2              max(need(e1), need(e2)), the value of e1 is dropped (or tested, for && and ||)
+         *                          before e2 runs
+         *      c ? a : b           max of the three, only one arm runs
+         *      f(e1, ..., en)      max(1, max(need(ei) + i - 1)), the values of the arguments before ei are live
+         *                          while it is evaluated
+         *
+         * @param expression
+         * @return int the label of the expression
+         */
+        static int labelExpression(ExpressionNode* expression);
+        /**
+         * @brief The label of a node with two operands, evaluating the one with the larger label first.
+         * The heavier operand is evaluated with every temporary free, and only the result of the first
+         * operand is live while the second one is evaluated, which is what makes the count minimal.
+         *
+         * @param first
+         * @param second
+         * @return int
+         */
+        static int combineNeeds(int first, int second);
+        /**
+         * @brief Checks if the second operand of a node should be evaluated before the first, because it needs
+         * more temporaries. Operands with the same label keep the source order.
+         *
+         * @param first
+         * @param second
+         * @return bool
+         */
+        static bool evaluateSecondFirst(ExpressionNode* first, ExpressionNode* second);
 
+        /**
+         * @brief Appends the TAC of the expression and returns the value holding its result. A comparison is a
+         * TackyBinary giving 0 or 1 and !e is e == 0. c ? a : b is
+         *      t = c; JumpIfZero(t, else.n); dst = a; Jump(end.n); else.n: dst = b; end.n:
+         * with dst a temporary written on both paths. The instruction selector turns such a diamond into a cmov when
+         * its arms are cheap and have no side effects (see InstructionSelector.hpp). A call evaluates its arguments
+         * left to right and puts its result in a new temporary.
+         *
+         * @param expression
+         * @param instructions
+         * @return TackyVal*
+         */
         TackyVal* convertExpression(ExpressionNode* expression, std::vector<TackyInstruction*>& instructions);
-        std::vector<TackyInstruction*> convertStatement(StatementNode* statement);
+        /**
+         * @brief Appends the rest of the TAC of e1 && e2 or e1 || e2 once e1 is in left, short circuiting on it:
+         *      &&      t = e1; JumpIfZero(t, false.n); dst = e2 != 0; Jump(end.n); false.n: dst = 0; end.n:
+         *      ||      t = e1; JumpIfZero(t, right.n); dst = 1; Jump(end.n); right.n: dst = e2 != 0; end.n:
+         * e2 != 0 is a plain copy when e2 is already 0 or 1 (a comparison, !, && or ||).
+         *
+         * @param binaryNode
+         * @param left the value of e1
+         * @param instructions
+         * @return TackyVal*
+         */
+        TackyVal* convertLogical(BinaryNode* binaryNode, TackyVal* left, std::vector<TackyInstruction*>& instructions);
+        /**
+         * @brief Appends the TAC of the statement. An if becomes
+         *      c = condition; JumpIfZero(c, else.n); then; Jump(end.n); else.n: else; end.n:
+         * without the Jump and the else part when it has no else. A switch is
+         *      v = e; Switch(v, [c1: case.n1, ...], default.m); body; break.k:
+         * with a label in the body for every case and default (the switch goes to break.k when it has no default),
+         * and a break is a Jump to the break label of the closest switch. A declaration with an initializer is a
+         * Copy to the variable, which keeps the unique name the Parser gave it.
+         *
+         * @param statement
+         * @param instructions
+         */
+        void convertStatement(StatementNode* statement, std::vector<TackyInstruction*>& instructions);
+        /**
+         * @brief Converts the body of the function. A body whose end can be reached gets a return 0, so every
+         * path of the TAC ends with a return (see ControlFlowGraph.hpp).
+         *
+         * @param function
+         * @return TackyFunction*
+         */
         TackyFunction* convertFunction(FunctionNode* function);
         /**
          * @brief Takes in the root of an AST and produces the root of a Tacky tree
@@ -0,0 +1,89 @@
+#include "ThreadPool.hpp"
+#include <exception>
+#include <thread>
+
+// ======================================================
+//                     ThreadPool
+// ======================================================
+ThreadPool::ThreadPool(unsigned threadCount):threadCount(threadCount){
+    if(this->threadCount == 0){
+        this->threadCount = std::thread::hardware_concurrency();
+    }
+    if(this->threadCount == 0){
+        this->threadCount = 1;
+    }
+    for(unsigned i = 0; i < this->threadCount; i++){
+        this->queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue{}));
+    }
+}
+
+unsigned ThreadPool::getThreadCount(){
+    return(this->threadCount);
+}
+
+bool ThreadPool::nextJob(unsigned worker, size_t& job){
+    {
+        WorkQueue& own = *this->queues[worker];
+        std::lock_guard<std::mutex> guard{own.lock};
+        if(!own.jobs.empty()){
+            job = own.jobs.back();
+            own.jobs.pop_back();
+            return(true);
+        }
+    }
+    for(unsigned i = 1; i < this->threadCount; i++){
+        WorkQueue& victim = *this->queues[(worker + i) % this->threadCount];
+        std::lock_guard<std::mutex> guard{victim.lock};
+        if(!victim.jobs.empty()){
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            return(true);
+        }
+    }
+    return(false);
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task){
+    if(this->threadCount == 1 || count <= 1){
+        for(size_t i = 0; i < count; i++){
+            task(i);
+        }
+        return;
+    }
+    // Jobs are only ever added here, before the workers start, so a worker that finds every queue empty is done
+    for(unsigned w = 0; w < this->threadCount; w++){
+        size_t begin = count * w / this->threadCount;
+        size_t end = count * (w + 1) / this->threadCount;
+        for(size_t i = begin; i < end; i++){
+            this->queues[w]->jobs.push_back(i);
+        }
+    }
+
+    std::mutex errorLock;
+    std::exception_ptr firstError = nullptr;
+    auto work = [&](unsigned worker){
+        size_t job;
+        while(nextJob(worker, job)){
+            try{
+                task(job);
+            }catch(...){
+                std::lock_guard<std::mutex> guard{errorLock};
+                if(!firstError){
+                    firstError = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for(unsigned w = 1; w < this->threadCount; w++){
+        workers.emplace_back(work, w);
+    }
+    work(0);
+    for(std::thread& t: workers){
+        t.join();
+    }
+    if(firstError){
+        std::rethrow_exception(firstError);
+    }
+}
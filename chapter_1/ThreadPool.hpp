@@ -0,0 +1,56 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// ======================================================
+//                     ThreadPool
+// ======================================================
+/**
+ * @brief A work-stealing pool used to run independent jobs (i.e one per function) on several cores.
+ *
+ * Each worker owns a deque of job indices. A worker takes jobs from the back of its own deque and,
+ * once that runs dry, steals from the front of another worker's deque. Jobs start out split into
+ * contiguous blocks so neighbouring functions usually stay on the same core.
+ */
+class ThreadPool {
+    private:
+        struct WorkQueue {
+            std::mutex lock;
+            std::deque<size_t> jobs;
+        };
+        unsigned threadCount;
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        /**
+         * @brief Pops a job from the back of the worker's own queue, or steals one from the front of another queue.
+         *
+         * @param worker index of the worker looking for work
+         * @param job set to the index of the job found
+         * @return bool false when every queue is empty
+         */
+        bool nextJob(unsigned worker, size_t& job);
+
+    public:
+        /**
+         * @brief Construct a new Thread Pool object
+         *
+         * @param threadCount number of workers, 0 picks the number of hardware threads
+         */
+        explicit ThreadPool(unsigned threadCount);
+        unsigned getThreadCount();
+        /**
+         * @brief Runs task(0) ... task(count - 1) across the workers and waits for all of them.
+         * If a job throws, the remaining jobs still run and the first exception is rethrown to the caller.
+         *
+         * @param count
+         * @param task
+         */
+        void parallelFor(size_t count, const std::function<void(size_t)>& task);
+};
+
+#endif // THREADPOOL_HPP
@@ -35,6 +35,102 @@ std::string token_to_string(TokenType type){
         case 10:
             return("HYPHEN");
             break;
+        case 11:
+            return("ASSIGN");
+            break;
+        case 12:
+            return("PLUS");
+            break;
+        case 13:
+            return("ASTERISK");
+            break;
+        case 14:
+            return("SLASH");
+            break;
+        case 15:
+            return("PERCENT");
+            break;
+        case 16:
+            return("LESS");
+            break;
+        case 17:
+            return("GREATER");
+            break;
+        case 18:
+            return("LESS_EQUAL");
+            break;
+        case 19:
+            return("GREATER_EQUAL");
+            break;
+        case 20:
+            return("EQUAL");
+            break;
+        case 21:
+            return("NOT_EQUAL");
+            break;
+        case 22:
+            return("AMPERSAND");
+            break;
+        case 23:
+            return("CARET");
+            break;
+        case 24:
+            return("PIPE");
+            break;
+        case 25:
+            return("LOGICAL_AND");
+            break;
+        case 26:
+            return("LOGICAL_OR");
+            break;
+        case 27:
+            return("LEFT_SHIFT");
+            break;
+        case 28:
+            return("RIGHT_SHIFT");
+            break;
+        case 29:
+            return("QUESTION");
+            break;
+        case 30:
+            return("COLON");
+            break;
+        case 31:
+            return("COMMA");
+            break;
+        case 32:
+            return("PLUS_ASSIGN");
+            break;
+        case 33:
+            return("HYPHEN_ASSIGN");
+            break;
+        case 34:
+            return("ASTERISK_ASSIGN");
+            break;
+        case 35:
+            return("SLASH_ASSIGN");
+            break;
+        case 36:
+            return("PERCENT_ASSIGN");
+            break;
+        case 37:
+            return("AMPERSAND_ASSIGN");
+            break;
+        case 38:
+            return("CARET_ASSIGN");
+            break;
+        case 39:
+            return("PIPE_ASSIGN");
+            break;
+        case 40:
+            return("LEFT_SHIFT_ASSIGN");
+            break;
+        case 41:
+            return("RIGHT_SHIFT_ASSIGN");
+            break;
+        case 42:
+            return("EXCLAMATION");
+            break;
         default:
             return("UNKNOWN");
     }
@@ -43,15 +139,15 @@ Token::Token(std::string value, TokenType type){
     this->type =  type;
     this->value = value;
 }
-std::string Token::getValue(){
+const std::string& Token::getValue() const{
     return(this->value);
 }
-enum TokenType Token::getTokenType(){
+enum TokenType Token::getTokenType() const{
     return(this->type);
 }
 
-std::unordered_set<TokenType> unaryOperators = {HYPHEN,TILDE};
-bool isUnaryOperator(Token t){
+std::unordered_set<TokenType> unaryOperators = {HYPHEN,TILDE,EXCLAMATION};
+bool isUnaryOperator(const Token& t){
     if(unaryOperators.find(t.getTokenType()) == unaryOperators.end()){
         return(false);
     }
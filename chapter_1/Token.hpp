@@ -14,7 +14,41 @@ enum TokenType{
     IDENTIFIER,
     DECREMENT,
     TILDE,
-    HYPHEN
+    HYPHEN,
+    ASSIGN,
+    PLUS,
+    ASTERISK,
+    SLASH,
+    PERCENT,
+    LESS,
+    GREATER,
+    LESS_EQUAL,
+    GREATER_EQUAL,
+    EQUAL,
+    NOT_EQUAL,
+    AMPERSAND,
+    CARET,
+    PIPE,
+    LOGICAL_AND,
+    LOGICAL_OR,
+    LEFT_SHIFT,
+    RIGHT_SHIFT,
+    QUESTION,
+    COLON,
+    COMMA,
+    PLUS_ASSIGN,
+    HYPHEN_ASSIGN,
+    ASTERISK_ASSIGN,
+    SLASH_ASSIGN,
+    PERCENT_ASSIGN,
+    AMPERSAND_ASSIGN,
+    CARET_ASSIGN,
+    PIPE_ASSIGN,
+    LEFT_SHIFT_ASSIGN,
+    RIGHT_SHIFT_ASSIGN,
+    EXCLAMATION,
+    // not a token, the number of token types (tables indexed by TokenType are this long)
+    TOKEN_TYPE_COUNT
 };
 class Token{
     public:
@@ -22,8 +56,8 @@ class Token{
 
         }
         Token(std::string value, TokenType type);
-        std::string getValue();
-        enum TokenType getTokenType();
+        const std::string& getValue() const;
+        enum TokenType getTokenType() const;
 
     private:
         std::string value;
@@ -33,6 +67,6 @@ class Token{
 };
 
 std::string token_to_string(TokenType type);
-bool isUnaryOperator(Token t);
+bool isUnaryOperator(const Token& t);
 
 #endif // TOKEN_HPP
\ No newline at end of file
@@ -0,0 +1,613 @@
+#include "X86Encoder.hpp"
+#include "Optimizer.hpp"
+#include "Profile.hpp"
+#include <elf.h>
+#include <stdexcept>
+
+// register numbers used in the ModRM, SIB and REX bytes
+static const int RSP = 4;
+static const int RBP = 5;
+
+// DWARF call frame instructions (.eh_frame) and the DWARF numbers of %rsp and %rbp, which are not the ones above
+static const uint8_t DW_CFA_advance_loc = 0x40;
+static const uint8_t DW_CFA_offset = 0x80;
+static const uint8_t DW_CFA_advance_loc1 = 0x02;
+static const uint8_t DW_CFA_advance_loc2 = 0x03;
+static const uint8_t DW_CFA_advance_loc4 = 0x04;
+static const uint8_t DW_CFA_remember_state = 0x0A;
+static const uint8_t DW_CFA_restore_state = 0x0B;
+static const uint8_t DW_CFA_def_cfa = 0x0C;
+static const uint8_t DW_CFA_def_cfa_register = 0x0D;
+static const uint8_t DW_CFA_def_cfa_offset = 0x0E;
+static const uint8_t DWARF_RSP = 7;
+static const uint8_t DWARF_RBP = 6;
+
+const char* const X86Encoder::READ_ONLY_SECTION = ".rodata";
+
+// ======================================================
+//                     X86Encoder
+// ======================================================
+int X86Encoder::registerNumber(RegisterName reg){
+    switch(reg){
+        case RegisterName::AX: return 0;
+        case RegisterName::CX: return 1;
+        case RegisterName::DX: return 2;
+        case RegisterName::SI: return 6;
+        case RegisterName::DI: return 7;
+        case RegisterName::R8: return 8;
+        case RegisterName::R9: return 9;
+        case RegisterName::R10: return 10;
+        case RegisterName::R11: return 11;
+    }
+    throw std::runtime_error("Cannot encode unknown register");
+}
+
+uint8_t X86Encoder::conditionNibble(ConditionCode condition){
+    switch(condition){
+        case ConditionCode::E: return 0x4;
+        case ConditionCode::NE: return 0x5;
+        case ConditionCode::L: return 0xC;
+        case ConditionCode::GE: return 0xD;
+        case ConditionCode::LE: return 0xE;
+        case ConditionCode::G: return 0xF;
+        case ConditionCode::B: return 0x2;
+        case ConditionCode::AE: return 0x3;
+        case ConditionCode::BE: return 0x6;
+        case ConditionCode::A: return 0x7;
+    }
+    throw std::runtime_error("Cannot encode unknown condition");
+}
+
+int32_t X86Encoder::immediateValue(OperandNode* op){
+    ImmediateNode* imm = dynamic_cast<ImmediateNode*>(op);
+    if(imm == nullptr){
+        throw std::runtime_error("Expected an immediate operand");
+    }
+    // same truncation to 32 bits the assembler does for movl/addl
+    return(TackySimplifier::wrapConstant(imm->getImm()));
+}
+
+bool X86Encoder::fitsInByte(int32_t value){
+    return(value >= -128 && value <= 127);
+}
+
+void X86Encoder::emitByte(uint8_t byte){
+    this->code.push_back(byte);
+}
+
+void X86Encoder::emitInt32(int32_t value){
+    uint32_t bits = static_cast<uint32_t>(value);
+    for(int i = 0; i < 4; i++){
+        emitByte(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+}
+
+void X86Encoder::emitOpcode(uint16_t opcode){
+    if(opcode > 0xFF){
+        emitByte(static_cast<uint8_t>(opcode >> 8));
+    }
+    emitByte(static_cast<uint8_t>(opcode));
+}
+
+void X86Encoder::emitRegister(uint16_t opcode, int reg, int rm, bool wide){
+    uint8_t rex = (wide ? 0x08 : 0) | (reg >= 8 ? 0x04 : 0) | (rm >= 8 ? 0x01 : 0);
+    if(rex != 0){
+        emitByte(0x40 | rex);
+    }
+    emitOpcode(opcode);
+    emitByte(static_cast<uint8_t>(0xC0 | (reg & 7) << 3 | (rm & 7)));
+}
+
+void X86Encoder::emitMemory(uint16_t opcode, int reg, int base, int32_t displacement, bool wide){
+    uint8_t rex = (wide ? 0x08 : 0) | (reg >= 8 ? 0x04 : 0) | (base >= 8 ? 0x01 : 0);
+    if(rex != 0){
+        emitByte(0x40 | rex);
+    }
+    emitOpcode(opcode);
+    // %rbp and %r13 as a base always need a displacement, mod 00 means rip relative for them
+    uint8_t mod = 0x80;
+    if(displacement == 0 && (base & 7) != RBP){
+        mod = 0x00;
+    }else if(fitsInByte(displacement)){
+        mod = 0x40;
+    }
+    emitByte(static_cast<uint8_t>(mod | (reg & 7) << 3 | (base & 7)));
+    if((base & 7) == RSP){
+        // %rsp and %r12 as a base need a SIB byte
+        emitByte(0x24);
+    }
+    if(mod == 0x40){
+        emitByte(static_cast<uint8_t>(displacement));
+    }else if(mod == 0x80){
+        emitInt32(displacement);
+    }
+}
+
+void X86Encoder::emitIndexed(uint8_t opcode, int reg, int base, int index, int scale, int32_t displacement, bool wide){
+    uint8_t rex = (wide ? 0x08 : 0) | (reg >= 8 ? 0x04 : 0) | (index >= 8 ? 0x02 : 0) | (base >= 8 ? 0x01 : 0);
+    if(rex != 0){
+        emitByte(0x40 | rex);
+    }
+    emitByte(opcode);
+    uint8_t mod = 0x80;
+    if(displacement == 0 && (base & 7) != RBP){
+        mod = 0x00;
+    }else if(fitsInByte(displacement)){
+        mod = 0x40;
+    }
+    uint8_t scaleBits = scale == 8 ? 3 : scale == 4 ? 2 : scale == 2 ? 1 : 0;
+    emitByte(static_cast<uint8_t>(mod | (reg & 7) << 3 | RSP));
+    emitByte(static_cast<uint8_t>(scaleBits << 6 | (index & 7) << 3 | (base & 7)));
+    if(mod == 0x40){
+        emitByte(static_cast<uint8_t>(displacement));
+    }else if(mod == 0x80){
+        emitInt32(displacement);
+    }
+}
+
+void X86Encoder::emitModRM(uint16_t opcode, int reg, OperandNode* rm, bool wide){
+    if(RegisterNode* regNode = dynamic_cast<RegisterNode*>(rm)){
+        emitRegister(opcode, reg, registerNumber(regNode->getRegEnum()), wide);
+    }else if(Stack* stack = dynamic_cast<Stack*>(rm)){
+        emitMemory(opcode, reg, stack->getBase() == FrameBase::RBP ? RBP : RSP, stack->getAmount(), wide);
+    }else{
+        throw std::runtime_error("Cannot encode operand, only registers and stack slots can be the r/m operand");
+    }
+}
+
+void X86Encoder::encodeMove(MoveInstruction* mov){
+    OperandNode* src = mov->getSrc();
+    OperandNode* dst = mov->getDst();
+    RegisterNode* srcReg = dynamic_cast<RegisterNode*>(src);
+    RegisterNode* dstReg = dynamic_cast<RegisterNode*>(dst);
+    if(src->getType() == IMM && dstReg != nullptr){
+        // movl $imm, %r => B8+r id
+        int r = registerNumber(dstReg->getRegEnum());
+        if(r >= 8){
+            emitByte(0x41);
+        }
+        emitByte(static_cast<uint8_t>(0xB8 + (r & 7)));
+        emitInt32(immediateValue(src));
+    }else if(src->getType() == IMM){
+        emitModRM(0xC7, 0, dst);
+        emitInt32(immediateValue(src));
+    }else if(srcReg != nullptr){
+        emitModRM(0x89, registerNumber(srcReg->getRegEnum()), dst);
+    }else if(dstReg != nullptr){
+        emitModRM(0x8B, registerNumber(dstReg->getRegEnum()), src);
+    }else{
+        throw std::runtime_error("Cannot encode movl from memory to memory");
+    }
+}
+
+void X86Encoder::encodeUnary(UnaryInstruction* unary){
+    switch(unary->getUnaryOperator()){
+        case UnaryOperator::Negation: emitModRM(0xF7, 3, unary->getOperand()); break;
+        case UnaryOperator::Complement: emitModRM(0xF7, 2, unary->getOperand()); break;
+        case UnaryOperator::Increment: emitModRM(0xFF, 0, unary->getOperand()); break;
+        case UnaryOperator::Decrement: emitModRM(0xFF, 1, unary->getOperand()); break;
+        default: throw std::runtime_error("Cannot encode unknown unary operator");
+    }
+}
+
+void X86Encoder::encodeBinary(BinaryInstruction* binary){
+    // opcode extension of the 83/81 immediate forms, then the r => r/m and r/m => r opcodes
+    int extension = 0;
+    uint8_t toRm = 0x01, toReg = 0x03;
+    switch(binary->getBinaryOperator()){
+        case BinaryOperator::Add: break;
+        case BinaryOperator::Subtract: extension = 5; toRm = 0x29; toReg = 0x2B; break;
+        case BinaryOperator::BitwiseAnd: extension = 4; toRm = 0x21; toReg = 0x23; break;
+        case BinaryOperator::BitwiseOr: extension = 1; toRm = 0x09; toReg = 0x0B; break;
+        case BinaryOperator::BitwiseXor: extension = 6; toRm = 0x31; toReg = 0x33; break;
+        case BinaryOperator::Multiply: encodeMultiply(binary); return;
+        case BinaryOperator::LeftShift:
+        case BinaryOperator::RightShift:
+        case BinaryOperator::LogicalRightShift: encodeShift(binary); return;
+        default: throw std::runtime_error("Cannot encode binary operator " + binary_operator_to_string(binary->getBinaryOperator()));
+    }
+    OperandNode* src = binary->getSrc();
+    OperandNode* dst = binary->getDst();
+    RegisterNode* srcReg = dynamic_cast<RegisterNode*>(src);
+    RegisterNode* dstReg = dynamic_cast<RegisterNode*>(dst);
+    if(src->getType() == IMM){
+        int32_t value = immediateValue(src);
+        if(fitsInByte(value)){
+            emitModRM(0x83, extension, dst);
+            emitByte(static_cast<uint8_t>(value));
+        }else if(dstReg != nullptr && dstReg->getRegEnum() == RegisterName::AX){
+            // 05, 2D, 25, 0D, 35: the opcode of the %eax form is 8 * extension + 5
+            emitByte(static_cast<uint8_t>(8 * extension + 5));
+            emitInt32(value);
+        }else{
+            emitModRM(0x81, extension, dst);
+            emitInt32(value);
+        }
+    }else if(srcReg != nullptr){
+        emitModRM(toRm, registerNumber(srcReg->getRegEnum()), dst);
+    }else if(dstReg != nullptr){
+        emitModRM(toReg, registerNumber(dstReg->getRegEnum()), src);
+    }else{
+        throw std::runtime_error("Cannot encode a binary instruction from memory to memory");
+    }
+}
+
+void X86Encoder::encodeMultiply(BinaryInstruction* binary){
+    RegisterNode* dstReg = dynamic_cast<RegisterNode*>(binary->getDst());
+    if(dstReg == nullptr){
+        throw std::runtime_error("Cannot encode imull into memory");
+    }
+    int dst = registerNumber(dstReg->getRegEnum());
+    OperandNode* src = binary->getSrc();
+    if(src->getType() == IMM){
+        // imull $imm, %r => imul r, r/m, imm: 6B /r ib or 69 /r id with r/m the same register
+        int32_t value = immediateValue(src);
+        emitRegister(fitsInByte(value) ? 0x6B : 0x69, dst, dst);
+        if(fitsInByte(value)){
+            emitByte(static_cast<uint8_t>(value));
+        }else{
+            emitInt32(value);
+        }
+    }else{
+        // imull r/m, %r => 0F AF /r
+        emitModRM(0x0FAF, dst, src);
+    }
+}
+
+void X86Encoder::encodeShift(BinaryInstruction* binary){
+    int extension = binary->getBinaryOperator() == BinaryOperator::LeftShift ? 4
+        : binary->getBinaryOperator() == BinaryOperator::RightShift ? 7 : 5;
+    if(binary->getSrc()->getType() == REG){
+        // D3 /digit, the count is in %cl
+        emitModRM(0xD3, extension, binary->getDst());
+        return;
+    }
+    int32_t count = immediateValue(binary->getSrc());
+    if(count == 1){
+        // D1 /digit, no immediate
+        emitModRM(0xD1, extension, binary->getDst());
+    }else{
+        // C1 /digit ib
+        emitModRM(0xC1, extension, binary->getDst());
+        emitByte(static_cast<uint8_t>(count));
+    }
+}
+
+void X86Encoder::encodeMultiplyHigh(MultiplyHighInstruction* multiply){
+    int src = registerNumber(multiply->getSrc()->getRegEnum());
+    int dst = registerNumber(multiply->getDst()->getRegEnum());
+    // movslq %src, %dst => REX.W 63 /r
+    emitRegister(0x63, dst, src, true);
+    // imulq $magic, %dst, %dst => REX.W 6B /r ib or REX.W 69 /r id
+    int32_t magic = multiply->getMagic();
+    emitRegister(fitsInByte(magic) ? 0x6B : 0x69, dst, dst, true);
+    if(fitsInByte(magic)){
+        emitByte(static_cast<uint8_t>(magic));
+    }else{
+        emitInt32(magic);
+    }
+    // sarq $(32 + shift), %dst => REX.W C1 /7 ib
+    emitRegister(0xC1, 7, dst, true);
+    emitByte(static_cast<uint8_t>(32 + multiply->getShift()));
+}
+
+void X86Encoder::encodeCompare(CompareInstruction* compare){
+    OperandNode* src = compare->getSrc();
+    OperandNode* dst = compare->getDst();
+    RegisterNode* srcReg = dynamic_cast<RegisterNode*>(src);
+    RegisterNode* dstReg = dynamic_cast<RegisterNode*>(dst);
+    if(src->getType() == IMM){
+        // cmpl $imm, r/m => 83 /7 ib, 3D id for %eax, 81 /7 id
+        int32_t value = immediateValue(src);
+        if(fitsInByte(value)){
+            emitModRM(0x83, 7, dst);
+            emitByte(static_cast<uint8_t>(value));
+        }else if(dstReg != nullptr && dstReg->getRegEnum() == RegisterName::AX){
+            emitByte(0x3D);
+            emitInt32(value);
+        }else{
+            emitModRM(0x81, 7, dst);
+            emitInt32(value);
+        }
+    }else if(srcReg != nullptr){
+        emitModRM(0x39, registerNumber(srcReg->getRegEnum()), dst);
+    }else if(dstReg != nullptr){
+        emitModRM(0x3B, registerNumber(dstReg->getRegEnum()), src);
+    }else{
+        throw std::runtime_error("Cannot encode cmpl from memory to memory");
+    }
+}
+
+void X86Encoder::encodeJump(uint8_t shortOpcode, std::initializer_list<uint8_t> nearOpcode, const std::string& target){
+    bool wide = this->longJumps[this->currentInstruction] != 0;
+    if(wide){
+        for(uint8_t byte: nearOpcode){
+            emitByte(byte);
+        }
+    }else{
+        emitByte(shortOpcode);
+    }
+    this->jumps.push_back(JumpField{this->currentInstruction, this->code.size(), wide, target});
+    for(int i = 0; i < (wide ? 4 : 1); i++){
+        emitByte(0);
+    }
+}
+
+bool X86Encoder::relaxJumps(){
+    bool widened = false;
+    for(const JumpField& jump: this->jumps){
+        auto label = this->labels.find(jump.target);
+        if(label == this->labels.end()){
+            throw std::runtime_error("Cannot encode a jump to undefined label " + jump.target);
+        }
+        // relative to the end of the jump, which is where its displacement ends
+        int64_t displacement = static_cast<int64_t>(label->second) - static_cast<int64_t>(jump.offset + (jump.wide ? 4 : 1));
+        if(!jump.wide && !fitsInByte(static_cast<int32_t>(displacement))){
+            this->longJumps[jump.instruction] = 1;
+            widened = true;
+        }
+    }
+    if(widened){
+        return(true);
+    }
+    for(const JumpField& jump: this->jumps){
+        int64_t displacement = static_cast<int64_t>(this->labels[jump.target]) - static_cast<int64_t>(jump.offset + (jump.wide ? 4 : 1));
+        uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(displacement));
+        for(int i = 0; i < (jump.wide ? 4 : 1); i++){
+            this->code[jump.offset + i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+    }
+    return(false);
+}
+
+void X86Encoder::encodeLea(LeaInstruction* lea){
+    int dst = registerNumber(lea->getDst()->getRegEnum());
+    int base = registerNumber(lea->getBase()->getRegEnum());
+    if(lea->getIndex() == nullptr){
+        emitMemory(0x8D, dst, base, lea->getDisplacement());
+    }else{
+        emitIndexed(0x8D, dst, base, registerNumber(lea->getIndex()->getRegEnum()), lea->getScale(), lea->getDisplacement());
+    }
+}
+
+void X86Encoder::encodeProfileCounter(ProfileCounterInstruction* counter){
+    // incq disp32(%rip) => REX.W FF /0, mod 00 r/m 101, the displacement is relative to the end of the instruction
+    emitByte(0x48);
+    emitByte(0xFF);
+    emitByte(0x05);
+    this->relocations.push_back(CodeRelocation{this->code.size(), Profile::COUNTERS_SECTION, R_X86_64_PC32,
+        static_cast<int64_t>(8 * counter->getIndex()) - 4});
+    emitInt32(0);
+}
+
+void X86Encoder::encodeJumpTable(JumpTableInstruction* dispatch){
+    int index = registerNumber(dispatch->getIndex()->getRegEnum());
+    int scratch = registerNumber(dispatch->getScratch()->getRegEnum());
+    // .p2align 2 in .rodata, then one entry per target
+    this->readOnlyData.resize((this->readOnlyData.size() + 3) / 4 * 4, 0);
+    size_t table = this->readOnlyData.size();
+    for(const std::string& target: dispatch->getTargets()){
+        this->tableEntries.push_back(TableEntry{this->readOnlyData.size(), target, dispatch->getBase()});
+        this->readOnlyData.resize(this->readOnlyData.size() + 4, 0);
+    }
+    // leaq table(%rip), %scratch => REX.W 8D /r, mod 00 r/m 101
+    emitByte(static_cast<uint8_t>(0x48 | (scratch >= 8 ? 0x04 : 0)));
+    emitByte(0x8D);
+    emitByte(static_cast<uint8_t>((scratch & 7) << 3 | RBP));
+    this->relocations.push_back(CodeRelocation{this->code.size(), READ_ONLY_SECTION, R_X86_64_PC32, static_cast<int64_t>(table) - 4});
+    emitInt32(0);
+    // movslq (%scratch,%index,4), %index => REX.W 63 /r
+    emitIndexed(0x63, index, scratch, index, 4, 0, true);
+    // leaq base(%rip), %scratch, patched like the displacement of a near jump
+    emitByte(static_cast<uint8_t>(0x48 | (scratch >= 8 ? 0x04 : 0)));
+    emitByte(0x8D);
+    emitByte(static_cast<uint8_t>((scratch & 7) << 3 | RBP));
+    this->jumps.push_back(JumpField{this->currentInstruction, this->code.size(), true, dispatch->getBase()});
+    emitInt32(0);
+    // addq %scratch, %index => REX.W 01 /r
+    emitRegister(0x01, scratch, index, true);
+    // jmp *%index => FF /4
+    emitRegister(0xFF, 4, index);
+}
+
+void X86Encoder::encodeInstruction(InstructionNode* instr){
+    if(MoveInstruction* mov = dynamic_cast<MoveInstruction*>(instr)){
+        encodeMove(mov);
+    }else if(UnaryInstruction* unary = dynamic_cast<UnaryInstruction*>(instr)){
+        encodeUnary(unary);
+    }else if(BinaryInstruction* binary = dynamic_cast<BinaryInstruction*>(instr)){
+        encodeBinary(binary);
+    }else if(CompareInstruction* compare = dynamic_cast<CompareInstruction*>(instr)){
+        encodeCompare(compare);
+    }else if(JumpInstruction* jump = dynamic_cast<JumpInstruction*>(instr)){
+        // jmp rel8 => EB cb, jmp rel32 => E9 cd
+        encodeJump(0xEB, {0xE9}, jump->getTarget());
+    }else if(ConditionalJumpInstruction* branch = dynamic_cast<ConditionalJumpInstruction*>(instr)){
+        // jcc rel8 => 70+cc cb, jcc rel32 => 0F 80+cc cd
+        uint8_t cc = conditionNibble(branch->getCondition());
+        encodeJump(static_cast<uint8_t>(0x70 | cc), {0x0F, static_cast<uint8_t>(0x80 | cc)}, branch->getTarget());
+    }else if(SetConditionInstruction* set = dynamic_cast<SetConditionInstruction*>(instr)){
+        // setcc r/m8 => 0F 90+cc /0, %sil and %dil need a REX prefix, without one they would be %dh and %bh
+        int dst = registerNumber(set->getDst()->getRegEnum());
+        if(dst == 6 || dst == 7){
+            emitByte(0x40);
+        }
+        emitRegister(static_cast<uint16_t>(0x0F90 | conditionNibble(set->getCondition())), 0, dst);
+    }else if(MoveZeroExtendInstruction* extend = dynamic_cast<MoveZeroExtendInstruction*>(instr)){
+        // movzbl r/m8, r32 => 0F B6 /r
+        int src = registerNumber(extend->getSrc()->getRegEnum());
+        int dst = registerNumber(extend->getDst()->getRegEnum());
+        if((src == 6 || src == 7) && dst < 8){
+            emitByte(0x40);
+        }
+        emitRegister(0x0FB6, dst, src);
+    }else if(ConditionalMoveInstruction* cmov = dynamic_cast<ConditionalMoveInstruction*>(instr)){
+        // cmovcc r/m32, r32 => 0F 40+cc /r
+        emitModRM(static_cast<uint16_t>(0x0F40 | conditionNibble(cmov->getCondition())),
+            registerNumber(cmov->getDst()->getRegEnum()), cmov->getSrc());
+    }else if(LabelInstruction* label = dynamic_cast<LabelInstruction*>(instr)){
+        this->labels[label->getName()] = this->code.size();
+    }else if(LeaInstruction* lea = dynamic_cast<LeaInstruction*>(instr)){
+        encodeLea(lea);
+    }else if(dynamic_cast<CdqInstruction*>(instr) != nullptr){
+        // cltd => 99
+        emitByte(0x99);
+    }else if(IdivInstruction* idiv = dynamic_cast<IdivInstruction*>(instr)){
+        // idivl r/m => F7 /7
+        emitModRM(0xF7, 7, idiv->getOperand());
+    }else if(MultiplyHighInstruction* multiply = dynamic_cast<MultiplyHighInstruction*>(instr)){
+        encodeMultiplyHigh(multiply);
+    }else if(ProfileCounterInstruction* counter = dynamic_cast<ProfileCounterInstruction*>(instr)){
+        encodeProfileCounter(counter);
+    }else if(JumpTableInstruction* dispatch = dynamic_cast<JumpTableInstruction*>(instr)){
+        encodeJumpTable(dispatch);
+    }else if(AllocateStack* allocate = dynamic_cast<AllocateStack*>(instr)){
+        // subq $n, %rsp
+        int32_t amount = allocate->getStackDecrementAmount();
+        emitRegister(fitsInByte(amount) ? 0x83 : 0x81, 5, RSP, true);
+        if(fitsInByte(amount)){
+            emitByte(static_cast<uint8_t>(amount));
+        }else{
+            emitInt32(amount);
+        }
+    }else if(DeallocateStack* deallocate = dynamic_cast<DeallocateStack*>(instr)){
+        // addq $n, %rsp
+        int32_t amount = deallocate->getAmount();
+        emitRegister(fitsInByte(amount) ? 0x83 : 0x81, 0, RSP, true);
+        if(fitsInByte(amount)){
+            emitByte(static_cast<uint8_t>(amount));
+        }else{
+            emitInt32(amount);
+        }
+    }else if(PushInstruction* push = dynamic_cast<PushInstruction*>(instr)){
+        if(RegisterNode* reg = dynamic_cast<RegisterNode*>(push->getOperand())){
+            // pushq r64 => [41] 50+r
+            int number = registerNumber(reg->getRegEnum());
+            if(number >= 8){
+                emitByte(0x41);
+            }
+            emitByte(static_cast<uint8_t>(0x50 + (number & 7)));
+        }else{
+            // pushq $imm => 6A ib or 68 id, sign extended to 64 bits
+            int32_t value = immediateValue(push->getOperand());
+            if(fitsInByte(value)){
+                emitByte(0x6A);
+                emitByte(static_cast<uint8_t>(value));
+            }else{
+                emitByte(0x68);
+                emitInt32(value);
+            }
+        }
+    }else if(CallInstruction* call = dynamic_cast<CallInstruction*>(instr)){
+        // call rel32 => E8 cd, through the PLT when the callee is in a shared library
+        emitByte(0xE8);
+        this->relocations.push_back(CodeRelocation{this->code.size(), call->getName(), R_X86_64_PLT32, -4});
+        emitInt32(0);
+    }else if(IRReturnNode* ret = dynamic_cast<IRReturnNode*>(instr)){
+        // [movq %rbp, %rsp; popq %rbp; .cfi_def_cfa %rsp, 8]; ret
+        if(ret->getRestoresFrame()){
+            emitRegister(0x89, RBP, RSP, true);
+            emitByte(0x5D);
+            emitCallFrame({DW_CFA_def_cfa, DWARF_RSP, 8});
+        }
+        emitByte(0xC3);
+    }else{
+        throw std::runtime_error("Cannot encode unknown instruction");
+    }
+}
+
+void X86Encoder::emitCallFrame(std::initializer_list<uint8_t> instruction){
+    size_t delta = this->code.size() - this->callFrameLocation;
+    if(delta > 0 && delta < 0x40){
+        this->callFrame.push_back(static_cast<uint8_t>(DW_CFA_advance_loc | delta));
+    }else if(delta > 0){
+        // DW_CFA_advance_loc1/2/4, little endian
+        int bytes = delta <= 0xFF ? 1 : delta <= 0xFFFF ? 2 : 4;
+        this->callFrame.push_back(bytes == 1 ? DW_CFA_advance_loc1 : bytes == 2 ? DW_CFA_advance_loc2 : DW_CFA_advance_loc4);
+        for(int i = 0; i < bytes; i++){
+            this->callFrame.push_back(static_cast<uint8_t>(delta >> (8 * i)));
+        }
+    }
+    this->callFrameLocation = this->code.size();
+    this->callFrame.insert(this->callFrame.end(), instruction);
+}
+
+std::vector<uint8_t> X86Encoder::encodeFunction(IRFunctionNode* function, std::vector<uint8_t>* callFrame,
+    std::vector<CodeRelocation>* relocations, std::vector<uint8_t>* readOnlyData){
+    std::vector<InstructionNode*> instructions = function->getInstructions();
+    X86Encoder encoder{};
+    encoder.longJumps.assign(instructions.size(), 0);
+    while(true){
+        // start over with what the last round learned about the jumps
+        std::vector<char> longJumps = std::move(encoder.longJumps);
+        encoder = X86Encoder{};
+        encoder.longJumps = std::move(longJumps);
+        if(function->hasFramePointer()){
+            // pushq %rbp; .cfi_def_cfa_offset 16; .cfi_offset %rbp, -16 (factored by the -8 of the CIE)
+            encoder.emitByte(0x55);
+            encoder.emitCallFrame({DW_CFA_def_cfa_offset, 16, DW_CFA_offset | DWARF_RBP, 2});
+            // movq %rsp, %rbp; .cfi_def_cfa_register %rbp
+            encoder.emitRegister(0x89, RSP, RBP, true);
+            encoder.emitCallFrame({DW_CFA_def_cfa_register, DWARF_RBP});
+        }
+        for(size_t i = 0; i < instructions.size(); i++){
+            IRReturnNode* ret = dynamic_cast<IRReturnNode*>(instructions[i]);
+            bool reentered = ret != nullptr && ret->getRestoresFrame() && i + 1 < instructions.size();
+            if(reentered){
+                encoder.emitCallFrame({DW_CFA_remember_state});
+            }
+            encoder.currentInstruction = i;
+            encoder.encodeInstruction(instructions[i]);
+            if(reentered){
+                encoder.emitCallFrame({DW_CFA_restore_state});
+            }
+        }
+        if(!encoder.relaxJumps()){
+            break;
+        }
+    }
+    for(const TableEntry& entry: encoder.tableEntries){
+        uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(encoder.labels.at(entry.target) - encoder.labels.at(entry.base)));
+        for(int i = 0; i < 4; i++){
+            encoder.readOnlyData[entry.offset + i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+    }
+    if(callFrame != nullptr){
+        *callFrame = encoder.callFrame;
+    }
+    if(relocations != nullptr){
+        *relocations = encoder.relocations;
+    }else if(!encoder.relocations.empty()){
+        throw std::runtime_error("Function " + function->getIdentifier() + " refers to symbols, it can only be encoded into an object file");
+    }
+    if(readOnlyData != nullptr){
+        *readOnlyData = encoder.readOnlyData;
+    }else if(!encoder.readOnlyData.empty()){
+        throw std::runtime_error("Function " + function->getIdentifier() + " has jump tables, their data has to be placed too");
+    }
+    return(encoder.code);
+}
+
+std::vector<uint8_t> X86Encoder::padding(size_t size){
+    static const std::vector<std::vector<uint8_t>> nops = {
+        {},
+        {0x90},
+        {0x66, 0x90},
+        {0x0F, 0x1F, 0x00},
+        {0x0F, 0x1F, 0x40, 0x00},
+        {0x0F, 0x1F, 0x44, 0x00, 0x00},
+        {0x66, 0x0F, 0x1F, 0x44, 0x00, 0x00},
+        {0x0F, 0x1F, 0x80, 0x00, 0x00, 0x00, 0x00},
+        {0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+        {0x66, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+        {0x66, 0x2E, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+        {0x66, 0x66, 0x2E, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+    };
+    std::vector<uint8_t> bytes;
+    while(size > 0){
+        size_t chunk = size < nops.size() ? size : nops.size() - 1;
+        bytes.insert(bytes.end(), nops[chunk].begin(), nops[chunk].end());
+        size -= chunk;
+    }
+    return(bytes);
+}
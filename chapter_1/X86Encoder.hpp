@@ -0,0 +1,210 @@
+#ifndef X86ENCODER_HPP
+#define X86ENCODER_HPP
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Assembly.hpp"
+
+/**
+ * @brief A field of the machine code the linker has to fill in, with the meaning of an ELF64 Rela entry
+ *
+ */
+struct CodeRelocation {
+    /**
+     * @brief Offset of the field from the start of the function
+     *
+     */
+    uint64_t offset;
+    /**
+     * @brief The symbol or section the field refers to
+     *
+     */
+    std::string symbol;
+    uint32_t type;
+    int64_t addend;
+};
+
+// ======================================================
+//                     X86Encoder
+// ======================================================
+/**
+ * @brief Encodes the InstructionNodes of a function to x86-64 machine code, byte for byte what the assembler
+ * would produce from the text IRFunctionNode::filePrint writes.
+ *
+ * The shortest encoding is always picked: 8 bit displacements for stack slots within -128 bytes of %rbp,
+ * 8 bit immediates for addl/subl/andl/orl/xorl/imull/subq when they fit, the one byte shorter %eax forms of
+ * addl/subl/andl/orl/xorl otherwise, the D1 form of a shift by 1 (D3 for a shift by %cl),
+ * and no displacement at all for leal 0(%reg). A REX prefix is only emitted for 64 bit operands, %r8-%r11 and the
+ * byte registers %sil and %dil (setcc, movzbl), which are %dh and %bh without one.
+ *
+ * Jumps are relaxed the way the assembler does it: every jmp/jcc starts with an 8 bit displacement, the function
+ * is encoded, and the jumps whose label turned out to be too far are given a 32 bit displacement before encoding
+ * it again. Jumps only ever grow, so this stops after a couple of rounds (one when no jump is long).
+ *
+ * The jump tables of a function go to its own read only data, to be placed in .rodata: the leaq of a table is
+ * a R_X86_64_PC32 relocation against that section with the offset of the table in the data of the function as
+ * addend (whoever places the data adds where it starts), the entries are filled in once the labels are final.
+ * A call is E8 with a R_X86_64_PLT32 relocation against the callee and an addend of -4, like the assembler
+ * makes of call f: the linker resolves it to f or to its PLT entry.
+ */
+class X86Encoder {
+    private:
+        std::vector<uint8_t> code;
+        /**
+         * @brief DWARF call frame instructions of the function, the .cfi directives of filePrint assembled
+         *
+         */
+        std::vector<uint8_t> callFrame;
+        /**
+         * @brief Code offset the call frame instructions have advanced to
+         *
+         */
+        size_t callFrameLocation = 0;
+        std::vector<CodeRelocation> relocations;
+        /**
+         * @brief The jump tables of the function, each aligned on 4 bytes
+         *
+         */
+        std::vector<uint8_t> readOnlyData;
+        /**
+         * @brief An entry of a jump table, target - base once the labels are known
+         *
+         */
+        struct TableEntry {
+            size_t offset;
+            std::string target;
+            std::string base;
+        };
+        std::vector<TableEntry> tableEntries;
+        /**
+         * @brief The displacement of a jump, filled in once the offsets of the labels are known
+         *
+         */
+        struct JumpField {
+            /**
+             * @brief Index of the jump in the instructions of the function
+             *
+             */
+            size_t instruction;
+            size_t offset;
+            bool wide;
+            std::string target;
+        };
+        std::vector<JumpField> jumps;
+        std::unordered_map<std::string, size_t> labels;
+        /**
+         * @brief One flag per instruction, set for the jumps that need a 32 bit displacement
+         *
+         */
+        std::vector<char> longJumps;
+        size_t currentInstruction = 0;
+
+        static int registerNumber(RegisterName reg);
+        static int32_t immediateValue(OperandNode* op);
+        /**
+         * @brief The condition field of the jcc, setcc and cmovcc opcodes (e => 4, l => 0xC)
+         *
+         */
+        static uint8_t conditionNibble(ConditionCode condition);
+        static bool fitsInByte(int32_t value);
+        void emitByte(uint8_t byte);
+        void emitInt32(int32_t value);
+        /**
+         * @brief Appends a call frame instruction taking effect at the current code offset
+         *
+         */
+        void emitCallFrame(std::initializer_list<uint8_t> instruction);
+        /**
+         * @brief Emits one opcode byte, or two for the 0F xx opcodes (i.e 0x0FAF for imul)
+         *
+         */
+        void emitOpcode(uint16_t opcode);
+        /**
+         * @brief Emits [REX] opcode ModRM [disp] for an instruction whose r/m operand is a register or a
+         * stack slot. reg is either a register number or the opcode extension (/digit).
+         *
+         * @param opcode one byte, or 0F xx written as 0x0Fxx
+         * @param reg
+         * @param rm
+         * @param wide sets REX.W for a 64 bit operand size
+         */
+        void emitModRM(uint16_t opcode, int reg, OperandNode* rm, bool wide = false);
+        /**
+         * @brief Same as emitModRM for a register given by its number (i.e 4 for %rsp)
+         *
+         */
+        void emitRegister(uint16_t opcode, int reg, int rm, bool wide = false);
+        /**
+         * @brief Same as emitModRM for a [base + displacement] memory operand
+         *
+         */
+        void emitMemory(uint16_t opcode, int reg, int base, int32_t displacement, bool wide = false);
+        /**
+         * @brief Same as emitMemory for a [base + index*scale + displacement] operand, always with a SIB byte
+         *
+         */
+        void emitIndexed(uint8_t opcode, int reg, int base, int index, int scale, int32_t displacement, bool wide = false);
+        void encodeLea(LeaInstruction* lea);
+        void encodeProfileCounter(ProfileCounterInstruction* counter);
+        void encodeJumpTable(JumpTableInstruction* dispatch);
+        void encodeMove(MoveInstruction* mov);
+        void encodeUnary(UnaryInstruction* unary);
+        void encodeBinary(BinaryInstruction* binary);
+        /**
+         * @brief imull, which unlike the other binary instructions needs its destination in a register
+         *
+         */
+        void encodeMultiply(BinaryInstruction* binary);
+        void encodeShift(BinaryInstruction* binary);
+        void encodeMultiplyHigh(MultiplyHighInstruction* multiply);
+        void encodeCompare(CompareInstruction* compare);
+        /**
+         * @brief Emits the opcode of a jump (short or near, see longJumps) and leaves its displacement to patch
+         *
+         * @param shortOpcode
+         * @param nearOpcode the opcode bytes of the rel32 form
+         * @param target
+         */
+        void encodeJump(uint8_t shortOpcode, std::initializer_list<uint8_t> nearOpcode, const std::string& target);
+        /**
+         * @brief Widens the short jumps that can't reach their label, or writes the displacements of every jump
+         * if they all can
+         *
+         * @return bool true if a jump was widened and the function has to be encoded again
+         */
+        bool relaxJumps();
+        void encodeInstruction(InstructionNode* instr);
+    public:
+        /**
+         * @brief The section the relocations of the jump tables refer to
+         *
+         */
+        static const char* const READ_ONLY_SECTION;
+        /**
+         * @brief Encodes the prologue and every instruction of the function
+         *
+         * @param function
+         * @param callFrame if not null, set to the call frame instructions of the function's FDE in .eh_frame
+         * (the same bytes the assembler makes of the .cfi directives)
+         * @param relocations if not null, set to the fields left for the linker (the profile counters, the jump
+         * tables). Throws when the function needs one and it is null, the code couldn't run as is.
+         * @param readOnlyData if not null, set to the jump tables of the function, which the relocations against
+         * READ_ONLY_SECTION refer to from the start of. Throws when the function has a table and it is null.
+         * @return std::vector<uint8_t>
+         */
+        static std::vector<uint8_t> encodeFunction(IRFunctionNode* function, std::vector<uint8_t>* callFrame = nullptr,
+            std::vector<CodeRelocation>* relocations = nullptr, std::vector<uint8_t>* readOnlyData = nullptr);
+        /**
+         * @brief The nops the assembler fills a .p2align gap in .text with: one instruction of up to 11 bytes,
+         * then another one for the rest
+         *
+         * @param size
+         * @return std::vector<uint8_t>
+         */
+        static std::vector<uint8_t> padding(size_t size);
+};
+
+#endif // X86ENCODER_HPP
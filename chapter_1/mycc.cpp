@@ -3,17 +3,153 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cctype>
 #include "Lexer.hpp"
 #include "Parser.hpp"
 #include "AST.hpp"
 #include "Assembly.hpp"
+#include "ParallelBackend.hpp"
+#include "PassManager.hpp"
+#include "Jit.hpp"
+#include "Superoptimizer.hpp"
+#include "CodeFolding.hpp"
+#include "Profile.hpp"
+#include "FunctionLayout.hpp"
 int main(int argc, char* argv[]){
     if(argc<2){
         std::cout<<"Source file was not provided";
         return(-1);
     }else{
+        std::string sourceFile;
+        //-jN runs the backend on N threads (-j alone uses every hardware thread). Without it the backend runs serially.
+        unsigned threadCount = 1;
+        //-passes=a,b,c replaces the default pipeline (see PassManager.hpp for the pass names)
+        std::string pipeline = PassManager::defaultPipeline();
+        //-time-passes prints the time and instruction count change of every pass
+        bool timePasses = false;
+        //-verify-each runs the IR verifier after every pass
+        bool verifyEach = false;
+        //-frame-report prints the stack slot bytes of every function before and after slot sharing
+        bool frameReport = false;
+        //-c encodes the functions directly and writes an ELF object next to the source file instead of assembly
+        bool objectMode = false;
+        //-fno-icf emits every function even when an earlier one has the same body (see CodeFolding.hpp)
+        bool foldIdentical = true;
+        //-icf-report lists the functions folded into an alias and the bytes of code saved
+        bool foldReport = false;
+        //--jit compiles in memory, runs main and exits with what it returned, no file is written
+        bool jitMode = false;
+        //-superoptimize[=N] searches the rewrite table of the instruction selector for chains of up to N operators and
+        //prints it, -superopt-exhaustive checks every winner on all 2^32 inputs, -superopt-bench times the rewrites
+        Superoptimizer::Options superoptOptions;
+        bool superoptimize = false;
+        //-fprofile-generate counts the calls of every function, link with ProfileRuntime.o to get them written at exit
+        bool profileGenerate = false;
+        //-profile-merge=out a b c sums the profiles a, b and c into out
+        std::string profileMerge;
+        //-fprofile-use=file orders the functions by the counts of a profile and moves the ones that never ran to
+        //.text.unlikely (see FunctionLayout.hpp), -layout-report prints where each function went
+        std::string profileUse;
+        bool layoutReport = false;
+        std::vector<std::string> inputFiles;
+        for(int i = 1; i < argc; i++){
+            std::string arg = argv[i];
+            if(arg.size() == 3 && arg.compare(0, 2, "-O") == 0 && std::isdigit(static_cast<unsigned char>(arg[2]))){
+                //-O0, -O1 (default) and -O2, the pipelines are described in PassManager.hpp
+                pipeline = PassManager::pipelineForLevel(arg[2] - '0');
+            }else if(arg == "-fast"){
+                //skips the TAC and the assembly tree, see DirectCodegen.hpp
+                pipeline = "direct-emit";
+            }else if(arg.compare(0, 8, "-passes=") == 0){
+                pipeline = arg.substr(8);
+            }else if(arg == "-time-passes"){
+                timePasses = true;
+            }else if(arg == "--jit"){
+                jitMode = true;
+            }else if(arg == "-superoptimize" || arg.compare(0, 15, "-superoptimize=") == 0){
+                superoptimize = true;
+                if(arg.size() > 15){
+                    superoptOptions.chainLength = std::stoi(arg.substr(15));
+                }
+            }else if(arg == "-superopt-exhaustive"){
+                superoptOptions.exhaustive = true;
+            }else if(arg == "-superopt-bench"){
+                superoptOptions.benchmark = true;
+            }else if(arg == "-fprofile-generate"){
+                profileGenerate = true;
+            }else if(arg.compare(0, 14, "-fprofile-use=") == 0){
+                profileUse = arg.substr(14);
+            }else if(arg == "-layout-report"){
+                layoutReport = true;
+            }else if(arg.compare(0, 15, "-profile-merge=") == 0){
+                profileMerge = arg.substr(15);
+            }else if(arg == "-c"){
+                objectMode = true;
+            }else if(arg == "-fno-icf"){
+                foldIdentical = false;
+            }else if(arg == "-icf-report"){
+                foldReport = true;
+            }else if(arg == "-frame-report"){
+                frameReport = true;
+            }else if(arg == "-verify-each"){
+                verifyEach = true;
+            }else if(arg.compare(0, 2, "-j") == 0){
+                std::string count = arg.substr(2);
+                if(count.empty() && i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))){
+                    count = argv[++i];
+                }
+                threadCount = count.empty() ? 0 : static_cast<unsigned>(std::stoul(count));
+            }else{
+                sourceFile = arg;
+                inputFiles.push_back(arg);
+            }
+        }
+        if(!profileMerge.empty()){
+            try{
+                Profile merged;
+                for(const std::string& input: inputFiles){
+                    merged.merge(Profile::read(input));
+                }
+                merged.write(profileMerge);
+                return(0);
+            }catch(const std::exception& e){
+                std::cerr<<e.what()<<'\n';
+                return(-1);
+            }
+        }
+        if(superoptimize){
+            try{
+                Superoptimizer superoptimizer{superoptOptions};
+                std::vector<Superoptimizer::Result> results = superoptimizer.run();
+                superoptimizer.writeTable(results, std::cout);
+                if(superoptOptions.benchmark){
+                    superoptimizer.writeBenchmark(results, std::cerr);
+                }
+                return(0);
+            }catch(const std::exception& e){
+                std::cerr<<e.what()<<'\n';
+                return(-1);
+            }
+        }
+        if(jitMode){
+            try{
+                if(profileGenerate){
+                    pipeline = PassManager::instrumentedPipeline(pipeline);
+                }
+                JitCompiler jit{pipeline, threadCount};
+                std::unique_ptr<JitModule> module = jit.compile(JitCompiler::preprocess(sourceFile));
+                JitFunction entry = module->getFunction("main");
+                if(entry == nullptr){
+                    std::cerr<<"No main function in "<<sourceFile<<'\n';
+                    return(-1);
+                }
+                return(entry());
+            }catch(const std::exception& e){
+                std::cerr<<e.what()<<'\n';
+                return(-1);
+            }
+        }
         std::cout<<"Processing Source File\n";
-        std::string sourceFile =  argv[1];
         std::cout<<sourceFile<<'\n';
 
         //Getting the file name to construct output file name for command
@@ -72,14 +208,44 @@ int main(int argc, char* argv[]){
             std::cout<<"----------------\nPARSE SUCCESSFUL\n----------------\n";
             
             ast.PrettyPrint();
-            TackyGenerator tackyGenerator{};
-            TackyProgram* tackyProgram = tackyGenerator.convertProgram(&ast);
-            tackyProgram->prettyPrint();
-            std::cout<<"-------------------------------------------------------------------------------\n";
-            IRTree intermidate{};
-            intermidate.transformFromTacky(tackyProgram);
-            intermidate.replacePseudoOperands();
-            intermidate.filePrint(fileName);
+            PassManager passManager{};
+            if(profileGenerate){
+                pipeline = PassManager::instrumentedPipeline(pipeline);
+            }
+            passManager.setPipeline(objectMode ? PassManager::objectPipeline(pipeline) : pipeline);
+            passManager.setVerifyEach(verifyEach);
+            ParallelBackend backend{threadCount};
+            std::vector<PassStatistics> statistics;
+            std::vector<FunctionUnit> units = backend.runPipeline(&ast, passManager, statistics);
+            FoldingReport folding;
+            if(foldIdentical){
+                folding = CodeFolder::fold(units);
+            }
+            Profile profile;
+            LayoutReport layout;
+            if(!profileUse.empty()){
+                profile = Profile::read(profileUse);
+                layout = FunctionLayout::apply(units, profile);
+            }
+            if(objectMode){
+                ParallelBackend::buildObject(units).writeFile(fileName + ".o");
+                std::cout<<"Created Object File: "<<fileName<<".o\n";
+            }else{
+                std::cout<<"-------------------------------------------------------------------------------\n";
+                IRTree::writeAssemblyFile(fileName, ParallelBackend::joinAssembly(units));
+            }
+            if(timePasses){
+                passManager.printReport(statistics, std::cout);
+            }
+            if(frameReport){
+                PassManager::printFrameReport(units, std::cout);
+            }
+            if(foldReport){
+                CodeFolder::printReport(units, folding, std::cout);
+            }
+            if(layoutReport){
+                FunctionLayout::printReport(units, profile, layout, std::cout);
+            }
         }
         // IRTree intermidate{ast};
         // intermidate.transform();
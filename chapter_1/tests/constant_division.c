@@ -0,0 +1,127 @@
+int putchar(int c);
+int getchar(void);
+
+int hex(int v, int k){
+    int d = (v >> (k * 4)) & 15;
+    putchar(d < 10 ? 48 + d : 87 + d);
+    if (k)
+        hex(v, k - 1);
+    return 0;
+}
+
+int show(int v){
+    hex(v, 7);
+    putchar(32);
+    return 0;
+}
+
+int positive(int x){
+    show(x / 1);
+    show(x % 1);
+    show(x / 2);
+    show(x % 2);
+    show(x / 3);
+    show(x % 3);
+    show(x / 4);
+    show(x % 4);
+    show(x / 7);
+    show(x % 7);
+    show(x / 10);
+    show(x % 10);
+    show(x / 16);
+    show(x % 16);
+    show(x / 25);
+    show(x % 25);
+    show(x / 641);
+    show(x % 641);
+    show(x / 1000);
+    show(x % 1000);
+    show(x / 65536);
+    show(x % 65536);
+    show(x / 1073741824);
+    show(x % 1073741824);
+    show(x / 2147483647);
+    show(x % 2147483647);
+    putchar(10);
+    return 0;
+}
+
+int negative(int x){
+    if (x != -2147483647 - 1) {
+        show(x / -1);
+        show(x % -1);
+    }
+    show(x / -2);
+    show(x % -2);
+    show(x / -3);
+    show(x % -3);
+    show(x / -7);
+    show(x % -7);
+    show(x / -8);
+    show(x % -8);
+    show(x / -10);
+    show(x % -10);
+    show(x / -641);
+    show(x % -641);
+    show(x / -1073741824);
+    show(x % -1073741824);
+    show(x / -2147483647);
+    show(x % -2147483647);
+    show(x / (-2147483647 - 1));
+    show(x % (-2147483647 - 1));
+    putchar(10);
+    return 0;
+}
+
+int compound(int x){
+    int q = x;
+    int r = x;
+    q /= 6;
+    r %= -6;
+    show(q);
+    show(r);
+    show(x / 3 * 3 + x % 3);
+    show(x / -5 * -5 + x % -5);
+    show((x / 9) / 9);
+    show(x % 12 % 5);
+    putchar(10);
+    return 0;
+}
+
+int all(int x){
+    positive(x);
+    negative(x);
+    compound(x);
+    return 0;
+}
+
+int main(void){
+    int zero = getchar() + 1;
+    all(zero - 2147483647 - 1);
+    all(zero - 2147483647);
+    all(zero - 1073741825);
+    all(zero - 1073741824);
+    all(zero - 65537);
+    all(zero - 1001);
+    all(zero - 641);
+    all(zero - 100);
+    all(zero - 7);
+    all(zero - 3);
+    all(zero - 2);
+    all(zero - 1);
+    all(zero);
+    all(zero + 1);
+    all(zero + 2);
+    all(zero + 3);
+    all(zero + 7);
+    all(zero + 99);
+    all(zero + 641);
+    all(zero + 999);
+    all(zero + 65536);
+    all(zero + 123456789);
+    all(zero + 1073741823);
+    all(zero + 1073741824);
+    all(zero + 2147483646);
+    all(zero + 2147483647);
+    return (zero - 29) / 4 & 255;
+}
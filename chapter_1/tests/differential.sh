@@ -0,0 +1,76 @@
+#!/bin/bash
+# Differential tests: every tests/*.c is built with gcc and with mycc at each level, and the programs must print
+# the same output and exit with the same status. tests/name.in, when present, is the standard input of name.c, and
+# tests/name.profile is passed to every mycc build of name.c with -fprofile-use (the layout must not change results).
+#
+#   tests/differential.sh [mycc] [cases...]
+#
+# mycc writes Assembly.s to the parent of its working directory and the .i and .o files next to the source, so every
+# case is copied to a scratch directory first and the tree stays clean.
+MYCC=$(realpath "${1:-$(dirname "$0")/../mycc}")
+shift
+cd "$(dirname "$0")" || exit 1
+CASES=("$@")
+if [ ${#CASES[@]} -eq 0 ]; then
+    CASES=(*.c)
+fi
+CONFIGS=("-O0" "-O1" "-O2" "-fast" "-O0 -c" "-O1 -c" "-O2 -c" "-O0 --jit" "-O1 --jit" "-O2 --jit")
+
+SCRATCH=$(mktemp -d)
+trap 'rm -rf "$SCRATCH"' EXIT
+mkdir -p "$SCRATCH/w"
+failures=0
+checks=0
+
+for source in "${CASES[@]}"; do
+    name=$(basename "$source" .c)
+    input=/dev/null
+    [ -f "$name.in" ] && input=$(realpath "$name.in")
+    profile=()
+    [ -f "$name.profile" ] && profile=("-fprofile-use=$(realpath "$name.profile")")
+    cp "$source" "$SCRATCH/$name.c"
+    gcc -w -fwrapv -O0 "$SCRATCH/$name.c" -o "$SCRATCH/ref" || { echo "FAIL $name: gcc can't build it"; failures=$((failures + 1)); continue; }
+    "$SCRATCH/ref" < "$input" > "$SCRATCH/ref.out"
+    expected=$?
+
+    for config in "${CONFIGS[@]}"; do
+        rm -f "$SCRATCH/Assembly.s" "$SCRATCH/$name.o" "$SCRATCH/got"
+        if [[ $config == *--jit* ]]; then
+            # the JIT only links the functions of the program, a case calling into libc is skipped
+            grep -q "^int [a-z_]*(.*);" "$SCRATCH/$name.c" && continue
+            (cd "$SCRATCH/w" && "$MYCC" "$SCRATCH/$name.c" $config "${profile[@]}" < "$input" > "$SCRATCH/log" 2>&1)
+            status=$?
+            checks=$((checks + 1))
+            if [ $status -ne $expected ]; then
+                echo "FAIL $name ($config): exit status $status, gcc gives $expected"
+                failures=$((failures + 1))
+            fi
+            continue
+        fi
+        if ! (cd "$SCRATCH/w" && "$MYCC" "$SCRATCH/$name.c" $config "${profile[@]}" > "$SCRATCH/log" 2>&1); then
+            echo "FAIL $name ($config): mycc failed"
+            tail -3 "$SCRATCH/log" | cut -c1-200
+            failures=$((failures + 1))
+            continue
+        fi
+        if [[ $config == *-c* ]]; then
+            gcc "$SCRATCH/$name.o" -o "$SCRATCH/got"
+        else
+            gcc "$SCRATCH/Assembly.s" -o "$SCRATCH/got"
+        fi || { echo "FAIL $name ($config): the output doesn't link"; failures=$((failures + 1)); continue; }
+        "$SCRATCH/got" < "$input" > "$SCRATCH/got.out"
+        status=$?
+        checks=$((checks + 1))
+        if [ $status -ne $expected ]; then
+            echo "FAIL $name ($config): exit status $status, gcc gives $expected"
+            failures=$((failures + 1))
+        elif ! cmp -s "$SCRATCH/ref.out" "$SCRATCH/got.out"; then
+            echo "FAIL $name ($config): the output differs from gcc's"
+            diff "$SCRATCH/ref.out" "$SCRATCH/got.out" | head -5
+            failures=$((failures + 1))
+        fi
+    done
+done
+
+echo "$checks checks, $failures failures"
+[ $failures -eq 0 ]
@@ -0,0 +1,127 @@
+int putchar(int c);
+int getchar(void);
+
+int hex(int v, int k){
+    int d = (v >> (k * 4)) & 15;
+    putchar(d < 10 ? 48 + d : 87 + d);
+    if (k)
+        hex(v, k - 1);
+    return 0;
+}
+
+int show(int v){
+    hex(v, 7);
+    putchar(10);
+    return 0;
+}
+
+int scale(int x, int y){
+    return x * 3 + y;
+}
+
+int scaleAgain(int x, int y){
+    return x * 3 + y;
+}
+
+static int scaleHidden(int x, int y){
+    return x * 3 + y;
+}
+
+int scaleOther(int x, int y){
+    return x * 5 + y;
+}
+
+int swapped(int x, int y){
+    return y * 3 + x;
+}
+
+int sign(int x){
+    if (x < 0)
+        return -1;
+    return x > 0;
+}
+
+static int signToo(int x){
+    if (x < 0)
+        return -1;
+    return x > 0;
+}
+
+int countdown(int n){
+    if (n <= 0)
+        return 0;
+    return 1 + countdown(n - 1);
+}
+
+int countdownToo(int n){
+    if (n <= 0)
+        return 0;
+    return 1 + countdownToo(n - 1);
+}
+
+int callsScale(int x){
+    return scale(x, 1) + sign(x);
+}
+
+int callsScaleOther(int x){
+    return scaleOther(x, 1) + sign(x);
+}
+
+int callsScaleAgain(int x){
+    return scaleAgain(x, 1) + signToo(x);
+}
+
+int classify(int x){
+    switch (x) {
+        case 0: return 10;
+        case 1: return 20;
+        case 2: return 30;
+        case 3: return 40;
+        case 4: return 50;
+    }
+    return 0;
+}
+
+int classifyToo(int x){
+    switch (x) {
+        case 0: return 10;
+        case 1: return 20;
+        case 2: return 30;
+        case 3: return 40;
+        case 4: return 50;
+    }
+    return 0;
+}
+
+int classifyOther(int x){
+    switch (x) {
+        case 0: return 10;
+        case 1: return 20;
+        case 2: return 30;
+        case 3: return 40;
+        case 4: return 51;
+    }
+    return 0;
+}
+
+int all(int x){
+    show(scale(x, 2) ^ scaleAgain(x, 3) << 8 ^ scaleHidden(x, 4) << 16);
+    show(scaleOther(x, 2) ^ swapped(x, 3) << 8);
+    show(sign(x) ^ signToo(x + 1) << 4 ^ sign(x - 1) << 8);
+    show(callsScale(x) ^ callsScaleOther(x) << 8 ^ callsScaleAgain(x) << 16);
+    show(classify(x) ^ classifyToo(x + 1) << 8 ^ classifyOther(x) << 16);
+    return 0;
+}
+
+int main(void){
+    int zero = getchar() + 1;
+    all(zero - 2);
+    all(zero - 1);
+    all(zero);
+    all(zero + 1);
+    all(zero + 3);
+    all(zero + 4);
+    all(zero + 100000);
+    show(countdown(zero + 40) ^ countdownToo(zero + 7) << 8);
+    return scaleHidden(zero + 5, zero) + signToo(zero - 3) + classifyToo(zero + 4);
+}
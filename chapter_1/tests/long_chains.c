@@ -0,0 +1,48 @@
+// Operator chains far longer than any walk over the AST could recurse through, and nesting close to the limit
+// of the parser. R4096(m) expands to 4096 copies of m(), m() being one link of a chain.
+#define R4(m) m() m() m() m()
+#define R16(m) R4(m) R4(m) R4(m) R4(m)
+#define R64(m) R16(m) R16(m) R16(m) R16(m)
+#define R256(m) R64(m) R64(m) R64(m) R64(m)
+#define R1024(m) R256(m) R256(m) R256(m) R256(m)
+#define R4096(m) R1024(m) R1024(m) R1024(m) R1024(m)
+// 496 levels, each a + (b - ...) is two nodes deep
+#define R496(m) R256(m) R64(m) R64(m) R64(m) R16(m) R16(m) R16(m)
+
+#define PLUS() + a
+#define AND() && a
+#define OR() || a
+#define STEP() , a = a * 3 + 1
+#define HEAVY() - (a * b + (b ^ a))
+#define OPEN() a + (b -
+#define CLOSE() )
+
+int sum(int a){
+    return a R4096(PLUS) R4096(PLUS) R4096(PLUS) R4096(PLUS);
+}
+
+int all(int a){
+    return a R4096(AND);
+}
+
+int any(int a){
+    return a R4096(OR);
+}
+
+int steps(int a){
+    return (a R4096(STEP));
+}
+
+int heavy(int a, int b){
+    return a R1024(HEAVY);
+}
+
+int nested(int a, int b){
+    return R496(OPEN) a R496(CLOSE);
+}
+
+int main(void){
+    int total = sum(3) + all(5) + 2 * all(0) + 4 * any(0) + 8 * any(7);
+    total = total ^ steps(2) ^ heavy(7, 3) ^ nested(11, 4);
+    return total & 255;
+}
@@ -0,0 +1,55 @@
+int seven(int a, int b, int c, int d, int e, int f, int g){
+    return a - b * 2 + c * 3 - d * 4 + e * 5 - f * 6 + g * 7;
+}
+
+int ten(int a, int b, int c, int d, int e, int f, int g, int h, int i, int j){
+    return ((a ^ j) + (b ^ i) * 3 + (c ^ h) * 5 + (d ^ g) * 7 + (e ^ f) * 11) ^ (g - h + i - j);
+}
+
+int rotate(int n, int a, int b, int c, int d, int e, int f, int g, int h){
+    if (n == 0)
+        return a + b * 2 + c * 3 + d * 4 + e * 5 + f * 6 + g * 7 + h * 8;
+    return rotate(n - 1, h, a, b, c, d, e, f, g + n) * 3 + h;
+}
+
+static int pass(int a, int b, int c, int d, int e, int f, int g, int h){
+    return seven(h, g, f, e, d, c, b) + ten(a, b, c, d, e, f, g, h, a + h, b - g);
+}
+
+int leaf(int a, int b, int c, int d, int e, int f, int g, int h, int i){
+    int s = a * b;
+    s = s + c * d;
+    s = s + e * f;
+    s = s + g * h;
+    return s - i;
+}
+
+int keep(int a, int b, int c, int d, int e, int f, int g, int h){
+    int before = a + h;
+    int sum = seven(b, c, d, e, f, g, h);
+    return sum + before * 1000 + a + b + c + d + e + f + g + h;
+}
+
+int nestedCalls(int x, int y){
+    return ten(seven(x, y, 1, 2, 3, 4, 5), x, y, seven(y, x, 5, 4, 3, 2, 1), 7, 8, 9,
+        leaf(x, y, x, y, x, y, x, y, x), 10, rotate(3, x, y, 1, 2, 3, 4, 5, 6));
+}
+
+int main(void){
+    int h = 17;
+    h = h * 31 + seven(1, 2, 3, 4, 5, 6, 7);
+    h = h * 31 + seven(-7, -6, -5, -4, -3, -2, -1);
+    h = h * 31 + ten(1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+    h = h * 31 + ten(-2147483647 - 1, 2147483647, 0, -1, 1, 65536, -65536, 3, 5, 7);
+    h = h * 31 + rotate(12, 1, 2, 3, 4, 5, 6, 7, 8);
+    h = h * 31 + rotate(5, -1, 9, -3, 7, -5, 5, -7, 3);
+    h = h * 31 + pass(11, 22, 33, 44, 55, 66, 77, 88);
+    h = h * 31 + pass(-1, -2, -3, -4, -5, -6, -7, -8);
+    h = h * 31 + leaf(1, 2, 3, 4, 5, 6, 7, 8, 9);
+    h = h * 31 + leaf(9, 8, 7, 6, 5, 4, 3, 2, 1);
+    h = h * 31 + keep(1, 3, 5, 7, 9, 11, 13, 15);
+    h = h * 31 + keep(2, 4, 6, 8, 10, 12, 14, 16);
+    h = h * 31 + nestedCalls(3, 4);
+    h = h * 31 + nestedCalls(-5, 12);
+    return (h ^ h >> 8 ^ h >> 16 ^ h >> 24) & 255;
+}
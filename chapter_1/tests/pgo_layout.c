@@ -0,0 +1,67 @@
+int putchar(int c);
+int getchar(void);
+
+int hex(int v, int k){
+    int d = (v >> (k * 4)) & 15;
+    putchar(d < 10 ? 48 + d : 87 + d);
+    if (k)
+        hex(v, k - 1);
+    return 0;
+}
+
+int show(int v){
+    hex(v, 7);
+    putchar(10);
+    return 0;
+}
+
+int rarely(int x){
+    return x * 7 - 3;
+}
+
+int neverInProfile(int x){
+    return x / 3 + 11;
+}
+
+static int coldStatic(int x){
+    switch (x & 7) {
+        case 0: return 5;
+        case 1: return 9;
+        case 2: return 13;
+        case 3: return 17;
+        default: return x;
+    }
+}
+
+int coldTwin(int x){
+    return x * 7 - 3;
+}
+
+int hotLeaf(int x){
+    return x * x + 1;
+}
+
+int hotMiddle(int x, int y){
+    return hotLeaf(x) - hotLeaf(y) + coldStatic(x + y);
+}
+
+static int warm(int x){
+    if (x > 5)
+        return hotMiddle(x, x - 5);
+    return rarely(x);
+}
+
+int newFunction(int x){
+    return warm(x) ^ coldTwin(x);
+}
+
+int main(void){
+    int zero = getchar() + 1;
+    show(hotMiddle(zero + 3, zero + 4));
+    show(warm(zero + 9) + warm(zero + 2));
+    show(rarely(zero + 5) ^ coldTwin(zero + 6));
+    show(neverInProfile(zero - 100));
+    show(coldStatic(zero + 3) + coldStatic(zero + 30));
+    show(newFunction(zero + 12));
+    return hotLeaf(zero + 3) + coldTwin(zero + 1);
+}
@@ -0,0 +1,13 @@
+# mycc profile
+runs 3
+900000 hotLeaf
+450000 hotMiddle
+300000 warm
+3 main
+3 show
+96 hex
+1 rarely
+0 coldTwin
+0 coldStatic
+0 neverInProfile
+5 removedSinceTraining
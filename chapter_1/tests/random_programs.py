@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+# Random programs for the differential test: every program only uses what mycc accepts (int locals, the C
+# operators, if/else, switch, static functions and calls with up to 10 arguments) and has no undefined behavior
+# under gcc -fwrapv (divisors and shift counts are kept in range), so gcc and mycc must agree on its output.
+#
+#   tests/random_programs.py [-n COUNT] [-s SEED] [-o DIR]
+#
+# writes DIR/random_SEED.c ... and prints their paths. A program calls putchar to print its values, or with
+# --no-libc only returns a hash of them so that the --jit configurations run it too. make test-random generates a
+# batch into a scratch directory and runs tests/differential.sh on it.
+import argparse
+import os
+import random
+
+INT_MIN = -2147483648
+INT_MAX = 2147483647
+EDGES = [0, 1, -1, 2, -2, 7, 255, 256, 65535, 65536, INT_MAX, INT_MIN, INT_MAX - 1, INT_MIN + 1]
+DIVISORS = [1, 2, 3, 5, 6, 7, 9, 10, 16, 25, 100, 641, 1000, 65536, 1 << 30, INT_MAX,
+            -2, -3, -7, -8, -10, -641, -(1 << 30), -INT_MAX, INT_MIN]
+BINARY = ["+", "-", "*", "&", "|", "^", "<", "<=", ">", ">=", "==", "!=", "&&", "||"]
+
+
+def literal(value):
+    # -2147483648 isn't a C constant, it is - applied to an int that doesn't fit
+    if value == INT_MIN:
+        return "(-2147483647 - 1)"
+    return "(%d)" % value if value < 0 else str(value)
+
+
+class Generator:
+    def __init__(self, rng, libc):
+        self.rng = rng
+        self.libc = libc
+        self.functions = []
+
+    def constant(self):
+        if self.rng.random() < 0.3:
+            return literal(self.rng.choice(EDGES))
+        return literal(self.rng.randint(-1000, 1000))
+
+    def expression(self, names, depth, callees):
+        rng = self.rng
+        if depth <= 0 or rng.random() < 0.2:
+            return rng.choice(names) if names and rng.random() < 0.75 else self.constant()
+        kind = rng.random()
+        sub = lambda: self.expression(names, depth - 1, callees)
+        if kind < 0.12:
+            return "%s(%s)" % (rng.choice(["-", "~", "!"]), sub())
+        if kind < 0.55:
+            return "(%s %s %s)" % (sub(), rng.choice(BINARY), sub())
+        if kind < 0.67:
+            # a constant divisor takes the magic number path, a variable one is kept in 1..256
+            divisor = literal(rng.choice(DIVISORS)) if rng.random() < 0.7 else "((%s & 255) + 1)" % sub()
+            return "(%s %s %s)" % (sub(), rng.choice(["/", "%"]), divisor)
+        if kind < 0.75:
+            return "(%s %s (%s & 31))" % (sub(), rng.choice(["<<", ">>"]), sub())
+        if kind < 0.85:
+            return "(%s ? %s : %s)" % (sub(), sub(), sub())
+        if callees and kind < 0.95:
+            name, arity = rng.choice(callees)
+            return "%s(%s)" % (name, ", ".join(self.expression(names, depth - 2, []) for _ in range(arity)))
+        return sub()
+
+    def statements(self, names, depth, callees, lines, indent, count, in_switch=False):
+        rng = self.rng
+        pad = "    " * indent
+        for _ in range(count):
+            kind = rng.random()
+            if kind < 0.25 and not in_switch:
+                name = "v%d" % len(names)
+                lines.append("%sint %s = %s;" % (pad, name, self.expression(names, 3, callees)))
+                names = names + [name]
+            elif kind < 0.5 and names:
+                op = rng.choice(["=", "+=", "-=", "*=", "^=", "|=", "&="])
+                lines.append("%s%s %s %s;" % (pad, rng.choice(names), op, self.expression(names, 3, callees)))
+            elif kind < 0.65 and depth > 0:
+                lines.append("%sif (%s) {" % (pad, self.expression(names, 2, callees)))
+                self.statements(names, depth - 1, callees, lines, indent + 1, rng.randint(1, 3))
+                lines.append("%s} else {" % pad)
+                self.statements(names, depth - 1, callees, lines, indent + 1, rng.randint(1, 3))
+                lines.append("%s}" % pad)
+            elif kind < 0.8 and depth > 0 and names:
+                self.switch(names, depth, callees, lines, indent)
+            elif kind < 0.85 and depth > 0:
+                lines.append("%sif (%s)" % (pad, self.expression(names, 2, callees)))
+                lines.append("%s    return %s;" % (pad, self.expression(names, 2, callees)))
+            elif kind < 0.9 and len(names) > 1:
+                # expressions have no side effects, an assignment in one could be unsequenced with a read
+                first, second = rng.sample(names, 2)
+                lines.append("%s%s = %s = %s;" % (pad, first, second, self.expression(names, 3, callees)))
+            elif names:
+                lines.append("%s%s = %s;" % (pad, rng.choice(names), self.expression(names, 3, callees)))
+        return names
+
+    def switch(self, names, depth, callees, lines, indent):
+        rng = self.rng
+        pad = "    " * indent
+        if rng.random() < 0.5:
+            # dense enough for a jump table
+            base = rng.randint(-20, 20)
+            values = rng.sample(range(base, base + 12), rng.randint(4, 10))
+            selector = "(%s %% 16)" % self.expression(names, 2, callees)
+        else:
+            values = rng.sample(EDGES + [rng.randint(-100000, 100000) for _ in range(12)], rng.randint(3, 14))
+            values = list(dict.fromkeys(values))
+            selector = self.expression(names, 2, callees)
+        lines.append("%sswitch (%s) {" % (pad, selector))
+        default = rng.random() < 0.6
+        for k, value in enumerate(values):
+            lines.append("%s    case %s:" % (pad, literal(value)))
+            self.statements(names, depth - 1, callees, lines, indent + 2, rng.randint(0, 2), in_switch=True)
+            # a label has to be followed by a statement
+            if rng.random() < 0.7 or (k == len(values) - 1 and not default):
+                lines.append("%s        break;" % pad)
+        if default:
+            lines.append("%s    default:" % pad)
+            self.statements(names, depth - 1, callees, lines, indent + 2, 1, in_switch=True)
+        lines.append("%s}" % pad)
+
+    def function(self, index):
+        rng = self.rng
+        arity = rng.choice([0, 1, 2, 3, 6, 7, 8, 10])
+        name = "f%d" % index
+        params = ["p%d" % k for k in range(arity)]
+        # only two of the earlier functions are called, there is no recursion and every program ends quickly
+        callees = rng.sample(self.functions, min(len(self.functions), 2))
+        lines = []
+        static = "static " if rng.random() < 0.3 else ""
+        lines.append("%sint %s(%s){" % (static, name, ", ".join("int " + p for p in params) or "void"))
+        names = self.statements(list(params), 2, callees, lines, 1, rng.randint(2, 6))
+        lines.append("    return %s;" % self.expression(names, 3, callees))
+        lines.append("}")
+        self.functions.append((name, arity))
+        text = "\n".join(lines)
+        if rng.random() < 0.15:
+            # an identical twin for the code folding
+            twin = "f%dtwin" % index
+            text += "\n\n" + text.replace("int %s(" % name, "int %s(" % twin, 1)
+            self.functions.append((twin, arity))
+        return text
+
+    def program(self):
+        rng = self.rng
+        parts = []
+        if self.libc:
+            parts.append("int putchar(int c);\nint getchar(void);")
+            parts.append(PRINT)
+        for index in range(rng.randint(3, 8)):
+            parts.append(self.function(index))
+        main = ["int main(void){"]
+        main.append("    int zero = getchar() + 1;" if self.libc else "    int zero = 0;")
+        main.append("    int h = 17;")
+        for name, arity in self.functions:
+            for _ in range(2):
+                arguments = ", ".join("zero + %s" % self.constant() for _ in range(arity))
+                call = "%s(%s)" % (name, arguments)
+                main.append("    show(%s);" % call if self.libc else "    h = h * 31 + %s;" % call)
+        main.append("    return (h ^ h >> 8 ^ h >> 16 ^ h >> 24) & 255;")
+        main.append("}")
+        parts.append("\n".join(main))
+        return "\n\n".join(parts) + "\n"
+
+
+PRINT = """int hex(int v, int k){
+    int d = (v >> (k * 4)) & 15;
+    putchar(d < 10 ? 48 + d : 87 + d);
+    if (k)
+        hex(v, k - 1);
+    return 0;
+}
+
+int show(int v){
+    hex(v, 7);
+    putchar(10);
+    return 0;
+}"""
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generates random programs for tests/differential.sh")
+    parser.add_argument("-n", "--count", type=int, default=20)
+    parser.add_argument("-s", "--seed", type=int, default=1)
+    parser.add_argument("-o", "--output", default=".")
+    parser.add_argument("--no-libc", action="store_true", help="return a hash instead of printing, runs under --jit")
+    args = parser.parse_args()
+    os.makedirs(args.output, exist_ok=True)
+    for seed in range(args.seed, args.seed + args.count):
+        path = os.path.join(args.output, "random_%d.c" % seed)
+        with open(path, "w") as file:
+            file.write(Generator(random.Random(seed), not args.no_libc).program())
+        print(path)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,12 @@
+int getchar(void);
+
+int g(void){
+    int x = getchar();
+    return x / 3 + x % 7;
+}
+
+int main(void){
+    int h = getchar();
+    int k = h * 31 + g();
+    return (k + h) & 255;
+}
@@ -0,0 +1,105 @@
+int putchar(int c);
+int getchar(void);
+
+int hex(int v, int k){
+    int d = (v >> (k * 4)) & 15;
+    putchar(d < 10 ? 48 + d : 87 + d);
+    if (k)
+        hex(v, k - 1);
+    return 0;
+}
+
+int show(int v){
+    hex(v, 7);
+    putchar(32);
+    return 0;
+}
+
+int mark(int c, int v){
+    putchar(c);
+    return v;
+}
+
+int compares(int a, int b){
+    show((a < b) | (a <= b) << 1 | (a > b) << 2 | (a >= b) << 3 | (a == b) << 4 | (a != b) << 5);
+    show((a < 0) + (b > 0) + !a + !b);
+    show(a == b ? 1 : 2);
+    putchar(10);
+    return 0;
+}
+
+int selects(int a, int b){
+    int min = a < b ? a : b;
+    int max = a > b ? a : b;
+    int abs = a < 0 ? -a : a;
+    int clamp = b < -100 ? -100 : b > 100 ? 100 : b;
+    int pick = 0;
+    if (a >= b)
+        pick = a - b;
+    else
+        pick = b - a;
+    show(min);
+    show(max);
+    show(abs);
+    show(clamp);
+    show(pick);
+    show(a != 0 ? b : a + 1);
+    putchar(10);
+    return 0;
+}
+
+int logic(int a, int b){
+    show(a && b);
+    show(a || b);
+    show(!a && !b || a && b);
+    show((a > 0 && b > 0) + (a < 0 || b < 0) * 2);
+    show(a && (b || a - 1));
+    putchar(10);
+    return 0;
+}
+
+int shortCircuit(int a, int b){
+    int r = 0;
+    r = mark(97, a) && mark(98, b);
+    show(r);
+    r = mark(99, a) || mark(100, b);
+    show(r);
+    r = mark(101, a) && mark(102, b) || mark(103, a + b);
+    show(r);
+    r = (mark(104, a) || mark(105, b)) && mark(106, 1);
+    show(r);
+    show(b != 0 && a / b > 1);
+    show(b == 0 || a % b == 0);
+    show(b != 0 ? a / b : -1);
+    show(b ? a % b : a);
+    if (b != 0 && a / b < 0)
+        show(1);
+    if (b == 0 || a / b >= 0)
+        show(2);
+    putchar(10);
+    return 0;
+}
+
+int all(int a, int b){
+    compares(a, b);
+    selects(a, b);
+    logic(a, b);
+    shortCircuit(a, b);
+    return 0;
+}
+
+int main(void){
+    int zero = getchar() + 1;
+    all(zero, zero);
+    all(zero, zero + 1);
+    all(zero + 1, zero);
+    all(zero - 1, zero + 1);
+    all(zero + 7, zero - 3);
+    all(zero - 250, zero + 250);
+    all(zero + 9, zero + 3);
+    all(zero - 2147483647 - 1, zero + 2147483647);
+    all(zero + 2147483647, zero - 2147483647 - 1);
+    all(zero - 2147483647 - 1, zero + 1);
+    all(zero + 42, zero);
+    return (zero + 3 > 2) + (zero && 5) * 2;
+}
@@ -0,0 +1,164 @@
+int putchar(int c);
+int getchar(void);
+
+int hex(int v, int k){
+    int d = (v >> (k * 4)) & 15;
+    putchar(d < 10 ? 48 + d : 87 + d);
+    if (k)
+        hex(v, k - 1);
+    return 0;
+}
+
+int show(int v){
+    hex(v, 7);
+    putchar(10);
+    return 0;
+}
+
+int dense(int x){
+    int r = 100;
+    switch (x) {
+        case 0: r = 7; break;
+        case 1: r = 11;
+        case 2: r = r + 13; break;
+        case 3:
+        case 4: r = 17; break;
+        case 5: return 19;
+        case 6: r = 23; break;
+        case 7: r = 29; break;
+        case 9: r = 31; break;
+        default: r = -1;
+    }
+    return r;
+}
+
+int negative(int x){
+    switch (x - 2) {
+        case -5: return 1;
+        case -4: return 2;
+        case -3: return 3;
+        case -2: return 4;
+        case -1: return 5;
+        case 0: return 6;
+        case 1: return 7;
+    }
+    return 0;
+}
+
+int sparse(int x){
+    switch (x) {
+        case -2147483647 - 1: return 1;
+        case -100000: return 2;
+        case -777: return 3;
+        case -1: return 4;
+        case 12: return 5;
+        case 99: return 6;
+        case 1000: return 7;
+        case 4096: return 8;
+        case 65535: return 9;
+        case 65536: return 10;
+        case 123456: return 11;
+        case 1000000: return 12;
+        case 31415926: return 13;
+        case 2147483646: return 14;
+        case 2147483647: return 15;
+        default: return 16;
+    }
+}
+
+int mixed(int x){
+    int r = 0;
+    switch (x) {
+        case 10: r = 1; break;
+        case 11: r = 2; break;
+        case 12: r = 3; break;
+        case 13: r = 4; break;
+        case 15: r = 5; break;
+        case 500: r = 6; break;
+        case 1000: r = 7; break;
+        case 2000: r = 8;
+        case 2001: r = r + 9; break;
+        case 2002: r = 10; break;
+        case 2003: r = 11; break;
+        case 2004: r = 12; break;
+    }
+    return r;
+}
+
+int top(int x){
+    switch (x) {
+        case 2147483640: return 1;
+        case 2147483641: return 2;
+        case 2147483643: return 3;
+        case 2147483645: return 4;
+        case 2147483647: return 5;
+        default: return 6;
+    }
+}
+
+int nested(int x, int y){
+    switch (x) {
+        case 0:
+            switch (y) {
+                case 0: return 1;
+                case 1: return 2;
+                case 2: return 3;
+                case 3: break;
+                default: return 4;
+            }
+            return 5;
+        case 1: {
+            int t = y * 3;
+            switch (t) {
+                case 0: t = 40; break;
+                case 3: t = 50; break;
+                case 6: t = 60; break;
+                case 9: t = 70; break;
+            }
+            return t;
+        }
+        default:
+            break;
+    }
+    return 6;
+}
+
+int sweep(int x, int end, int step){
+    show(dense(x) ^ negative(x) << 8 ^ mixed(x) << 16 ^ top(x) << 24);
+    if (x < end)
+        sweep(x + step, end, step);
+    return 0;
+}
+
+int probe(int x){
+    show(sparse(x) ^ top(x) << 8 ^ mixed(x) << 16 ^ dense(x) << 24);
+    show(sparse(x - 1) ^ sparse(x + 1) << 8);
+    return 0;
+}
+
+int main(void){
+    int zero = getchar() + 1;
+    sweep(zero - 8, zero + 20, 1);
+    sweep(zero + 480, zero + 520, 5);
+    sweep(zero + 1990, zero + 2010, 1);
+    sweep(zero + 2147483630, zero + 2147483646, 1);
+    probe(zero - 2147483647 - 1);
+    probe(zero - 100000);
+    probe(zero - 777);
+    probe(zero - 1);
+    probe(zero + 12);
+    probe(zero + 99);
+    probe(zero + 1000);
+    probe(zero + 4096);
+    probe(zero + 65535);
+    probe(zero + 65536);
+    probe(zero + 123456);
+    probe(zero + 1000000);
+    probe(zero + 31415926);
+    probe(zero + 2147483646);
+    probe(zero + 77);
+    show(nested(zero, zero) ^ nested(zero, zero + 1) << 4 ^ nested(zero, zero + 2) << 8 ^ nested(zero, zero + 3) << 12);
+    show(nested(zero, zero + 9) ^ nested(zero + 1, zero) << 8 ^ nested(zero + 1, zero + 2) << 16);
+    show(nested(zero + 1, zero + 3) ^ nested(zero + 1, zero + 1) << 8 ^ nested(zero + 2, zero) << 16);
+    return dense(zero + 2) + sparse(zero + 65536);
+}
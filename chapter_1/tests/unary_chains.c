@@ -0,0 +1,49 @@
+int putchar(int c);
+
+int hex(int v, int k){
+    int d = (v >> (k * 4)) & 15;
+    putchar(d < 10 ? 48 + d : 87 + d);
+    if (k)
+        hex(v, k - 1);
+    return 0;
+}
+
+int show(int v){
+    hex(v, 7);
+    putchar(10);
+    return 0;
+}
+
+int chains(int x){
+    show(-(-x));
+    show(~~x);
+    show(-~x);
+    show(~-x);
+    show(-~-~-~x);
+    show(~-~-~-x);
+    show(- - - -x);
+    show(~~~~~x);
+    return 0;
+}
+
+int limits(int big, int small){
+    show(-small);
+    show(-(-small));
+    show(~small);
+    show(-~small);
+    show(big + 1);
+    show(-big - 2);
+    show(~big + small);
+    show(big * 2);
+    return 0;
+}
+
+int main(void){
+    chains(0);
+    chains(1);
+    chains(-7);
+    chains(2147483647);
+    chains(-2147483647 - 1);
+    limits(2147483647, -2147483647 - 1);
+    return (-~-~5 + ~-(-2147483647 - 1)) & 255;
+}